@@ -66,6 +66,20 @@ void DEV_Digital_Write(UWORD Pin, UBYTE Value);
  */
 UBYTE DEV_Digital_Read(UWORD Pin);
 
+/**
+ * @brief Wait until a GPIO input reads the given level.
+ *
+ * Backends block on edge notifications where the GPIO library provides them
+ * (gpiod line events, lgpio alerts) and fall back to a sleep ladder otherwise,
+ * so the CPU is released while the pin is held.
+ *
+ * @param Pin GPIO pin number.
+ * @param Value Level to wait for (HIGH or LOW).
+ * @param Timeout_us Give up after this many microseconds.
+ * @return 0 once the pin reads Value, -1 on timeout or error.
+ */
+int DEV_Digital_WaitLevel(UWORD Pin, UBYTE Value, UDOUBLE Timeout_us);
+
 /**
  * @brief Write a byte over the SPI bus.
  * @param Value Byte to send.
@@ -78,6 +92,24 @@ void DEV_SPI_WriteByte(UBYTE Value);
  */
 UBYTE DEV_SPI_ReadByte();
 
+/**
+ * @brief Write a block of bytes over the SPI bus.
+ *
+ * Backends send the block with as few library calls or kernel transfers as
+ * they allow, instead of one transaction per byte.
+ *
+ * @param pData Bytes to send.
+ * @param Len Number of bytes to send.
+ */
+void DEV_SPI_WriteBuffer(const UBYTE *pData, UDOUBLE Len);
+
+/**
+ * @brief Read a block of bytes from the SPI bus.
+ * @param pData Destination buffer.
+ * @param Len Number of bytes to read.
+ */
+void DEV_SPI_ReadBuffer(UBYTE *pData, UDOUBLE Len);
+
 /**
  * @brief Delay for a specified number of milliseconds.
  * @param xms Number of milliseconds to delay.
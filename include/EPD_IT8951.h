@@ -14,6 +14,8 @@
 
 #include <stdbool.h>
 #include "DEV_Config.h"
+#include "EPD_IT8951_Policy.h"
+#include "GUI_Dither.h"
 
 /**
  * @brief Image load information for IT8951 controller.
@@ -57,6 +59,94 @@ typedef struct {
 
 EPD_Config EPD_IT8951_ComputeConfig(UWORD mode);
 
+/**
+ * @brief Flags for EPD_IT8951_InitEx().
+ */
+#define EPD_IT8951_INIT_ASYNC_TX  0x0001  /**< Stream packed pixels through a transmit worker thread. */
+
+/**
+ * @brief Reads of the BUSY (HRDY) pin before ReadBusy blocks on an edge wait.
+ */
+#ifndef EPD_IT8951_BUSY_SPIN_LIMIT
+#define EPD_IT8951_BUSY_SPIN_LIMIT 64
+#endif
+
+/**
+ * @brief Default HRDY timeout, see EPD_IT8951_SetBusyTimeout().
+ */
+#define EPD_IT8951_BUSY_TIMEOUT_MS 5000
+
+/**
+ * @brief Waveform modes with their own learned refresh duration; the last slot
+ *        is shared by all higher mode numbers.
+ */
+#define EPD_IT8951_MODE_SLOTS 9
+
+/**
+ * @brief Waveform mode argument asking the driver to pick the mode from the
+ *        pixels, see EPD_IT8951_SetAutoWaveform().
+ */
+#define EPD_IT8951_MODE_AUTO 0xFFFF
+
+/**
+ * @brief Share of the estimated refresh duration slept before polling LUTAFSR.
+ */
+#ifndef EPD_IT8951_READY_SLEEP_PCT
+#define EPD_IT8951_READY_SLEEP_PCT 80
+#endif
+
+/**
+ * @brief Longest gap between LUTAFSR polls once the estimate has run out.
+ */
+#define EPD_IT8951_READY_BACKOFF_MAX_MS 16
+
+/**
+ * @brief Give up waiting for a refresh after this long.
+ */
+#define EPD_IT8951_READY_TIMEOUT_MS 10000
+
+/**
+ * @brief Error codes returned by EPD_IT8951_GetError().
+ */
+#define EPD_IT8951_ERR_BUSY_TIMEOUT  (-1)  /**< HRDY stayed low past the timeout. */
+
+/**
+ * @brief Driver performance counters, see EPD_IT8951_GetStats().
+ */
+typedef struct {
+    uint64_t Busy_Spin_Iterations; /**< BUSY pin reads made while spinning. */
+    uint64_t Busy_Spin_Hits;       /**< HRDY waits that ended within the spin. */
+    uint64_t Busy_Blocking_Waits;  /**< HRDY waits that fell back to a blocking wait. */
+    uint64_t Busy_Timeouts;        /**< Blocking waits that hit the timeout. */
+    uint64_t Busy_Wait_us;         /**< Time spent in blocking waits. */
+    uint64_t Ready_Polls;          /**< LUTAFSR register reads while waiting for refreshes. */
+    uint64_t Ready_Waits;          /**< Refreshes waited for. */
+    uint64_t Ready_Last_Latency_us; /**< Display command to refresh done, last refresh. */
+    uint64_t Reg_Reads_Elided;     /**< Register/VCOM reads answered from the host-side shadow. */
+    uint64_t Reg_Writes_Elided;    /**< Register/VCOM writes skipped because the value was unchanged. */
+    uint64_t Fill_Areas;           /**< Solid areas loaded with EPD_IT8951_Fill_Area(). */
+    uint64_t Fill_Words;           /**< Pixel words sent for them, all from one repeated pattern. */
+    uint64_t Diff_Updates;         /**< *bp_Refresh calls taken by the incremental path. */
+    uint64_t Diff_Areas;           /**< Changed areas uploaded by it. */
+    uint64_t Diff_Bytes_Sent;      /**< Pixel bytes uploaded by it. */
+    uint64_t Diff_Bytes_Avoided;   /**< Pixel bytes of unchanged tiles it did not upload. */
+    uint64_t Diff_Last_Bytes_Avoided; /**< Bytes avoided by the last incremental update. */
+    uint64_t Auto_A2;              /**< Updates the waveform classifier sent with A2. */
+    uint64_t Auto_DU;              /**< ... with DU. */
+    uint64_t Auto_GL16;            /**< ... with GL16. */
+    uint64_t Auto_GC16;            /**< ... with GC16. */
+    uint64_t Depth_1bpp_Uploads;   /**< Areas sent as 1bpp by the adaptive depth path. */
+    uint64_t Depth_2bpp_Uploads;   /**< Areas sent as 2bpp by it. */
+    uint64_t Depth_Bytes_Saved;    /**< Pixel bytes it kept off the bus. */
+    uint64_t Async_Streams;    /**< Pixel streams sent through the transmit worker. */
+    uint64_t Async_Chunks;     /**< Staging slots handed to the worker. */
+    uint64_t Async_Slot_Waits; /**< Times the packer had to wait for a free slot. */
+    uint64_t Async_Pack_us;    /**< Time spent byte-swapping pixels into slots. */
+    uint64_t Async_Wire_us;    /**< Time the worker spent inside DEV_SPI_WriteBuffer(). */
+    uint64_t Async_Wall_us;    /**< Wall time of the async pixel streams. */
+    float    Async_Overlap;    /**< Share of pack time hidden behind the SPI transfer (0..1). */
+} EPD_IT8951_Stats;
+
 /*-----------------------------------------------------------------------
 IT8951 Command defines
 ------------------------------------------------------------------------*/
@@ -163,6 +253,182 @@ void EPD_IT8951_Sleep(void);
  */
 IT8951_Dev_Info EPD_IT8951_Init(UWORD VCOM);
 
+/**
+ * @brief Initialize the IT8951 controller with optional driver features.
+ *
+ * EPD_IT8951_Init(VCOM) is EPD_IT8951_InitEx(VCOM, 0). Features not requested
+ * in Flags are switched off, so calling this again reconfigures the driver.
+ *
+ * @param VCOM VCOM voltage setting.
+ * @param Flags Bitwise OR of EPD_IT8951_INIT_* flags.
+ * @return Device information structure.
+ */
+IT8951_Dev_Info EPD_IT8951_InitEx(UWORD VCOM, UDOUBLE Flags);
+
+/**
+ * @brief Read the driver performance counters.
+ * @param Stats Destination for the counters.
+ */
+void EPD_IT8951_GetStats(EPD_IT8951_Stats *Stats);
+
+/**
+ * @brief Reset the driver performance counters to zero.
+ */
+void EPD_IT8951_ResetStats(void);
+
+/**
+ * @brief Wait for the last display refresh to finish.
+ *
+ * Sleeps for most of the refresh time expected for its waveform mode, then
+ * polls LUTAFSR with exponential backoff. The expectation for each mode is
+ * learned from the measured latencies.
+ *
+ * @param Latency_us If not NULL, receives the time from the display command
+ *        to the refresh being done, or 0 if no refresh was pending or it was
+ *        already done when this was called, so its duration is unknown.
+ * @return 0 when done, -1 on timeout, -2 if the controller stopped responding.
+ */
+int EPD_IT8951_WaitForRefresh(UDOUBLE *Latency_us);
+
+/**
+ * @brief Get the current refresh duration estimate of a waveform mode.
+ * @param Mode Waveform mode.
+ * @return Estimated duration in milliseconds.
+ */
+UDOUBLE EPD_IT8951_GetRefreshEstimate(UWORD Mode);
+
+/**
+ * @brief Set how long to wait for HRDY before aborting transfers.
+ * @param Timeout_ms Timeout in milliseconds (default EPD_IT8951_BUSY_TIMEOUT_MS).
+ */
+void EPD_IT8951_SetBusyTimeout(UDOUBLE Timeout_ms);
+
+/**
+ * @brief Let the controller rotate pixels while they are loaded.
+ *
+ * Frame buffers are then drawn in the rotated orientation with Paint's
+ * ROTATE_0, so Paint_SetPixel() no longer remaps every pixel. The 2, 4 and
+ * 8bpp uploads (EPD_IT8951_*bp_Refresh(), EPD_IT8951_Area_Load() and
+ * EPD_IT8951_Area_Refresh()) take their area in rotated coordinates and
+ * refresh the matching panel area. Fills, clears, EPD_IT8951_Buffer_Refresh()
+ * and the 1bpp functions keep using panel coordinates and are not rotated.
+ * EPD_IT8951_Init() resets the rotation to 0.
+ *
+ * @param Dev_Info Device information of the panel.
+ * @param Rotate 0, 90, 180 or 270 degrees, turning the same way as Paint_SetRotate().
+ * @return 0 on success, -2 for any other angle.
+ */
+int EPD_IT8951_SetRotate(IT8951_Dev_Info Dev_Info, UWORD Rotate);
+
+/**
+ * @brief Get the rotation set with EPD_IT8951_SetRotate().
+ * @return 0, 90, 180 or 270.
+ */
+UWORD EPD_IT8951_GetRotate(void);
+
+/**
+ * @brief Map an area of the rotated frame to the panel area it is shown on.
+ * @param X X coordinate, replaced by the panel X.
+ * @param Y Y coordinate, replaced by the panel Y.
+ * @param W Width, replaced by the panel width.
+ * @param H Height, replaced by the panel height.
+ */
+void EPD_IT8951_RotateArea(UWORD *X, UWORD *Y, UWORD *W, UWORD *H);
+
+/**
+ * @brief Upload only what changed between consecutive *bp_Refresh frames.
+ *
+ * While enabled, EPD_IT8951_2bp_Refresh(), EPD_IT8951_4bp_Refresh() and
+ * EPD_IT8951_8bp_Refresh() keep a host-side copy of the last frame they
+ * uploaded. The next frame for the same area, depth, rotation and image buffer
+ * is compared with it in EPD_IT8951_DIFF_TILE square tiles; only the changed
+ * tiles are uploaded, joined into larger areas, and their bounding box is
+ * refreshed once. A frame with no changes is neither uploaded nor refreshed.
+ * Any other write into the same image buffer starts over with a full upload.
+ * The bytes saved are counted in EPD_IT8951_Stats (Diff_*).
+ *
+ * Disabling frees the copy. EPD_IT8951_Init() keeps the setting but forgets
+ * the copy.
+ *
+ * @param Enable true to diff frames, false for plain uploads (default).
+ */
+void EPD_IT8951_SetIncremental(bool Enable);
+
+/**
+ * @brief Let the *bp_Refresh functions pick the fastest correct waveform.
+ *
+ * EPD_IT8951_2bp_Refresh(), EPD_IT8951_4bp_Refresh() and
+ * EPD_IT8951_8bp_Refresh() normally refresh with GC16. While enabled they
+ * use DU when every pixel of the area is black or white, GL16 when the area
+ * is mostly white (text on a page), and GC16 otherwise. With
+ * EPD_IT8951_SetIncremental() also enabled the old pixels are known, so only
+ * the changed pixels count, and A2 is used when they all go from black or
+ * white to black or white. Mode numbers come from EPD_IT8951_GetModeTable().
+ *
+ * @param Enable true to pick the waveform, false for GC16 (default).
+ */
+void EPD_IT8951_SetAutoWaveform(bool Enable);
+
+/**
+ * @brief Send areas with few grays at a lower bit depth.
+ *
+ * While enabled, the 2, 4 and 8bpp refreshes (EPD_IT8951_*bp_Refresh() and
+ * EPD_IT8951_Area_Refresh()) histogram each area first. An area with two
+ * grays is sent as 1bpp and shown with the two grays set in BGVR; an area
+ * whose grays are all black, 0x55, 0xAA or white is sent as 2bpp. What is
+ * shown does not change, only the bytes on the bus. 1bpp needs X and W to be
+ * multiples of 16 (32 with Four_Byte_Align) and no controller rotation;
+ * otherwise 2bpp is tried. Frames taken by the incremental path are not
+ * repacked.
+ *
+ * @param Enable true to repack, false to send the frame's own depth (default).
+ */
+void EPD_IT8951_SetAdaptiveDepth(bool Enable);
+
+/**
+ * @brief Draw at 8bpp and send at the panel's bit depth.
+ *
+ * Paint draws fastest at 8bpp, a byte per pixel. With a depth below 8 set,
+ * 8bpp frames given to EPD_IT8951_Area_Refresh() and 8bpp Paint images sent
+ * by EPD_IT8951_RefreshDirty() are packed to that depth in one pass right
+ * before the upload (see EPD_IT8951_Pack.h), and the bus carries the same
+ * bytes as if Paint had drawn at that depth. EPD_IT8951_8bp_Refresh() still
+ * sends 8bpp.
+ *
+ * @param Bits_Per_Pixel 1, 2 or 4, or 8 to send 8bpp frames as they are (default).
+ * @return 0, or -2 for any other depth.
+ */
+int EPD_IT8951_SetUploadDepth(UBYTE Bits_Per_Pixel);
+
+/**
+ * @brief Dither 8bpp frames as they are packed to the upload depth.
+ *
+ * With a depth of 1 or 2 set by EPD_IT8951_SetUploadDepth(), the 16 grays
+ * of an 8bpp frame are dithered to the 2 or 4 shown instead of cut to the
+ * top bits. The frame itself is not changed. DITHER_BAYER is placed by panel
+ * position, so dirty areas sent apart meet without seams; error diffusion
+ * starts afresh in each area, and is best kept for whole frames.
+ *
+ * @param Mode Method, DITHER_NONE to keep the top bits (default).
+ * @return 0, or -2 for an unknown method.
+ */
+int EPD_IT8951_SetUploadDither(DITHER_MODE Mode);
+
+/**
+ * @brief Get the sticky driver error.
+ *
+ * Once HRDY times out, every further transfer is skipped until the error is
+ * cleared, either by EPD_IT8951_ClearError() or by the next EPD_IT8951_Init().
+ *
+ * @return 0, or an EPD_IT8951_ERR_* code.
+ */
+int EPD_IT8951_GetError(void);
+
+/**
+ * @brief Clear the sticky driver error.
+ */
+void EPD_IT8951_ClearError(void);
+
 /**
  * @brief Clear the display and refresh with the given mode.
  * @param Dev_Info Device information.
@@ -171,6 +437,36 @@ IT8951_Dev_Info EPD_IT8951_Init(UWORD VCOM);
  */
 void EPD_IT8951_Clear_Refresh(IT8951_Dev_Info Dev_Info, UDOUBLE Target_Memory_Addr, UWORD Mode);
 
+/**
+ * @brief Load a solid gray area into controller memory without a host framebuffer.
+ *
+ * The area is sent as 4bpp pixels from one small pattern buffer that is
+ * repeated on the wire, so nothing frame-sized is allocated. This is the
+ * controller-side counterpart of Paint_ClearWindows(). Nothing is refreshed.
+ *
+ * @param X X coordinate.
+ * @param Y Y coordinate.
+ * @param W Width.
+ * @param H Height.
+ * @param Gray Gray level, 0x00 (black) to 0xFF (white); the top 4 bits are used.
+ * @param Target_Memory_Addr Target memory address.
+ * @return 0 on success, -2 on bad arguments, or an EPD_IT8951_ERR_* code.
+ */
+int EPD_IT8951_Fill_Area(UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Gray, UDOUBLE Target_Memory_Addr);
+
+/**
+ * @brief Fill an area with a solid gray and refresh it.
+ * @param X X coordinate.
+ * @param Y Y coordinate.
+ * @param W Width.
+ * @param H Height.
+ * @param Gray Gray level, 0x00 (black) to 0xFF (white).
+ * @param Mode Waveform mode (e.g., INIT, GC16, DU).
+ * @param Target_Memory_Addr Target memory address.
+ * @return 0 on success, -2 on bad arguments, or an EPD_IT8951_ERR_* code.
+ */
+int EPD_IT8951_Fill_Refresh(UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Gray, UWORD Mode, UDOUBLE Target_Memory_Addr);
+
 /**
  * @brief Refresh a region of the display with a 1bpp (monochrome) image buffer.
  * @param Frame_Buf Pointer to the image buffer.
@@ -244,17 +540,117 @@ void EPD_IT8951_4bp_Refresh(UBYTE* Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H
  */
 void EPD_IT8951_8bp_Refresh(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H, bool Hold, UDOUBLE Target_Memory_Addr);
 
+/**
+ * @brief Refresh a region of the display with the given waveform mode.
+ *
+ * The 2/4/8bpp rows must be a whole number of 16 bit words (W * Bits_Per_Pixel
+ * a multiple of 16); 1bpp needs X and W to be multiples of 8. 1bpp areas cannot be
+ * rotated by the controller, see EPD_IT8951_SetRotate().
+ *
+ * @param Frame_Buf Pointer to the image buffer.
+ * @param X X coordinate.
+ * @param Y Y coordinate.
+ * @param W Width.
+ * @param H Height.
+ * @param Bits_Per_Pixel 1, 2, 4 or 8.
+ * @param Mode Waveform mode (e.g., GC16, DU, A2), or EPD_IT8951_MODE_AUTO to
+ *        pick one from the pixels as EPD_IT8951_SetAutoWaveform() does.
+ * @param Target_Memory_Addr Target memory address.
+ * @return 0 on success, -2 on bad arguments, or an EPD_IT8951_ERR_* code.
+ */
+int EPD_IT8951_Area_Refresh(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Bits_Per_Pixel, UWORD Mode, UDOUBLE Target_Memory_Addr);
+
+/**
+ * @brief Load a region into controller memory without refreshing it.
+ *
+ * Rows must be a whole number of 16 bit words (W * Bits_Per_Pixel a multiple of 16).
+ *
+ * @param Frame_Buf Pointer to the image buffer.
+ * @param X X coordinate.
+ * @param Y Y coordinate.
+ * @param W Width.
+ * @param H Height.
+ * @param Bits_Per_Pixel 2, 4 or 8.
+ * @param Target_Memory_Addr Target memory address.
+ * @return 0 on success, -2 on bad arguments, or an EPD_IT8951_ERR_* code.
+ */
+int EPD_IT8951_Area_Load(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Bits_Per_Pixel, UDOUBLE Target_Memory_Addr);
+
+/**
+ * @brief Refresh a region from an image buffer already in controller memory.
+ *
+ * Sends one DPY_BUF_AREA command, so any buffer loaded earlier with
+ * EPD_IT8951_Area_Load() can be shown without uploading it again.
+ *
+ * @param X X coordinate.
+ * @param Y Y coordinate.
+ * @param W Width.
+ * @param H Height.
+ * @param Mode Waveform mode (e.g., GC16, DU, A2).
+ * @param Target_Memory_Addr Image buffer to show.
+ * @return 0 on success, -2 on bad arguments, or an EPD_IT8951_ERR_* code.
+ */
+int EPD_IT8951_Buffer_Refresh(UWORD X, UWORD Y, UWORD W, UWORD H, UWORD Mode, UDOUBLE Target_Memory_Addr);
+
 /**
  * @brief High-level API: Display a BMP image file on the e-Paper display.
  *
  * Loads a BMP file, draws it to the display buffer, and refreshes the e-Paper display.
- * Handles all buffer management and display logic internally.
+ * Handles all buffer management and display logic internally. PNG and baseline
+ * JPEG files are decoded in process (see GUI_ReadImage()).
  *
- * @param path Path to the BMP file.
+ * @param path Path to the BMP, PNG or JPEG file.
  * @param VCOM VCOM voltage setting (pass 0 to use default).
  * @param Mode Display mode (e.g., INIT, GC16, A2).
- * @return 0 on success, negative value on error.
+ * @return 0 on success, negative value on error (-13 if the controller stopped responding).
  */
 int EPD_IT8951_DisplayBMP(const char *path, UWORD VCOM, UWORD Mode);
 
+/**
+ * @brief Display a BMP image file, clearing the panel only when the policy says so.
+ *
+ * EPD_IT8951_DisplayBMP() is this function with a NULL policy, which clears the
+ * panel with INIT mode before every image. With a policy, the clear happens
+ * only when the full-panel GC16 update would overrun a region's budget or a
+ * clear was requested, and both updates are recorded in the policy.
+ *
+ * @param path Path to the BMP, PNG or JPEG file.
+ * @param VCOM VCOM voltage setting (pass 0 to use default).
+ * @param Mode Display mode (0-3).
+ * @param Policy Refresh policy, or NULL to always clear.
+ * @return 0 on success, negative value on error (-13 if the controller stopped responding).
+ */
+int EPD_IT8951_DisplayBMPEx(const char *path, UWORD VCOM, UWORD Mode, EPD_IT8951_Policy *Policy);
+
+/**
+ * @brief Draw a BMP image file on an already initialized display.
+ *
+ * Same as EPD_IT8951_DisplayBMP() without the init and the INIT mode clear,
+ * for callers that keep the controller initialized between images.
+ *
+ * @param Dev_Info Device information returned by EPD_IT8951_Init().
+ * @param path Path to the BMP, PNG or JPEG file.
+ * @param Mode Display mode (0-3), see EPD_IT8951_ComputeConfig().
+ * @return 0 on success, negative value on error (-13 if the controller stopped responding).
+ */
+int EPD_IT8951_DrawBMP(IT8951_Dev_Info Dev_Info, const char *path, UWORD Mode);
+
+/**
+ * @brief Upload and refresh only the changed areas of the current Paint image.
+ *
+ * The areas come from the damage the Paint functions record (see
+ * Paint_GetDamage()), aligned so every row is a whole number of 16 bit words,
+ * or 32 pixels when Four_Byte_Align is set, at the depth set with
+ * EPD_IT8951_SetUploadDepth() for an 8bpp image. Each area is loaded with
+ * LD_IMG_AREA and refreshed on its own, and the damage is cleared afterwards.
+ * On error the damage is kept, so the call can be retried.
+ *
+ * @param Mode Waveform mode (e.g., GC16, DU, A2), or EPD_IT8951_MODE_AUTO to
+ *        pick one per area.
+ * @param Target_Memory_Addr Target memory address.
+ * @return Number of areas refreshed, -2 without a Paint image, -11 if out of
+ *         memory, or an EPD_IT8951_Area_Refresh() error code.
+ */
+int EPD_IT8951_RefreshDirty(UWORD Mode, UDOUBLE Target_Memory_Addr);
+
 #endif
@@ -0,0 +1,73 @@
+/**
+ * @file EPD_IT8951_AsyncTx.h
+ * @brief Optional transmit worker for IT8951 pixel streams.
+ *
+ * The caller packs (byte-swaps) pixel words into one of N staging slots while
+ * a worker thread pushes the previously filled slot through DEV_SPI_WriteBuffer().
+ * Slots are handed over through a single-producer/single-consumer ring, so
+ * packing chunk k+1 overlaps the SPI transfer of chunk k.
+ *
+ * Used internally by EPD_IT8951.c when EPD_IT8951_InitEx() is called with
+ * EPD_IT8951_INIT_ASYNC_TX.
+ */
+#ifndef __EPD_IT8951_ASYNCTX_H_
+#define __EPD_IT8951_ASYNCTX_H_
+
+#include <stdbool.h>
+#include "DEV_Config.h"
+#include "EPD_IT8951.h"
+
+/**
+ * @brief Number of staging slots in the ring.
+ */
+#ifndef EPD_IT8951_ASYNC_TX_SLOTS
+#define EPD_IT8951_ASYNC_TX_SLOTS 4
+#endif
+
+/**
+ * @brief Size of each staging slot in bytes (must be even).
+ */
+#ifndef EPD_IT8951_ASYNC_TX_SLOT_BYTES
+#define EPD_IT8951_ASYNC_TX_SLOT_BYTES 16384
+#endif
+
+/**
+ * @brief Allocate the staging slots and start the worker thread.
+ * @return 0 on success (or if already running), negative value on error.
+ */
+int EPD_IT8951_AsyncTx_Start(void);
+
+/**
+ * @brief Drain pending slots, stop the worker and free the slots.
+ */
+void EPD_IT8951_AsyncTx_Stop(void);
+
+/**
+ * @brief Check whether the worker is running.
+ * @return true if pixel streams go through the worker.
+ */
+bool EPD_IT8951_AsyncTx_Running(void);
+
+/**
+ * @brief Stream words to the SPI bus MSB first through the worker.
+ *
+ * The caller must already hold CS low and have sent the data preamble.
+ * Returns once every byte is on the wire, so CS can be released afterwards.
+ *
+ * @param Data_Buf Words to send.
+ * @param Length Number of words.
+ */
+void EPD_IT8951_AsyncTx_WriteWords(const UWORD *Data_Buf, UDOUBLE Length);
+
+/**
+ * @brief Copy the worker counters into the async fields of a stats struct.
+ * @param Stats Destination.
+ */
+void EPD_IT8951_AsyncTx_GetStats(EPD_IT8951_Stats *Stats);
+
+/**
+ * @brief Zero the worker counters.
+ */
+void EPD_IT8951_AsyncTx_ResetStats(void);
+
+#endif
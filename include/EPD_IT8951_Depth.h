@@ -0,0 +1,59 @@
+/**
+ * @file EPD_IT8951_Depth.h
+ * @brief Sending frames at the lowest bit depth that still holds their grays.
+ *
+ * A 4bpp page of black text on white uses two gray levels, so it can go over
+ * SPI as 1bpp, a quarter of the bytes: the 1bpp path shows bit 1 and bit 0
+ * as any two grays set in the BGVR register. Content with up to four levels
+ * that 2bpp can express (black, white and the two grays between, 0x55 and
+ * 0xAA, as the controller widens 2bpp pixels) is sent as 2bpp.
+ *
+ * Used internally by EPD_IT8951.c when EPD_IT8951_SetAdaptiveDepth() is enabled.
+ */
+#ifndef __EPD_IT8951_DEPTH_H_
+#define __EPD_IT8951_DEPTH_H_
+
+#include "DEV_Config.h"
+
+/**
+ * @brief How a frame can be sent.
+ */
+typedef struct EPD_IT8951_Depth_Plan {
+    UBYTE Bits_Per_Pixel;  /**< Depth to send: 1, 2, or the frame's own depth. */
+    UBYTE Levels;          /**< Distinct grays found; 5 means more than 4. */
+    UBYTE Gray[4];         /**< The grays as 8 bit values, darkest first. */
+} EPD_IT8951_Depth_Plan;
+
+/**
+ * @brief Histogram a frame and choose the depth to send it at.
+ * @param Frame Packed pixels, 0 black and all ones white; only the high
+ *              nibble of 8bpp pixels counts, as on the panel.
+ * @param W Width in pixels.
+ * @param H Height in rows.
+ * @param Bits_Per_Pixel Frame depth: 2, 4 or 8.
+ * @param Stride Bytes from one row to the next.
+ * @param Plan Receives the result.
+ * @return Plan->Bits_Per_Pixel.
+ */
+UBYTE EPD_IT8951_Depth_Analyze(const UBYTE *Frame, UWORD W, UWORD H, UBYTE Bits_Per_Pixel, UDOUBLE Stride,
+                               EPD_IT8951_Depth_Plan *Plan);
+
+/**
+ * @brief Repack a frame at the depth chosen by EPD_IT8951_Depth_Analyze().
+ *
+ * Pixels are laid out as Paint draws them, leftmost in the low bits: 8 per
+ * byte at 1bpp, with bit 1 for Plan->Gray[1] and bit 0 for Plan->Gray[0],
+ * and 4 per byte at 2bpp.
+ *
+ * @param Frame Pixels passed to EPD_IT8951_Depth_Analyze().
+ * @param W Width in pixels, a multiple of 8.
+ * @param H Height in rows.
+ * @param Bits_Per_Pixel Frame depth: 2, 4 or 8.
+ * @param Stride Bytes from one row to the next in Frame.
+ * @param Plan Plan with Bits_Per_Pixel 1 or 2.
+ * @param Out W * H * Plan->Bits_Per_Pixel / 8 bytes.
+ */
+void EPD_IT8951_Depth_Pack(const UBYTE *Frame, UWORD W, UWORD H, UBYTE Bits_Per_Pixel, UDOUBLE Stride,
+                           const EPD_IT8951_Depth_Plan *Plan, UBYTE *Out);
+
+#endif
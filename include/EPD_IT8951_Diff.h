@@ -0,0 +1,46 @@
+/**
+ * @file EPD_IT8951_Diff.h
+ * @brief Tile diff between two packed frames, for incremental uploads.
+ *
+ * Both frames are split into EPD_IT8951_DIFF_TILE x EPD_IT8951_DIFF_TILE pixel
+ * tiles and compared 8 bytes at a time. Changed tiles are joined into
+ * rectangles: runs of tiles along a tile row, then runs with the same columns
+ * in consecutive tile rows.
+ *
+ * Used internally by EPD_IT8951.c when EPD_IT8951_SetIncremental() is enabled.
+ */
+#ifndef __EPD_IT8951_DIFF_H_
+#define __EPD_IT8951_DIFF_H_
+
+#include "DEV_Config.h"
+#include "EPD_IT8951.h"
+
+/**
+ * @brief Tile side in pixels; a multiple of 16 keeps every area word aligned.
+ */
+#ifndef EPD_IT8951_DIFF_TILE
+#define EPD_IT8951_DIFF_TILE 32
+#endif
+
+/**
+ * @brief Most areas one diff produces before they are folded into their bounding box.
+ */
+#ifndef EPD_IT8951_DIFF_MAX_AREAS
+#define EPD_IT8951_DIFF_MAX_AREAS 32
+#endif
+
+/**
+ * @brief Find the areas where two frames differ.
+ * @param Old Previous frame, W x H packed pixels with rows of W * Bits_Per_Pixel / 8 bytes.
+ * @param New New frame, same layout.
+ * @param W Width in pixels; W * Bits_Per_Pixel must be a multiple of 8.
+ * @param H Height in rows.
+ * @param Bits_Per_Pixel 2, 4 or 8.
+ * @param Areas Receives the changed areas, relative to the frame.
+ * @param Max Size of Areas, at least 1.
+ * @return Number of areas, 0 if the frames are equal.
+ */
+int EPD_IT8951_Diff_Areas(const UBYTE *Old, const UBYTE *New, UWORD W, UWORD H, UBYTE Bits_Per_Pixel,
+                          IT8951_Area_Img_Info *Areas, UWORD Max);
+
+#endif
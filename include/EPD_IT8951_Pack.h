@@ -0,0 +1,86 @@
+/**
+ * @file EPD_IT8951_Pack.h
+ * @brief Converting 8bpp frames to the panel's bit depth in one pass.
+ *
+ * Paint draws 8bpp images a byte per pixel, with no read-modify-write of
+ * nibbles or bits. Such a frame is packed to 4, 2 or 1bpp right before it is
+ * sent, keeping the top 4, 2 or 1 bits of each pixel, so the result is the
+ * same bytes Paint would have drawn at that depth: leftmost pixel in the low
+ * bits, and 1bpp white for pixels of 0x80 and above.
+ *
+ * Each depth has a scalar kernel and, where the CPU has them, SSE2 and AVX2
+ * (x86) or NEON (ARM) kernels. The fastest one the CPU supports is picked on
+ * first use; EPD_IT8951_Pack_SetKernel() overrides it, e.g. for tests and
+ * benchmarks.
+ *
+ * Used by EPD_IT8951.c when EPD_IT8951_SetUploadDepth() is set below 8.
+ */
+#ifndef __EPD_IT8951_PACK_H_
+#define __EPD_IT8951_PACK_H_
+
+#include "DEV_Config.h"
+#include <stdbool.h>
+
+/**
+ * @brief Kernel sets, slowest first.
+ */
+typedef enum {
+    EPD_IT8951_PACK_SCALAR = 0,  /**< Plain C, always available. */
+    EPD_IT8951_PACK_SSE2,        /**< x86 SSE2, 16 pixels at a time. */
+    EPD_IT8951_PACK_AVX2,        /**< x86 AVX2, 32 pixels at a time. */
+    EPD_IT8951_PACK_NEON,        /**< ARM NEON, aarch64 or armv7 whose CPU reports NEON. */
+    EPD_IT8951_PACK_KERNELS,     /**< Number of kernel sets. */
+} EPD_IT8951_Pack_Kernel;
+
+/**
+ * @brief Check whether this build and CPU can run a kernel set.
+ * @param Kernel Kernel set.
+ * @return true if EPD_IT8951_Pack_SetKernel() would accept it.
+ */
+bool EPD_IT8951_Pack_Supported(EPD_IT8951_Pack_Kernel Kernel);
+
+/**
+ * @brief Use a kernel set for every later conversion.
+ * @param Kernel Kernel set.
+ * @return 0, or -2 if it is not supported here.
+ */
+int EPD_IT8951_Pack_SetKernel(EPD_IT8951_Pack_Kernel Kernel);
+
+/**
+ * @brief Get the kernel set in use; the first call picks the fastest one.
+ * @return Kernel set.
+ */
+EPD_IT8951_Pack_Kernel EPD_IT8951_Pack_GetKernel(void);
+
+/**
+ * @brief Name of a kernel set, e.g. "avx2".
+ * @param Kernel Kernel set.
+ * @return Name, or "?" for an unknown value.
+ */
+const char *EPD_IT8951_Pack_KernelName(EPD_IT8951_Pack_Kernel Kernel);
+
+/**
+ * @brief Pack one row of 8bpp pixels.
+ * @param Src Pixels, a byte each.
+ * @param Dst Receives (Pixels * Bits_Per_Pixel + 7) / 8 bytes; unused bits
+ *        of the last byte are zero.
+ * @param Pixels Pixels in the row.
+ * @param Bits_Per_Pixel 1, 2 or 4; 8 copies the row.
+ */
+void EPD_IT8951_Pack_Row(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels, UBYTE Bits_Per_Pixel);
+
+/**
+ * @brief Pack an area of an 8bpp frame.
+ * @param Src First pixel of the area.
+ * @param Src_Stride Bytes from one row of Src to the next.
+ * @param W Width in pixels.
+ * @param H Height in rows.
+ * @param Bits_Per_Pixel 1, 2, 4 or 8.
+ * @param Dst Receives H rows.
+ * @param Dst_Stride Bytes from one row of Dst to the next, at least
+ *        (W * Bits_Per_Pixel + 7) / 8.
+ */
+void EPD_IT8951_Pack_Area(const UBYTE *Src, UDOUBLE Src_Stride, UWORD W, UWORD H, UBYTE Bits_Per_Pixel,
+                          UBYTE *Dst, UDOUBLE Dst_Stride);
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @file EPD_IT8951_Policy.h
+ * @brief Ghosting-aware refresh policy: decides when a full INIT clear is due.
+ *
+ * The panel is split into a grid of regions. Each region counts the GC16-class,
+ * DU-class and A2 updates that touched it since it was last cleared with INIT.
+ * A clear is scheduled only when an update would push a region over its budget
+ * for that class, or when one was requested explicitly.
+ *
+ * Waveform classes follow the standard IT8951 mode numbers: 0 INIT, 1 DU,
+ * 2 GC16, 3 GL16, 4 GLR16, 5 GLD16, 6 A2, 7 DU4.
+ */
+#ifndef __EPD_IT8951_POLICY_H_
+#define __EPD_IT8951_POLICY_H_
+
+#include <stdbool.h>
+#include "DEV_Config.h"
+
+/**
+ * @brief Regions per panel side.
+ */
+#ifndef EPD_IT8951_POLICY_GRID
+#define EPD_IT8951_POLICY_GRID 8
+#endif
+
+/**
+ * @brief Default number of updates of each class a region takes before it is cleared.
+ */
+#define EPD_IT8951_POLICY_BUDGET_GC16 20
+#define EPD_IT8951_POLICY_BUDGET_DU   10
+#define EPD_IT8951_POLICY_BUDGET_A2   5
+
+/**
+ * @brief Default state file used by epdraw and epdrawd to carry counts between runs.
+ */
+#define EPD_IT8951_POLICY_STATE_PATH "/var/tmp/epdraw-policy"
+
+/**
+ * @brief Waveform classes tracked by the policy.
+ */
+#define EPD_IT8951_POLICY_GC16  0
+#define EPD_IT8951_POLICY_DU    1
+#define EPD_IT8951_POLICY_A2    2
+#define EPD_IT8951_POLICY_CLASSES 3
+
+/**
+ * @brief Refresh policy state.
+ */
+typedef struct EPD_IT8951_Policy {
+    UWORD Panel_W;                          /**< Panel width the grid is laid over. */
+    UWORD Panel_H;                          /**< Panel height the grid is laid over. */
+    UWORD Budget[EPD_IT8951_POLICY_CLASSES];/**< Updates per class before a clear; 0 clears before every update. */
+    UWORD Count[EPD_IT8951_POLICY_GRID][EPD_IT8951_POLICY_GRID][EPD_IT8951_POLICY_CLASSES]; /**< Updates since the last INIT, per region [y][x]. */
+    bool  Clear_Requested;                  /**< Clear before the next update regardless of the counts. */
+    UDOUBLE Updates;                        /**< Updates recorded. */
+    UDOUBLE Clears;                         /**< Full INIT clears recorded. */
+} EPD_IT8951_Policy;
+
+/**
+ * @brief Set up a policy for a panel with the default budgets.
+ *
+ * The panel state is unknown at this point, so the first update asks for a clear.
+ *
+ * @param Policy Policy to initialize.
+ * @param Panel_W Panel width.
+ * @param Panel_H Panel height.
+ */
+void EPD_IT8951_Policy_Init(EPD_IT8951_Policy *Policy, UWORD Panel_W, UWORD Panel_H);
+
+/**
+ * @brief Change the budgets.
+ * @param Policy Policy.
+ * @param GC16 Budget for GC16, GL16, GLR16 and GLD16 updates.
+ * @param DU Budget for DU and DU4 updates.
+ * @param A2 Budget for A2 updates.
+ */
+void EPD_IT8951_Policy_SetBudget(EPD_IT8951_Policy *Policy, UWORD GC16, UWORD DU, UWORD A2);
+
+/**
+ * @brief Ask for a full clear before the next update.
+ * @param Policy Policy.
+ */
+void EPD_IT8951_Policy_RequestClear(EPD_IT8951_Policy *Policy);
+
+/**
+ * @brief Check whether the panel should be cleared before an update.
+ * @param Policy Policy.
+ * @param X X coordinate of the update.
+ * @param Y Y coordinate of the update.
+ * @param W Width of the update.
+ * @param H Height of the update.
+ * @param Mode Waveform mode of the update.
+ * @return true if a full INIT clear is due first.
+ */
+bool EPD_IT8951_Policy_NeedsClear(const EPD_IT8951_Policy *Policy, UWORD X, UWORD Y, UWORD W, UWORD H, UWORD Mode);
+
+/**
+ * @brief Record an update that was sent to the panel.
+ *
+ * An INIT update resets the regions it fully covers; a full-panel INIT also
+ * drops a pending clear request.
+ *
+ * @param Policy Policy.
+ * @param X X coordinate of the update.
+ * @param Y Y coordinate of the update.
+ * @param W Width of the update.
+ * @param H Height of the update.
+ * @param Mode Waveform mode of the update.
+ */
+void EPD_IT8951_Policy_Record(EPD_IT8951_Policy *Policy, UWORD X, UWORD Y, UWORD W, UWORD H, UWORD Mode);
+
+/**
+ * @brief Load the counts saved by EPD_IT8951_Policy_Save().
+ *
+ * The budgets are kept. If the file is missing, unreadable or was written for
+ * another panel size, a clear is requested, since the panel state is unknown.
+ * A policy initialized with a 0x0 panel takes the panel size from the file.
+ *
+ * @param Policy Policy initialized for the current panel, or for 0x0.
+ * @param Path State file.
+ * @return 0 on success, negative value if a clear was requested instead.
+ */
+int EPD_IT8951_Policy_Load(EPD_IT8951_Policy *Policy, const char *Path);
+
+/**
+ * @brief Save the counts so the next process can continue from them.
+ * @param Policy Policy.
+ * @param Path State file.
+ * @return 0 on success, negative value on error.
+ */
+int EPD_IT8951_Policy_Save(const EPD_IT8951_Policy *Policy, const char *Path);
+
+#endif
@@ -0,0 +1,125 @@
+/**
+ * @file EPD_IT8951_Slots.h
+ * @brief Frames preloaded into spare IT8951 SDRAM and shown with one command.
+ *
+ * The controller memory past the panel's own image buffer is split into
+ * full-panel slots. A frame is uploaded into a slot ahead of time, typically
+ * while the application is idle, and later shown with a single DPY_BUF_AREA
+ * command instead of a full upload. When every slot is taken, the least
+ * recently used frame is evicted.
+ *
+ * Frames are identified by a caller-chosen key, such as an index into a
+ * slideshow. The controller keeps 8 bits per pixel whatever depth a frame
+ * was uploaded with, so a slot takes Panel_W * Panel_H bytes.
+ */
+#ifndef __EPD_IT8951_SLOTS_H_
+#define __EPD_IT8951_SLOTS_H_
+
+#include <stdbool.h>
+#include "EPD_IT8951.h"
+
+/**
+ * @brief End of the controller SDRAM used for slots.
+ *
+ * IT8951 boards ship with at least 8 MiB (64 Mbit); pass a larger value to
+ * EPD_IT8951_Slots_Init() if yours has more.
+ */
+#ifndef EPD_IT8951_SDRAM_END
+#define EPD_IT8951_SDRAM_END 0x00800000
+#endif
+
+/**
+ * @brief Most slots a pool manages.
+ */
+#ifndef EPD_IT8951_SLOTS_MAX
+#define EPD_IT8951_SLOTS_MAX 16
+#endif
+
+/**
+ * @brief Slot start addresses are rounded up to this many bytes.
+ */
+#define EPD_IT8951_SLOT_ALIGN 16
+
+/**
+ * @brief Error codes, in addition to the EPD_IT8951_ERR_* codes.
+ */
+#define EPD_IT8951_SLOTS_ERR_ARGS     -2   /**< Bad arguments, same as EPD_IT8951_Area_Load(). */
+#define EPD_IT8951_SLOTS_ERR_NO_ROOM  -3   /**< Not even one slot fits in the SDRAM. */
+#define EPD_IT8951_SLOTS_ERR_MISSING  -4   /**< The frame is not preloaded. */
+
+/**
+ * @brief One frame-sized region of controller memory.
+ */
+typedef struct EPD_IT8951_Slot {
+    UDOUBLE Addr;       /**< Image buffer address in the controller. */
+    UDOUBLE Key;        /**< Frame held by the slot. */
+    bool    Valid;      /**< The slot holds a frame. */
+    uint64_t Last_Used; /**< Pool clock at the last preload or show. */
+} EPD_IT8951_Slot;
+
+/**
+ * @brief Slot pool state.
+ */
+typedef struct EPD_IT8951_Slots {
+    UWORD Panel_W;                            /**< Panel width; every frame covers the panel. */
+    UWORD Panel_H;                            /**< Panel height. */
+    UDOUBLE Slot_Bytes;                       /**< Controller memory per slot, including alignment. */
+    UWORD Count;                              /**< Slots available. */
+    EPD_IT8951_Slot Slot[EPD_IT8951_SLOTS_MAX];
+    uint64_t Clock;                           /**< Incremented on every preload and show. */
+    uint64_t Preloads;                        /**< Frames uploaded into a slot. */
+    uint64_t Hits;                            /**< Shows answered from a slot. */
+    uint64_t Misses;                          /**< Shows of frames that were not preloaded. */
+    uint64_t Evictions;                       /**< Frames dropped to make room for another. */
+} EPD_IT8951_Slots;
+
+/**
+ * @brief Lay out slots between the panel's image buffer and the end of SDRAM.
+ * @param Slots Pool to initialize.
+ * @param Dev_Info Device information from EPD_IT8951_Init().
+ * @param Memory_End First address past the usable SDRAM, e.g. EPD_IT8951_SDRAM_END.
+ * @return Number of slots, or EPD_IT8951_SLOTS_ERR_NO_ROOM.
+ */
+int EPD_IT8951_Slots_Init(EPD_IT8951_Slots *Slots, IT8951_Dev_Info Dev_Info, UDOUBLE Memory_End);
+
+/**
+ * @brief Upload a full-panel frame into a slot without refreshing the panel.
+ *
+ * A frame that is already preloaded is overwritten in place. Otherwise a free
+ * slot is used, or the least recently used frame is evicted.
+ *
+ * @param Slots Pool.
+ * @param Key Frame identifier.
+ * @param Frame_Buf Panel_W x Panel_H packed pixels, or Panel_H x Panel_W while
+ *        EPD_IT8951_SetRotate() is set to 90 or 270 degrees.
+ * @param Bits_Per_Pixel 2, 4 or 8.
+ * @return Slot index on success, or a negative error code.
+ */
+int EPD_IT8951_Slots_Preload(EPD_IT8951_Slots *Slots, UDOUBLE Key, UBYTE *Frame_Buf, UBYTE Bits_Per_Pixel);
+
+/**
+ * @brief Show a preloaded frame with one DPY_BUF_AREA command.
+ * @param Slots Pool.
+ * @param Key Frame identifier.
+ * @param Mode Waveform mode (e.g., GC16, DU, A2).
+ * @return 0 on success, EPD_IT8951_SLOTS_ERR_MISSING if the frame is not
+ *         preloaded, or an EPD_IT8951_ERR_* code.
+ */
+int EPD_IT8951_Slots_Show(EPD_IT8951_Slots *Slots, UDOUBLE Key, UWORD Mode);
+
+/**
+ * @brief Find the slot holding a frame.
+ * @param Slots Pool.
+ * @param Key Frame identifier.
+ * @return Slot index, or -1 if the frame is not preloaded.
+ */
+int EPD_IT8951_Slots_Find(const EPD_IT8951_Slots *Slots, UDOUBLE Key);
+
+/**
+ * @brief Forget a frame, e.g. after its source changed.
+ * @param Slots Pool.
+ * @param Key Frame identifier.
+ */
+void EPD_IT8951_Slots_Drop(EPD_IT8951_Slots *Slots, UDOUBLE Key);
+
+#endif
@@ -0,0 +1,99 @@
+/**
+ * @file EPD_IT8951_Waveform.h
+ * @brief Waveform mode table per panel, and picking the fastest correct mode
+ *        for an update.
+ *
+ * The mode numbers behind INIT, DU, GC16, GL16, A2 and the rest depend on
+ * the waveform LUT flashed with the panel; EPD_IT8951_Init() picks the table
+ * from the LUT version the controller reports.
+ *
+ * The classifier compares the old and new pixels of an area:
+ *   - A2 when every changed pixel goes from black or white to black or white,
+ *   - DU when every changed pixel ends black or white,
+ *   - GL16 when the new area is mostly white, i.e. text on a white page,
+ *   - GC16 otherwise.
+ */
+#ifndef __EPD_IT8951_WAVEFORM_H_
+#define __EPD_IT8951_WAVEFORM_H_
+
+#include "EPD_IT8951.h"
+
+/**
+ * @brief Share of white pixels, in percent, above which gray content is
+ *        refreshed with GL16 instead of GC16.
+ */
+#ifndef EPD_IT8951_WAVE_TEXT_WHITE_PCT
+#define EPD_IT8951_WAVE_TEXT_WHITE_PCT 70
+#endif
+
+/**
+ * @brief Mode numbers of one waveform LUT.
+ *
+ * LUTs without GLR16, GLD16 or DU4 map them to the nearest mode they have.
+ */
+typedef struct EPD_IT8951_Mode_Table {
+    UBYTE Init;   /**< Full clear, slow and flashing. */
+    UBYTE DU;     /**< Any gray to black or white, no flash. */
+    UBYTE GC16;   /**< 16 grays, flashing; always correct. */
+    UBYTE GL16;   /**< 16 grays, white pixels are not driven. */
+    UBYTE GLR16;  /**< GL16 with ghost reduction. */
+    UBYTE GLD16;  /**< GL16 with ghost reduction, dithered. */
+    UBYTE A2;     /**< Black or white to black or white, fastest. */
+    UBYTE DU4;    /**< 4 grays, no flash. */
+} EPD_IT8951_Mode_Table;
+
+/**
+ * @brief Waveform classes the classifier picks from, fastest first.
+ */
+typedef enum {
+    EPD_IT8951_WAVE_NONE = 0,  /**< No pixel changed; nothing to refresh. */
+    EPD_IT8951_WAVE_A2,
+    EPD_IT8951_WAVE_DU,
+    EPD_IT8951_WAVE_GL16,
+    EPD_IT8951_WAVE_GC16,
+} EPD_IT8951_Wave;
+
+/**
+ * @brief Pick the mode table matching the panel's LUT version.
+ *
+ * Called by EPD_IT8951_Init(). Also updates the INIT_Mode, GC16_Mode and
+ * A2_Mode globals kept for older code.
+ *
+ * @param Dev_Info Device information read from the controller.
+ */
+void EPD_IT8951_Waveform_SelectTable(const IT8951_Dev_Info *Dev_Info);
+
+/**
+ * @brief Get the current mode table.
+ * @return Table in use, never NULL.
+ */
+const EPD_IT8951_Mode_Table *EPD_IT8951_GetModeTable(void);
+
+/**
+ * @brief Replace the mode table, e.g. for a LUT this driver does not know.
+ * @param Table Mode numbers to use; copied.
+ */
+void EPD_IT8951_SetModeTable(const EPD_IT8951_Mode_Table *Table);
+
+/**
+ * @brief Find the fastest waveform class that shows New correctly over Old.
+ * @param Old Pixels on the panel, or NULL if unknown; A2 needs them.
+ * @param New Pixels to show.
+ * @param W Width in pixels.
+ * @param H Height in rows.
+ * @param Bits_Per_Pixel 2, 4 or 8; 0 is black and all ones is white, at 8bpp
+ *        only the high nibble counts.
+ * @param Stride Bytes from one row to the next in both buffers.
+ * @return Waveform class.
+ */
+EPD_IT8951_Wave EPD_IT8951_Waveform_Classify(const UBYTE *Old, const UBYTE *New, UWORD W, UWORD H,
+                                             UBYTE Bits_Per_Pixel, UDOUBLE Stride);
+
+/**
+ * @brief Mode number of a waveform class in the current table.
+ * @param Wave Waveform class; EPD_IT8951_WAVE_NONE gives the DU mode.
+ * @return Mode number for the display commands.
+ */
+UWORD EPD_IT8951_Waveform_Mode(EPD_IT8951_Wave Wave);
+
+#endif
@@ -17,6 +17,7 @@
 #include <stdint.h>
 
 #include "DEV_Config.h"
+#include "GUI_Dither.h"
 
 extern UBYTE *bmp_dst_buf;
 extern UBYTE *bmp_src_buf;
@@ -76,4 +77,29 @@ typedef struct
  */
 int GUI_ReadBmp(const char *path, UWORD x, UWORD y);
 
+/**
+ * @brief Dither images to the Paint image's depth as GUI_ReadBmp() draws them.
+ *
+ * Each row is converted to gray and dithered in memory before it is drawn,
+ * to 2, 4 or 16 levels at 1, 2 or 4bpp and to 16 at 8bpp. Without dithering
+ * (the default) Paint keeps the top bits of each gray. When isColor is set,
+ * error diffusion falls back to Bayer.
+ *
+ * @param Mode Method.
+ * @return 0, or -2 for an unknown method.
+ */
+int GUI_SetBmpDither(DITHER_MODE Mode);
+
+/**
+ * @brief Draw 8 bit grays on the Paint image the way GUI_ReadBmp() draws a
+ *        BMP, with the same dithering; used for decoded PNG and JPEG files.
+ *
+ * @param Xpos X coordinate of the top left corner.
+ * @param Ypos Y coordinate of the top left corner.
+ * @param Width Pixels per row.
+ * @param High Rows.
+ * @param Gray Width x High grays, row by row, 0 black.
+ */
+void GUI_DrawGray(UWORD Xpos, UWORD Ypos, UWORD Width, UWORD High, const UBYTE *Gray);
+
 #endif
@@ -0,0 +1,95 @@
+/**
+ * @file GUI_Dither.h
+ * @brief Quantizing 8 bit gray rows to the 2, 4 or 16 levels of 1, 2 and
+ *        4bpp, with ordered or error diffusion dithering.
+ *
+ * Rows are dithered one at a time, top to bottom, in place: each pixel is
+ * replaced by the level it is shown as, still as an 8 bit gray (0x00, 0x11
+ * ... 0xFF at 4bpp, 0x00, 0x55, 0xAA, 0xFF at 2bpp, 0x00 and 0xFF at 1bpp).
+ * That is the value Paint_BlitRow() and the packing at upload time keep
+ * exactly, so no further rounding happens on the way to the panel.
+ *
+ *   - Bayer: an 8x8 ordered threshold pattern. Each pixel depends only on
+ *     its value and position, so areas can be dithered separately without
+ *     seams and the loop vectorizes; suited to A2 and animation.
+ *   - Floyd-Steinberg: spreads all of each pixel's error to its right and
+ *     lower neighbors; the smoothest gradients.
+ *   - Atkinson: spreads 6/8 of the error over two rows below; more contrast,
+ *     as on line art and text.
+ *
+ * Error diffusion keeps two rows of error, the next two rows', whatever the
+ * image height.
+ */
+#ifndef __GUI_DITHER_H
+#define __GUI_DITHER_H
+
+#include "DEV_Config.h"
+#include <stdint.h>
+
+/**
+ * @brief Error codes.
+ */
+#define DITHER_ERR_MEMORY  -1   /**< No memory for the error rows. */
+#define DITHER_ERR_ARGS    -2   /**< Unknown mode or depth, or zero width. */
+
+/**
+ * @brief Dithering methods.
+ */
+typedef enum {
+    DITHER_NONE = 0,            /**< Round each pixel to the nearest level. */
+    DITHER_BAYER,               /**< 8x8 ordered dither. */
+    DITHER_FLOYD_STEINBERG,     /**< Floyd-Steinberg error diffusion. */
+    DITHER_ATKINSON,            /**< Atkinson error diffusion. */
+    DITHER_MODES,               /**< Number of methods. */
+} DITHER_MODE;
+
+/**
+ * @brief Dither state for one image.
+ */
+typedef struct {
+    DITHER_MODE Mode;       /**< Method. */
+    UBYTE Bits_Per_Pixel;   /**< Output depth: 1, 2 or 4. */
+    UWORD Width;            /**< Pixels per row. */
+    int16_t *Error[2];      /**< Error carried into the next two rows, with 2 pixels of margin each side. */
+} DITHER;
+
+/**
+ * @brief Set up dithering for an image.
+ * @param Dither State to initialize.
+ * @param Mode Method.
+ * @param Bits_Per_Pixel Output depth: 1, 2 or 4; 8 is taken as 4, the 16
+ *        grays an 8bpp Paint image holds.
+ * @param Width Pixels per row.
+ * @return 0, DITHER_ERR_MEMORY or DITHER_ERR_ARGS.
+ */
+int Dither_Init(DITHER *Dither, DITHER_MODE Mode, UBYTE Bits_Per_Pixel, UWORD Width);
+
+/**
+ * @brief Free the error rows.
+ */
+void Dither_Release(DITHER *Dither);
+
+/**
+ * @brief Forget the error carried so far, to start another image.
+ */
+void Dither_Reset(DITHER *Dither);
+
+/**
+ * @brief Dither the next row of the image in place.
+ * @param Dither State from Dither_Init().
+ * @param Row Width 8 bit grays, 0 black; replaced by the levels shown.
+ * @param X Image position of the row's first pixel; places the Bayer pattern.
+ * @param Y Image row; places the Bayer pattern.
+ */
+void Dither_Row(DITHER *Dither, UBYTE *Row, UWORD X, UWORD Y);
+
+/**
+ * @brief Parse a method name: "none", "bayer", "floyd-steinberg" (or "fs")
+ *        or "atkinson".
+ * @param Name Name to parse.
+ * @param Mode Receives the method.
+ * @return 0, or DITHER_ERR_ARGS for an unknown name.
+ */
+int Dither_ParseMode(const char *Name, DITHER_MODE *Mode);
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file GUI_Image.h
+ * @brief PNG and baseline JPEG decoding to 8 bit gray, in process.
+ *
+ * Images are decoded straight to one gray byte per pixel, 0 black, with the
+ * same weights GUI_ReadBmp() uses for color. Nothing outside this library
+ * is needed:
+ *
+ *   - PNG: every color type and bit depth, with transparency over white.
+ *     Interlaced images are not decoded.
+ *   - JPEG: baseline and extended Huffman, gray or YCbCr with any chroma
+ *     sampling. Only the luma is decoded, which is the gray; the chroma is
+ *     skipped. Progressive, arithmetic, lossless, 12 bit, CMYK and RGB
+ *     JPEGs, and those with their components in separate scans, are not
+ *     decoded.
+ *
+ * Whatever is not decoded is reported as GUI_IMAGE_ERR_FORMAT, so callers can
+ * hand those files to another converter.
+ */
+#ifndef __GUI_IMAGE_H
+#define __GUI_IMAGE_H
+
+#include "DEV_Config.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Error codes; -1 and -5 mean the same as for GUI_ReadBmp().
+ */
+#define GUI_IMAGE_ERR_OPEN    -1   /**< File not found or not readable. */
+#define GUI_IMAGE_ERR_FORMAT  -3   /**< Not a BMP, PNG or JPEG file, or a kind of PNG or JPEG not decoded here. */
+#define GUI_IMAGE_ERR_MEMORY  -5   /**< Out of memory, or the image is too large. */
+#define GUI_IMAGE_ERR_DECODE  -7   /**< Damaged or truncated data. */
+
+/**
+ * @brief File formats, told apart by their first bytes.
+ */
+typedef enum {
+    GUI_IMAGE_UNKNOWN = 0,
+    GUI_IMAGE_BMP,
+    GUI_IMAGE_PNG,
+    GUI_IMAGE_JPEG,
+} GUI_IMAGE_FORMAT;
+
+/**
+ * @brief A decoded image.
+ */
+typedef struct {
+    UWORD Width;    /**< Pixels per row. */
+    UWORD Height;   /**< Rows. */
+    UBYTE *Gray;    /**< Width x Height grays, row by row, 0 black; free with GUI_FreeImage(). */
+} GUI_IMAGE;
+
+/**
+ * @brief Tell the format of a file from its first bytes.
+ * @param Data First bytes of the file; 8 are enough.
+ * @param Len Bytes in Data.
+ * @return Format, GUI_IMAGE_UNKNOWN if none of these.
+ */
+GUI_IMAGE_FORMAT GUI_ImageFormat(const UBYTE *Data, size_t Len);
+
+/**
+ * @brief Check whether a file can be drawn by GUI_ReadImage() without
+ *        decoding it: a BMP, or a PNG or JPEG of a kind decoded here.
+ *
+ * Only the headers are read, up to the JPEG frame header.
+ *
+ * @param Path File to check.
+ * @return 0, GUI_IMAGE_ERR_OPEN, GUI_IMAGE_ERR_FORMAT or GUI_IMAGE_ERR_DECODE.
+ */
+int GUI_CheckImage(const char *Path);
+
+/**
+ * @brief Decode a PNG file held in memory.
+ * @param Data The whole file.
+ * @param Len Bytes in Data.
+ * @param Image Receives the image.
+ * @return 0, GUI_IMAGE_ERR_FORMAT, GUI_IMAGE_ERR_MEMORY or GUI_IMAGE_ERR_DECODE.
+ */
+int GUI_DecodePNG(const UBYTE *Data, size_t Len, GUI_IMAGE *Image);
+
+/**
+ * @brief Decode a JPEG file held in memory.
+ *
+ * A file that ends early decodes with the blocks past the end middle gray,
+ * as libjpeg shows it.
+ *
+ * @param Data The whole file.
+ * @param Len Bytes in Data.
+ * @param Image Receives the image.
+ * @return 0, GUI_IMAGE_ERR_FORMAT, GUI_IMAGE_ERR_MEMORY or GUI_IMAGE_ERR_DECODE.
+ */
+int GUI_DecodeJPEG(const UBYTE *Data, size_t Len, GUI_IMAGE *Image);
+
+/**
+ * @brief Read and decode a PNG or JPEG file.
+ * @param Path File to read.
+ * @param Image Receives the image.
+ * @return 0 or a GUI_IMAGE_ERR_* code; a BMP is GUI_IMAGE_ERR_FORMAT.
+ */
+int GUI_LoadImage(const char *Path, GUI_IMAGE *Image);
+
+/**
+ * @brief Rotate, then mirror, an image in memory.
+ * @param Image Image to change.
+ * @param Rotation Degrees clockwise, a multiple of 90; negative turns the other way.
+ * @param Mirror true to mirror left to right after rotating.
+ * @return 0, -2 for another rotation, or GUI_IMAGE_ERR_MEMORY.
+ */
+int GUI_TransformImage(GUI_IMAGE *Image, int Rotation, bool Mirror);
+
+/**
+ * @brief Free a decoded image.
+ */
+void GUI_FreeImage(GUI_IMAGE *Image);
+
+/**
+ * @brief Set how GUI_ReadImage() rotates and mirrors PNG and JPEG files.
+ * @param Rotation Degrees clockwise, a multiple of 90 (default 0).
+ * @param Mirror true to mirror left to right after rotating (default false).
+ * @return 0, or -2 for another rotation.
+ */
+int GUI_SetImageTransform(int Rotation, bool Mirror);
+
+/**
+ * @brief Read and draw a BMP, PNG or JPEG file on the Paint image.
+ *
+ * BMP files go to GUI_ReadBmp() as they are. PNG and JPEG files are decoded,
+ * rotated and mirrored as set with GUI_SetImageTransform(), and drawn as
+ * GUI_ReadBmp() draws, with the dithering set by GUI_SetBmpDither().
+ *
+ * @param Path File to draw.
+ * @param X X coordinate of the image's top left corner.
+ * @param Y Y coordinate of the image's top left corner.
+ * @return 0, a GUI_ReadBmp() error for a BMP, or a GUI_IMAGE_ERR_* code.
+ */
+int GUI_ReadImage(const char *Path, UWORD X, UWORD Y);
+
+#endif
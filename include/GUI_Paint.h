@@ -12,13 +12,102 @@
 #ifndef __GUI_PAINT_H
 #define __GUI_PAINT_H
 
+#include <stdbool.h>
 #include "DEV_Config.h"
 #include "fonts.h"
 
 /**
- * @brief Image buffer attributes and drawing context.
+ * @brief Most damaged areas tracked before they are folded together.
+ */
+#ifndef PAINT_DAMAGE_MAX
+#define PAINT_DAMAGE_MAX 8
+#endif
+
+/**
+ * @brief Fixed cost of one more damaged area, in pixels.
+ *
+ * Each area is a separate upload and refresh, so two areas are merged into
+ * their bounding box whenever the box has fewer pixels than both areas plus
+ * this cost.
+ */
+#ifndef PAINT_DAMAGE_AREA_COST
+#define PAINT_DAMAGE_AREA_COST 16384
+#endif
+
+/**
+ * @brief Default memory limit of the glyph cache, in bytes.
+ *
+ * Enough for every ASCII glyph of Font24 in two colors at 8bpp with room
+ * to spare; Paint_SetGlyphCache() changes it at run time.
+ */
+#ifndef PAINT_GLYPH_CACHE_BYTES
+#define PAINT_GLYPH_CACHE_BYTES (256 * 1024)
+#endif
+
+/**
+ * @brief Chinese fonts whose lookup index is kept; Paint_DrawString_CN()
+ *        builds the index of a font the first time it draws with it.
+ */
+#ifndef PAINT_CN_INDEX_MAX
+#define PAINT_CN_INDEX_MAX 4
+#endif
+
+/**
+ * @brief Largest radius of an ellipse or rounded corner; larger ones are clamped.
+ */
+#define PAINT_SHAPE_RADIUS_MAX 0x7FFF
+
+/**
+ * @brief Rectangle in image memory coordinates.
+ */
+typedef struct {
+    UWORD X;    /**< Left column. */
+    UWORD Y;    /**< Top row. */
+    UWORD W;    /**< Width in pixels. */
+    UWORD H;    /**< Height in rows. */
+} PAINT_RECT;
+
+/**
+ * @brief Areas of the image changed since the damage was last cleared.
  */
 typedef struct {
+    PAINT_RECT Rect[PAINT_DAMAGE_MAX]; /**< Disjoint damaged areas. */
+    UWORD Count;                       /**< Areas in use. */
+    UWORD Depth;                       /**< Nesting of Paint_BeginDamage() calls. */
+    bool  Pending;                     /**< Pixels set since the last area was recorded. */
+    UWORD Pending_X0, Pending_Y0;      /**< Bounding box of those pixels, inclusive. */
+    UWORD Pending_X1, Pending_Y1;
+} PAINT_DAMAGE;
+
+/**
+ * @brief Glyph cache counters, from Paint_GetGlyphStats().
+ */
+typedef struct {
+    uint64_t Hits;          /**< Characters drawn from a cached glyph. */
+    uint64_t Misses;        /**< Characters whose glyph had to be rendered. */
+    uint64_t Evictions;     /**< Glyphs dropped to stay within the limit. */
+    UDOUBLE Glyphs;         /**< Glyphs cached now. */
+    UDOUBLE Bytes;          /**< Memory they use. */
+    UDOUBLE Max_Bytes;      /**< Memory limit, 0 when the cache is off. */
+} PAINT_GLYPH_STATS;
+
+/**
+ * @brief Drawing calls recorded for replay, see Paint_Ctx_Record().
+ */
+typedef struct PAINT_BATCH {
+    struct PAINT_OP *Ops;   /**< Recorded calls. */
+    UDOUBLE Count;          /**< Calls recorded. */
+    UDOUBLE Capacity;       /**< Calls that fit in Ops. */
+    UBYTE *Data;            /**< Strings and rows the calls draw. */
+    UDOUBLE Data_Len;       /**< Bytes used in Data. */
+    UDOUBLE Data_Capacity;  /**< Bytes that fit in Data. */
+    bool Failed;            /**< A call was dropped for lack of memory. */
+} PAINT_BATCH;
+
+/**
+ * @brief Image buffer attributes and drawing context.
+ */
+typedef struct PAINT {
     UBYTE *Image;           /**< Pointer to image buffer. */
     UWORD Width;            /**< Width of the drawing area. */
     UWORD Height;           /**< Height of the drawing area. */
@@ -31,7 +120,21 @@ typedef struct {
     UWORD HeightByte;       /**< Bytes per column. */
     UWORD BitsPerPixel;     /**< Bits per pixel. */
     UWORD GrayScale;        /**< Number of grayscale levels. */
+    PAINT_DAMAGE Damage;    /**< Areas changed since the last refresh. */
+    PAINT_RECT Clip;        /**< Area of image memory drawing is limited to. */
+    UBYTE IsColor;          /**< Points go through Paint_SetColor(); Paint follows isColor. */
+    struct PAINT_GLYPH_CACHE *Glyphs; /**< Glyph cache, created on first use. */
+    PAINT_BATCH *Batch;     /**< Batch the drawing calls are recorded into, or NULL. */
 } PAINT;
+
+/**
+ * @brief A drawing context.
+ *
+ * Paint is the context of the Paint_* functions. Other contexts are set up
+ * with Paint_Ctx_Init() and drawn into with the Paint_Ctx_* functions, so
+ * several threads can draw at once, each into its own context.
+ */
+typedef PAINT Paint_Ctx;
 extern PAINT Paint;
 
 /**
@@ -92,8 +195,17 @@ typedef enum {
 typedef enum {
     LINE_STYLE_SOLID = 0,    /**< Solid line. */
     LINE_STYLE_DOTTED,       /**< Dotted line. */
+    LINE_STYLE_DASHED,       /**< Dashed line; gaps are left as they were. */
 } LINE_STYLE;
 
+/**
+ * @brief Line end options for Paint_DrawThickLine().
+ */
+typedef enum {
+    LINE_CAP_BUTT = 0,       /**< End at the end points. */
+    LINE_CAP_SQUARE,         /**< Reach half the line width past the end points. */
+} LINE_CAP;
+
 /**
  * @brief Rectangle/circle fill options.
  */
@@ -157,6 +269,36 @@ void Paint_SetBitsPerPixel(UBYTE bpp);
  */
 void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color);
 
+/**
+ * @brief Fill a run of pixels of one row.
+ *
+ * Same result as Paint_SetPixel() on each pixel, but the rotation and mirror
+ * are applied once and whole bytes are written between masked edge bytes.
+ * The run is clipped to the image.
+ *
+ * @param Xpoint X coordinate of the first pixel.
+ * @param Ypoint Y coordinate of the row.
+ * @param Len Number of pixels.
+ * @param Color Color value.
+ */
+void Paint_FillSpan(UWORD Xpoint, UWORD Ypoint, UWORD Len, UWORD Color);
+
+/**
+ * @brief Copy a row of pixels into the image.
+ *
+ * Same result as Paint_SetPixel() on each pixel, with the source gray
+ * levels quantized to the image depth. Rows of the image's own depth are
+ * copied a byte at a time when the row starts on a byte boundary of image
+ * memory. The row is clipped to the image.
+ *
+ * @param Xpoint X coordinate of the first pixel.
+ * @param Ypoint Y coordinate of the row.
+ * @param Src Pixels, packed like the image: leftmost in the low bits of a byte.
+ * @param Len Number of pixels.
+ * @param Src_Bpp Bits per pixel of Src (1, 2, 4, or 8).
+ */
+void Paint_BlitRow(UWORD Xpoint, UWORD Ypoint, const UBYTE *Src, UWORD Len, UBYTE Src_Bpp);
+
 /**
  * @brief Clear the entire image buffer to a color.
  * @param Color Color value to fill.
@@ -195,6 +337,26 @@ void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color, DOT_PIXEL Dot_Pixe
  */
 void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style);
 
+/**
+ * @brief Draw a line of any width as the rectangle around it.
+ *
+ * The line is Line_width pixels across, centered on the segment between the
+ * centers of the end pixels, and drawn as one span per row, so every pixel
+ * is written once. With LINE_CAP_SQUARE a 1 pixel line covers both end
+ * pixels. Dotted lines are dashes and gaps of Line_width pixels, dashed
+ * lines are dashes of 3 and gaps of 2 times Line_width. Gaps are not drawn.
+ *
+ * @param Xstart Starting X coordinate.
+ * @param Ystart Starting Y coordinate.
+ * @param Xend Ending X coordinate.
+ * @param Yend Ending Y coordinate.
+ * @param Color Color value.
+ * @param Line_width Line width, in pixels.
+ * @param Cap End style (butt/square).
+ * @param Line_Style Line style (solid/dotted/dashed).
+ */
+void Paint_DrawThickLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, UWORD Line_width, LINE_CAP Cap, LINE_STYLE Line_Style);
+
 /**
  * @brief Draw a rectangle.
  * @param Xstart Starting X coordinate.
@@ -218,6 +380,42 @@ void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWO
  */
 void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
 
+/**
+ * @brief Draw an ellipse.
+ *
+ * The ellipse covers the pixels whose centers lie within X_Radius + 1/2 and
+ * Y_Radius + 1/2 of the center pixel. It is drawn as one span per row, so
+ * every pixel is written once.
+ *
+ * @param X_Center Center X coordinate.
+ * @param Y_Center Center Y coordinate.
+ * @param X_Radius Horizontal radius.
+ * @param Y_Radius Vertical radius.
+ * @param Color Color value.
+ * @param Line_width Thickness of the outline, in pixels.
+ * @param Draw_Fill Fill style (empty/full).
+ */
+void Paint_DrawEllipse(UWORD X_Center, UWORD Y_Center, UWORD X_Radius, UWORD Y_Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+
+/**
+ * @brief Draw a rectangle with rounded corners.
+ *
+ * Covers the pixels from Xstart to Xend - 1 and Ystart to Yend - 1, like
+ * Paint_ClearWindows(). Each corner is a quarter circle, shrunk to fit
+ * when Radius is more than half the width or height. It is drawn as one or
+ * two spans per row, so every pixel is written once.
+ *
+ * @param Xstart Left column.
+ * @param Ystart Top row.
+ * @param Xend Right column (exclusive).
+ * @param Yend Bottom row (exclusive).
+ * @param Radius Corner radius, 0 for square corners.
+ * @param Color Color value.
+ * @param Line_width Thickness of the outline, in pixels.
+ * @param Draw_Fill Fill style (empty/full).
+ */
+void Paint_DrawRoundedRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+
 /**
  * @brief Draw a single ASCII character.
  * @param Xstart X coordinate.
@@ -229,6 +427,31 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius, UWORD Color,
  */
 void Paint_DrawChar(UWORD Xstart, UWORD Ystart, const char Acsii_Char, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
 
+/**
+ * @brief Set the memory limit of the glyph cache.
+ *
+ * Paint_DrawChar() and Paint_DrawString_CN() render each glyph once per
+ * font, colors, bit depth, rotation and mirror into the layout of image
+ * memory, then copy it a byte at a time under a mask of its drawn pixels. The least recently used
+ * glyphs are dropped to stay within the limit. Characters that do not fit
+ * wholly on the image are drawn a pixel at a time.
+ *
+ * @param Max_Bytes Memory limit; 0 turns the cache off. The default is
+ *        PAINT_GLYPH_CACHE_BYTES.
+ */
+void Paint_SetGlyphCache(UDOUBLE Max_Bytes);
+
+/**
+ * @brief Drop every cached glyph, keeping the counters.
+ */
+void Paint_FlushGlyphCache(void);
+
+/**
+ * @brief Get the glyph cache counters.
+ * @param Stats Receives the counters.
+ */
+void Paint_GetGlyphStats(PAINT_GLYPH_STATS *Stats);
+
 /**
  * @brief Draw an ASCII string.
  * @param Xstart X coordinate.
@@ -242,6 +465,11 @@ void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString, sFONT
 
 /**
  * @brief Draw a string with Chinese (GB2312) and ASCII characters.
+ *
+ * Characters are looked up in an index of the font table built on first use,
+ * and bytes above 0x7F are read as GB2312 whether or not char is signed.
+ * Characters missing from the font leave their cell untouched.
+ *
  * @param Xstart X coordinate.
  * @param Ystart Y coordinate.
  * @param pString Pointer to string.
@@ -273,6 +501,131 @@ void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT* Font, UWO
  */
 void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
 
+/**
+ * @brief Group drawing into one damaged area.
+ *
+ * Pixels set until the matching Paint_EndDamage() are recorded as their
+ * bounding box. The drawing functions do this themselves; calls may nest.
+ */
+void Paint_BeginDamage(void);
+
+/**
+ * @brief End a group started with Paint_BeginDamage() and record its area.
+ */
+void Paint_EndDamage(void);
+
+/**
+ * @brief Mark an area as changed.
+ * @param Xstart X starting point.
+ * @param Ystart Y starting point.
+ * @param Xend X end point (exclusive).
+ * @param Yend Y end point (exclusive).
+ */
+void Paint_AddDamage(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend);
+
+/**
+ * @brief Get the damaged areas in image memory coordinates.
+ *
+ * Each area is widened so its left edge and width are multiples of Align
+ * pixels, clipped to the image, and areas that then overlap are merged.
+ *
+ * @param Rects Receives the areas.
+ * @param Max Size of Rects; at least PAINT_DAMAGE_MAX to get every area.
+ * @param Align Pixel alignment of X and W, 1 for none.
+ * @return Number of areas written to Rects.
+ */
+UWORD Paint_GetDamage(PAINT_RECT *Rects, UWORD Max, UWORD Align);
+
+/**
+ * @brief Forget all damage, e.g. after the areas were refreshed.
+ */
+void Paint_ClearDamage(void);
+
+/**
+ * @brief Mark an area of image memory as changed.
+ *
+ * Unlike Paint_AddDamage() the area is not rotated or mirrored, so damage
+ * read from one context with Paint_GetDamage() can be added to another.
+ *
+ * @param Rect Area in image memory coordinates.
+ */
+void Paint_AddDamageRect(const PAINT_RECT *Rect);
+
+/**
+ * @brief Limit drawing to an area.
+ *
+ * Pixels outside the area are left alone by every drawing function, and
+ * damage outside it is not recorded. NewImage resets the clip to the whole
+ * image.
+ *
+ * @param Xstart X starting point.
+ * @param Ystart Y starting point.
+ * @param Xend X end point (exclusive).
+ * @param Yend Y end point (exclusive).
+ */
+void Paint_SetClip(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend);
+
+/**
+ * @brief Draw on the whole image again.
+ */
+void Paint_ClearClip(void);
+
+/**
+ * @brief Record drawing calls into a batch instead of drawing them.
+ *
+ * The drawing functions, from Paint_SetPixel() to Paint_DrawTime() and
+ * Paint_SetColor(), are recorded with copies of their strings and rows;
+ * settings, damage and the glyph cache calls still take effect at once. A
+ * batch is drawn with the settings of the context it is replayed into, so
+ * it can be replayed into several contexts, e.g. by Paint_Bands_Render().
+ *
+ * @param Batch Batch to add the calls to, or NULL to draw again.
+ */
+void Paint_Record(PAINT_BATCH *Batch);
+
+/**
+ * @brief Draw the calls recorded in a batch, in order.
+ * @param Batch Batch from Paint_Record().
+ */
+void Paint_Replay(const PAINT_BATCH *Batch);
+
+/**
+ * @brief Set up an empty batch.
+ */
+void Paint_Batch_Init(PAINT_BATCH *Batch);
+
+/**
+ * @brief Forget the recorded calls, keeping their memory for the next ones.
+ */
+void Paint_Batch_Reset(PAINT_BATCH *Batch);
+
+/**
+ * @brief Free the memory of a batch.
+ */
+void Paint_Batch_Release(PAINT_BATCH *Batch);
+
+/**
+ * @brief Check whether two batches make the same calls with the same
+ *        arguments, strings and rows.
+ * @return false as well if either batch lost calls for lack of memory.
+ */
+bool Paint_Batch_Equal(const PAINT_BATCH *A, const PAINT_BATCH *B);
+
+/**
+ * @brief Get the area of image memory a batch can draw on.
+ *
+ * The area is worked out from the arguments of each call with the context's
+ * current settings, without drawing. It may be larger than the pixels
+ * actually drawn, never smaller: a string that wraps counts as reaching the
+ * right and bottom edges, and Paint_Clear() as the whole image.
+ *
+ * @param Ctx Context the batch would be replayed into.
+ * @param Batch Recorded calls.
+ * @param Rect Receives the area in image memory coordinates.
+ * @return false if the batch draws nothing on the image.
+ */
+bool Paint_Ctx_BatchBounds(Paint_Ctx *Ctx, const PAINT_BATCH *Batch, PAINT_RECT *Rect);
+
 /**
  * @brief Set a 3x3 color block at the specified location (for color e-Paper).
  * @param x X coordinate.
@@ -288,6 +641,64 @@ void Paint_SetColor(UWORD x, UWORD y, UWORD color);
  */
 void Paint_GetColor(UWORD color, UBYTE* arr_color);
 
+
+/**
+ * @brief Set up a drawing context with no image.
+ *
+ * Paint_Ctx_NewImage() then gives it an image, which several contexts may
+ * share as long as they draw into different areas of it.
+ */
+void Paint_Ctx_Init(Paint_Ctx *Ctx);
+
+/**
+ * @brief Free the glyph cache of a context.
+ */
+void Paint_Ctx_Release(Paint_Ctx *Ctx);
+
+/**
+ * @brief The Paint_* functions on a given context.
+ *
+ * Each behaves as the function of the same name without Ctx_, which draws
+ * into Paint. Contexts do not share state other than the Chinese font index,
+ * so threads may draw at once into different contexts.
+ */
+void Paint_Ctx_NewImage(Paint_Ctx *Ctx, UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color);
+void Paint_Ctx_SelectImage(Paint_Ctx *Ctx, UBYTE *image);
+void Paint_Ctx_SetRotate(Paint_Ctx *Ctx, UWORD Rotate);
+void Paint_Ctx_SetMirroring(Paint_Ctx *Ctx, UBYTE mirror);
+void Paint_Ctx_SetBitsPerPixel(Paint_Ctx *Ctx, UBYTE bpp);
+void Paint_Ctx_SetPixel(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, UWORD Color);
+void Paint_Ctx_FillSpan(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, UWORD Len, UWORD Color);
+void Paint_Ctx_BlitRow(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, const UBYTE *Src, UWORD Len, UBYTE Src_Bpp);
+void Paint_Ctx_Clear(Paint_Ctx *Ctx, UWORD Color);
+void Paint_Ctx_ClearWindows(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color);
+void Paint_Ctx_DrawPoint(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, UWORD Color, DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_FillWay);
+void Paint_Ctx_DrawLine(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style);
+void Paint_Ctx_DrawThickLine(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, UWORD Line_width, LINE_CAP Cap, LINE_STYLE Line_Style);
+void Paint_Ctx_DrawRectangle(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_Ctx_DrawCircle(Paint_Ctx *Ctx, UWORD X_Center, UWORD Y_Center, UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_Ctx_DrawEllipse(Paint_Ctx *Ctx, UWORD X_Center, UWORD Y_Center, UWORD X_Radius, UWORD Y_Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_Ctx_DrawRoundedRectangle(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void Paint_Ctx_DrawChar(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, const char Acsii_Char, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_Ctx_SetGlyphCache(Paint_Ctx *Ctx, UDOUBLE Max_Bytes);
+void Paint_Ctx_FlushGlyphCache(Paint_Ctx *Ctx);
+void Paint_Ctx_GetGlyphStats(Paint_Ctx *Ctx, PAINT_GLYPH_STATS *Stats);
+void Paint_Ctx_DrawString_EN(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, const char * pString, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_Ctx_DrawString_CN(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_Ctx_DrawNum(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, int32_t Nummber, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_Ctx_DrawTime(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font, UWORD Color_Foreground, UWORD Color_Background);
+void Paint_Ctx_BeginDamage(Paint_Ctx *Ctx);
+void Paint_Ctx_EndDamage(Paint_Ctx *Ctx);
+void Paint_Ctx_AddDamage(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend);
+void Paint_Ctx_AddDamageRect(Paint_Ctx *Ctx, const PAINT_RECT *Rect);
+UWORD Paint_Ctx_GetDamage(Paint_Ctx *Ctx, PAINT_RECT *Rects, UWORD Max, UWORD Align);
+void Paint_Ctx_ClearDamage(Paint_Ctx *Ctx);
+void Paint_Ctx_SetClip(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend);
+void Paint_Ctx_ClearClip(Paint_Ctx *Ctx);
+void Paint_Ctx_Record(Paint_Ctx *Ctx, PAINT_BATCH *Batch);
+void Paint_Ctx_Replay(Paint_Ctx *Ctx, const PAINT_BATCH *Batch);
+void Paint_Ctx_SetColor(Paint_Ctx *Ctx, UWORD x, UWORD y, UWORD color);
+
 #endif
 
 
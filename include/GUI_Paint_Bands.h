@@ -0,0 +1,64 @@
+/**
+ * @file GUI_Paint_Bands.h
+ * @brief Drawing a batch on several threads, each into a band of the image.
+ *
+ * A batch recorded with Paint_Record() is replayed once per band, each band
+ * a context clipped to its own rows of image memory, with the bands drawn on
+ * threads of their own. Bands never share a byte of the image, so the result
+ * is the same as replaying the batch on one thread, and the damage of every
+ * band is added to the target context.
+ */
+#ifndef __GUI_PAINT_BANDS_H
+#define __GUI_PAINT_BANDS_H
+
+#include "GUI_Paint.h"
+
+/**
+ * @brief Most bands, and so threads, a render uses.
+ */
+#ifndef PAINT_BANDS_MAX
+#define PAINT_BANDS_MAX 16
+#endif
+
+/**
+ * @brief Error codes.
+ */
+#define PAINT_BANDS_ERR_ARGS   -1   /**< No bands, or more than PAINT_BANDS_MAX. */
+#define PAINT_BANDS_ERR_BATCH  -2   /**< The batch lost calls for lack of memory. */
+
+/**
+ * @brief Band contexts, kept between renders for their glyph caches.
+ */
+typedef struct {
+    UWORD Count;                        /**< Bands an image is split into. */
+    Paint_Ctx Band[PAINT_BANDS_MAX];    /**< Context of each band. */
+} PAINT_BANDS;
+
+/**
+ * @brief Set up bands.
+ * @param Bands Bands to initialize.
+ * @param Count Number of bands, 1 to PAINT_BANDS_MAX; one thread each.
+ * @return 0 on success, or PAINT_BANDS_ERR_ARGS.
+ */
+int Paint_Bands_Init(PAINT_BANDS *Bands, UWORD Count);
+
+/**
+ * @brief Free the glyph caches of the bands.
+ */
+void Paint_Bands_Release(PAINT_BANDS *Bands);
+
+/**
+ * @brief Replay a batch into a context, one band per thread.
+ *
+ * The rows of image memory inside the context's clip are split into equal
+ * bands. Each band draws with the context's image, settings and clip, and
+ * its own glyph cache. The calling thread draws the first band.
+ *
+ * @param Bands Bands from Paint_Bands_Init().
+ * @param Ctx Context to draw into, e.g. &Paint.
+ * @param Batch Calls to draw.
+ * @return 0 on success, or a negative error code; nothing is drawn then.
+ */
+int Paint_Bands_Render(PAINT_BANDS *Bands, Paint_Ctx *Ctx, const PAINT_BATCH *Batch);
+
+#endif
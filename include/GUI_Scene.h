@@ -0,0 +1,179 @@
+/**
+ * @file GUI_Scene.h
+ * @brief Retained display list: nodes kept between frames and redrawn only
+ *        where they changed.
+ *
+ * A scene owns the image of a drawing context, or the part of it inside the
+ * context's clip. It holds nodes, each a text, rectangle, circle, bitmap or
+ * BMP file, or any drawing calls made between Scene_BeginNode() and
+ * Scene_EndNode(), under an ID chosen by the caller. Setting a node again
+ * with the same ID replaces it. Nodes are drawn in the order they were
+ * first added.
+ *
+ * Scene_Commit() compares each node with what it drew at the last commit.
+ * Only the areas of nodes that were added, changed or removed are cleared to
+ * the background and drawn again, with every node that reaches into them,
+ * so the image is the same as if the whole scene were drawn afresh. The
+ * areas are added to the context's damage, so for the Paint context
+ * EPD_IT8951_RefreshDirty() sends just them to the panel.
+ */
+#ifndef __GUI_SCENE_H
+#define __GUI_SCENE_H
+
+#include "GUI_Paint.h"
+
+/**
+ * @brief Error codes.
+ */
+#define SCENE_ERR_MEMORY   -1   /**< Out of memory; the node keeps its last setting. */
+#define SCENE_ERR_MISSING  -2   /**< No node has the ID. */
+#define SCENE_ERR_FILE     -3   /**< The BMP file could not be read. */
+#define SCENE_ERR_BUSY     -4   /**< A node is open between Scene_BeginNode() and Scene_EndNode(). */
+
+/**
+ * @brief One node of a scene.
+ */
+typedef struct {
+    UDOUBLE Id;             /**< Caller's ID. */
+    PAINT_BATCH Calls;      /**< What the node draws. */
+    PAINT_RECT Drawn;       /**< Area it could draw on at the last commit. */
+    bool Was_Drawn;         /**< Drawn holds an area. */
+    bool Present;           /**< Not removed since the last commit. */
+    bool Changed;           /**< Set or removed since the last commit. */
+} SCENE_NODE;
+
+/**
+ * @brief Scene state.
+ */
+typedef struct {
+    Paint_Ctx *Ctx;         /**< Context the scene draws into. */
+    UWORD Background;       /**< Color of areas no node covers. */
+    SCENE_NODE *Nodes;      /**< Nodes in drawing order. */
+    UDOUBLE Count;          /**< Nodes in use. */
+    UDOUBLE Capacity;       /**< Nodes that fit in Nodes. */
+    PAINT_BATCH Scratch;    /**< Calls of the node being set. */
+    PAINT_BATCH *Saved;     /**< Batch the context recorded into before. */
+    long Open;              /**< Node being set, or -1. */
+    bool Redraw_All;        /**< Redraw everything at the next commit. */
+} SCENE;
+
+/**
+ * @brief Set up an empty scene.
+ *
+ * The first commit clears the whole image, within the clip, to Background.
+ *
+ * @param Scene Scene to initialize.
+ * @param Ctx Context to draw into, e.g. &Paint, with its image set up.
+ * @param Background Color of areas no node covers.
+ */
+void Scene_Init(SCENE *Scene, Paint_Ctx *Ctx, UWORD Background);
+
+/**
+ * @brief Free the nodes of a scene. The image is left as it is.
+ */
+void Scene_Release(SCENE *Scene);
+
+/**
+ * @brief Start setting a node from drawing calls.
+ *
+ * Until Scene_EndNode(), the Paint_Ctx_* drawing calls on the scene's
+ * context, or the Paint_* ones if it is Paint, are recorded into the node
+ * instead of drawn.
+ *
+ * @param Scene Scene.
+ * @param Id Node ID; a new ID adds a node at the top.
+ * @return 0, SCENE_ERR_MEMORY or SCENE_ERR_BUSY.
+ */
+int Scene_BeginNode(SCENE *Scene, UDOUBLE Id);
+
+/**
+ * @brief Finish setting a node. It is redrawn at the next commit only if
+ *        its calls differ from before.
+ * @return 0, SCENE_ERR_MEMORY or SCENE_ERR_MISSING if no node is open.
+ */
+int Scene_EndNode(SCENE *Scene);
+
+/**
+ * @brief Set a node to an ASCII string, as Paint_DrawString_EN() draws it.
+ * @return 0 or a negative error code.
+ */
+int Scene_SetText(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, const char *pString,
+                  sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+
+/**
+ * @brief Set a node to a GB2312 and ASCII string, as Paint_DrawString_CN()
+ *        draws it.
+ * @return 0 or a negative error code.
+ */
+int Scene_SetTextCN(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, const char *pString,
+                    cFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+
+/**
+ * @brief Set a node to a rectangle, as Paint_DrawRoundedRectangle() draws it.
+ * @param Xend X end point (exclusive).
+ * @param Yend Y end point (exclusive).
+ * @param Radius Corner radius, 0 for square corners.
+ * @return 0 or a negative error code.
+ */
+int Scene_SetRect(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                  UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+
+/**
+ * @brief Set a node to a circle, as Paint_DrawCircle() draws it.
+ * @return 0 or a negative error code.
+ */
+int Scene_SetCircle(SCENE *Scene, UDOUBLE Id, UWORD X_Center, UWORD Y_Center, UWORD Radius,
+                    UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+
+/**
+ * @brief Set a node to a bitmap, drawn a row at a time by Paint_BlitRow().
+ *
+ * The pixels are copied, so the caller may change or free them afterwards.
+ *
+ * @param Pixels Height rows of Width pixels, each row starting on a byte.
+ * @param Bpp Bits per source pixel: 1, 2, 4 or 8.
+ * @return 0 or a negative error code.
+ */
+int Scene_SetBitmap(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, UWORD Width, UWORD Height,
+                    const UBYTE *Pixels, UBYTE Bpp);
+
+/**
+ * @brief Set a node to a BMP file, drawn as GUI_ReadBmp() draws it.
+ *
+ * The file is read now, and the node is only redrawn if its pixels or
+ * position changed. Uses the Paint context while reading, so it must not
+ * be drawn into from another thread meanwhile.
+ *
+ * @return 0 or a negative error code.
+ */
+int Scene_SetBMP(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, const char *Path);
+
+/**
+ * @brief Remove a node at the next commit.
+ *
+ * Setting the ID again before the commit brings the node back in its place.
+ *
+ * @return 0 or SCENE_ERR_MISSING.
+ */
+int Scene_Remove(SCENE *Scene, UDOUBLE Id);
+
+/**
+ * @brief Redraw the whole scene at the next commit, e.g. after the image
+ *        was drawn over or the context's rotation changed.
+ */
+void Scene_Invalidate(SCENE *Scene);
+
+/**
+ * @brief Redraw the areas that changed since the last commit.
+ *
+ * The areas are merged as damage is, so there are at most
+ * PAINT_DAMAGE_MAX of them. They are also added to the context's damage.
+ *
+ * @param Scene Scene.
+ * @param Rects Receives the redrawn areas in image memory coordinates, or NULL.
+ * @param Max Size of Rects.
+ * @return Number of areas redrawn, or SCENE_ERR_BUSY.
+ */
+int Scene_Commit(SCENE *Scene, PAINT_RECT *Rects, UWORD Max);
+
+#endif
@@ -82,6 +82,8 @@ int GPIOD_Export();
 int GPIOD_Unexport(int Pin);
 int GPIOD_Unexport_GPIO(void);
 int GPIOD_Direction(int Pin, int Dir);
+int GPIOD_Direction_Events(int Pin);
+int GPIOD_Wait_Level(int Pin, int Value, unsigned int Timeout_us);
 int GPIOD_Read(int Pin);
 int GPIOD_Write(int Pin, int value);
 
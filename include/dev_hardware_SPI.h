@@ -40,6 +40,12 @@
 #define DEV_HARDWARE_SPI_Debug(__info,...)
 #endif
 
+//spidev copies every message through a bounce buffer of this many bytes
+#ifndef DEV_HARDWARE_SPI_BUFSIZ_PATH
+#define DEV_HARDWARE_SPI_BUFSIZ_PATH "/sys/module/spidev/parameters/bufsiz"
+#endif
+#define DEV_HARDWARE_SPI_DEFAULT_BUFSIZ 4096
+
 #define SPI_CPHA        0x01
 #define SPI_CPOL        0x02
 #define SPI_MODE_0      (0|0)
@@ -94,6 +100,7 @@ typedef struct SPIStruct {
     uint32_t speed;
     uint16_t mode;
     uint16_t delay;
+    uint32_t bufsiz; //largest message spidev accepts, read at begin
     int fd; //
 } HARDWARE_SPI;
 
@@ -108,6 +115,9 @@ int DEV_HARDWARE_SPI_setSpeed(uint32_t speed);
 
 uint8_t DEV_HARDWARE_SPI_TransferByte(uint8_t buf);
 int DEV_HARDWARE_SPI_Transfer(uint8_t *buf, uint32_t len);
+int DEV_HARDWARE_SPI_Write(const uint8_t *buf, uint32_t len);
+int DEV_HARDWARE_SPI_Read(uint8_t *buf, uint32_t len);
+uint32_t DEV_HARDWARE_SPI_GetBufsiz(void);
 
 void DEV_HARDWARE_SPI_SetDataInterval(uint16_t us);
 int DEV_HARDWARE_SPI_SetBusMode(BusMode mode);
@@ -0,0 +1,149 @@
+/**
+ * @file epdrawd_protocol.h
+ * @brief Wire protocol between epdraw and the epdrawd display daemon.
+ *
+ * A client connects to the daemon's Unix domain stream socket and sends one or
+ * more requests. Each request is an EPDRAWD_Request header followed by
+ * Payload_Len bytes: a NUL-terminated absolute BMP, PNG or JPEG path for EPDRAWD_REQ_FILE,
+ * or raw packed pixels for EPDRAWD_REQ_FRAMEBUFFER. The daemon answers every
+ * request with one EPDRAWD_Response. Both ends run on the same host, so
+ * fields are in host byte order.
+ */
+#ifndef __EPDRAWD_PROTOCOL_H_
+#define __EPDRAWD_PROTOCOL_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+/**
+ * @brief Default socket path, overridable with the EPDRAWD_SOCKET environment variable.
+ */
+#define EPDRAWD_SOCKET_PATH "/run/epdrawd.sock"
+#define EPDRAWD_SOCKET_ENV  "EPDRAWD_SOCKET"
+
+/**
+ * @brief Magic at the start of every request and response ("EPD1").
+ */
+#define EPDRAWD_MAGIC 0x31445045u
+
+/**
+ * @brief Largest accepted payload (one 8bpp frame of a 2200x1650 panel, rounded up).
+ */
+#define EPDRAWD_MAX_PAYLOAD (4u * 1024u * 1024u)
+
+/**
+ * @brief Seconds the daemon waits on a client that sends or reads nothing before
+ *        dropping it, so one idle client cannot keep others waiting.
+ */
+#define EPDRAWD_CLIENT_TIMEOUT_S 10
+
+/**
+ * @brief Request types.
+ */
+#define EPDRAWD_REQ_FILE        1   /**< Draw a BMP, PNG or JPEG file; Mode is the epdraw display mode (0-3). */
+#define EPDRAWD_REQ_FRAMEBUFFER 2   /**< Refresh X/Y/W/H from packed pixels; Mode is the waveform mode. */
+
+/**
+ * @brief Request flags.
+ */
+#define EPDRAWD_FLAG_CLEAR 0x01     /**< Clear the panel with INIT mode before this update. */
+
+/**
+ * @brief Transform bits: how a PNG or JPEG file is turned before it is drawn.
+ *        BMP files are drawn as they are.
+ */
+#define EPDRAWD_TRANSFORM_ROTATE_MASK 0x03  /**< Quarter turns clockwise. */
+#define EPDRAWD_TRANSFORM_MIRROR      0x04  /**< Mirror left to right after rotating. */
+
+/**
+ * @brief Daemon status codes, in addition to the EPD_IT8951_DrawBMP() and
+ *        EPD_IT8951_Area_Refresh() error codes.
+ */
+#define EPDRAWD_ERR_PROTOCOL   -20  /**< Bad magic, type or payload length. */
+#define EPDRAWD_ERR_RECT       -21  /**< Rectangle outside the panel or misaligned, see EPDRAWD_Request.W. */
+#define EPDRAWD_ERR_NO_REFRESH -22  /**< The panel did not report the refresh as done. */
+
+/**
+ * @brief Request header.
+ */
+typedef struct EPDRAWD_Request {
+    uint32_t Magic;          /**< EPDRAWD_MAGIC. */
+    uint16_t Type;           /**< EPDRAWD_REQ_*. */
+    uint16_t Mode;           /**< Display mode (FILE) or waveform mode (FRAMEBUFFER). */
+    uint16_t X;              /**< Area X (FRAMEBUFFER only). */
+    uint16_t Y;              /**< Area Y (FRAMEBUFFER only). */
+    uint16_t W;              /**< Area width (FRAMEBUFFER only); rows are whole 16 bit words, and at 1bpp X and W are multiples of 8. */
+    uint16_t H;              /**< Area height (FRAMEBUFFER only). */
+    uint8_t  Bits_Per_Pixel; /**< 1, 2, 4 or 8 (FRAMEBUFFER only). */
+    uint8_t  Flags;          /**< EPDRAWD_FLAG_*. */
+    uint8_t  Dither;         /**< DITHER_MODE the image is drawn with (FILE only); 0 is none. */
+    uint8_t  Transform;      /**< EPDRAWD_TRANSFORM_* bits (FILE only). */
+    uint32_t Payload_Len;    /**< Bytes following the header. */
+} EPDRAWD_Request;
+
+/**
+ * @brief Response to one request; the latencies are measured by the daemon.
+ */
+typedef struct EPDRAWD_Response {
+    uint32_t Magic;          /**< EPDRAWD_MAGIC. */
+    int32_t  Status;         /**< 0 on success, negative error code otherwise. */
+    uint32_t Draw_us;        /**< Decode and upload to the controller. */
+    uint32_t Refresh_us;     /**< Display command to refresh done. */
+    uint32_t Clear_us;       /**< INIT clear scheduled by the refresh policy, 0 if none. */
+    uint32_t Total_us;       /**< Header received to response sent. */
+} EPDRAWD_Response;
+
+/**
+ * @brief Socket path to use: $EPDRAWD_SOCKET if set, else EPDRAWD_SOCKET_PATH.
+ */
+static inline const char *epdrawd_socket_path(void)
+{
+    const char *path = getenv(EPDRAWD_SOCKET_ENV);
+    return (path != NULL && path[0] != '\0') ? path : EPDRAWD_SOCKET_PATH;
+}
+
+/**
+ * @brief Read exactly Len bytes.
+ * @param stop Flag set by a signal handler: a read interrupted once it is set
+ *        gives up. NULL retries every interrupted read.
+ * @return 0 on success, -1 on error, early end of stream or stop.
+ */
+static inline int epdrawd_read_full(int fd, void *buf, size_t len, volatile sig_atomic_t *stop)
+{
+    uint8_t *p = (uint8_t *)buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR && (stop == NULL || !*stop))
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * @brief Write exactly Len bytes.
+ * @param stop As for epdrawd_read_full().
+ * @return 0 on success, -1 on error or stop.
+ */
+static inline int epdrawd_write_full(int fd, const void *buf, size_t len, volatile sig_atomic_t *stop)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR && (stop == NULL || !*stop))
+            continue;
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+#endif
@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include <gpiod.h>
 
 struct gpiod_chip *gpiochip;
@@ -132,6 +133,77 @@ int GPIOD_Direction(int Pin, int Dir)
     return 0;
 }
 
+/*
+ * Request the pin as an input that also queues both-edge events, so
+ * GPIOD_Wait_Level() can sleep in the kernel instead of polling.
+ */
+int GPIOD_Direction_Events(int Pin)
+{
+    gpioline = gpiod_chip_get_line(gpiochip, Pin);
+    if (gpioline == NULL)
+    {
+        GPIOD_Debug( "Export Failed: Pin%d\n", Pin);
+        return -1;
+    }
+
+    ret = gpiod_line_request_both_edges_events(gpioline, "gpio");
+    if (ret != 0)
+    {
+        GPIOD_Debug( "Event request Failed: Pin%d\n", Pin);
+        return -1;
+    }
+    GPIOD_Debug("Pin%d:intput, edge events\r\n", Pin);
+    return 0;
+}
+
+/*
+ * Wait for a pin requested with GPIOD_Direction_Events() to read Value.
+ * Edges are queued by the kernel from the moment of the request, so an edge
+ * between the level check and the wait still wakes us up.
+ * Return 0 when the level is reached, 1 on timeout, -1 on error.
+ */
+int GPIOD_Wait_Level(int Pin, int Value, unsigned int Timeout_us)
+{
+    struct gpiod_line *line;
+    struct gpiod_line_event event;
+    struct timespec start, now, timeout;
+    unsigned long long elapsed_us;
+
+    line = gpiod_chip_get_line(gpiochip, Pin);
+    if (line == NULL)
+    {
+        GPIOD_Debug( "Export Failed: Pin%d\n", Pin);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (;;)
+    {
+        ret = gpiod_line_get_value(line);
+        if (ret < 0)
+            return -1;
+        if (ret == Value)
+            return 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed_us = (unsigned long long)(now.tv_sec - start.tv_sec) * 1000000ULL + (now.tv_nsec - start.tv_nsec) / 1000;
+        if (elapsed_us >= Timeout_us)
+            return 1;
+
+        timeout.tv_sec = (Timeout_us - elapsed_us) / 1000000;
+        timeout.tv_nsec = ((Timeout_us - elapsed_us) % 1000000) * 1000;
+        ret = gpiod_line_event_wait(line, &timeout);
+        if (ret < 0)
+            return -1;
+        if (ret == 0)
+            return (gpiod_line_get_value(line) == Value) ? 0 : 1;
+
+        //Drain the queued edge; the level is re-read at the top of the loop
+        if (gpiod_line_event_read(line, &event) < 0)
+            return -1;
+    }
+}
+
 int GPIOD_Read(int Pin)
 {
     gpioline = gpiod_chip_get_line(gpiochip, Pin);
@@ -36,6 +36,7 @@
 #include <stdio.h>
 
 #include <stdint.h> 
+#include <string.h> 
 #include <unistd.h> 
 #include <stdio.h> 
 #include <stdlib.h> 
@@ -71,6 +72,37 @@ static uint8_t bits = 8;
 
 struct spi_ioc_transfer tr;
 
+//spidev pads each transfer in its bounce buffer to the DMA alignment
+#define DEV_HARDWARE_SPI_XFER_ALIGN 128
+
+/******************************************************************************
+function:   Read the spidev bounce buffer size
+parameter:
+Info:
+    spidev fails any SPI_IOC_MESSAGE whose transfers add up to more than
+    bufsiz bytes with EMSGSIZE. The value comes from the module parameter
+    (spidev.bufsiz=N on the kernel command line) and falls back to the
+    kernel default when sysfs is not readable.
+******************************************************************************/
+static uint32_t DEV_HARDWARE_SPI_ReadBufsiz(void)
+{
+    FILE *fp;
+    unsigned long value = 0;
+
+    fp = fopen(DEV_HARDWARE_SPI_BUFSIZ_PATH, "r");
+    if (fp == NULL) {
+        DEV_LOG_DEBUG("Can't read %s, assuming bufsiz %u", DEV_HARDWARE_SPI_BUFSIZ_PATH, DEV_HARDWARE_SPI_DEFAULT_BUFSIZ);
+        return DEV_HARDWARE_SPI_DEFAULT_BUFSIZ;
+    }
+    if (fscanf(fp, "%lu", &value) != 1 || value == 0 || value > 0x7FFFFFFFUL) {
+        value = DEV_HARDWARE_SPI_DEFAULT_BUFSIZ;
+    }
+    fclose(fp);
+
+    DEV_LOG_DEBUG("spidev bufsiz = %lu", value);
+    return (uint32_t)value;
+}
+
 
 /******************************************************************************
 function:   SPI port initialization
@@ -91,6 +123,7 @@ void DEV_HARDWARE_SPI_begin(char *SPI_device)
         DEV_LOG_DEBUG("Opened SPI device: %s", SPI_device);
     }
     hardware_SPI.mode = 0;
+    hardware_SPI.bufsiz = DEV_HARDWARE_SPI_ReadBufsiz();
     ret = ioctl(hardware_SPI.fd, SPI_IOC_WR_BITS_PER_WORD, &bits);
     if (ret == -1) {
         DEV_LOG_WARN("Can't set bits per word");
@@ -115,6 +148,7 @@ void DEV_HARDWARE_SPI_beginSet(char *SPI_device, SPIMode mode, uint32_t speed)
         perror("Failed to open SPI device.\n");  
         exit(1); 
     }
+    hardware_SPI.bufsiz = DEV_HARDWARE_SPI_ReadBufsiz();
     ret = ioctl(hardware_SPI.fd, SPI_IOC_WR_BITS_PER_WORD, &bits);
     if (ret == -1) {
         DEV_LOG_WARN("Can't set bits per word");
@@ -367,3 +401,97 @@ int DEV_HARDWARE_SPI_Transfer(uint8_t *buf, uint32_t len)
     return 1;
 }
 
+/******************************************************************************
+function: Largest chunk that fits in one spidev message
+parameter:
+Info:
+    The whole message, not just each transfer, has to fit in bufsiz, so
+    splitting a chunk into several transfers of one SPI_IOC_MESSAGE(N)
+    would not move more bytes per ioctl. Raise spidev.bufsiz to cut the
+    number of ioctls per frame.
+******************************************************************************/
+uint32_t DEV_HARDWARE_SPI_GetBufsiz(void)
+{
+    uint32_t bufsiz = hardware_SPI.bufsiz;
+
+    if (bufsiz == 0) {
+        bufsiz = DEV_HARDWARE_SPI_DEFAULT_BUFSIZ;
+    }
+    if (bufsiz >= DEV_HARDWARE_SPI_XFER_ALIGN) {
+        bufsiz -= bufsiz % DEV_HARDWARE_SPI_XFER_ALIGN;
+    }
+    return bufsiz;
+}
+
+/******************************************************************************
+function: Stream a block through spidev in bufsiz sized messages
+parameter:
+    tx  :   Data to send, or NULL to clock out zeros
+    rx  :   Receive buffer, or NULL to discard
+    len :   Number of bytes
+Info:
+    CS is held by the caller through EPD_CS_PIN, and cs_change stays 0
+    so the controller never toggles it between chunks.
+    Return 1 success
+    Return -1 failed
+******************************************************************************/
+static int DEV_HARDWARE_SPI_Stream(const uint8_t *tx, uint8_t *rx, uint32_t len)
+{
+    struct spi_ioc_transfer xfer;
+    uint32_t max_chunk = DEV_HARDWARE_SPI_GetBufsiz();
+
+    while (len > 0) {
+        uint32_t chunk = (len > max_chunk) ? max_chunk : len;
+
+        memset(&xfer, 0, sizeof(xfer));
+        xfer.tx_buf = (unsigned long)tx;
+        xfer.rx_buf = (unsigned long)rx;
+        xfer.len = chunk;
+        xfer.speed_hz = tr.speed_hz;
+        xfer.delay_usecs = tr.delay_usecs;
+        xfer.bits_per_word = tr.bits_per_word;
+        xfer.cs_change = 0;
+
+        if (ioctl(hardware_SPI.fd, SPI_IOC_MESSAGE(1), &xfer) < 1) {
+            DEV_LOG_WARN("Can't send spi message of %u bytes", chunk);
+            return -1;
+        }
+        if (tx != NULL) {
+            tx += chunk;
+        }
+        if (rx != NULL) {
+            rx += chunk;
+        }
+        len -= chunk;
+    }
+    return 1;
+}
+
+/******************************************************************************
+function: The SPI port sends a block of data
+parameter:
+    buf :   Data to send
+    len :   Number of bytes
+Info:
+    Received bytes are discarded and buf is left untouched.
+    Return 1 success
+    Return -1 failed
+******************************************************************************/
+int DEV_HARDWARE_SPI_Write(const uint8_t *buf, uint32_t len)
+{
+    return DEV_HARDWARE_SPI_Stream(buf, NULL, len);
+}
+
+/******************************************************************************
+function: The SPI port reads a block of data
+parameter:
+    buf :   Destination buffer
+    len :   Number of bytes
+Info:
+    Return 1 success
+    Return -1 failed
+******************************************************************************/
+int DEV_HARDWARE_SPI_Read(uint8_t *buf, uint32_t len)
+{
+    return DEV_HARDWARE_SPI_Stream(NULL, buf, len);
+}
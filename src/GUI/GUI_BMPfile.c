@@ -11,6 +11,7 @@
 
 #include "GUI_BMPfile.h"
 #include "GUI_Paint.h"
+#include "GUI_Dither.h"
 #include "../../include/Debug.h"
 
 #include <fcntl.h>
@@ -33,6 +34,34 @@ UDOUBLE skip;
 BMPRGBQUAD  palette[256];
 extern UBYTE isColor;
 
+//Dithering applied to images as they are drawn
+static DITHER_MODE bmp_Dither = DITHER_NONE;
+
+/******************************************************************************
+function: Set the dithering applied by GUI_ReadBmp
+parameter:
+******************************************************************************/
+int GUI_SetBmpDither(DITHER_MODE Mode)
+{
+	if ((unsigned)Mode >= DITHER_MODES)
+		return -2;
+	bmp_Dither = Mode;
+	return 0;
+}
+
+/******************************************************************************
+function: Dithering for the rows about to be drawn
+Info:
+	Color panels halve every third column after the gray is taken; error
+	diffusion would spread that into its neighbours, so they use Bayer.
+******************************************************************************/
+static DITHER_MODE Row_Dither(void)
+{
+	if(isColor && (bmp_Dither == DITHER_FLOYD_STEINBERG || bmp_Dither == DITHER_ATKINSON))
+		return DITHER_BAYER;
+	return bmp_Dither;
+}
+
 static void Bitmap_format_Matrix(UBYTE *dst,UBYTE *src)
 {
 	UDOUBLE i,j,k;
@@ -174,7 +203,19 @@ static void DrawMatrix(UWORD Xpos, UWORD Ypos,UWORD Width, UWORD High,const UBYT
 	UBYTE R,G,B;
 	UBYTE temp1,temp2;
 	double Gray;
-	
+	UBYTE *Row = (UBYTE *)malloc(Width);
+	DITHER Dither;
+	DITHER_MODE Mode = Row_Dither();
+	bool Dithered = Mode != DITHER_NONE;
+
+	if(Row == NULL) {
+		Debug("Not enough memory for a BMP row\n");
+		return;
+	}
+	if(Dithered && Dither_Init(&Dither, Mode, Paint.BitsPerPixel, Width) != 0) {
+		Debug("Not enough memory to dither a BMP, drawing it undithered\n");
+		Dithered = false;
+	}
 	for (y=0,j=Ypos;y<High;y++,j++)
 	{
  		for (x=0,i=Xpos;x<Width;x++,i++)
@@ -215,11 +256,56 @@ static void DrawMatrix(UWORD Xpos, UWORD Ypos,UWORD Width, UWORD High,const UBYT
 		
 			Gray = (R*299 + G*587 + B*114 + 500) / 1000;
             if(isColor && i%3==2)
-				Paint_SetPixel(i, j, Gray/2);
+				Row[x] = Gray/2;
 			else
-				Paint_SetPixel(i, j, Gray);
+				Row[x] = Gray;
 		}
+		if(Dithered)
+			Dither_Row(&Dither, Row, Xpos, j);
+		Paint_BlitRow(Xpos, j, Row, Width, 8);
+	}
+	if(Dithered)
+		Dither_Release(&Dither);
+	free(Row);
+}
+
+/******************************************************************************
+function: Draw 8 bit grays as GUI_ReadBmp draws a BMP
+parameter:
+	Gray : Width x High grays, row by row, 0 black
+******************************************************************************/
+void GUI_DrawGray(UWORD Xpos, UWORD Ypos, UWORD Width, UWORD High, const UBYTE *Gray)
+{
+	UWORD x,y;
+	UBYTE *Row = (UBYTE *)malloc(Width);
+	DITHER Dither;
+	DITHER_MODE Mode = Row_Dither();
+	bool Dithered = Mode != DITHER_NONE;
+
+	if(Row == NULL) {
+		Debug("Not enough memory for an image row\n");
+		return;
+	}
+	if(Dithered && Dither_Init(&Dither, Mode, Paint.BitsPerPixel, Width) != 0) {
+		Debug("Not enough memory to dither an image, drawing it undithered\n");
+		Dithered = false;
+	}
+	Paint_BeginDamage();
+	for (y=0;y<High;y++)
+	{
+		memcpy(Row, Gray + (size_t)y*Width, Width);
+		if(isColor)
+			for (x=0;x<Width;x++)
+				if((Xpos+x)%3==2)
+					Row[x] /= 2;
+		if(Dithered)
+			Dither_Row(&Dither, Row, Xpos, Ypos+y);
+		Paint_BlitRow(Xpos, Ypos+y, Row, Width, 8);
 	}
+	Paint_EndDamage();
+	if(Dithered)
+		Dither_Release(&Dither);
+	free(Row);
 }
 
 /**
@@ -439,7 +525,9 @@ int GUI_ReadBmp(const char *path, UWORD x, UWORD y)
     }
 
 	Bitmap_format_Matrix(bmp_dst_buf,bmp_src_buf);
+	Paint_BeginDamage();
 	DrawMatrix(x, y,InfoHead.biWidth, InfoHead.biHeight, bmp_dst_buf);
+	Paint_EndDamage();
 
     free(bmp_src_buf);
     free(bmp_dst_buf);
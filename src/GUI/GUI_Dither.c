@@ -0,0 +1,208 @@
+/**
+ * @file GUI_Dither.c
+ * @brief Ordered and error diffusion dithering of gray rows to 1, 2 or 4bpp levels.
+ */
+#include "GUI_Dither.h"
+#include "../../include/Debug.h"
+#include <stdlib.h>
+#include <string.h>
+
+//Standard 8x8 Bayer index matrix
+static const UBYTE Bayer8[8][8] = {
+    {  0, 32,  8, 40,  2, 34, 10, 42 },
+    { 48, 16, 56, 24, 50, 18, 58, 26 },
+    { 12, 44,  4, 36, 14, 46,  6, 38 },
+    { 60, 28, 52, 20, 62, 30, 54, 22 },
+    {  3, 35, 11, 43,  1, 33,  9, 41 },
+    { 51, 19, 59, 27, 49, 17, 57, 25 },
+    { 15, 47,  7, 39, 13, 45,  5, 37 },
+    { 63, 31, 55, 23, 61, 29, 53, 21 },
+};
+
+//Error rows have this many spare entries each side, so neighbors need no bounds checks
+#define DITHER_MARGIN 2
+
+/******************************************************************************
+function: Set up dithering for an image
+parameter:
+    Bits_Per_Pixel : output depth, 8 taken as 4
+    Width          : pixels per row
+******************************************************************************/
+int Dither_Init(DITHER *Dither, DITHER_MODE Mode, UBYTE Bits_Per_Pixel, UWORD Width)
+{
+    memset(Dither, 0, sizeof(*Dither));
+    if (Bits_Per_Pixel == 8)
+        Bits_Per_Pixel = 4;
+    if ((unsigned)Mode >= DITHER_MODES || Width == 0 ||
+        (Bits_Per_Pixel != 1 && Bits_Per_Pixel != 2 && Bits_Per_Pixel != 4)) {
+        Debug("Dither_Init: mode %d at %dbpp over %d pixels is not supported\r\n", Mode, Bits_Per_Pixel, Width);
+        return DITHER_ERR_ARGS;
+    }
+    Dither->Mode = Mode;
+    Dither->Bits_Per_Pixel = Bits_Per_Pixel;
+    Dither->Width = Width;
+
+    if (Mode == DITHER_FLOYD_STEINBERG || Mode == DITHER_ATKINSON) {
+        for (int i = 0; i < 2; i++) {
+            Dither->Error[i] = (int16_t *)calloc(Width + 2 * DITHER_MARGIN, sizeof(int16_t));
+            if (Dither->Error[i] == NULL) {
+                Debug("Dither_Init: no memory for %d pixel error rows\r\n", Width);
+                Dither_Release(Dither);
+                return DITHER_ERR_MEMORY;
+            }
+        }
+    }
+    return 0;
+}
+
+/******************************************************************************
+function: Free the error rows
+parameter:
+******************************************************************************/
+void Dither_Release(DITHER *Dither)
+{
+    free(Dither->Error[0]);
+    free(Dither->Error[1]);
+    Dither->Error[0] = NULL;
+    Dither->Error[1] = NULL;
+}
+
+/******************************************************************************
+function: Forget the error carried so far
+parameter:
+******************************************************************************/
+void Dither_Reset(DITHER *Dither)
+{
+    for (int i = 0; i < 2; i++)
+        if (Dither->Error[i] != NULL)
+            memset(Dither->Error[i], 0, (Dither->Width + 2 * DITHER_MARGIN) * sizeof(int16_t));
+}
+
+/******************************************************************************
+function: Ordered dither of one row
+parameter:
+Info:
+    A pixel p shows level (p * Max + T * 255) / 255 rounded down, with the
+    threshold T = (index + 0.5) / 64 from the pattern; scaled by 128 it is
+    all integer, and exact levels are kept as they are. The pattern row is
+    laid out from the row's first pixel, so the loop has no table lookup
+    by position and vectorizes.
+******************************************************************************/
+static void Dither_RowBayer(DITHER *Dither, UBYTE *Row, UWORD X, UWORD Y)
+{
+    UDOUBLE Max = (1u << Dither->Bits_Per_Pixel) - 1, Step = 255 / Max;
+    UDOUBLE Bias[8];
+
+    for (int i = 0; i < 8; i++)
+        Bias[i] = (2u * Bayer8[Y & 7][(X + i) & 7] + 1) * 255;
+    for (UWORD x = 0; x < Dither->Width; x++)
+        Row[x] = (UBYTE)((Row[x] * Max * 128 + Bias[x & 7]) / (255 * 128) * Step);
+}
+
+/******************************************************************************
+function: Error diffusion of one row
+parameter:
+Info:
+    Error[0] holds the error carried into this row and Error[1] into the
+    next one. Atkinson also reaches two rows down, but only straight below,
+    so that error goes into Error[0] at the pixel just read; swapping the
+    rows afterwards leaves both in place for the next row.
+******************************************************************************/
+static void Dither_RowDiffuse(DITHER *Dither, UBYTE *Row)
+{
+    int Max = (1 << Dither->Bits_Per_Pixel) - 1, Step = 255 / Max;
+    int16_t *Here = Dither->Error[0] + DITHER_MARGIN;
+    int16_t *Below = Dither->Error[1] + DITHER_MARGIN;
+    int16_t *Swap;
+    int Right = 0, Right2 = 0;
+
+    for (UWORD x = 0; x < Dither->Width; x++) {
+        int Value = Row[x] + Here[x] + Right;
+        int Shown, Error;
+
+        if (Value < 0)
+            Value = 0;
+        else if (Value > 255)
+            Value = 255;
+        Shown = (Value * Max + 127) / 255 * Step;
+        Row[x] = (UBYTE)Shown;
+        Error = Value - Shown;
+
+        if (Dither->Mode == DITHER_FLOYD_STEINBERG) {
+            //7/16 right, 3/16 below left, 5/16 below, the rest below right
+            int E7 = Error * 7 / 16, E3 = Error * 3 / 16, E5 = Error * 5 / 16;
+            Right = E7;
+            Below[x - 1] += E3;
+            Below[x] += E5;
+            Below[x + 1] += Error - E7 - E3 - E5;
+            Here[x] = 0;
+        } else {
+            //1/8 to each of right, two right, below left, below, below right
+            //and two below; the last 2/8 are dropped
+            int E = Error / 8;
+            Right = Right2 + E;
+            Right2 = E;
+            Below[x - 1] += E;
+            Below[x] += E;
+            Below[x + 1] += E;
+            Here[x] = E;
+        }
+    }
+
+    //What fell off the ends is dropped
+    Below[-1] = 0;
+    Below[Dither->Width] = 0;
+    Swap = Dither->Error[0];
+    Dither->Error[0] = Dither->Error[1];
+    Dither->Error[1] = Swap;
+}
+
+/******************************************************************************
+function: Dither the next row of the image in place
+parameter:
+    X, Y : image position of the row's first pixel
+******************************************************************************/
+void Dither_Row(DITHER *Dither, UBYTE *Row, UWORD X, UWORD Y)
+{
+    switch (Dither->Mode) {
+    case DITHER_BAYER:
+        Dither_RowBayer(Dither, Row, X, Y);
+        break;
+    case DITHER_FLOYD_STEINBERG:
+    case DITHER_ATKINSON:
+        Dither_RowDiffuse(Dither, Row);
+        break;
+    default: {
+        UDOUBLE Max = (1u << Dither->Bits_Per_Pixel) - 1, Step = 255 / Max;
+        for (UWORD x = 0; x < Dither->Width; x++)
+            Row[x] = (UBYTE)((Row[x] * Max + 127) / 255 * Step);
+        break;
+    }
+    }
+}
+
+/******************************************************************************
+function: Parse a method name
+parameter:
+******************************************************************************/
+int Dither_ParseMode(const char *Name, DITHER_MODE *Mode)
+{
+    static const struct {
+        const char *Name;
+        DITHER_MODE Mode;
+    } Names[] = {
+        { "none", DITHER_NONE },
+        { "bayer", DITHER_BAYER },
+        { "floyd-steinberg", DITHER_FLOYD_STEINBERG },
+        { "fs", DITHER_FLOYD_STEINBERG },
+        { "atkinson", DITHER_ATKINSON },
+    };
+
+    for (size_t i = 0; i < sizeof(Names) / sizeof(Names[0]); i++) {
+        if (strcmp(Name, Names[i].Name) == 0) {
+            *Mode = Names[i].Mode;
+            return 0;
+        }
+    }
+    return DITHER_ERR_ARGS;
+}
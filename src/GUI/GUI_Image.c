@@ -0,0 +1,1427 @@
+/**
+ * @file GUI_Image.c
+ * @brief PNG and baseline JPEG decoders writing 8 bit gray.
+ *
+ * Both decode a file held in memory in one pass. PNG data is inflated with
+ * table-driven Huffman decoding, unfiltered row by row and turned into gray.
+ * JPEG scans are Huffman decoded in full, but only luma blocks are dequantized
+ * and transformed, with the same integer IDCT as libjpeg's default, so the
+ * grays match what libjpeg decodes to gray.
+ */
+#include "GUI_Image.h"
+#include "GUI_BMPfile.h"
+#include "GUI_Paint.h"
+#include "../../include/Debug.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//Larger images are refused rather than allocated
+#define IMAGE_MAX_PIXELS (64UL * 1024 * 1024)
+
+//How GUI_ReadImage() turns PNG and JPEG files
+static int Image_Rotation = 0;
+static bool Image_Mirror = false;
+
+//Same weights as GUI_ReadBmp()
+static inline UBYTE Image_Luma(UDOUBLE R, UDOUBLE G, UDOUBLE B)
+{
+    return (UBYTE)((R * 299 + G * 587 + B * 114 + 500) / 1000);
+}
+
+//A gray with this much opacity over white
+static inline UBYTE Image_OverWhite(UDOUBLE Gray, UDOUBLE Alpha)
+{
+    return (UBYTE)((Gray * Alpha + 255 * (255 - Alpha) + 127) / 255);
+}
+
+static UDOUBLE Image_U32(const UBYTE *P)
+{
+    return ((UDOUBLE)P[0] << 24) | ((UDOUBLE)P[1] << 16) | ((UDOUBLE)P[2] << 8) | P[3];
+}
+
+static UWORD Image_U16(const UBYTE *P)
+{
+    return (UWORD)((P[0] << 8) | P[1]);
+}
+
+/******************************************************************************
+function: Tell the format of a file from its first bytes
+parameter:
+******************************************************************************/
+GUI_IMAGE_FORMAT GUI_ImageFormat(const UBYTE *Data, size_t Len)
+{
+    static const UBYTE Png_Signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    if (Len >= 8 && memcmp(Data, Png_Signature, 8) == 0)
+        return GUI_IMAGE_PNG;
+    if (Len >= 3 && Data[0] == 0xFF && Data[1] == 0xD8 && Data[2] == 0xFF)
+        return GUI_IMAGE_JPEG;
+    if (Len >= 2 && Data[0] == 'B' && Data[1] == 'M')
+        return GUI_IMAGE_BMP;
+    return GUI_IMAGE_UNKNOWN;
+}
+
+/******************************************************************************
+                                  Inflate
+******************************************************************************/
+//Codes up to this long are decoded with one table lookup
+#define INFLATE_FAST_BITS 9
+
+typedef struct {
+    UWORD Fast[1 << INFLATE_FAST_BITS]; //symbol | length << 9, 0 for longer codes
+    UWORD Count[16];                    //codes of each length
+    UWORD Symbol[288];                  //symbols by code
+} INFLATE_HUFF;
+
+typedef struct {
+    const UBYTE *In;
+    size_t In_Len, In_Pos;
+    uint64_t Bits;                      //next bits, first in the low bit
+    int Bit_Count;
+    UBYTE *Out;
+    size_t Out_Len, Out_Pos;
+} INFLATE;
+
+static const UWORD Inflate_Len_Base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const UBYTE Inflate_Len_Extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const UWORD Inflate_Dist_Base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const UBYTE Inflate_Dist_Extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+//Past the end of the input, zeros are read; this tells they were used
+static inline bool Inflate_Overrun(const INFLATE *S)
+{
+    return S->In_Pos * 8 - S->Bit_Count > S->In_Len * 8;
+}
+
+static inline void Inflate_Fill(INFLATE *S)
+{
+    while (S->Bit_Count <= 56) {
+        uint64_t Byte = (S->In_Pos < S->In_Len) ? S->In[S->In_Pos] : 0;
+        S->In_Pos++;
+        S->Bits |= Byte << S->Bit_Count;
+        S->Bit_Count += 8;
+    }
+}
+
+static inline UDOUBLE Inflate_Bits(INFLATE *S, int N)
+{
+    UDOUBLE Value;
+
+    if (S->Bit_Count < N)
+        Inflate_Fill(S);
+    Value = (UDOUBLE)(S->Bits & ((1u << N) - 1));
+    S->Bits >>= N;
+    S->Bit_Count -= N;
+    return Value;
+}
+
+/******************************************************************************
+function: Build a decoding table from code lengths
+parameter:
+Info:
+    Returns -1 for lengths that give more codes than fit. Incomplete codes
+    are allowed; their missing codes fail to decode.
+******************************************************************************/
+static int Inflate_Build(INFLATE_HUFF *H, const UBYTE *Lengths, int N)
+{
+    UWORD Offset[16];
+    int Left = 1, Index = 0;
+    UDOUBLE Code = 0;
+
+    memset(H->Count, 0, sizeof(H->Count));
+    memset(H->Fast, 0, sizeof(H->Fast));
+    for (int i = 0; i < N; i++)
+        H->Count[Lengths[i]]++;
+    H->Count[0] = 0;
+    for (int Len = 1; Len < 16; Len++) {
+        Left = (Left << 1) - H->Count[Len];
+        if (Left < 0)
+            return -1;
+    }
+    Offset[1] = 0;
+    for (int Len = 1; Len < 15; Len++)
+        Offset[Len + 1] = Offset[Len] + H->Count[Len];
+    for (int i = 0; i < N; i++)
+        if (Lengths[i] != 0)
+            H->Symbol[Offset[Lengths[i]]++] = (UWORD)i;
+
+    //Codes are sent first bit first, so the table is indexed by the code reversed
+    for (int Len = 1; Len <= INFLATE_FAST_BITS; Len++, Code <<= 1) {
+        for (int k = 0; k < H->Count[Len]; k++, Code++) {
+            UDOUBLE Reversed = 0;
+            for (int b = 0; b < Len; b++)
+                Reversed |= ((Code >> b) & 1) << (Len - 1 - b);
+            for (UDOUBLE r = Reversed; r < (1u << INFLATE_FAST_BITS); r += 1u << Len)
+                H->Fast[r] = (UWORD)(H->Symbol[Index] | (Len << 9));
+            Index++;
+        }
+    }
+    return 0;
+}
+
+static int Inflate_Decode(INFLATE *S, const INFLATE_HUFF *H)
+{
+    int Code = 0, First = 0, Index = 0;
+    UWORD Entry;
+
+    if (S->Bit_Count < 16)
+        Inflate_Fill(S);
+    Entry = H->Fast[S->Bits & ((1u << INFLATE_FAST_BITS) - 1)];
+    if (Entry != 0) {
+        S->Bits >>= Entry >> 9;
+        S->Bit_Count -= Entry >> 9;
+        return Entry & 0x1FF;
+    }
+    //A longer code: walk it a bit at a time
+    for (int Len = 1; Len < 16; Len++) {
+        Code |= (int)(S->Bits & 1);
+        S->Bits >>= 1;
+        S->Bit_Count--;
+        if (Code - H->Count[Len] < First)
+            return H->Symbol[Index + (Code - First)];
+        Index += H->Count[Len];
+        First = (First + H->Count[Len]) << 1;
+        Code <<= 1;
+    }
+    return -1;
+}
+
+static int Inflate_Codes(INFLATE *S, const INFLATE_HUFF *Lit, const INFLATE_HUFF *Dist)
+{
+    for (;;) {
+        int Sym = Inflate_Decode(S, Lit);
+
+        if (Sym < 0 || Inflate_Overrun(S))
+            return -1;
+        if (Sym < 256) {
+            if (S->Out_Pos >= S->Out_Len)
+                return -1;
+            S->Out[S->Out_Pos++] = (UBYTE)Sym;
+        } else if (Sym == 256) {
+            return 0;
+        } else {
+            size_t Len, Distance;
+            UBYTE *To;
+
+            Sym -= 257;
+            if (Sym >= 29)
+                return -1;
+            Len = Inflate_Len_Base[Sym] + Inflate_Bits(S, Inflate_Len_Extra[Sym]);
+            Sym = Inflate_Decode(S, Dist);
+            if (Sym < 0 || Sym >= 30)
+                return -1;
+            Distance = Inflate_Dist_Base[Sym] + Inflate_Bits(S, Inflate_Dist_Extra[Sym]);
+            if (Distance > S->Out_Pos || Len > S->Out_Len - S->Out_Pos)
+                return -1;
+            //Byte by byte: the copy may overlap what it writes
+            To = S->Out + S->Out_Pos;
+            for (size_t i = 0; i < Len; i++)
+                To[i] = To[i - Distance];
+            S->Out_Pos += Len;
+        }
+    }
+}
+
+static int Inflate_Stored(INFLATE *S)
+{
+    UDOUBLE Len, Check;
+
+    Inflate_Bits(S, S->Bit_Count % 8);
+    Len = Inflate_Bits(S, 16);
+    Check = Inflate_Bits(S, 16);
+    if ((Len ^ 0xFFFF) != Check || Len > S->Out_Len - S->Out_Pos)
+        return -1;
+    //What is left in the bit buffer comes first, then the input itself
+    while (Len > 0 && S->Bit_Count >= 8) {
+        S->Out[S->Out_Pos++] = (UBYTE)Inflate_Bits(S, 8);
+        Len--;
+    }
+    if (Len > 0) {
+        if (S->In_Pos > S->In_Len || Len > S->In_Len - S->In_Pos)
+            return -1;
+        memcpy(S->Out + S->Out_Pos, S->In + S->In_Pos, Len);
+        S->Out_Pos += Len;
+        S->In_Pos += Len;
+    }
+    return Inflate_Overrun(S) ? -1 : 0;
+}
+
+static int Inflate_Fixed(INFLATE *S)
+{
+    INFLATE_HUFF Lit, Dist;
+    UBYTE Lengths[288];
+    int i;
+
+    for (i = 0; i < 144; i++)
+        Lengths[i] = 8;
+    for (; i < 256; i++)
+        Lengths[i] = 9;
+    for (; i < 280; i++)
+        Lengths[i] = 7;
+    for (; i < 288; i++)
+        Lengths[i] = 8;
+    Inflate_Build(&Lit, Lengths, 288);
+    memset(Lengths, 5, 30);
+    Inflate_Build(&Dist, Lengths, 30);
+    return Inflate_Codes(S, &Lit, &Dist);
+}
+
+static int Inflate_Dynamic(INFLATE *S)
+{
+    static const UBYTE Order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    INFLATE_HUFF Lit, Dist;
+    UBYTE Lengths[286 + 30];
+    int Lit_Count, Dist_Count, Len_Count, Index = 0;
+
+    Lit_Count = (int)Inflate_Bits(S, 5) + 257;
+    Dist_Count = (int)Inflate_Bits(S, 5) + 1;
+    Len_Count = (int)Inflate_Bits(S, 4) + 4;
+    if (Lit_Count > 286 || Dist_Count > 30)
+        return -1;
+
+    //The code lengths are themselves Huffman coded
+    memset(Lengths, 0, 19);
+    for (int i = 0; i < Len_Count; i++)
+        Lengths[Order[i]] = (UBYTE)Inflate_Bits(S, 3);
+    if (Inflate_Build(&Lit, Lengths, 19) != 0)
+        return -1;
+    while (Index < Lit_Count + Dist_Count) {
+        int Sym = Inflate_Decode(S, &Lit), Repeat;
+        UBYTE Value = 0;
+
+        if (Sym < 0 || Inflate_Overrun(S))
+            return -1;
+        if (Sym < 16) {
+            Lengths[Index++] = (UBYTE)Sym;
+            continue;
+        }
+        if (Sym == 16) {
+            if (Index == 0)
+                return -1;
+            Value = Lengths[Index - 1];
+            Repeat = 3 + (int)Inflate_Bits(S, 2);
+        } else if (Sym == 17) {
+            Repeat = 3 + (int)Inflate_Bits(S, 3);
+        } else {
+            Repeat = 11 + (int)Inflate_Bits(S, 7);
+        }
+        if (Index + Repeat > Lit_Count + Dist_Count)
+            return -1;
+        memset(Lengths + Index, Value, Repeat);
+        Index += Repeat;
+    }
+    //A block without an end code could never finish
+    if (Lengths[256] == 0)
+        return -1;
+    if (Inflate_Build(&Lit, Lengths, Lit_Count) != 0 || Inflate_Build(&Dist, Lengths + Lit_Count, Dist_Count) != 0)
+        return -1;
+    return Inflate_Codes(S, &Lit, &Dist);
+}
+
+/******************************************************************************
+function: Inflate a zlib stream into exactly Out_Len bytes
+parameter:
+******************************************************************************/
+static int Inflate_Zlib(const UBYTE *In, size_t In_Len, UBYTE *Out, size_t Out_Len)
+{
+    INFLATE S;
+    UDOUBLE Final;
+
+    //Deflate, no preset dictionary, and the header check
+    if (In_Len < 2 || (In[0] & 0x0F) != 8 || (In[1] & 0x20) != 0 || ((In[0] << 8) | In[1]) % 31 != 0)
+        return -1;
+    memset(&S, 0, sizeof(S));
+    S.In = In + 2;
+    S.In_Len = In_Len - 2;
+    S.Out = Out;
+    S.Out_Len = Out_Len;
+    do {
+        int Ret;
+
+        Final = Inflate_Bits(&S, 1);
+        switch (Inflate_Bits(&S, 2)) {
+        case 0:
+            Ret = Inflate_Stored(&S);
+            break;
+        case 1:
+            Ret = Inflate_Fixed(&S);
+            break;
+        case 2:
+            Ret = Inflate_Dynamic(&S);
+            break;
+        default:
+            Ret = -1;
+            break;
+        }
+        if (Ret != 0)
+            return -1;
+    } while (!Final && S.Out_Pos < S.Out_Len);
+    return S.Out_Pos == S.Out_Len ? 0 : -1;
+}
+
+/******************************************************************************
+                                    PNG
+******************************************************************************/
+/******************************************************************************
+function: Check a PNG header
+parameter:
+    Ihdr : the 13 bytes of the IHDR chunk
+******************************************************************************/
+static int Png_Check(const UBYTE *Ihdr)
+{
+    UDOUBLE Width = Image_U32(Ihdr), Height = Image_U32(Ihdr + 4);
+    UBYTE Depth = Ihdr[8], Color_Type = Ihdr[9];
+    bool Valid;
+
+    switch (Color_Type) {
+    case 0:
+        Valid = Depth == 1 || Depth == 2 || Depth == 4 || Depth == 8 || Depth == 16;
+        break;
+    case 3:
+        Valid = Depth == 1 || Depth == 2 || Depth == 4 || Depth == 8;
+        break;
+    case 2:
+    case 4:
+    case 6:
+        Valid = Depth == 8 || Depth == 16;
+        break;
+    default:
+        Valid = false;
+        break;
+    }
+    if (!Valid || Width == 0 || Height == 0 || Ihdr[10] != 0 || Ihdr[11] != 0 || Ihdr[12] > 1)
+        return GUI_IMAGE_ERR_DECODE;
+    if (Ihdr[12] == 1) {
+        Debug("PNG: interlaced images are not decoded\r\n");
+        return GUI_IMAGE_ERR_FORMAT;
+    }
+    if (Width > 0xFFFF || Height > 0xFFFF || Width * Height > IMAGE_MAX_PIXELS)
+        return GUI_IMAGE_ERR_MEMORY;
+    return 0;
+}
+
+static inline UBYTE Png_Paeth(int A, int B, int C)
+{
+    int P = A + B - C, PA = abs(P - A), PB = abs(P - B), PC = abs(P - C);
+
+    if (PA <= PB && PA <= PC)
+        return (UBYTE)A;
+    return (UBYTE)(PB <= PC ? B : C);
+}
+
+static int Png_Unfilter(UBYTE Filter, UBYTE *Row, const UBYTE *Prev, size_t Len, size_t Bpp)
+{
+    size_t i;
+
+    switch (Filter) {
+    case 0:
+        break;
+    case 1:
+        for (i = Bpp; i < Len; i++)
+            Row[i] += Row[i - Bpp];
+        break;
+    case 2:
+        for (i = 0; i < Len; i++)
+            Row[i] += Prev[i];
+        break;
+    case 3:
+        for (i = 0; i < Bpp; i++)
+            Row[i] += Prev[i] >> 1;
+        for (; i < Len; i++)
+            Row[i] += (Row[i - Bpp] + Prev[i]) >> 1;
+        break;
+    case 4:
+        for (i = 0; i < Bpp; i++)
+            Row[i] += Prev[i];
+        for (; i < Len; i++)
+            Row[i] += Png_Paeth(Row[i - Bpp], Prev[i], Prev[i - Bpp]);
+        break;
+    default:
+        return -1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+function: Decode a PNG file held in memory
+parameter:
+******************************************************************************/
+int GUI_DecodePNG(const UBYTE *Data, size_t Len, GUI_IMAGE *Image)
+{
+    static const UBYTE Channels_Of[7] = { 1, 0, 3, 1, 2, 0, 4 };
+    const UBYTE *Ihdr = NULL, *Palette = NULL, *Trns = NULL;
+    size_t Palette_Len = 0, Trns_Len = 0, Idat_Len = 0, Pos;
+    UBYTE Depth, Color_Type, Channels, Gray_Of[256];
+    size_t Row_Bytes, Bpp;
+    UBYTE *Idat, *Raw, *Zero;
+    int Ret;
+
+    memset(Image, 0, sizeof(*Image));
+    if (GUI_ImageFormat(Data, Len) != GUI_IMAGE_PNG)
+        return GUI_IMAGE_ERR_FORMAT;
+
+    //First pass over the chunks: the header, palette, transparency and data size
+    for (Pos = 8; Pos + 12 <= Len; ) {
+        UDOUBLE Chunk_Len = Image_U32(Data + Pos);
+        const UBYTE *Type = Data + Pos + 4, *Body = Data + Pos + 8;
+
+        if (Chunk_Len > Len - Pos - 12)
+            return GUI_IMAGE_ERR_DECODE;
+        if (memcmp(Type, "IHDR", 4) == 0 && Chunk_Len >= 13) {
+            Ihdr = Body;
+        } else if (memcmp(Type, "PLTE", 4) == 0) {
+            Palette = Body;
+            Palette_Len = Chunk_Len / 3;
+        } else if (memcmp(Type, "tRNS", 4) == 0) {
+            Trns = Body;
+            Trns_Len = Chunk_Len;
+        } else if (memcmp(Type, "IDAT", 4) == 0) {
+            Idat_Len += Chunk_Len;
+        } else if (memcmp(Type, "IEND", 4) == 0) {
+            break;
+        }
+        Pos += 12 + Chunk_Len;
+    }
+    if (Ihdr == NULL || Idat_Len == 0)
+        return GUI_IMAGE_ERR_DECODE;
+    Ret = Png_Check(Ihdr);
+    if (Ret != 0)
+        return Ret;
+    Image->Width = (UWORD)Image_U32(Ihdr);
+    Image->Height = (UWORD)Image_U32(Ihdr + 4);
+    Depth = Ihdr[8];
+    Color_Type = Ihdr[9];
+    Channels = Channels_Of[Color_Type];
+    Row_Bytes = ((size_t)Image->Width * Channels * Depth + 7) / 8;
+    Bpp = (Channels * Depth + 7) / 8;
+    if (Color_Type == 3 && Palette == NULL)
+        return GUI_IMAGE_ERR_DECODE;
+
+    //Palette entries straight to gray; indexes past the palette are black
+    memset(Gray_Of, 0, sizeof(Gray_Of));
+    for (size_t i = 0; i < Palette_Len && i < 256; i++) {
+        const UBYTE *Rgb = Palette + i * 3;
+        Gray_Of[i] = Image_Luma(Rgb[0], Rgb[1], Rgb[2]);
+        if (Color_Type == 3 && i < Trns_Len)
+            Gray_Of[i] = Image_OverWhite(Gray_Of[i], Trns[i]);
+    }
+
+    //Second pass: the data, joined up
+    Idat = (UBYTE *)malloc(Idat_Len);
+    Raw = (UBYTE *)malloc((Row_Bytes + 1) * Image->Height);
+    Zero = (UBYTE *)calloc(1, Row_Bytes);
+    Image->Gray = (UBYTE *)malloc((size_t)Image->Width * Image->Height);
+    if (Idat == NULL || Raw == NULL || Zero == NULL || Image->Gray == NULL) {
+        Debug("PNG: no memory for a %dx%d image\r\n", Image->Width, Image->Height);
+        Ret = GUI_IMAGE_ERR_MEMORY;
+        goto out;
+    }
+    Idat_Len = 0;
+    for (Pos = 8; Pos + 12 <= Len; ) {
+        UDOUBLE Chunk_Len = Image_U32(Data + Pos);
+
+        if (memcmp(Data + Pos + 4, "IDAT", 4) == 0) {
+            memcpy(Idat + Idat_Len, Data + Pos + 8, Chunk_Len);
+            Idat_Len += Chunk_Len;
+        } else if (memcmp(Data + Pos + 4, "IEND", 4) == 0) {
+            break;
+        }
+        Pos += 12 + Chunk_Len;
+    }
+    if (Inflate_Zlib(Idat, Idat_Len, Raw, (Row_Bytes + 1) * Image->Height) != 0) {
+        Debug("PNG: damaged image data\r\n");
+        Ret = GUI_IMAGE_ERR_DECODE;
+        goto out;
+    }
+
+    for (UWORD y = 0; y < Image->Height; y++) {
+        UBYTE *Row = Raw + y * (Row_Bytes + 1) + 1;
+        const UBYTE *Prev = (y == 0) ? Zero : Row - (Row_Bytes + 1);
+        UBYTE *Out = Image->Gray + (size_t)y * Image->Width;
+
+        if (Png_Unfilter(Row[-1], Row, Prev, Row_Bytes, Bpp) != 0) {
+            Ret = GUI_IMAGE_ERR_DECODE;
+            goto out;
+        }
+
+        for (UWORD x = 0; x < Image->Width; x++) {
+            UDOUBLE Gray, Alpha = 255;
+
+            if (Depth < 8) {
+                UDOUBLE Bit = (UDOUBLE)x * Depth;
+                UBYTE Sample = (Row[Bit / 8] >> (8 - Depth - Bit % 8)) & ((1 << Depth) - 1);
+                if (Color_Type == 3) {
+                    Out[x] = Gray_Of[Sample];
+                    continue;
+                }
+                Gray = Sample * 255u / ((1u << Depth) - 1);
+                if (Trns_Len >= 2 && Sample == Image_U16(Trns))
+                    Alpha = 0;
+            } else if (Color_Type == 3) {
+                Out[x] = Gray_Of[Row[x]];
+                continue;
+            } else {
+                //16 bit samples keep their high byte
+                const UBYTE *P = Row + (size_t)x * Bpp;
+                size_t Step = Depth / 8;
+                switch (Color_Type) {
+                case 0:
+                    Gray = P[0];
+                    if (Trns_Len >= 2 && (Step == 1 ? P[0] : Image_U16(P)) == Image_U16(Trns))
+                        Alpha = 0;
+                    break;
+                case 2:
+                    Gray = Image_Luma(P[0], P[Step], P[2 * Step]);
+                    if (Trns_Len >= 6 &&
+                        (Step == 1 ? P[0] == Image_U16(Trns) && P[1] == Image_U16(Trns + 2) && P[2] == Image_U16(Trns + 4)
+                                   : memcmp(P, Trns, 6) == 0))
+                        Alpha = 0;
+                    break;
+                case 4:
+                    Gray = P[0];
+                    Alpha = P[Step];
+                    break;
+                default:
+                    Gray = Image_Luma(P[0], P[Step], P[2 * Step]);
+                    Alpha = P[3 * Step];
+                    break;
+                }
+            }
+            Out[x] = (Alpha == 255) ? (UBYTE)Gray : Image_OverWhite(Gray, Alpha);
+        }
+    }
+    Ret = 0;
+
+out:
+    free(Idat);
+    free(Raw);
+    free(Zero);
+    if (Ret != 0)
+        GUI_FreeImage(Image);
+    return Ret;
+}
+
+/******************************************************************************
+                                   JPEG
+******************************************************************************/
+//Codes up to this long are decoded with one table lookup
+#define JPEG_FAST_BITS 9
+
+typedef struct {
+    UWORD Fast[1 << JPEG_FAST_BITS];    //value | length << 8, 0 for longer codes
+    int Max_Code[17];                   //largest code of each length, -1 if none
+    int Value_Offset[17];               //index in Values of a code of each length, minus the code
+    UBYTE Values[256];
+    bool Defined;
+} JPEG_HUFF;
+
+typedef struct {
+    UBYTE Id;
+    UBYTE H, V;                         //sampling factors
+    UBYTE Quant, Dc, Ac;                //table numbers
+    int Pred;                           //last DC value
+} JPEG_COMPONENT;
+
+typedef struct {
+    const UBYTE *Data;
+    size_t Len, Pos;
+    UDOUBLE Bits;                       //next bits, first in the high bit
+    int Bit_Count;
+    int Padding;                        //zero bits fed in after a marker
+    bool Marker;                        //a marker was reached; zeros follow
+} JPEG_BITS;
+
+typedef struct {
+    UWORD Quant[4][64];                 //in zigzag order
+    bool Quant_Defined[4];
+    JPEG_HUFF Huff[2][4];               //DC and AC
+    JPEG_COMPONENT Component[4];
+    int Components;
+    UWORD Width, Height;
+    UWORD Restart_Interval;
+    int Adobe_Transform;                //-1 without an Adobe marker
+} JPEG;
+
+static const UBYTE Jpeg_Zigzag[64] = {
+    0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+static int Jpeg_BuildHuff(JPEG_HUFF *H, const UBYTE *Counts, const UBYTE *Values, int Total)
+{
+    int Code = 0, k = 0;
+
+    H->Defined = false;
+    memset(H->Fast, 0, sizeof(H->Fast));
+    memcpy(H->Values, Values, Total);
+    for (int Len = 1; Len <= 16; Len++) {
+        //More codes than this length has room for, checked before they are laid out
+        if (Code + Counts[Len - 1] > (1 << Len))
+            return -1;
+        H->Value_Offset[Len] = k - Code;
+        for (int i = 0; i < Counts[Len - 1]; i++, Code++, k++) {
+            if (Len <= JPEG_FAST_BITS) {
+                int Shift = JPEG_FAST_BITS - Len;
+                for (int f = Code << Shift; f < (Code + 1) << Shift && f < (1 << JPEG_FAST_BITS); f++)
+                    H->Fast[f] = (UWORD)(Values[k] | (Len << 8));
+            }
+        }
+        H->Max_Code[Len] = Counts[Len - 1] ? Code - 1 : -1;
+        Code <<= 1;
+    }
+    H->Defined = true;
+    return 0;
+}
+
+static void Jpeg_Fill(JPEG_BITS *B)
+{
+    while (B->Bit_Count <= 24) {
+        UDOUBLE Byte = 0;
+
+        if (!B->Marker && B->Pos < B->Len) {
+            Byte = B->Data[B->Pos];
+            if (Byte != 0xFF) {
+                B->Pos++;
+            } else if (B->Pos + 1 < B->Len && B->Data[B->Pos + 1] == 0x00) {
+                //A stuffed 0xFF
+                B->Pos += 2;
+            } else {
+                //Markers end the data; they stay where they are
+                B->Marker = true;
+                Byte = 0;
+            }
+        } else {
+            B->Marker = true;
+        }
+        if (B->Marker)
+            B->Padding += 8;
+        B->Bits |= Byte << (24 - B->Bit_Count);
+        B->Bit_Count += 8;
+    }
+}
+
+static inline int Jpeg_Decode(JPEG_BITS *B, const JPEG_HUFF *H)
+{
+    UWORD Entry;
+
+    if (B->Bit_Count < 16)
+        Jpeg_Fill(B);
+    Entry = H->Fast[B->Bits >> (32 - JPEG_FAST_BITS)];
+    if (Entry != 0) {
+        B->Bits <<= Entry >> 8;
+        B->Bit_Count -= Entry >> 8;
+        return Entry & 0xFF;
+    }
+    for (int Len = JPEG_FAST_BITS + 1; Len <= 16; Len++) {
+        int Code = (int)(B->Bits >> (32 - Len));
+        if (Code <= H->Max_Code[Len]) {
+            B->Bits <<= Len;
+            B->Bit_Count -= Len;
+            return H->Values[H->Value_Offset[Len] + Code];
+        }
+    }
+    return -1;
+}
+
+//S bits, as a signed value
+static inline int Jpeg_Receive(JPEG_BITS *B, int S)
+{
+    int Value;
+
+    if (S == 0)
+        return 0;
+    if (B->Bit_Count < S)
+        Jpeg_Fill(B);
+    Value = (int)(B->Bits >> (32 - S));
+    B->Bits <<= S;
+    B->Bit_Count -= S;
+    return Value < (1 << (S - 1)) ? Value - (1 << S) + 1 : Value;
+}
+
+/******************************************************************************
+function: Decode one block
+parameter:
+    Coef : receives the dequantized coefficients, NULL to only skip the block
+******************************************************************************/
+static int Jpeg_Block(JPEG_BITS *B, const JPEG_HUFF *Dc, const JPEG_HUFF *Ac, int *Pred,
+                      const UWORD *Quant, int64_t *Coef)
+{
+    int S = Jpeg_Decode(B, Dc);
+
+    if (S < 0 || S > 15)
+        return -1;
+    //A DC value libjpeg could not hold in its 16 bit coefficients is damage
+    *Pred += Jpeg_Receive(B, S);
+    if (*Pred < -32768 || *Pred > 32767)
+        return -1;
+    if (Coef != NULL) {
+        memset(Coef, 0, 64 * sizeof(int64_t));
+        Coef[0] = (int64_t)*Pred * Quant[0];
+    }
+    for (int k = 1; k < 64; ) {
+        int RS = Jpeg_Decode(B, Ac), Value;
+
+        if (RS < 0)
+            return -1;
+        if ((RS & 15) == 0) {
+            //End of block, or a run of 16 zeros
+            if (RS != 0xF0)
+                break;
+            k += 16;
+            continue;
+        }
+        k += RS >> 4;
+        if (k > 63)
+            return -1;
+        Value = Jpeg_Receive(B, RS & 15);
+        if (Coef != NULL)
+            Coef[Jpeg_Zigzag[k]] = (int64_t)Value * Quant[k];
+        k++;
+    }
+    return 0;
+}
+
+/******************************************************************************
+function: Inverse DCT of one block
+parameter:
+Info:
+    libjpeg's accurate integer method (jidctint.c), with 64 bit sums so that
+    damaged coefficients cannot overflow.
+******************************************************************************/
+#define JPEG_CONST_BITS 13
+#define JPEG_PASS1_BITS 2
+#define JPEG_FIX(x) ((int64_t)((x) * (1 << JPEG_CONST_BITS) + 0.5))
+#define JPEG_DESCALE(x, n) (((x) + ((int64_t)1 << ((n) - 1))) >> (n))
+
+static void Jpeg_Idct(const int64_t *In, UBYTE *Out, size_t Stride)
+{
+    int64_t Ws[64];
+
+    for (int Pass = 0; Pass < 2; Pass++) {
+        for (int i = 0; i < 8; i++) {
+            int64_t P[8], Tmp0, Tmp1, Tmp2, Tmp3, Tmp10, Tmp11, Tmp12, Tmp13, Z1, Z2, Z3, Z4, Z5, R[8];
+            int Shift = Pass == 0 ? JPEG_CONST_BITS - JPEG_PASS1_BITS : JPEG_CONST_BITS + JPEG_PASS1_BITS + 3;
+
+            //Columns of the coefficients first, then rows of the workspace
+            for (int k = 0; k < 8; k++)
+                P[k] = Pass == 0 ? In[k * 8 + i] : Ws[i * 8 + k];
+            if (P[1] == 0 && P[2] == 0 && P[3] == 0 && P[4] == 0 && P[5] == 0 && P[6] == 0 && P[7] == 0) {
+                int64_t Dc = Pass == 0 ? P[0] * (1 << JPEG_PASS1_BITS) : JPEG_DESCALE(P[0], JPEG_PASS1_BITS + 3);
+                for (int k = 0; k < 8; k++)
+                    R[k] = Dc;
+            } else {
+                //Even part
+                Z2 = P[2];
+                Z3 = P[6];
+                Z1 = (Z2 + Z3) * JPEG_FIX(0.541196100);
+                Tmp2 = Z1 + Z3 * -JPEG_FIX(1.847759065);
+                Tmp3 = Z1 + Z2 * JPEG_FIX(0.765366865);
+                Tmp0 = (P[0] + P[4]) * (1 << JPEG_CONST_BITS);
+                Tmp1 = (P[0] - P[4]) * (1 << JPEG_CONST_BITS);
+                Tmp10 = Tmp0 + Tmp3;
+                Tmp13 = Tmp0 - Tmp3;
+                Tmp11 = Tmp1 + Tmp2;
+                Tmp12 = Tmp1 - Tmp2;
+
+                //Odd part
+                Tmp0 = P[7];
+                Tmp1 = P[5];
+                Tmp2 = P[3];
+                Tmp3 = P[1];
+                Z1 = Tmp0 + Tmp3;
+                Z2 = Tmp1 + Tmp2;
+                Z3 = Tmp0 + Tmp2;
+                Z4 = Tmp1 + Tmp3;
+                Z5 = (Z3 + Z4) * JPEG_FIX(1.175875602);
+                Tmp0 *= JPEG_FIX(0.298631336);
+                Tmp1 *= JPEG_FIX(2.053119869);
+                Tmp2 *= JPEG_FIX(3.072711026);
+                Tmp3 *= JPEG_FIX(1.501321110);
+                Z1 *= -JPEG_FIX(0.899976223);
+                Z2 *= -JPEG_FIX(2.562915447);
+                Z3 = Z3 * -JPEG_FIX(1.961570560) + Z5;
+                Z4 = Z4 * -JPEG_FIX(0.390180644) + Z5;
+                Tmp0 += Z1 + Z3;
+                Tmp1 += Z2 + Z4;
+                Tmp2 += Z2 + Z3;
+                Tmp3 += Z1 + Z4;
+
+                R[0] = JPEG_DESCALE(Tmp10 + Tmp3, Shift);
+                R[7] = JPEG_DESCALE(Tmp10 - Tmp3, Shift);
+                R[1] = JPEG_DESCALE(Tmp11 + Tmp2, Shift);
+                R[6] = JPEG_DESCALE(Tmp11 - Tmp2, Shift);
+                R[2] = JPEG_DESCALE(Tmp12 + Tmp1, Shift);
+                R[5] = JPEG_DESCALE(Tmp12 - Tmp1, Shift);
+                R[3] = JPEG_DESCALE(Tmp13 + Tmp0, Shift);
+                R[4] = JPEG_DESCALE(Tmp13 - Tmp0, Shift);
+            }
+            for (int k = 0; k < 8; k++) {
+                if (Pass == 0) {
+                    Ws[k * 8 + i] = R[k];
+                } else {
+                    int64_t V = R[k] + 128;
+                    Out[i * Stride + k] = (UBYTE)(V < 0 ? 0 : V > 255 ? 255 : V);
+                }
+            }
+        }
+    }
+}
+
+/******************************************************************************
+function: Check a JPEG frame header
+parameter:
+    Marker : the SOFn marker
+    Body   : the segment after its length
+Info:
+    Also fills in the frame when Jpeg is not NULL.
+******************************************************************************/
+static int Jpeg_Frame(UBYTE Marker, const UBYTE *Body, size_t Len, int Adobe_Transform, JPEG *Jpeg)
+{
+    int Components;
+
+    if (Marker != 0xC0 && Marker != 0xC1) {
+        Debug("JPEG: only baseline and extended Huffman JPEGs are decoded (SOF%d)\r\n", Marker - 0xC0);
+        return GUI_IMAGE_ERR_FORMAT;
+    }
+    if (Len < 6)
+        return GUI_IMAGE_ERR_DECODE;
+    Components = Body[5];
+    if (Len < 6 + 3 * (size_t)Components || Components == 0)
+        return GUI_IMAGE_ERR_DECODE;
+    if (Body[0] != 8 || Image_U16(Body + 1) == 0 || (Components != 1 && Components != 3)) {
+        Debug("JPEG: %d bit, %d component images are not decoded\r\n", Body[0], Components);
+        return GUI_IMAGE_ERR_FORMAT;
+    }
+    //Adobe's transform 0, or components named R, G, B, mean RGB rather than YCbCr
+    if (Components == 3 && (Adobe_Transform == 0 || (Body[6] == 'R' && Body[9] == 'G' && Body[12] == 'B'))) {
+        Debug("JPEG: RGB images are not decoded\r\n");
+        return GUI_IMAGE_ERR_FORMAT;
+    }
+    if (Image_U16(Body + 3) == 0 || (UDOUBLE)Image_U16(Body + 1) * Image_U16(Body + 3) > IMAGE_MAX_PIXELS)
+        return Image_U16(Body + 3) == 0 ? GUI_IMAGE_ERR_DECODE : GUI_IMAGE_ERR_MEMORY;
+    for (int i = 0; i < Components; i++) {
+        const UBYTE *C = Body + 6 + 3 * i;
+        if ((C[1] >> 4) < 1 || (C[1] >> 4) > 4 || (C[1] & 15) < 1 || (C[1] & 15) > 4 || C[2] > 3)
+            return GUI_IMAGE_ERR_DECODE;
+        if (Jpeg != NULL) {
+            Jpeg->Component[i].Id = C[0];
+            Jpeg->Component[i].H = C[1] >> 4;
+            Jpeg->Component[i].V = C[1] & 15;
+            Jpeg->Component[i].Quant = C[2];
+        }
+    }
+    if (Jpeg != NULL) {
+        Jpeg->Height = Image_U16(Body + 1);
+        Jpeg->Width = Image_U16(Body + 3);
+        Jpeg->Components = Components;
+    }
+    return 0;
+}
+
+//Skip to the restart marker and start the bits and DC predictions over
+static void Jpeg_Restart(JPEG *Jpeg, JPEG_BITS *B)
+{
+    while (B->Pos + 1 < B->Len && !(B->Data[B->Pos] == 0xFF && (B->Data[B->Pos + 1] & 0xF8) == 0xD0))
+        B->Pos++;
+    if (B->Pos + 1 < B->Len)
+        B->Pos += 2;
+    B->Bits = 0;
+    B->Bit_Count = 0;
+    B->Padding = 0;
+    B->Marker = false;
+    for (int i = 0; i < Jpeg->Components; i++)
+        Jpeg->Component[i].Pred = 0;
+}
+
+/******************************************************************************
+function: Decode the scan into the luma plane
+parameter:
+    Scan : the SOS segment after its length
+    Pos  : offset of the entropy coded data
+******************************************************************************/
+static int Jpeg_Scan(JPEG *Jpeg, const UBYTE *Scan, size_t Scan_Len, const UBYTE *Data, size_t Len, size_t Pos,
+                     GUI_IMAGE *Image)
+{
+    JPEG_COMPONENT *Order[4];
+    int Count, H_Max = 1, V_Max = 1, MCU_W, MCU_H, MCUs_X, MCUs_Y;
+    int64_t Coef[64];
+    size_t Plane_W, Plane_H;
+    UBYTE *Plane;
+    JPEG_BITS B;
+    UDOUBLE MCU = 0;
+
+    if (Scan_Len < 1 || Scan_Len < 1 + 2 * (size_t)Scan[0] + 3)
+        return GUI_IMAGE_ERR_DECODE;
+    Count = Scan[0];
+    //All components in one scan; several scans are left to other decoders
+    if (Count != Jpeg->Components) {
+        Debug("JPEG: images in several scans are not decoded\r\n");
+        return GUI_IMAGE_ERR_FORMAT;
+    }
+    for (int i = 0; i < Count; i++) {
+        UBYTE Id = Scan[1 + 2 * i], Tables = Scan[2 + 2 * i];
+        Order[i] = NULL;
+        for (int c = 0; c < Jpeg->Components; c++)
+            if (Jpeg->Component[c].Id == Id)
+                Order[i] = &Jpeg->Component[c];
+        if (Order[i] == NULL || (Tables >> 4) > 3 || (Tables & 15) > 3)
+            return GUI_IMAGE_ERR_DECODE;
+        Order[i]->Dc = Tables >> 4;
+        Order[i]->Ac = Tables & 15;
+        Order[i]->Pred = 0;
+        if (!Jpeg->Huff[0][Order[i]->Dc].Defined || !Jpeg->Huff[1][Order[i]->Ac].Defined)
+            return GUI_IMAGE_ERR_DECODE;
+    }
+    if (!Jpeg->Quant_Defined[Jpeg->Component[0].Quant])
+        return GUI_IMAGE_ERR_DECODE;
+    for (int c = 0; c < Jpeg->Components; c++) {
+        if (Jpeg->Component[c].H > H_Max)
+            H_Max = Jpeg->Component[c].H;
+        if (Jpeg->Component[c].V > V_Max)
+            V_Max = Jpeg->Component[c].V;
+    }
+    if (Count == 1) {
+        //One component is not interleaved: a block per MCU, whatever its sampling
+        Jpeg->Component[0].H = Jpeg->Component[0].V = 1;
+        H_Max = V_Max = 1;
+    } else if (Jpeg->Component[0].H != H_Max || Jpeg->Component[0].V != V_Max) {
+        Debug("JPEG: images with subsampled luma are not decoded\r\n");
+        return GUI_IMAGE_ERR_FORMAT;
+    }
+    MCU_W = 8 * H_Max;
+    MCU_H = 8 * V_Max;
+    MCUs_X = (Jpeg->Width + MCU_W - 1) / MCU_W;
+    MCUs_Y = (Jpeg->Height + MCU_H - 1) / MCU_H;
+    Plane_W = (size_t)MCUs_X * MCU_W;
+    Plane_H = (size_t)MCUs_Y * MCU_H;
+
+    //Blocks never reached stay at the middle gray a block of zeros gives
+    Plane = (UBYTE *)malloc(Plane_W * Plane_H);
+    if (Plane == NULL) {
+        Debug("JPEG: no memory for a %dx%d image\r\n", Jpeg->Width, Jpeg->Height);
+        return GUI_IMAGE_ERR_MEMORY;
+    }
+    memset(Plane, 128, Plane_W * Plane_H);
+
+    memset(&B, 0, sizeof(B));
+    B.Data = Data;
+    B.Len = Len;
+    B.Pos = Pos;
+    for (int My = 0; My < MCUs_Y; My++) {
+        for (int Mx = 0; Mx < MCUs_X; Mx++, MCU++) {
+            bool Damaged = false;
+            UBYTE *Corner = Plane + (size_t)My * MCU_H * Plane_W + (size_t)Mx * MCU_W;
+
+            if (Jpeg->Restart_Interval != 0 && MCU != 0 && MCU % Jpeg->Restart_Interval == 0)
+                Jpeg_Restart(Jpeg, &B);
+
+            //Every bit left is padding: the data ended early
+            if (B.Marker && B.Bit_Count <= B.Padding)
+                goto truncated;
+            for (int i = 0; i < Count && !Damaged; i++) {
+                JPEG_COMPONENT *C = Order[i];
+                bool Luma = C == &Jpeg->Component[0];
+                for (int v = 0; v < C->V && !Damaged; v++) {
+                    for (int h = 0; h < C->H && !Damaged; h++) {
+                        Damaged = Jpeg_Block(&B, &Jpeg->Huff[0][C->Dc], &Jpeg->Huff[1][C->Ac], &C->Pred,
+                                             Jpeg->Quant[C->Quant], Luma ? Coef : NULL) != 0;
+                        if (Luma && !Damaged)
+                            Jpeg_Idct(Coef, Corner + (size_t)v * 8 * Plane_W + h * 8, Plane_W);
+                    }
+                }
+            }
+            //Codes cut off by the end of the data are not damage
+            if (Damaged && B.Marker && B.Bit_Count < B.Padding)
+                goto truncated;
+            if (Damaged) {
+                Debug("JPEG: damaged data at block row %d\r\n", My);
+                free(Plane);
+                return GUI_IMAGE_ERR_DECODE;
+            }
+        }
+    }
+    goto done;
+
+truncated:
+    Debug("JPEG: data ends at block row %d of %d\r\n", (int)(MCU / MCUs_X), MCUs_Y);
+done:
+    //Crop the padding blocks, in place
+    for (UWORD y = 0; y < Jpeg->Height; y++)
+        memmove(Plane + (size_t)y * Jpeg->Width, Plane + y * Plane_W, Jpeg->Width);
+    Image->Width = Jpeg->Width;
+    Image->Height = Jpeg->Height;
+    Image->Gray = Plane;
+    return 0;
+}
+
+/******************************************************************************
+function: Decode a JPEG file held in memory
+parameter:
+******************************************************************************/
+int GUI_DecodeJPEG(const UBYTE *Data, size_t Len, GUI_IMAGE *Image)
+{
+    JPEG *Jpeg;
+    size_t Pos = 2;
+    bool Have_Frame = false;
+    int Ret = GUI_IMAGE_ERR_DECODE;
+
+    memset(Image, 0, sizeof(*Image));
+    if (GUI_ImageFormat(Data, Len) != GUI_IMAGE_JPEG)
+        return GUI_IMAGE_ERR_FORMAT;
+    Jpeg = (JPEG *)calloc(1, sizeof(JPEG));
+    if (Jpeg == NULL)
+        return GUI_IMAGE_ERR_MEMORY;
+    Jpeg->Adobe_Transform = -1;
+
+    while (Pos + 4 <= Len) {
+        UBYTE Marker;
+        const UBYTE *Body;
+        size_t Body_Len;
+
+        if (Data[Pos] != 0xFF) {
+            Pos++;
+            continue;
+        }
+        Marker = Data[Pos + 1];
+        if (Marker == 0xFF) {
+            Pos++;
+            continue;
+        }
+        //Markers without a segment
+        if (Marker == 0xD8 || Marker == 0x01 || (Marker & 0xF8) == 0xD0) {
+            Pos += 2;
+            continue;
+        }
+        if (Marker == 0xD9)
+            break;
+        Body_Len = Image_U16(Data + Pos + 2);
+        if (Body_Len < 2 || Body_Len > Len - Pos - 2)
+            break;
+        Body = Data + Pos + 4;
+        Body_Len -= 2;
+        Pos += 4 + Body_Len;
+
+        if (Marker >= 0xC0 && Marker <= 0xCF && Marker != 0xC4 && Marker != 0xC8 && Marker != 0xCC) {
+            Ret = Jpeg_Frame(Marker, Body, Body_Len, Jpeg->Adobe_Transform, Jpeg);
+            if (Ret != 0)
+                goto out;
+            Ret = GUI_IMAGE_ERR_DECODE;
+            Have_Frame = true;
+        } else if (Marker == 0xC4) {
+            //Huffman tables
+            while (Body_Len >= 17) {
+                UBYTE Class = Body[0] >> 4, Id = Body[0] & 15;
+                int Total = 0;
+                for (int i = 1; i <= 16; i++)
+                    Total += Body[i];
+                if (Class > 1 || Id > 3 || Total > 256 || Body_Len < 17 + (size_t)Total ||
+                    Jpeg_BuildHuff(&Jpeg->Huff[Class][Id], Body + 1, Body + 17, Total) != 0)
+                    goto out;
+                Body += 17 + Total;
+                Body_Len -= 17 + Total;
+            }
+        } else if (Marker == 0xDB) {
+            //Quantization tables, 8 or 16 bit
+            while (Body_Len >= 1) {
+                UBYTE Precision = Body[0] >> 4, Id = Body[0] & 15;
+                size_t Size = 1 + 64 * (Precision ? 2 : 1);
+                if (Precision > 1 || Id > 3 || Body_Len < Size)
+                    goto out;
+                for (int k = 0; k < 64; k++)
+                    Jpeg->Quant[Id][k] = Precision ? Image_U16(Body + 1 + 2 * k) : Body[1 + k];
+                Jpeg->Quant_Defined[Id] = true;
+                Body += Size;
+                Body_Len -= Size;
+            }
+        } else if (Marker == 0xDD) {
+            if (Body_Len < 2)
+                goto out;
+            Jpeg->Restart_Interval = Image_U16(Body);
+        } else if (Marker == 0xEE) {
+            if (Body_Len >= 12 && memcmp(Body, "Adobe", 5) == 0)
+                Jpeg->Adobe_Transform = Body[11];
+        } else if (Marker == 0xDA) {
+            if (!Have_Frame)
+                goto out;
+            if (Jpeg->Components == 3 && Jpeg->Adobe_Transform == 0) {
+                Ret = GUI_IMAGE_ERR_FORMAT;
+                goto out;
+            }
+            Ret = Jpeg_Scan(Jpeg, Body, Body_Len, Data, Len, Pos, Image);
+            goto out;
+        }
+    }
+    Debug("JPEG: no image data\r\n");
+
+out:
+    free(Jpeg);
+    return Ret;
+}
+
+/******************************************************************************
+function: Check a JPEG file up to the header of its first scan
+parameter:
+******************************************************************************/
+static int Jpeg_Probe(FILE *Fp)
+{
+    UBYTE Head[4], Body[6 + 3 * 255];
+    int Adobe_Transform = -1, Components = 0;
+
+    if (fseek(Fp, 2, SEEK_SET) != 0)
+        return GUI_IMAGE_ERR_DECODE;
+    for (;;) {
+        size_t Len;
+
+        if (fread(Head, 1, 2, Fp) != 2)
+            return GUI_IMAGE_ERR_DECODE;
+        if (Head[0] != 0xFF)
+            return GUI_IMAGE_ERR_DECODE;
+        if (Head[1] == 0xFF) {
+            fseek(Fp, -1, SEEK_CUR);
+            continue;
+        }
+        if (Head[1] == 0x01 || (Head[1] & 0xF8) == 0xD0)
+            continue;
+        if (Head[1] == 0xD9 || fread(Head + 2, 1, 2, Fp) != 2)
+            return GUI_IMAGE_ERR_DECODE;
+        Len = Image_U16(Head + 2);
+        if (Len < 2)
+            return GUI_IMAGE_ERR_DECODE;
+        Len -= 2;
+        if (Head[1] >= 0xC0 && Head[1] <= 0xCF && Head[1] != 0xC4 && Head[1] != 0xC8 && Head[1] != 0xCC) {
+            size_t Got = fread(Body, 1, Len < sizeof(Body) ? Len : sizeof(Body), Fp);
+            int Ret = Jpeg_Frame(Head[1], Body, Got, Adobe_Transform, NULL);
+            if (Ret != 0)
+                return Ret;
+            Components = Body[5];
+            Len -= Got;
+        }
+        //The first scan tells whether all components come in one
+        if (Head[1] == 0xDA) {
+            if (Components == 0 || Len < 1 || fread(Body, 1, 1, Fp) != 1)
+                return GUI_IMAGE_ERR_DECODE;
+            if (Components == 3 && Adobe_Transform == 0)
+                return GUI_IMAGE_ERR_FORMAT;
+            if (Body[0] != Components) {
+                Debug("JPEG: images in several scans are not decoded\r\n");
+                return GUI_IMAGE_ERR_FORMAT;
+            }
+            return 0;
+        }
+        if (Head[1] == 0xEE && Len >= 12) {
+            if (fread(Body, 1, 12, Fp) != 12)
+                return GUI_IMAGE_ERR_DECODE;
+            if (memcmp(Body, "Adobe", 5) == 0)
+                Adobe_Transform = Body[11];
+            Len -= 12;
+        }
+        if (fseek(Fp, (long)Len, SEEK_CUR) != 0)
+            return GUI_IMAGE_ERR_DECODE;
+    }
+}
+
+/******************************************************************************
+                           Files, transforms, drawing
+******************************************************************************/
+/******************************************************************************
+function: Check whether a file can be drawn without decoding it
+parameter:
+******************************************************************************/
+int GUI_CheckImage(const char *Path)
+{
+    UBYTE Head[33];
+    size_t Got;
+    int Ret;
+    FILE *Fp;
+
+    if (Path == NULL || (Fp = fopen(Path, "rb")) == NULL)
+        return GUI_IMAGE_ERR_OPEN;
+    Got = fread(Head, 1, sizeof(Head), Fp);
+    switch (GUI_ImageFormat(Head, Got)) {
+    case GUI_IMAGE_BMP:
+        Ret = 0;
+        break;
+    case GUI_IMAGE_PNG:
+        //IHDR always comes first
+        if (Got < sizeof(Head) || Image_U32(Head + 8) < 13 || memcmp(Head + 12, "IHDR", 4) != 0)
+            Ret = GUI_IMAGE_ERR_DECODE;
+        else
+            Ret = Png_Check(Head + 16);
+        break;
+    case GUI_IMAGE_JPEG:
+        Ret = Jpeg_Probe(Fp);
+        break;
+    default:
+        Ret = GUI_IMAGE_ERR_FORMAT;
+        break;
+    }
+    fclose(Fp);
+    return Ret;
+}
+
+/******************************************************************************
+function: Read and decode a PNG or JPEG file
+parameter:
+******************************************************************************/
+int GUI_LoadImage(const char *Path, GUI_IMAGE *Image)
+{
+    UBYTE *Data;
+    long Len;
+    int Ret;
+    FILE *Fp;
+
+    memset(Image, 0, sizeof(*Image));
+    if (Path == NULL || (Fp = fopen(Path, "rb")) == NULL)
+        return GUI_IMAGE_ERR_OPEN;
+    if (fseek(Fp, 0, SEEK_END) != 0 || (Len = ftell(Fp)) <= 0 || fseek(Fp, 0, SEEK_SET) != 0) {
+        fclose(Fp);
+        return GUI_IMAGE_ERR_OPEN;
+    }
+    Data = (UBYTE *)malloc(Len);
+    if (Data == NULL) {
+        fclose(Fp);
+        return GUI_IMAGE_ERR_MEMORY;
+    }
+    if (fread(Data, 1, Len, Fp) != (size_t)Len) {
+        Ret = GUI_IMAGE_ERR_OPEN;
+    } else {
+        switch (GUI_ImageFormat(Data, Len)) {
+        case GUI_IMAGE_PNG:
+            Ret = GUI_DecodePNG(Data, Len, Image);
+            break;
+        case GUI_IMAGE_JPEG:
+            Ret = GUI_DecodeJPEG(Data, Len, Image);
+            break;
+        default:
+            Ret = GUI_IMAGE_ERR_FORMAT;
+            break;
+        }
+    }
+    free(Data);
+    fclose(Fp);
+    return Ret;
+}
+
+/******************************************************************************
+function: Rotate, then mirror, an image in memory
+parameter:
+******************************************************************************/
+int GUI_TransformImage(GUI_IMAGE *Image, int Rotation, bool Mirror)
+{
+    UWORD W = Image->Width, H = Image->Height;
+
+    if (Rotation % 90 != 0)
+        return -2;
+    Rotation = ((Rotation % 360) + 360) % 360;
+
+    if (Rotation == 180) {
+        //Reversing the whole buffer turns it half way
+        for (size_t i = 0, j = (size_t)W * H - 1; i < j; i++, j--) {
+            UBYTE T = Image->Gray[i];
+            Image->Gray[i] = Image->Gray[j];
+            Image->Gray[j] = T;
+        }
+    } else if (Rotation != 0) {
+        UBYTE *Turned = (UBYTE *)malloc((size_t)W * H);
+        if (Turned == NULL)
+            return GUI_IMAGE_ERR_MEMORY;
+        //In tiles, so both buffers are walked a cache line at a time
+        for (UWORD Y0 = 0; Y0 < H; Y0 += 32) {
+            for (UWORD X0 = 0; X0 < W; X0 += 32) {
+                for (UWORD y = Y0; y < H && y < Y0 + 32; y++) {
+                    const UBYTE *Src = Image->Gray + (size_t)y * W;
+                    for (UWORD x = X0; x < W && x < X0 + 32; x++) {
+                        if (Rotation == 90)
+                            Turned[(size_t)x * H + (H - 1 - y)] = Src[x];
+                        else
+                            Turned[(size_t)(W - 1 - x) * H + y] = Src[x];
+                    }
+                }
+            }
+        }
+        free(Image->Gray);
+        Image->Gray = Turned;
+        Image->Width = H;
+        Image->Height = W;
+    }
+
+    if (Mirror) {
+        for (UWORD y = 0; y < Image->Height; y++) {
+            UBYTE *Row = Image->Gray + (size_t)y * Image->Width;
+            for (UWORD i = 0, j = Image->Width - 1; i < j; i++, j--) {
+                UBYTE T = Row[i];
+                Row[i] = Row[j];
+                Row[j] = T;
+            }
+        }
+    }
+    return 0;
+}
+
+/******************************************************************************
+function: Free a decoded image
+parameter:
+******************************************************************************/
+void GUI_FreeImage(GUI_IMAGE *Image)
+{
+    free(Image->Gray);
+    Image->Gray = NULL;
+    Image->Width = Image->Height = 0;
+}
+
+/******************************************************************************
+function: Set how GUI_ReadImage turns PNG and JPEG files
+parameter:
+******************************************************************************/
+int GUI_SetImageTransform(int Rotation, bool Mirror)
+{
+    if (Rotation % 90 != 0)
+        return -2;
+    Image_Rotation = Rotation;
+    Image_Mirror = Mirror;
+    return 0;
+}
+
+/******************************************************************************
+function: Read and draw a BMP, PNG or JPEG file
+parameter:
+******************************************************************************/
+int GUI_ReadImage(const char *Path, UWORD X, UWORD Y)
+{
+    UBYTE Head[8];
+    size_t Got;
+    GUI_IMAGE Image;
+    int Ret;
+    FILE *Fp;
+
+    if (Path == NULL || (Fp = fopen(Path, "rb")) == NULL)
+        return GUI_IMAGE_ERR_OPEN;
+    Got = fread(Head, 1, sizeof(Head), Fp);
+    fclose(Fp);
+    if (GUI_ImageFormat(Head, Got) == GUI_IMAGE_BMP)
+        return GUI_ReadBmp(Path, X, Y);
+
+    Ret = GUI_LoadImage(Path, &Image);
+    if (Ret != 0)
+        return Ret;
+    Ret = GUI_TransformImage(&Image, Image_Rotation, Image_Mirror);
+    if (Ret == 0)
+        GUI_DrawGray(X, Y, Image.Width, Image.Height, Image.Gray);
+    GUI_FreeImage(&Image);
+    return Ret;
+}
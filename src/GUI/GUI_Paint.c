@@ -15,9 +15,152 @@
 #include <stdlib.h>
 #include <string.h> //memset()
 #include <math.h>
+#include <pthread.h>
 
 PAINT Paint;
 UBYTE isColor = 0;
+
+/******************************************************************************
+function: Set up a drawing context
+parameter:
+******************************************************************************/
+void Paint_Ctx_Init(Paint_Ctx *Ctx)
+{
+    memset(Ctx, 0, sizeof(*Ctx));
+}
+
+/******************************************************************************
+function: Free the memory of a drawing context
+parameter:
+******************************************************************************/
+void Paint_Ctx_Release(Paint_Ctx *Ctx)
+{
+    Paint_Ctx_FlushGlyphCache(Ctx);
+    if (Ctx != &Paint)
+        free(Ctx->Glyphs);
+    Ctx->Glyphs = NULL;
+}
+
+/******************************************************************************
+Batches: drawing calls recorded by a context, drawn later by Paint_Ctx_Replay()
+******************************************************************************/
+typedef enum {
+    PAINT_OP_PIXEL = 0,
+    PAINT_OP_SPAN,
+    PAINT_OP_ROW,
+    PAINT_OP_CLEAR,
+    PAINT_OP_CLEAR_WINDOWS,
+    PAINT_OP_POINT,
+    PAINT_OP_LINE,
+    PAINT_OP_THICK_LINE,
+    PAINT_OP_RECTANGLE,
+    PAINT_OP_CIRCLE,
+    PAINT_OP_ELLIPSE,
+    PAINT_OP_ROUNDED_RECTANGLE,
+    PAINT_OP_CHAR,
+    PAINT_OP_STRING_EN,
+    PAINT_OP_STRING_CN,
+    PAINT_OP_NUM,
+    PAINT_OP_TIME,
+    PAINT_OP_COLOR,
+} PAINT_OP_TYPE;
+
+typedef struct PAINT_OP {
+    UBYTE Type;
+    UBYTE Style;                //Dot, line or fill style, or bits per pixel of a row
+    UBYTE Cap;
+    UWORD X0, Y0, X1, Y1;
+    UWORD R0, R1;               //Radii, or the length of a span or row
+    UWORD Color, Background;
+    UWORD Width;                //Line width or dot size
+    int32_t Number;             //Character or number
+    const void *Font;
+    UDOUBLE Data;               //Offset of the string, row or time in the batch data
+} PAINT_OP;
+
+/******************************************************************************
+function: Grow a batch array to hold Need items
+parameter:
+******************************************************************************/
+static bool Paint_BatchGrow(void **Array, UDOUBLE *Capacity, UDOUBLE Need, size_t Size)
+{
+    UDOUBLE New_Capacity = *Capacity ? *Capacity : 64;
+    void *New_Array;
+
+    if (Need <= *Capacity)
+        return true;
+    while (New_Capacity < Need)
+        New_Capacity *= 2;
+    New_Array = realloc(*Array, New_Capacity * Size);
+    if (New_Array == NULL)
+        return false;
+    *Array = New_Array;
+    *Capacity = New_Capacity;
+    return true;
+}
+
+/******************************************************************************
+function: Record a drawing call
+parameter:
+    Data, Len : bytes the call draws from, copied into the batch
+******************************************************************************/
+static void Paint_BatchAdd(PAINT_BATCH *Batch, const PAINT_OP *Op, const void *Data, UDOUBLE Len)
+{
+    if (!Paint_BatchGrow((void **)&Batch->Ops, &Batch->Capacity, Batch->Count + 1, sizeof(PAINT_OP)) ||
+        !Paint_BatchGrow((void **)&Batch->Data, &Batch->Data_Capacity, Batch->Data_Len + Len, 1)) {
+        Debug("Paint_BatchAdd: no memory, call dropped\r\n");
+        Batch->Failed = true;
+        return;
+    }
+    Batch->Ops[Batch->Count] = *Op;
+    Batch->Ops[Batch->Count].Data = Batch->Data_Len;
+    Batch->Count++;
+    if (Len > 0)
+        memcpy(Batch->Data + Batch->Data_Len, Data, Len);
+    Batch->Data_Len += Len;
+}
+
+/******************************************************************************
+function: Set up an empty batch
+parameter:
+******************************************************************************/
+void Paint_Batch_Init(PAINT_BATCH *Batch)
+{
+    memset(Batch, 0, sizeof(*Batch));
+}
+
+/******************************************************************************
+function: Forget the recorded calls, keeping the memory for the next ones
+parameter:
+******************************************************************************/
+void Paint_Batch_Reset(PAINT_BATCH *Batch)
+{
+    Batch->Count = 0;
+    Batch->Data_Len = 0;
+    Batch->Failed = false;
+}
+
+/******************************************************************************
+function: Free the memory of a batch
+parameter:
+******************************************************************************/
+void Paint_Batch_Release(PAINT_BATCH *Batch)
+{
+    free(Batch->Ops);
+    free(Batch->Data);
+    memset(Batch, 0, sizeof(*Batch));
+}
+
+/******************************************************************************
+function: Record the drawing calls of a context instead of drawing them
+parameter:
+    Batch : batch to add the calls to, NULL to draw again
+******************************************************************************/
+void Paint_Ctx_Record(Paint_Ctx *Ctx, PAINT_BATCH *Batch)
+{
+    Ctx->Batch = Batch;
+}
+
 /******************************************************************************
 function: Create Image
 parameter:
@@ -26,28 +169,33 @@ parameter:
     Height  :   The height of the picture
     Color   :   Whether the picture is inverted
 ******************************************************************************/
-void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color)
+void Paint_Ctx_NewImage(Paint_Ctx *Ctx, UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color)
 {
-    Paint.Image = NULL;
-    Paint.Image = image;
+    Ctx->Image = NULL;
+    Ctx->Image = image;
 
-    Paint.WidthMemory = Width;
-    Paint.HeightMemory = Height;
-    Paint.Color = Color;
-    Paint.BitsPerPixel = 8;
-    Paint.GrayScale = pow(2, Paint.BitsPerPixel);
-    Paint.WidthByte = Width;
-    Paint.HeightByte = Height;
+    Ctx->WidthMemory = Width;
+    Ctx->HeightMemory = Height;
+    Ctx->Color = Color;
+    Ctx->BitsPerPixel = 8;
+    Ctx->GrayScale = pow(2, Ctx->BitsPerPixel);
+    Ctx->WidthByte = Width;
+    Ctx->HeightByte = Height;
    
-    Paint.Rotate = Rotate;
-    Paint.Mirror = MIRROR_NONE;
+    Ctx->Rotate = Rotate;
+    Ctx->Mirror = MIRROR_NONE;
+    memset(&Ctx->Damage, 0, sizeof(Ctx->Damage));
+    Ctx->Clip.X = 0;
+    Ctx->Clip.Y = 0;
+    Ctx->Clip.W = Width;
+    Ctx->Clip.H = Height;
     
     if(Rotate == ROTATE_0 || Rotate == ROTATE_180) {
-        Paint.Width = Width;
-        Paint.Height = Height;
+        Ctx->Width = Width;
+        Ctx->Height = Height;
     } else {
-        Paint.Width = Height;
-        Paint.Height = Width;
+        Ctx->Width = Height;
+        Ctx->Height = Width;
     }
 }
 
@@ -56,9 +204,9 @@ function: Select Image
 parameter:
     image : Pointer to the image cache
 ******************************************************************************/
-void Paint_SelectImage(UBYTE *image)
+void Paint_Ctx_SelectImage(Paint_Ctx *Ctx, UBYTE *image)
 {
-    Paint.Image = image;
+    Ctx->Image = image;
 }
 
 /******************************************************************************
@@ -66,11 +214,11 @@ function: Select Image Rotate
 parameter:
     Rotate : 0,90,180,270
 ******************************************************************************/
-void Paint_SetRotate(UWORD Rotate)
+void Paint_Ctx_SetRotate(Paint_Ctx *Ctx, UWORD Rotate)
 {
     if(Rotate == ROTATE_0 || Rotate == ROTATE_90 || Rotate == ROTATE_180 || Rotate == ROTATE_270) {
         Debug("Set image Rotate %d\r\n", Rotate);
-        Paint.Rotate = Rotate;
+        Ctx->Rotate = Rotate;
     } else {
         Debug("rotate = 0, 90, 180, 270\r\n");
     }
@@ -81,12 +229,12 @@ function:	Select Image mirror
 parameter:
     mirror   :Not mirror,Horizontal mirror,Vertical mirror,Origin mirror
 ******************************************************************************/
-void Paint_SetMirroring(UBYTE mirror)
+void Paint_Ctx_SetMirroring(Paint_Ctx *Ctx, UBYTE mirror)
 {
     if(mirror == MIRROR_NONE || mirror == MIRROR_HORIZONTAL || 
         mirror == MIRROR_VERTICAL || mirror == MIRROR_ORIGIN) {
         Debug("mirror image x:%s, y:%s\r\n",(mirror & 0x01)? "mirror":"none", ((mirror >> 1) & 0x01)? "mirror":"none");
-        Paint.Mirror = mirror;
+        Ctx->Mirror = mirror;
     } else {
         Debug("mirror should be MIRROR_NONE, MIRROR_HORIZONTAL, \
         MIRROR_VERTICAL or MIRROR_ORIGIN\r\n");
@@ -100,12 +248,12 @@ parameter:
     Ypoint : At point Y
     Color  : Painted colors
 ******************************************************************************/
-void Paint_SetBitsPerPixel(UBYTE bpp)
+void Paint_Ctx_SetBitsPerPixel(Paint_Ctx *Ctx, UBYTE bpp)
 {
     if(bpp == 8 || bpp == 4 || bpp == 2 || bpp == 1){
-            Paint.BitsPerPixel = bpp;
-            Paint.GrayScale = pow(2, Paint.BitsPerPixel);
-            Paint.WidthByte = (Paint.WidthMemory * bpp % 8 == 0)? (Paint.WidthMemory * bpp / 8 ) : (Paint.WidthMemory * bpp / 8 + 1);
+            Ctx->BitsPerPixel = bpp;
+            Ctx->GrayScale = pow(2, Ctx->BitsPerPixel);
+            Ctx->WidthByte = (Ctx->WidthMemory * bpp % 8 == 0)? (Ctx->WidthMemory * bpp / 8 ) : (Ctx->WidthMemory * bpp / 8 + 1);
     }
     else{
         Debug("Set BitsPerPixel Input parameter error\r\n");
@@ -114,283 +262,1206 @@ void Paint_SetBitsPerPixel(UBYTE bpp)
 }
 
 /******************************************************************************
-function: Draw Pixels
+function: Map a point of the rotated, mirrored image to image memory
 parameter:
     Xpoint : At point X
     Ypoint : At point Y
-    Color  : Painted colors
+    X, Y   : Receive the memory coordinates
 ******************************************************************************/
-void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+static inline bool Paint_MapPoint(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, UWORD *X, UWORD *Y)
 {
-    if(Xpoint > Paint.Width || Ypoint > Paint.Height){
-        //Debug("Exceeding display boundaries\r\n");
-        return;
-    }      
-    UWORD X, Y;
-
-    switch(Paint.Rotate) {
+    switch(Ctx->Rotate) {
     case 0:
-        X = Xpoint;
-        Y = Ypoint;  
+        *X = Xpoint;
+        *Y = Ypoint;  
         break;
     case 90:
-        X = Paint.WidthMemory - Ypoint - 1;
-        Y = Xpoint;
+        *X = Ctx->WidthMemory - Ypoint - 1;
+        *Y = Xpoint;
         break;
     case 180:
-        X = Paint.WidthMemory - Xpoint - 1;
-        Y = Paint.HeightMemory - Ypoint - 1;
+        *X = Ctx->WidthMemory - Xpoint - 1;
+        *Y = Ctx->HeightMemory - Ypoint - 1;
         break;
     case 270:
-        X = Ypoint;
-        Y = Paint.HeightMemory - Xpoint - 1;
+        *X = Ypoint;
+        *Y = Ctx->HeightMemory - Xpoint - 1;
         break;
     default:
-        return;
+        return false;
     }
     
-    switch(Paint.Mirror) {
+    switch(Ctx->Mirror) {
     case MIRROR_NONE:
         break;
     case MIRROR_HORIZONTAL:
-        X = Paint.WidthMemory - X - 1;
+        *X = Ctx->WidthMemory - *X - 1;
         break;
     case MIRROR_VERTICAL:
-        Y = Paint.HeightMemory - Y - 1;
+        *Y = Ctx->HeightMemory - *Y - 1;
         break;
     case MIRROR_ORIGIN:
-        X = Paint.WidthMemory - X - 1;
-        Y = Paint.HeightMemory - Y - 1;
+        *X = Ctx->WidthMemory - *X - 1;
+        *Y = Ctx->HeightMemory - *Y - 1;
         break;
     default:
-        return;
+        return false;
     }
+    return true;
+}
 
-    if(X > Paint.WidthMemory || Y > Paint.HeightMemory){
-        Debug("Exceeding display boundaries\r\n");
-        return;
+/******************************************************************************
+function: Check whether a memory pixel is inside the clip
+parameter:
+******************************************************************************/
+static inline bool Paint_InClip(Paint_Ctx *Ctx, UWORD X, UWORD Y)
+{
+    return X >= Ctx->Clip.X && X - Ctx->Clip.X < Ctx->Clip.W &&
+           Y >= Ctx->Clip.Y && Y - Ctx->Clip.Y < Ctx->Clip.H;
+}
+
+/******************************************************************************
+function: Grow the box of the drawing in progress; it becomes an area later
+parameter:
+    X, Y : memory coordinates of a pixel that was set
+******************************************************************************/
+static inline void Paint_DamageGrow(Paint_Ctx *Ctx, UWORD X, UWORD Y)
+{
+    PAINT_DAMAGE *Damage = &Ctx->Damage;
+    if(!Damage->Pending) {
+        Damage->Pending = true;
+        Damage->Pending_X0 = Damage->Pending_X1 = X;
+        Damage->Pending_Y0 = Damage->Pending_Y1 = Y;
+    } else {
+        if(X < Damage->Pending_X0) Damage->Pending_X0 = X;
+        if(X > Damage->Pending_X1) Damage->Pending_X1 = X;
+        if(Y < Damage->Pending_Y0) Damage->Pending_Y0 = Y;
+        if(Y > Damage->Pending_Y1) Damage->Pending_Y1 = Y;
     }
+}
 
-    UDOUBLE Addr = X * (Paint.BitsPerPixel) / 8 + Y * Paint.WidthByte;
+/******************************************************************************
+function: Write one pixel of a memory row
+parameter:
+    Row   : first byte of the row
+    X     : memory column
+    Color : Painted colors
+******************************************************************************/
+static inline void Paint_PutPixel(Paint_Ctx *Ctx, UBYTE *Row, UWORD X, UWORD Color)
+{
+    UBYTE *Byte = Row + X * Ctx->BitsPerPixel / 8;
 
-    switch( Paint.BitsPerPixel ){
+    switch( Ctx->BitsPerPixel ){
         case 8:{
-            Paint.Image[Addr] = Color & 0xF0;
+            *Byte = Color & 0xF0;
             break;
         }
         case 4:{
-            Paint.Image[Addr] &= ~( (0xF0) >> (7 - (X*4+3)%8 ) );
-            Paint.Image[Addr] |= (Color & 0xF0) >> (7 - (X*4+3)%8 );
+            *Byte &= ~( (0xF0) >> (7 - (X*4+3)%8 ) );
+            *Byte |= (Color & 0xF0) >> (7 - (X*4+3)%8 );
             break;
         }
         case 2:{
-            Paint.Image[Addr] &= ~( (0xC0) >> (7 - (X*2+1)%8 ) );
-            Paint.Image[Addr] |= (Color & 0xC0) >> (7 - (X*2+1)%8 );
+            *Byte &= ~( (0xC0) >> (7 - (X*2+1)%8 ) );
+            *Byte |= (Color & 0xC0) >> (7 - (X*2+1)%8 );
             break;
         }
         case 1:{
-            Paint.Image[Addr] &= ~( (0x80) >> (7 - X%8) );
-            Paint.Image[Addr] |= (Color & 0x80) >> (7 - X%8);
+            *Byte &= ~( (0x80) >> (7 - X%8) );
+            *Byte |= (Color & 0x80) >> (7 - X%8);
             break;
         }
     }
 }
 
-void Paint_SetColor(UWORD x, UWORD y, UWORD color)
+/******************************************************************************
+function: Draw Pixels
+parameter:
+    Xpoint : At point X
+    Ypoint : At point Y
+    Color  : Painted colors
+******************************************************************************/
+void Paint_Ctx_SetPixel(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, UWORD Color)
 {
-	UWORD arr_XY[2] = {x, y};
-	UBYTE arr_color[9];
-	UBYTE offset = x/3%3;
-	
-	if(x%3 != 1)
-		(x%3==0) ? (arr_XY[0]++) : (arr_XY[0]--);
-	if((y+2)%3 != 1)
-		((y+2)%3==0) ? (arr_XY[1]++) : (arr_XY[1]--);
-	arr_XY[1] -= offset;
-	
-	Paint_GetColor(color, arr_color);
-	for(UBYTE i=0; i<3; i++) {
-		for(UBYTE j=0; j<3; j++) {
-			Paint_SetPixel(arr_XY[0]-1+j, arr_XY[1]-1+i, arr_color[i*3+j]);
-		}
-	}
-}
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_PIXEL, .X0 = Xpoint, .Y0 = Ypoint, .Color = Color};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if(Xpoint >= Ctx->Width || Ypoint >= Ctx->Height){
+        //Debug("Exceeding display boundaries\r\n");
+        return;
+    }      
+    UWORD X, Y;
 
-void Paint_GetColor(UWORD color, UBYTE* arr_color)
-{
-	UBYTE* p_color = arr_color;
-	UWORD R, G, B;
+    if(!Paint_MapPoint(Ctx, Xpoint, Ypoint, &X, &Y))
+        return;
 
-	B = (color>>4) & 0xf0;
-	G =  color	   & 0xf0;
-	R = (color<<4) & 0xf0;
-	UBYTE temp[9] = {G, G, G/2, B, B, B/2, R, R, R/2};
-	
-	for(UBYTE t=0; t<9; t++) {
-		p_color[t] = temp[t];
-	}
+    if(X >= Ctx->WidthMemory || Y >= Ctx->HeightMemory){
+        Debug("Exceeding display boundaries\r\n");
+        return;
+    }
+    if(!Paint_InClip(Ctx, X, Y))
+        return;
+
+    Paint_DamageGrow(Ctx, X, Y);
+    Paint_PutPixel(Ctx, Ctx->Image + (UDOUBLE)Y * Ctx->WidthByte, X, Color);
 }
 
 /******************************************************************************
-function: Clear the color of the picture
+function: A color repeated over every pixel of a byte, as Paint_SetPixel() stores it
 parameter:
     Color : Painted colors
 ******************************************************************************/
-void Paint_Clear(UWORD Color)
+static inline UBYTE Paint_ColorByte(Paint_Ctx *Ctx, UWORD Color)
 {
-    UDOUBLE ImageSize = Paint.WidthByte * Paint.HeightByte;
-    memset(Paint.Image, Color,  ImageSize);
+    switch(Ctx->BitsPerPixel) {
+    case 4:
+        return (Color & 0xF0) | ((Color & 0xF0) >> 4);
+    case 2:
+        return ((Color >> 6) & 0x03) * 0x55;
+    case 1:
+        return (Color & 0x80) ? 0xFF : 0x00;
+    default:
+        return Color & 0xF0;
+    }
 }
 
 /******************************************************************************
-function: Clear the color of a window
+function: Bits of the pixels P0..P1 of one byte, leftmost pixel in the low bits
 parameter:
-    Xstart : x starting point
-    Ystart : Y starting point
-    Xend   : x end point
-    Yend   : y end point
-    Color  : Painted colors
 ******************************************************************************/
-void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
+static inline UBYTE Paint_ByteMask(Paint_Ctx *Ctx, UWORD P0, UWORD P1)
 {
-    for (UWORD Y = Ystart; Y < Yend; Y++) {
-        for (UWORD X = Xstart; X < Xend; X++) {
-            Paint_SetPixel(X, Y, Color);
-        }
-    }
+    unsigned Bpp = Ctx->BitsPerPixel;
+    return (UBYTE)(((1u << ((P1 + 1) * Bpp)) - 1) & ~((1u << (P0 * Bpp)) - 1));
 }
 
 /******************************************************************************
-function: Draw Point(Xpoint, Ypoint) Fill the color
+function: Map a span of the rotated, mirrored image to image memory
 parameter:
-    Xpoint		: The Xpoint coordinate of the point
-    Ypoint		: The Ypoint coordinate of the point
-    Color		: Painted color
-    Dot_Pixel	: point size
-    Dot_Style	: point Style
+    Xpoint, Ypoint : first pixel
+    Len            : pixels, clipped to the image and the clip on return
+    Skip           : receives the pixels dropped from the start by the clip
+    X, Y           : memory coordinates of the first pixel drawn
+    DX, DY         : memory step from one pixel of the span to the next
+return: false if the span does not map as one run; Len is 0 if nothing of
+        it is inside the clip
 ******************************************************************************/
-void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
-                     DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
+static bool Paint_MapSpan(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, UWORD *Len, UWORD *Skip,
+                          UWORD *X, UWORD *Y, int *DX, int *DY)
 {
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height) {
-        Debug("Paint_DrawPoint Input exceeds the normal display range\r\n");
-        return;
-    }
+    UWORD X1, Y1;
 
-    int16_t XDir_Num , YDir_Num;
-    if (Dot_Style == DOT_FILL_AROUND) {
-        for (XDir_Num = 0; XDir_Num < 2 * Dot_Pixel - 1; XDir_Num++) {
-            for (YDir_Num = 0; YDir_Num < 2 * Dot_Pixel - 1; YDir_Num++) {
-                if(Xpoint + XDir_Num - Dot_Pixel < 0 || Ypoint + YDir_Num - Dot_Pixel < 0)
-                    break;
-                // Debug("x = %d, y = %d\r\n", Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel);
-				if(isColor)
-					Paint_SetColor(Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
-                else
-					Paint_SetPixel(Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
-            }
-        }
+    *Skip = 0;
+    if(Xpoint >= Ctx->Width || Ypoint >= Ctx->Height || *Len == 0)
+        return false;
+    if(*Len > Ctx->Width - Xpoint)
+        *Len = Ctx->Width - Xpoint;
+
+    //One transform for the whole span: the end is a straight run from the start
+    if(!Paint_MapPoint(Ctx, Xpoint, Ypoint, X, Y) ||
+       !Paint_MapPoint(Ctx, Xpoint + *Len - 1, Ypoint, &X1, &Y1))
+        return false;
+    if(*X >= Ctx->WidthMemory || *Y >= Ctx->HeightMemory ||
+       X1 >= Ctx->WidthMemory || Y1 >= Ctx->HeightMemory)
+        return false;  //Rotated after Paint_NewImage(); only part of the span fits
+
+    *DX = (X1 > *X) - (X1 < *X);
+    *DY = (Y1 > *Y) - (Y1 < *Y);
+    if(*DX == 0 && *DY == 0)
+        *DX = 1;
+
+    //The span runs along one memory axis: trim it to the clip on that axis
+    bool Down = *DY != 0;
+    int Step = Down ? *DY : *DX;
+    int At = Down ? *Y : *X, Across = Down ? *X : *Y;
+    int Lo = Down ? Ctx->Clip.Y : Ctx->Clip.X, Hi = Lo + (Down ? Ctx->Clip.H : Ctx->Clip.W);
+    int Across_Lo = Down ? Ctx->Clip.X : Ctx->Clip.Y, Across_Hi = Across_Lo + (Down ? Ctx->Clip.W : Ctx->Clip.H);
+    int First, Last;
+    if(Step > 0) {
+        First = At < Lo ? Lo - At : 0;
+        Last = Hi - 1 - At;
     } else {
-        for (XDir_Num = 0; XDir_Num <  Dot_Pixel; XDir_Num++) {
-            for (YDir_Num = 0; YDir_Num <  Dot_Pixel; YDir_Num++) {
-				if(isColor)
-					Paint_SetColor(Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
-				else
-					Paint_SetPixel(Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
-            }
-        }
+        First = At >= Hi ? At - (Hi - 1) : 0;
+        Last = At - Lo;
+    }
+    if(Last > *Len - 1)
+        Last = *Len - 1;
+    if(Across < Across_Lo || Across >= Across_Hi || First > Last) {
+        *Len = 0;
+        return false;
+    }
+    *Skip = First;
+    *Len = Last - First + 1;
+    if(Down) {
+        *Y = At + Step * First;
+        Y1 = *Y + Step * (*Len - 1);
+    } else {
+        *X = At + Step * First;
+        X1 = *X + Step * (*Len - 1);
     }
+
+    Paint_DamageGrow(Ctx, *X, *Y);
+    Paint_DamageGrow(Ctx, X1, Y1);
+    return true;
 }
 
 /******************************************************************************
-function: Draw a line of arbitrary slope
+function: Fill the memory pixels X0..X1 of a row with a byte pattern
 parameter:
-    Xstart ：Starting Xpoint point coordinates
-    Ystart ：Starting Xpoint point coordinates
-    Xend   ：End point Xpoint coordinate
-    Yend   ：End point Ypoint coordinate
-    Color  ：The color of the line segment
-    Line_width : Line width
-    Line_Style: Solid and dotted lines
+    Row     : first byte of the memory row
+    Pattern : the color in every pixel of a byte
 ******************************************************************************/
-void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
-                    UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+static void Paint_FillRow(Paint_Ctx *Ctx, UBYTE *Row, UWORD X0, UWORD X1, UBYTE Pattern)
 {
-    if (Xstart > Paint.Width || Ystart > Paint.Height ||
-        Xend > Paint.Width || Yend > Paint.Height) {
-        Debug("Paint_DrawLine Input exceeds the normal display range\r\n");
+    UWORD Bpp = Ctx->BitsPerPixel;
+    if(Bpp == 8) {
+        memset(Row + X0, Pattern, X1 - X0 + 1);
         return;
     }
 
-    UWORD Xpoint = Xstart;
-    UWORD Ypoint = Ystart;
-    int dx = (int)Xend - (int)Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
-    int dy = (int)Yend - (int)Ystart <= 0 ? Yend - Ystart : Ystart - Yend;
-
-    // Increment direction, 1 is positive, -1 is counter;
-    int XAddway = Xstart < Xend ? 1 : -1;
-    int YAddway = Ystart < Yend ? 1 : -1;
-
-    //Cumulative error
-    int Esp = dx + dy;
-    char Dotted_Len = 0;
-
-    for (;;) {
-        Dotted_Len++;
-        //Painted dotted line, 2 point is really virtual
-        if (Line_Style == LINE_STYLE_DOTTED && Dotted_Len % 3 == 0) {
-            //Debug("LINE_DOTTED\r\n");
-            Paint_DrawPoint(Xpoint, Ypoint, IMAGE_BACKGROUND, Line_width, DOT_STYLE_DFT);
-            Dotted_Len = 0;
-        } else {
-            Paint_DrawPoint(Xpoint, Ypoint, Color, Line_width, DOT_STYLE_DFT);
-        }
-        if (2 * Esp >= dy) {
-            if (Xpoint == Xend)
-                break;
-            Esp += dy;
-            Xpoint += XAddway;
-        }
-        if (2 * Esp <= dx) {
-            if (Ypoint == Yend)
-                break;
-            Esp += dx;
-            Ypoint += YAddway;
-        }
+    //Masked edge bytes, whole bytes in between
+    UWORD PPB = 8 / Bpp;
+    UDOUBLE B0 = X0 / PPB, B1 = X1 / PPB;
+    if(B0 == B1) {
+        UBYTE Mask = Paint_ByteMask(Ctx, X0 % PPB, X1 % PPB);
+        Row[B0] = (Row[B0] & ~Mask) | (Pattern & Mask);
+        return;
+    }
+    if(X0 % PPB != 0) {
+        UBYTE Mask = Paint_ByteMask(Ctx, X0 % PPB, PPB - 1);
+        Row[B0] = (Row[B0] & ~Mask) | (Pattern & Mask);
+        B0++;
     }
+    if(X1 % PPB != PPB - 1) {
+        UBYTE Mask = Paint_ByteMask(Ctx, 0, X1 % PPB);
+        Row[B1] = (Row[B1] & ~Mask) | (Pattern & Mask);
+    } else {
+        B1++;
+    }
+    if(B1 > B0)
+        memset(Row + B0, Pattern, B1 - B0);
 }
 
 /******************************************************************************
-function: Draw a rectangle
+function: Fill a run of pixels of one row
 parameter:
-    Xstart ：Rectangular  Starting Xpoint point coordinates
-    Ystart ：Rectangular  Starting Xpoint point coordinates
-    Xend   ：Rectangular  End point Xpoint coordinate
-    Yend   ：Rectangular  End point Ypoint coordinate
-    Color  ：The color of the Rectangular segment
-    Line_width: Line width
-    Draw_Fill : Whether to fill the inside of the rectangle
+    Xpoint : x starting point
+    Ypoint : Y point
+    Len    : number of pixels
+    Color  : Painted colors
 ******************************************************************************/
-void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
-                         UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+void Paint_Ctx_FillSpan(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, UWORD Len, UWORD Color)
 {
-    if (Xstart > Paint.Width || Ystart > Paint.Height ||
-        Xend > Paint.Width || Yend > Paint.Height) {
-        Debug("Input exceeds the normal display range\r\n");
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_SPAN, .X0 = Xpoint, .Y0 = Ypoint, .R0 = Len, .Color = Color};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
         return;
     }
+    UWORD X, Y, Skip, Bpp = Ctx->BitsPerPixel;
+    int DX, DY;
 
-    if (Draw_Fill) {
-        UWORD Ypoint;
-        for(Ypoint = Ystart; Ypoint < Yend; Ypoint++) {
-            Paint_DrawLine(Xstart, Ypoint, Xend, Ypoint, Color , Line_width, LINE_STYLE_SOLID);
-        }
-    } else {
-        Paint_DrawLine(Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xend, Yend, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
-        Paint_DrawLine(Xend, Yend, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+    if(!Paint_MapSpan(Ctx, Xpoint, Ypoint, &Len, &Skip, &X, &Y, &DX, &DY)) {
+        for(UWORD i = 0; i < Len && Xpoint + i < Ctx->Width; i++)
+            Paint_Ctx_SetPixel(Ctx, Xpoint + i, Ypoint, Color);
+        return;
+    }
+
+    UBYTE Pattern = Paint_ColorByte(Ctx, Color);
+    UBYTE *Row = Ctx->Image + (UDOUBLE)Y * Ctx->WidthByte;
+
+    if(DY != 0) {
+        //Rotated by 90 or 270 degrees: one pixel in each memory row
+        UWORD Top = DY > 0 ? Y : Y - (Len - 1);
+        UBYTE Mask = Paint_ByteMask(Ctx, X % (8 / Bpp), X % (8 / Bpp));
+        UBYTE *Byte = Ctx->Image + (UDOUBLE)Top * Ctx->WidthByte + X * Bpp / 8;
+        for(UWORD i = 0; i < Len; i++, Byte += Ctx->WidthByte)
+            *Byte = (*Byte & ~Mask) | (Pattern & Mask);
+        return;
     }
+
+    UWORD X0 = DX > 0 ? X : X - (Len - 1);
+    Paint_FillRow(Ctx, Row, X0, X0 + Len - 1, Pattern);
+}
+
+/******************************************************************************
+function: Gray level of one pixel of a packed row
+parameter:
+    Src : row, leftmost pixel in the low bits of each byte
+    i   : pixel
+    Bpp : bits per pixel of Src
+******************************************************************************/
+static inline UBYTE Paint_RowPixel(const UBYTE *Src, UWORD i, UBYTE Bpp)
+{
+    switch(Bpp) {
+    case 4:
+        return ((Src[i / 2] >> ((i % 2) * 4)) & 0x0F) * 0x11;
+    case 2:
+        return ((Src[i / 4] >> ((i % 4) * 2)) & 0x03) * 0x55;
+    case 1:
+        return ((Src[i / 8] >> (i % 8)) & 0x01) ? 0xFF : 0x00;
+    default:
+        return Src[i];
+    }
+}
+
+/******************************************************************************
+function: Copy a row of pixels into the image
+parameter:
+    Xpoint  : x starting point
+    Ypoint  : Y point
+    Src     : pixels, packed as in the image: leftmost in the low bits
+    Len     : number of pixels
+    Src_Bpp : bits per pixel of Src, 1, 2, 4 or 8
+******************************************************************************/
+void Paint_Ctx_BlitRow(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, const UBYTE *Src, UWORD Len, UBYTE Src_Bpp)
+{
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_ROW, .X0 = Xpoint, .Y0 = Ypoint, .R0 = Len, .Style = Src_Bpp};
+        Paint_BatchAdd(Ctx->Batch, &Op, Src, ((UDOUBLE)Len * Src_Bpp + 7) / 8);
+        return;
+    }
+    UWORD X, Y, Skip, Bpp = Ctx->BitsPerPixel;
+    int DX, DY;
+
+    if(Src_Bpp != 8 && Src_Bpp != 4 && Src_Bpp != 2 && Src_Bpp != 1) {
+        Debug("Paint_BlitRow Src_Bpp Only support: 1 2 4 8 \r\n");
+        return;
+    }
+    if(!Paint_MapSpan(Ctx, Xpoint, Ypoint, &Len, &Skip, &X, &Y, &DX, &DY)) {
+        for(UWORD i = 0; i < Len && Xpoint + i < Ctx->Width; i++)
+            Paint_Ctx_SetPixel(Ctx, Xpoint + i, Ypoint, Paint_RowPixel(Src, i, Src_Bpp));
+        return;
+    }
+
+    UBYTE *Row = Ctx->Image + (UDOUBLE)Y * Ctx->WidthByte;
+
+    //Same layout, forward and byte aligned: copy whole bytes
+    if(DX > 0 && Src_Bpp == Bpp && X % (8 / Bpp) == 0 && Skip % (8 / Bpp) == 0) {
+        UBYTE *Dst = Row + X * Bpp / 8;
+        Src += Skip * Bpp / 8;
+        if(Bpp == 8) {
+            for(UWORD i = 0; i < Len; i++)
+                Dst[i] = Src[i] & 0xF0;
+            return;
+        }
+        UWORD PPB = 8 / Bpp, Bytes = Len / PPB;
+        memcpy(Dst, Src, Bytes);
+        if(Len % PPB != 0) {
+            UBYTE Mask = Paint_ByteMask(Ctx, 0, Len % PPB - 1);
+            Dst[Bytes] = (Dst[Bytes] & ~Mask) | (Src[Bytes] & Mask);
+        }
+        return;
+    }
+
+    for(UWORD i = 0; i < Len; i++) {
+        Paint_PutPixel(Ctx, Row, X, Paint_RowPixel(Src, Skip + i, Src_Bpp));
+        X += DX;
+        Row += DY * (int)Ctx->WidthByte;
+    }
+}
+
+/******************************************************************************
+function: Cost of refreshing an area, in pixels
+parameter:
+******************************************************************************/
+static UDOUBLE Paint_DamageCost(const PAINT_RECT *Rect)
+{
+    return (UDOUBLE)Rect->W * Rect->H + PAINT_DAMAGE_AREA_COST;
+}
+
+/******************************************************************************
+function: Bounding box of two areas
+parameter:
+******************************************************************************/
+static PAINT_RECT Paint_DamageUnion(const PAINT_RECT *A, const PAINT_RECT *B)
+{
+    PAINT_RECT U;
+    UWORD X1 = (A->X + A->W > B->X + B->W) ? A->X + A->W : B->X + B->W;
+    UWORD Y1 = (A->Y + A->H > B->Y + B->H) ? A->Y + A->H : B->Y + B->H;
+    U.X = A->X < B->X ? A->X : B->X;
+    U.Y = A->Y < B->Y ? A->Y : B->Y;
+    U.W = X1 - U.X;
+    U.H = Y1 - U.Y;
+    return U;
+}
+
+/******************************************************************************
+function: Check whether two areas overlap or share an edge
+parameter:
+******************************************************************************/
+static bool Paint_DamageTouches(const PAINT_RECT *A, const PAINT_RECT *B)
+{
+    return A->X <= B->X + B->W && B->X <= A->X + A->W &&
+           A->Y <= B->Y + B->H && B->Y <= A->Y + A->H;
+}
+
+/******************************************************************************
+function: Add an area to a list, merging it with the areas it should share a refresh with
+parameter:
+    Rects, Count : list of disjoint areas
+    Max          : capacity of the list
+    Rect         : new area
+    Cost_Merge   : also merge areas that are cheaper to refresh as one
+******************************************************************************/
+static void Paint_DamageInsert(PAINT_RECT *Rects, UWORD *Count, UWORD Max, PAINT_RECT Rect, bool Cost_Merge)
+{
+    for (;;) {
+        bool Merged = false;
+        for (UWORD i = 0; i < *Count; i++) {
+            PAINT_RECT U = Paint_DamageUnion(&Rect, &Rects[i]);
+            if (Paint_DamageTouches(&Rect, &Rects[i]) ||
+                (Cost_Merge && Paint_DamageCost(&U) <= Paint_DamageCost(&Rect) + Paint_DamageCost(&Rects[i]))) {
+                Rect = U;
+                Rects[i] = Rects[--*Count];
+                Merged = true;
+                break;
+            }
+        }
+        if (Merged)
+            continue;
+        if (*Count < Max)
+            break;
+
+        //Full: fold into the area whose bounding box grows the least
+        UWORD Best = 0;
+        UDOUBLE Best_Growth = ~(UDOUBLE)0;
+        for (UWORD i = 0; i < *Count; i++) {
+            PAINT_RECT U = Paint_DamageUnion(&Rect, &Rects[i]);
+            UDOUBLE Growth = (UDOUBLE)U.W * U.H - (UDOUBLE)Rects[i].W * Rects[i].H;
+            if (Growth < Best_Growth) {
+                Best = i;
+                Best_Growth = Growth;
+            }
+        }
+        Rect = Paint_DamageUnion(&Rect, &Rects[Best]);
+        Rects[Best] = Rects[--*Count];
+    }
+    Rects[(*Count)++] = Rect;
+}
+
+/******************************************************************************
+function: Record the pixels set since the last area as one area
+parameter:
+******************************************************************************/
+static void Paint_DamageFlush(Paint_Ctx *Ctx)
+{
+    PAINT_DAMAGE *Damage = &Ctx->Damage;
+    PAINT_RECT Rect;
+
+    if (!Damage->Pending)
+        return;
+    Damage->Pending = false;
+    Rect.X = Damage->Pending_X0;
+    Rect.Y = Damage->Pending_Y0;
+    Rect.W = Damage->Pending_X1 - Damage->Pending_X0 + 1;
+    Rect.H = Damage->Pending_Y1 - Damage->Pending_Y0 + 1;
+    Paint_DamageInsert(Damage->Rect, &Damage->Count, PAINT_DAMAGE_MAX, Rect, true);
+}
+
+/******************************************************************************
+function: Start a group of drawing that forms one damaged area
+parameter:
+******************************************************************************/
+void Paint_Ctx_BeginDamage(Paint_Ctx *Ctx)
+{
+    //Pixels set outside any group are an area of their own
+    if (Ctx->Damage.Depth == 0)
+        Paint_DamageFlush(Ctx);
+    Ctx->Damage.Depth++;
+}
+
+/******************************************************************************
+function: End a group of drawing
+parameter:
+******************************************************************************/
+void Paint_Ctx_EndDamage(Paint_Ctx *Ctx)
+{
+    if (Ctx->Damage.Depth > 0 && --Ctx->Damage.Depth == 0)
+        Paint_DamageFlush(Ctx);
+}
+
+/******************************************************************************
+function: Map an area of the rotated, mirrored image to image memory
+parameter:
+    Xend, Yend : exclusive
+return: false if the area is empty
+******************************************************************************/
+static bool Paint_MapRect(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, PAINT_RECT *Rect)
+{
+    UWORD X0, Y0, X1, Y1;
+
+    if (Xend > Ctx->Width)
+        Xend = Ctx->Width;
+    if (Yend > Ctx->Height)
+        Yend = Ctx->Height;
+    if (Xstart >= Xend || Ystart >= Yend)
+        return false;
+
+    //Opposite corners of the rotated, mirrored area
+    if (!Paint_MapPoint(Ctx, Xstart, Ystart, &X0, &Y0) || !Paint_MapPoint(Ctx, Xend - 1, Yend - 1, &X1, &Y1))
+        return false;
+    Rect->X = X0 < X1 ? X0 : X1;
+    Rect->Y = Y0 < Y1 ? Y0 : Y1;
+    Rect->W = (X0 < X1 ? X1 - X0 : X0 - X1) + 1;
+    Rect->H = (Y0 < Y1 ? Y1 - Y0 : Y0 - Y1) + 1;
+    return true;
+}
+
+/******************************************************************************
+function: Cut an area of image memory down to its part inside another
+parameter:
+return: false if nothing is left
+******************************************************************************/
+static bool Paint_IntersectRect(PAINT_RECT *Rect, const PAINT_RECT *Bounds)
+{
+    UDOUBLE X1 = Rect->X + Rect->W, Y1 = Rect->Y + Rect->H;
+    UDOUBLE BX1 = Bounds->X + Bounds->W, BY1 = Bounds->Y + Bounds->H;
+
+    if (Rect->X < Bounds->X)
+        Rect->X = Bounds->X;
+    if (Rect->Y < Bounds->Y)
+        Rect->Y = Bounds->Y;
+    if (X1 > BX1)
+        X1 = BX1;
+    if (Y1 > BY1)
+        Y1 = BY1;
+    if (X1 <= Rect->X || Y1 <= Rect->Y)
+        return false;
+    Rect->W = X1 - Rect->X;
+    Rect->H = Y1 - Rect->Y;
+    return true;
+}
+
+/******************************************************************************
+function: Mark an area as changed
+parameter:
+    Xstart : x starting point
+    Ystart : Y starting point
+    Xend   : x end point, exclusive
+    Yend   : y end point, exclusive
+******************************************************************************/
+void Paint_Ctx_AddDamage(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
+{
+    PAINT_RECT Rect;
+
+    if (Paint_MapRect(Ctx, Xstart, Ystart, Xend, Yend, &Rect))
+        Paint_Ctx_AddDamageRect(Ctx, &Rect);
+}
+
+/******************************************************************************
+function: Mark an area of image memory as changed
+parameter:
+    Rect : memory coordinates, as from Paint_GetDamage()
+******************************************************************************/
+void Paint_Ctx_AddDamageRect(Paint_Ctx *Ctx, const PAINT_RECT *Rect)
+{
+    PAINT_RECT Clipped = *Rect;
+
+    if (Paint_IntersectRect(&Clipped, &Ctx->Clip))
+        Paint_DamageInsert(Ctx->Damage.Rect, &Ctx->Damage.Count, PAINT_DAMAGE_MAX, Clipped, true);
+}
+
+/******************************************************************************
+function: Limit drawing to an area
+parameter:
+    Xstart, Ystart : top left corner
+    Xend, Yend     : bottom right corner, exclusive
+******************************************************************************/
+void Paint_Ctx_SetClip(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
+{
+    PAINT_RECT Memory = {0, 0, Ctx->WidthMemory, Ctx->HeightMemory};
+
+    if (!Paint_MapRect(Ctx, Xstart, Ystart, Xend, Yend, &Ctx->Clip) ||
+        !Paint_IntersectRect(&Ctx->Clip, &Memory))
+        memset(&Ctx->Clip, 0, sizeof(Ctx->Clip));
+}
+
+/******************************************************************************
+function: Draw on the whole image again
+parameter:
+******************************************************************************/
+void Paint_Ctx_ClearClip(Paint_Ctx *Ctx)
+{
+    Ctx->Clip.X = 0;
+    Ctx->Clip.Y = 0;
+    Ctx->Clip.W = Ctx->WidthMemory;
+    Ctx->Clip.H = Ctx->HeightMemory;
+}
+
+/******************************************************************************
+function: Get the damaged areas, aligned for the controller
+parameter:
+    Rects : receives the areas
+    Max   : size of Rects
+    Align : pixel alignment of X and W
+******************************************************************************/
+UWORD Paint_Ctx_GetDamage(Paint_Ctx *Ctx, PAINT_RECT *Rects, UWORD Max, UWORD Align)
+{
+    PAINT_RECT Aligned[PAINT_DAMAGE_MAX];
+    UWORD Count = 0;
+
+    if (Ctx->Damage.Depth == 0)
+        Paint_DamageFlush(Ctx);
+    if (Align == 0)
+        Align = 1;
+
+    for (UWORD i = 0; i < Ctx->Damage.Count; i++) {
+        PAINT_RECT Rect = Ctx->Damage.Rect[i];
+        UDOUBLE X1 = Rect.X + Rect.W;
+        Rect.X -= Rect.X % Align;
+        X1 = (X1 + Align - 1) / Align * Align;
+        if (X1 > Ctx->WidthMemory)
+            X1 = Ctx->WidthMemory;
+        Rect.W = X1 - Rect.X;
+        //Widening can make areas overlap, which must not be refreshed twice
+        Paint_DamageInsert(Aligned, &Count, PAINT_DAMAGE_MAX, Rect, false);
+    }
+
+    if (Count > Max)
+        Count = Max;
+    memcpy(Rects, Aligned, Count * sizeof(PAINT_RECT));
+    return Count;
+}
+
+/******************************************************************************
+function: Forget all damage
+parameter:
+******************************************************************************/
+void Paint_Ctx_ClearDamage(Paint_Ctx *Ctx)
+{
+    UWORD Depth = Ctx->Damage.Depth;
+    memset(&Ctx->Damage, 0, sizeof(Ctx->Damage));
+    Ctx->Damage.Depth = Depth;
+}
+
+void Paint_Ctx_SetColor(Paint_Ctx *Ctx, UWORD x, UWORD y, UWORD color)
+{
+	if (Ctx->Batch != NULL) {
+		PAINT_OP Op = {.Type = PAINT_OP_COLOR, .X0 = x, .Y0 = y, .Color = color};
+		Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+		return;
+	}
+	UWORD arr_XY[2] = {x, y};
+	UBYTE arr_color[9];
+	UBYTE offset = x/3%3;
+	
+	if(x%3 != 1)
+		(x%3==0) ? (arr_XY[0]++) : (arr_XY[0]--);
+	if((y+2)%3 != 1)
+		((y+2)%3==0) ? (arr_XY[1]++) : (arr_XY[1]--);
+	arr_XY[1] -= offset;
+	
+	Paint_GetColor(color, arr_color);
+	for(UBYTE i=0; i<3; i++) {
+		for(UBYTE j=0; j<3; j++) {
+			Paint_Ctx_SetPixel(Ctx, arr_XY[0]-1+j, arr_XY[1]-1+i, arr_color[i*3+j]);
+		}
+	}
+}
+
+void Paint_GetColor(UWORD color, UBYTE* arr_color)
+{
+	UBYTE* p_color = arr_color;
+	UWORD R, G, B;
+
+	B = (color>>4) & 0xf0;
+	G =  color	   & 0xf0;
+	R = (color<<4) & 0xf0;
+	UBYTE temp[9] = {G, G, G/2, B, B, B/2, R, R, R/2};
+	
+	for(UBYTE t=0; t<9; t++) {
+		p_color[t] = temp[t];
+	}
+}
+
+/******************************************************************************
+function: Clear the color of the picture
+parameter:
+    Color : Painted colors
+******************************************************************************/
+void Paint_Ctx_Clear(Paint_Ctx *Ctx, UWORD Color)
+{
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_CLEAR, .Color = Color};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    const PAINT_RECT *Clip = &Ctx->Clip;
+    //Every pixel of a byte gets the color, as Paint_SetPixel() would store it
+    UBYTE Pattern = Ctx->BitsPerPixel == 8 ? Color : Paint_ColorByte(Ctx, Color);
+
+    if (Clip->W == 0 || Clip->H == 0)
+        return;
+    if (Clip->X == 0 && Clip->W == Ctx->WidthMemory) {
+        //Whole rows, including the padding bits at their ends
+        memset(Ctx->Image + (UDOUBLE)Clip->Y * Ctx->WidthByte, Pattern, (UDOUBLE)Clip->H * Ctx->WidthByte);
+    } else {
+        for (UWORD Y = Clip->Y; Y < Clip->Y + Clip->H; Y++)
+            Paint_FillRow(Ctx, Ctx->Image + (UDOUBLE)Y * Ctx->WidthByte, Clip->X, Clip->X + Clip->W - 1, Pattern);
+    }
+    Paint_Ctx_AddDamage(Ctx, 0, 0, Ctx->Width, Ctx->Height);
+}
+
+/******************************************************************************
+function: Clear the color of a window
+parameter:
+    Xstart : x starting point
+    Ystart : Y starting point
+    Xend   : x end point
+    Yend   : y end point
+    Color  : Painted colors
+******************************************************************************/
+void Paint_Ctx_ClearWindows(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
+{
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_CLEAR_WINDOWS, .X0 = Xstart, .Y0 = Ystart, .X1 = Xend, .Y1 = Yend, .Color = Color};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if (Xend <= Xstart)
+        return;
+
+    Paint_Ctx_BeginDamage(Ctx);
+    for (UWORD Y = Ystart; Y < Yend; Y++) {
+        Paint_Ctx_FillSpan(Ctx, Xstart, Y, Xend - Xstart, Color);
+    }
+    Paint_Ctx_EndDamage(Ctx);
+}
+
+/******************************************************************************
+function: Draw Point(Xpoint, Ypoint) Fill the color
+parameter:
+    Xpoint		: The Xpoint coordinate of the point
+    Ypoint		: The Ypoint coordinate of the point
+    Color		: Painted color
+    Dot_Pixel	: point size
+    Dot_Style	: point Style
+******************************************************************************/
+void Paint_Ctx_DrawPoint(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, UWORD Color,
+                         DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
+{
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_POINT, .X0 = Xpoint, .Y0 = Ypoint, .Color = Color, .Width = Dot_Pixel, .Style = Dot_Style};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if (Xpoint > Ctx->Width || Ypoint > Ctx->Height) {
+        Debug("Paint_DrawPoint Input exceeds the normal display range\r\n");
+        return;
+    }
+
+    Paint_Ctx_BeginDamage(Ctx);
+    int16_t XDir_Num , YDir_Num;
+    if (Dot_Style == DOT_FILL_AROUND) {
+        for (XDir_Num = 0; XDir_Num < 2 * Dot_Pixel - 1; XDir_Num++) {
+            for (YDir_Num = 0; YDir_Num < 2 * Dot_Pixel - 1; YDir_Num++) {
+                if(Xpoint + XDir_Num - Dot_Pixel < 0 || Ypoint + YDir_Num - Dot_Pixel < 0)
+                    break;
+                // Debug("x = %d, y = %d\r\n", Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel);
+				if(Ctx->IsColor)
+					Paint_Ctx_SetColor(Ctx, Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
+                else
+					Paint_Ctx_SetPixel(Ctx, Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
+            }
+        }
+    } else {
+        for (XDir_Num = 0; XDir_Num <  Dot_Pixel; XDir_Num++) {
+            for (YDir_Num = 0; YDir_Num <  Dot_Pixel; YDir_Num++) {
+				if(Ctx->IsColor)
+					Paint_Ctx_SetColor(Ctx, Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
+				else
+					Paint_Ctx_SetPixel(Ctx, Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
+            }
+        }
+    }
+    Paint_Ctx_EndDamage(Ctx);
+}
+
+/******************************************************************************
+function: Fill the pixels X0..X1 of row Y, clipped to the image
+parameter:
+******************************************************************************/
+static void Paint_ShapeSpan(Paint_Ctx *Ctx, int X0, int X1, int Y, UWORD Color)
+{
+    if (X0 < 0)
+        X0 = 0;
+    if (X1 >= Ctx->Width)
+        X1 = Ctx->Width - 1;
+    if (Y < 0 || Y >= Ctx->Height || X1 < X0)
+        return;
+
+    if (Ctx->IsColor) {
+        for (int X = X0; X <= X1; X++)
+            Paint_Ctx_SetColor(Ctx, X, Y, Color);
+    } else {
+        Paint_Ctx_FillSpan(Ctx, X0, Y, X1 - X0 + 1, Color);
+    }
+}
+
+/******************************************************************************
+function: Fill row Y of a shape outline: the outer span minus the inner one
+parameter:
+    X0, X1 : outer span
+    I0, I1 : inner span, empty if I1 < I0
+******************************************************************************/
+static void Paint_RingSpan(Paint_Ctx *Ctx, int X0, int X1, int I0, int I1, int Y, UWORD Color)
+{
+    if (I1 < I0) {
+        Paint_ShapeSpan(Ctx, X0, X1, Y, Color);
+    } else {
+        Paint_ShapeSpan(Ctx, X0, I0 - 1, Y, Color);
+        Paint_ShapeSpan(Ctx, I1 + 1, X1, Y, Color);
+    }
+}
+
+/******************************************************************************
+function: Half width of a row of an ellipse
+parameter:
+    Rx, Ry : radii; the ellipse covers the pixel centers within Rx + 1/2, Ry + 1/2
+    Dy     : row, counted from the center
+return: pixels left and right of the center, or -1 past the top and bottom
+******************************************************************************/
+static int Paint_EllipseHalf(int Rx, int Ry, int Dy)
+{
+    if (Rx < 0 || Ry < 0 || Dy > Ry || Dy < -Ry)
+        return -1;
+
+    //Inside when (2*Dx)^2 * B + (2*Dy)^2 * A <= A * B
+    uint64_t A = (uint64_t)(2 * Rx + 1) * (2 * Rx + 1);
+    uint64_t B = (uint64_t)(2 * Ry + 1) * (2 * Ry + 1);
+    uint64_t Room = A * (B - (uint64_t)(4 * Dy) * Dy);
+    int Dx = (int)(sqrt((double)Room / B) / 2);
+
+    //Correct the rounding of the square root
+    while (Dx > 0 && (uint64_t)(4 * Dx) * Dx * B > Room)
+        Dx--;
+    while ((uint64_t)(4 * (Dx + 1)) * (Dx + 1) * B <= Room)
+        Dx++;
+    return Dx;
+}
+
+/******************************************************************************
+function: Draw a solid line of Line_width dots as one span per row
+parameter:
+    Xstart, Ystart, Xend, Yend : end points, as for Paint_DrawLine()
+    Color : The color of the line segment
+    W     : Line width
+return: false if there was no memory for the row table
+******************************************************************************/
+static bool Paint_DrawLineSpans(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color, int W)
+{
+    int X0 = Xstart < Xend ? Xstart : Xend, X1 = Xstart < Xend ? Xend : Xstart;
+    int Y0 = Ystart < Yend ? Ystart : Yend, Y1 = Ystart < Yend ? Yend : Ystart;
+
+    //A row or column of dots is a rectangle; dots cover -W..W-2 around a point
+    if (Ystart == Yend || Xstart == Xend) {
+        for (int Y = Y0 - W; Y <= Y1 + W - 2; Y++)
+            Paint_ShapeSpan(Ctx, X0 - W, X1 + W - 2, Y, Color);
+        return true;
+    }
+
+    //The points of each row of the line, as Paint_DrawLine() steps through them
+    int Rows = Y1 - Y0 + 1;
+    int *Row_Min = (int *)malloc(2 * Rows * sizeof(int));
+    if (Row_Min == NULL)
+        return false;
+    int *Row_Max = Row_Min + Rows;
+    for (int i = 0; i < Rows; i++) {
+        Row_Min[i] = X1;
+        Row_Max[i] = X0;
+    }
+
+    int Xpoint = Xstart, Ypoint = Ystart;
+    int dx = (int)Xend - (int)Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
+    int dy = (int)Yend - (int)Ystart <= 0 ? Yend - Ystart : Ystart - Yend;
+    int XAddway = Xstart < Xend ? 1 : -1;
+    int YAddway = Ystart < Yend ? 1 : -1;
+    int Esp = dx + dy;
+    for (;;) {
+        if (Xpoint < Row_Min[Ypoint - Y0]) Row_Min[Ypoint - Y0] = Xpoint;
+        if (Xpoint > Row_Max[Ypoint - Y0]) Row_Max[Ypoint - Y0] = Xpoint;
+        if (2 * Esp >= dy) {
+            if (Xpoint == Xend)
+                break;
+            Esp += dy;
+            Xpoint += XAddway;
+        }
+        if (2 * Esp <= dx) {
+            if (Ypoint == Yend)
+                break;
+            Esp += dx;
+            Ypoint += YAddway;
+        }
+    }
+
+    //Row Y is covered by the dots of the points W-2 rows above to W rows below
+    for (int Y = Y0 - W; Y <= Y1 + W - 2; Y++) {
+        int Lo = Y - W + 2 > Y0 ? Y - W + 2 : Y0;
+        int Hi = Y + W < Y1 ? Y + W : Y1;
+        int Left = X1, Right = X0;
+        for (int Row = Lo; Row <= Hi; Row++) {
+            if (Row_Min[Row - Y0] < Left) Left = Row_Min[Row - Y0];
+            if (Row_Max[Row - Y0] > Right) Right = Row_Max[Row - Y0];
+        }
+        Paint_ShapeSpan(Ctx, Left - W, Right + W - 2, Y, Color);
+    }
+    free(Row_Min);
+    return true;
+}
+
+/******************************************************************************
+function: Fill a convex polygon, one span per row
+parameter:
+    Px, Py : corners, in order around the polygon
+    N      : number of corners
+    Color  : Painted colors
+note: Covers the pixels whose centers lie inside, counting the top and left
+      edges but not the bottom and right ones, so polygons that share an
+      edge never share a pixel.
+******************************************************************************/
+static void Paint_FillConvex(Paint_Ctx *Ctx, const double *Px, const double *Py, int N, UWORD Color)
+{
+    double Top = Py[0], Bottom = Py[0];
+    for (int i = 1; i < N; i++) {
+        if (Py[i] < Top) Top = Py[i];
+        if (Py[i] > Bottom) Bottom = Py[i];
+    }
+    int Y0 = (int)ceil(Top), Y1 = (int)ceil(Bottom) - 1;
+    if (Y0 < 0)
+        Y0 = 0;
+    if (Y1 >= Ctx->Height)
+        Y1 = Ctx->Height - 1;
+
+    for (int Y = Y0; Y <= Y1; Y++) {
+        double Left = 1e9, Right = -1e9;
+        for (int i = 0; i < N; i++) {
+            double Ax = Px[i], Ay = Py[i];
+            double Bx = Px[(i + 1) % N], By = Py[(i + 1) % N];
+            if ((Y < Ay && Y < By) || (Y > Ay && Y > By))
+                continue;
+            double X = Ay == By ? Ax : Ax + (Y - Ay) * (Bx - Ax) / (By - Ay);
+            if (X < Left) Left = X;
+            if (X > Right) Right = X;
+            if (Ay == By) {
+                if (Bx < Left) Left = Bx;
+                if (Bx > Right) Right = Bx;
+            }
+        }
+        if (Left <= Right)
+            Paint_ShapeSpan(Ctx, (int)ceil(Left), (int)ceil(Right) - 1, Y, Color);
+    }
+}
+
+/******************************************************************************
+function: Draw a line as the rectangle around it, optionally dashed
+parameter:
+    Xstart, Ystart, Xend, Yend : end points, at pixel centers
+    Color : The color of the line segment
+    Width : Line width, in pixels
+    Cap   : how far each dash reaches past its ends
+    Style : solid, dotted or dashed
+******************************************************************************/
+static void Paint_StrokeLine(Paint_Ctx *Ctx, int Xstart, int Ystart, int Xend, int Yend,
+                             UWORD Color, UWORD Width, LINE_CAP Cap, LINE_STYLE Style)
+{
+    double Dx = Xend - Xstart, Dy = Yend - Ystart;
+    double Length = sqrt(Dx * Dx + Dy * Dy);
+    double Half = Width / 2.0;
+    double Extend = Cap == LINE_CAP_SQUARE ? Half : 0;
+    double On = Length, Off = 0;
+
+    if (Width == 0)
+        return;
+    //Along the line and across it; a point has no direction, so pick one
+    double Ux = Length > 0 ? Dx / Length : 1, Uy = Length > 0 ? Dy / Length : 0;
+    double Nx = -Uy * Half, Ny = Ux * Half;
+
+    if (Style == LINE_STYLE_DOTTED) {
+        On = Width;
+        Off = Width;
+    } else if (Style == LINE_STYLE_DASHED) {
+        On = 3.0 * Width;
+        Off = 2.0 * Width;
+    }
+
+    for (double Start = 0;; Start += On + Off) {
+        double End = Start + On < Length ? Start + On : Length;
+        double Sx = Xstart + Ux * (Start - Extend), Sy = Ystart + Uy * (Start - Extend);
+        double Ex = Xstart + Ux * (End + Extend), Ey = Ystart + Uy * (End + Extend);
+        double Px[4] = {Sx + Nx, Ex + Nx, Ex - Nx, Sx - Nx};
+        double Py[4] = {Sy + Ny, Ey + Ny, Ey - Ny, Sy - Ny};
+        Paint_FillConvex(Ctx, Px, Py, 4, Color);
+        if (Start + On + Off >= Length)
+            break;
+    }
+}
+
+/******************************************************************************
+function: Draw a line of arbitrary slope
+parameter:
+    Xstart ：Starting Xpoint point coordinates
+    Ystart ：Starting Xpoint point coordinates
+    Xend   ：End point Xpoint coordinate
+    Yend   ：End point Ypoint coordinate
+    Color  ：The color of the line segment
+    Line_width : Line width
+    Line_Style: Solid and dotted lines
+******************************************************************************/
+void Paint_Ctx_DrawLine(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                        UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+{
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_LINE, .X0 = Xstart, .Y0 = Ystart, .X1 = Xend, .Y1 = Yend, .Color = Color,
+                       .Width = Line_width, .Style = Line_Style};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if (Xstart > Ctx->Width || Ystart > Ctx->Height ||
+        Xend > Ctx->Width || Yend > Ctx->Height) {
+        Debug("Paint_DrawLine Input exceeds the normal display range\r\n");
+        return;
+    }
+
+    UWORD Xpoint = Xstart;
+    UWORD Ypoint = Ystart;
+    int dx = (int)Xend - (int)Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
+    int dy = (int)Yend - (int)Ystart <= 0 ? Yend - Ystart : Ystart - Yend;
+
+    // Increment direction, 1 is positive, -1 is counter;
+    int XAddway = Xstart < Xend ? 1 : -1;
+    int YAddway = Ystart < Yend ? 1 : -1;
+
+    //Cumulative error
+    int Esp = dx + dy;
+    char Dotted_Len = 0;
+
+    Paint_Ctx_BeginDamage(Ctx);
+    if (!Ctx->IsColor && Line_Style == LINE_STYLE_SOLID &&
+        Paint_DrawLineSpans(Ctx, Xstart, Ystart, Xend, Yend, Color, Line_width)) {
+        Paint_Ctx_EndDamage(Ctx);
+        return;
+    }
+    if (Line_Style == LINE_STYLE_DASHED) {
+        //Dots around each point make a line 2 * Line_width - 1 wide, one pixel up and left
+        Paint_StrokeLine(Ctx, Xstart - 1, Ystart - 1, Xend - 1, Yend - 1, Color, 2 * Line_width - 1,
+                         LINE_CAP_SQUARE, LINE_STYLE_DASHED);
+        Paint_Ctx_EndDamage(Ctx);
+        return;
+    }
+    for (;;) {
+        Dotted_Len++;
+        //Painted dotted line, 2 point is really virtual
+        if (Line_Style == LINE_STYLE_DOTTED && Dotted_Len % 3 == 0) {
+            //Debug("LINE_DOTTED\r\n");
+            Paint_Ctx_DrawPoint(Ctx, Xpoint, Ypoint, IMAGE_BACKGROUND, Line_width, DOT_STYLE_DFT);
+            Dotted_Len = 0;
+        } else {
+            Paint_Ctx_DrawPoint(Ctx, Xpoint, Ypoint, Color, Line_width, DOT_STYLE_DFT);
+        }
+        if (2 * Esp >= dy) {
+            if (Xpoint == Xend)
+                break;
+            Esp += dy;
+            Xpoint += XAddway;
+        }
+        if (2 * Esp <= dx) {
+            if (Ypoint == Yend)
+                break;
+            Esp += dx;
+            Ypoint += YAddway;
+        }
+    }
+    Paint_Ctx_EndDamage(Ctx);
+}
+
+/******************************************************************************
+function: Draw a line of any width with butt or square ends
+parameter:
+    Xstart ：Starting Xpoint point coordinates
+    Ystart ：Starting Xpoint point coordinates
+    Xend   ：End point Xpoint coordinate
+    Yend   ：End point Ypoint coordinate
+    Color  ：The color of the line segment
+    Line_width : Line width, in pixels
+    Cap        : Butt or square ends
+    Line_Style : Solid, dotted or dashed
+******************************************************************************/
+void Paint_Ctx_DrawThickLine(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                             UWORD Color, UWORD Line_width, LINE_CAP Cap, LINE_STYLE Line_Style)
+{
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_THICK_LINE, .X0 = Xstart, .Y0 = Ystart, .X1 = Xend, .Y1 = Yend, .Color = Color,
+                       .Width = Line_width, .Cap = Cap, .Style = Line_Style};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if (Xstart > Ctx->Width || Ystart > Ctx->Height ||
+        Xend > Ctx->Width || Yend > Ctx->Height) {
+        Debug("Paint_DrawThickLine Input exceeds the normal display range\r\n");
+        return;
+    }
+
+    Paint_Ctx_BeginDamage(Ctx);
+    Paint_StrokeLine(Ctx, Xstart, Ystart, Xend, Yend, Color, Line_width, Cap, Line_Style);
+    Paint_Ctx_EndDamage(Ctx);
+}
+
+/******************************************************************************
+function: Draw a rectangle
+parameter:
+    Xstart ：Rectangular  Starting Xpoint point coordinates
+    Ystart ：Rectangular  Starting Xpoint point coordinates
+    Xend   ：Rectangular  End point Xpoint coordinate
+    Yend   ：Rectangular  End point Ypoint coordinate
+    Color  ：The color of the Rectangular segment
+    Line_width: Line width
+    Draw_Fill : Whether to fill the inside of the rectangle
+******************************************************************************/
+void Paint_Ctx_DrawRectangle(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                             UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_RECTANGLE, .X0 = Xstart, .Y0 = Ystart, .X1 = Xend, .Y1 = Yend, .Color = Color,
+                       .Width = Line_width, .Style = Draw_Fill};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if (Xstart > Ctx->Width || Ystart > Ctx->Height ||
+        Xend > Ctx->Width || Yend > Ctx->Height) {
+        Debug("Input exceeds the normal display range\r\n");
+        return;
+    }
+
+    Paint_Ctx_BeginDamage(Ctx);
+    if (Draw_Fill && !Ctx->IsColor) {
+        //The rows Paint_DrawLine() would cover with Line_width dots around each point
+        int W = Line_width;
+        int X0 = (Xstart < Xend ? Xstart : Xend) - W;
+        int X1 = (Xstart < Xend ? Xend : Xstart) + W - 2;
+        int Y0 = Ystart - W;
+        if (X0 < 0)
+            X0 = 0;
+        if (Y0 < 0)
+            Y0 = 0;
+        if (X1 >= X0 && Ystart < Yend) {
+            for (int Y = Y0; Y <= Yend + W - 3 && Y < Ctx->Height; Y++) {
+                Paint_Ctx_FillSpan(Ctx, X0, Y, X1 - X0 + 1, Color);
+            }
+        }
+    } else if (Draw_Fill) {
+        UWORD Ypoint;
+        for(Ypoint = Ystart; Ypoint < Yend; Ypoint++) {
+            Paint_Ctx_DrawLine(Ctx, Xstart, Ypoint, Xend, Ypoint, Color , Line_width, LINE_STYLE_SOLID);
+        }
+    } else {
+        Paint_Ctx_DrawLine(Ctx, Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_Ctx_DrawLine(Ctx, Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_Ctx_DrawLine(Ctx, Xend, Yend, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        Paint_Ctx_DrawLine(Ctx, Xend, Yend, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+    }
+    Paint_Ctx_EndDamage(Ctx);
 }
 
 /******************************************************************************
@@ -404,10 +1475,16 @@ parameter:
     Line_width: Line width
     Draw_Fill : Whether to fill the inside of the Circle
 ******************************************************************************/
-void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
-                      UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+void Paint_Ctx_DrawCircle(Paint_Ctx *Ctx, UWORD X_Center, UWORD Y_Center, UWORD Radius,
+                          UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
 {
-    if (X_Center > Paint.Width || Y_Center >= Paint.Height) {
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_CIRCLE, .X0 = X_Center, .Y0 = Y_Center, .R0 = Radius, .Color = Color,
+                       .Width = Line_width, .Style = Draw_Fill};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if (X_Center > Ctx->Width || Y_Center >= Ctx->Height) {
         Debug("Paint_DrawCircle Input exceeds the normal display range\r\n");
         return;
     }
@@ -421,17 +1498,37 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
     int16_t Esp = 3 - (Radius << 1 );
 
     int16_t sCountY;
-    if (Draw_Fill == DRAW_FILL_FULL) {
+    Paint_Ctx_BeginDamage(Ctx);
+    if (Draw_Fill == DRAW_FILL_FULL && !Ctx->IsColor) {
+        //Row X spans out to Y, and row Y, before Y moves on, out to X.
+        //Points are drawn one pixel up and left of their coordinates.
+        while (XCurrent <= YCurrent) {
+            Paint_ShapeSpan(Ctx, X_Center - YCurrent - 1, X_Center + YCurrent - 1, Y_Center + XCurrent - 1, Color);
+            if (XCurrent > 0)
+                Paint_ShapeSpan(Ctx, X_Center - YCurrent - 1, X_Center + YCurrent - 1, Y_Center - XCurrent - 1, Color);
+            if (Esp < 0 )
+                Esp += 4 * XCurrent + 6;
+            else {
+                if (YCurrent > XCurrent) {
+                    Paint_ShapeSpan(Ctx, X_Center - XCurrent - 1, X_Center + XCurrent - 1, Y_Center + YCurrent - 1, Color);
+                    Paint_ShapeSpan(Ctx, X_Center - XCurrent - 1, X_Center + XCurrent - 1, Y_Center - YCurrent - 1, Color);
+                }
+                Esp += 10 + 4 * (XCurrent - YCurrent );
+                YCurrent --;
+            }
+            XCurrent ++;
+        }
+    } else if (Draw_Fill == DRAW_FILL_FULL) {
         while (XCurrent <= YCurrent ) { //Realistic circles
             for (sCountY = XCurrent; sCountY <= YCurrent; sCountY ++ ) {
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//1
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//2
-                Paint_DrawPoint(X_Center - sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//3
-                Paint_DrawPoint(X_Center - sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//4
-                Paint_DrawPoint(X_Center - XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//5
-                Paint_DrawPoint(X_Center + XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//6
-                Paint_DrawPoint(X_Center + sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//7
-                Paint_DrawPoint(X_Center + sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);
+                Paint_Ctx_DrawPoint(Ctx, X_Center + XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//1
+                Paint_Ctx_DrawPoint(Ctx, X_Center - XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//2
+                Paint_Ctx_DrawPoint(Ctx, X_Center - sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//3
+                Paint_Ctx_DrawPoint(Ctx, X_Center - sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//4
+                Paint_Ctx_DrawPoint(Ctx, X_Center - XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//5
+                Paint_Ctx_DrawPoint(Ctx, X_Center + XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//6
+                Paint_Ctx_DrawPoint(Ctx, X_Center + sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);//7
+                Paint_Ctx_DrawPoint(Ctx, X_Center + sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);
             }
             if (Esp < 0 )
                 Esp += 4 * XCurrent + 6;
@@ -443,14 +1540,14 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
         }
     } else { //Draw a hollow circle
         while (XCurrent <= YCurrent ) {
-            Paint_DrawPoint(X_Center + XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//1
-            Paint_DrawPoint(X_Center - XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//2
-            Paint_DrawPoint(X_Center - YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//3
-            Paint_DrawPoint(X_Center - YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//4
-            Paint_DrawPoint(X_Center - XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//5
-            Paint_DrawPoint(X_Center + XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//6
-            Paint_DrawPoint(X_Center + YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//7
-            Paint_DrawPoint(X_Center + YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//0
+            Paint_Ctx_DrawPoint(Ctx, X_Center + XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//1
+            Paint_Ctx_DrawPoint(Ctx, X_Center - XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT);//2
+            Paint_Ctx_DrawPoint(Ctx, X_Center - YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//3
+            Paint_Ctx_DrawPoint(Ctx, X_Center - YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//4
+            Paint_Ctx_DrawPoint(Ctx, X_Center - XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//5
+            Paint_Ctx_DrawPoint(Ctx, X_Center + XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT);//6
+            Paint_Ctx_DrawPoint(Ctx, X_Center + YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT);//7
+            Paint_Ctx_DrawPoint(Ctx, X_Center + YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT);//0
 
             if (Esp < 0 )
                 Esp += 4 * XCurrent + 6;
@@ -461,45 +1558,150 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
             XCurrent ++;
         }
     }
+    Paint_Ctx_EndDamage(Ctx);
 }
 
 /******************************************************************************
-function: Show English characters
+function: Draw an ellipse, one span per row
 parameter:
-    Xpoint           ：X coordinate
-    Ypoint           ：Y coordinate
-    Acsii_Char       ：To display the English characters
-    Font             ：A structure pointer that displays a character size
-    Color_Foreground : Select the foreground color
-    Color_Background : Select the background color
+    X_Center  ：Center X coordinate
+    Y_Center  ：Center Y coordinate
+    X_Radius  ：Horizontal radius
+    Y_Radius  ：Vertical radius
+    Color     ：The color of the ellipse
+    Line_width: Thickness of the outline, in pixels
+    Draw_Fill : Whether to fill the inside of the ellipse
 ******************************************************************************/
-void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
-                    sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+void Paint_Ctx_DrawEllipse(Paint_Ctx *Ctx, UWORD X_Center, UWORD Y_Center, UWORD X_Radius, UWORD Y_Radius,
+                           UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
 {
-    UWORD Page, Column;
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_ELLIPSE, .X0 = X_Center, .Y0 = Y_Center, .R0 = X_Radius, .R1 = Y_Radius, .Color = Color,
+                       .Width = Line_width, .Style = Draw_Fill};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if (X_Center > Ctx->Width || Y_Center >= Ctx->Height) {
+        Debug("Paint_DrawEllipse Input exceeds the normal display range\r\n");
+        return;
+    }
+    //Keeps the inside test in 64 bits
+    if (X_Radius > PAINT_SHAPE_RADIUS_MAX)
+        X_Radius = PAINT_SHAPE_RADIUS_MAX;
+    if (Y_Radius > PAINT_SHAPE_RADIUS_MAX)
+        Y_Radius = PAINT_SHAPE_RADIUS_MAX;
 
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height) {
-        Debug("Paint_DrawChar Input exceeds the normal display range\r\n");
+    int Rx = X_Radius, Ry = Y_Radius, W = Line_width;
+    Paint_Ctx_BeginDamage(Ctx);
+    for (int Dy = -Ry; Dy <= Ry; Dy++) {
+        int Half = Paint_EllipseHalf(Rx, Ry, Dy);
+        int Hole = Draw_Fill == DRAW_FILL_FULL ? -1 : Paint_EllipseHalf(Rx - W, Ry - W, Dy);
+        Paint_RingSpan(Ctx, X_Center - Half, X_Center + Half, X_Center - Hole, X_Center + Hole,
+                       Y_Center + Dy, Color);
+    }
+    Paint_Ctx_EndDamage(Ctx);
+}
+
+/******************************************************************************
+function: Span of a row of a rounded rectangle
+parameter:
+    X0, Y0 : top left corner
+    W, H   : size, in pixels
+    Radius : corner radius
+    Y      : row
+    Left, Right : receive the span
+return: whether the row crosses the rectangle
+******************************************************************************/
+static bool Paint_RoundedSpan(int X0, int Y0, int W, int H, int Radius, int Y, int *Left, int *Right)
+{
+    int Dy = 0, Inset;
+
+    if (W <= 0 || H <= 0 || Y < Y0 || Y >= Y0 + H)
+        return false;
+    if (Y < Y0 + Radius)
+        Dy = Y0 + Radius - Y;
+    else if (Y > Y0 + H - 1 - Radius)
+        Dy = Y - (Y0 + H - 1 - Radius);
+    Inset = Radius - Paint_EllipseHalf(Radius, Radius, Dy);
+    *Left = X0 + Inset;
+    *Right = X0 + W - 1 - Inset;
+    return true;
+}
+
+/******************************************************************************
+function: Draw a rectangle with rounded corners, one span per row
+parameter:
+    Xstart ：Left column
+    Ystart ：Top row
+    Xend   ：Right column, exclusive
+    Yend   ：Bottom row, exclusive
+    Radius ：Corner radius
+    Color  ：The color of the rectangle
+    Line_width: Thickness of the outline, in pixels
+    Draw_Fill : Whether to fill the inside of the rectangle
+******************************************************************************/
+void Paint_Ctx_DrawRoundedRectangle(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Radius,
+                                    UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_ROUNDED_RECTANGLE, .X0 = Xstart, .Y0 = Ystart, .X1 = Xend, .Y1 = Yend, .R0 = Radius,
+                       .Color = Color, .Width = Line_width, .Style = Draw_Fill};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if (Xstart > Ctx->Width || Ystart > Ctx->Height ||
+        Xend > Ctx->Width || Yend > Ctx->Height) {
+        Debug("Paint_DrawRoundedRectangle Input exceeds the normal display range\r\n");
         return;
     }
+    if (Xend <= Xstart || Yend <= Ystart)
+        return;
 
-    uint32_t Char_Offset = (Acsii_Char - ' ') * Font->Height * (Font->Width / 8 + (Font->Width % 8 ? 1 : 0));
-    const unsigned char *ptr = &Font->table[Char_Offset];
+    int W = Xend - Xstart, H = Yend - Ystart, T = Line_width;
+    int R = Radius;
+    //The corners of each side meet at most in its middle
+    if (R > (W - 1) / 2)
+        R = (W - 1) / 2;
+    if (R > (H - 1) / 2)
+        R = (H - 1) / 2;
+    int Inner_R = R > T ? R - T : 0;
+
+    Paint_Ctx_BeginDamage(Ctx);
+    for (int Y = Ystart; Y < Yend; Y++) {
+        int Left, Right, Hole_Left = 0, Hole_Right = -1;
+        Paint_RoundedSpan(Xstart, Ystart, W, H, R, Y, &Left, &Right);
+        if (Draw_Fill != DRAW_FILL_FULL)
+            Paint_RoundedSpan(Xstart + T, Ystart + T, W - 2 * T, H - 2 * T, Inner_R, Y, &Hole_Left, &Hole_Right);
+        Paint_RingSpan(Ctx, Left, Right, Hole_Left, Hole_Right, Y, Color);
+    }
+    Paint_Ctx_EndDamage(Ctx);
+}
+
+/******************************************************************************
+function: Draw a character a pixel at a time
+parameter:
+    ptr           : first byte of the character's bitmap in the font table
+    Width, Height : size of the character
+******************************************************************************/
+static void Paint_DrawGlyphPixels(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, const unsigned char *ptr, UWORD Width, UWORD Height,
+                                  UWORD Color_Foreground, UWORD Color_Background)
+{
+    UWORD Page, Column;
 
-    for (Page = 0; Page < Font->Height; Page ++ ) {
-        for (Column = 0; Column < Font->Width; Column ++ ) {
+    for (Page = 0; Page < Height; Page ++ ) {
+        for (Column = 0; Column < Width; Column ++ ) {
 
             //To determine whether the font background color and screen background color is consistent
             if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
                 if (*ptr & (0x80 >> (Column % 8)))
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+                    Paint_Ctx_SetPixel(Ctx, Xpoint + Column, Ypoint + Page, Color_Foreground);
                     // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
             } else {
                 if (*ptr & (0x80 >> (Column % 8))) {
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+                    Paint_Ctx_SetPixel(Ctx, Xpoint + Column, Ypoint + Page, Color_Foreground);
                     // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                 } else {
-                    Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Background);
+                    Paint_Ctx_SetPixel(Ctx, Xpoint + Column, Ypoint + Page, Color_Background);
                     // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                 }
             }
@@ -507,11 +1709,371 @@ void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
             if (Column % 8 == 7)
                 ptr++;
         }// Write a line
-        if (Font->Width % 8 != 0)
+        if (Width % 8 != 0)
             ptr++;
     }// Write all
 }
 
+/******************************************************************************
+Glyph cache: characters rendered once into image memory layout
+******************************************************************************/
+typedef struct PAINT_GLYPH {
+    const unsigned char *Bitmap;    //Character in the font table
+    UWORD Width, Height;
+    UWORD Foreground, Background;
+    UWORD BitsPerPixel, Rotate, Mirror;
+    UWORD Phase;                    //First pixel's position in its byte
+    UWORD Bucket;                   //Hash chain the glyph is on
+    UWORD Rows, Bytes_Per_Row;      //Size in image memory
+    bool Ink;                       //Any pixel is drawn
+    UWORD Ink_X0, Ink_Y0;           //Box of the drawn pixels, in memory
+    UWORD Ink_X1, Ink_Y1;           //coordinates relative to the cell
+    UDOUBLE Size;                   //Bytes charged to the cache
+    UBYTE *Pixels;                  //Rows * Bytes_Per_Row packed pixels,
+    UBYTE *Mask;                    //and the bits of the drawn ones
+    struct PAINT_GLYPH *Next;       //Hash chain
+    struct PAINT_GLYPH *Older, *Newer;
+} PAINT_GLYPH;
+
+#define PAINT_GLYPH_BUCKETS 256
+
+typedef struct PAINT_GLYPH_CACHE {
+    PAINT_GLYPH *Bucket[PAINT_GLYPH_BUCKETS];
+    PAINT_GLYPH *Newest, *Oldest;
+    UDOUBLE Max_Bytes;
+    PAINT_GLYPH_STATS Stats;
+} PAINT_GLYPH_CACHE;
+
+//The cache of Paint; other contexts allocate their own
+static PAINT_GLYPH_CACHE Glyph_Cache = {.Max_Bytes = PAINT_GLYPH_CACHE_BYTES, .Stats = {.Max_Bytes = PAINT_GLYPH_CACHE_BYTES}};
+
+/******************************************************************************
+function: Get the glyph cache of a context, creating it on first use
+parameter:
+return: NULL if out of memory
+******************************************************************************/
+static PAINT_GLYPH_CACHE *Paint_GlyphCache(Paint_Ctx *Ctx)
+{
+    if (Ctx->Glyphs != NULL)
+        return Ctx->Glyphs;
+    if (Ctx == &Paint) {
+        Ctx->Glyphs = &Glyph_Cache;
+    } else {
+        Ctx->Glyphs = (PAINT_GLYPH_CACHE *)calloc(1, sizeof(PAINT_GLYPH_CACHE));
+        if (Ctx->Glyphs == NULL)
+            return NULL;
+        Ctx->Glyphs->Max_Bytes = PAINT_GLYPH_CACHE_BYTES;
+        Ctx->Glyphs->Stats.Max_Bytes = PAINT_GLYPH_CACHE_BYTES;
+    }
+    return Ctx->Glyphs;
+}
+
+/******************************************************************************
+function: Hash bucket of a glyph key
+parameter:
+******************************************************************************/
+static UWORD Paint_GlyphBucket(Paint_Ctx *Ctx, const unsigned char *Bitmap, UWORD Foreground, UWORD Background, UWORD Phase)
+{
+    uintptr_t Hash = (uintptr_t)Bitmap;
+    Hash = Hash * 31 + Foreground;
+    Hash = Hash * 31 + Background;
+    Hash = Hash * 31 + Phase * 7 + Ctx->BitsPerPixel + Ctx->Rotate + Ctx->Mirror;
+    return Hash % PAINT_GLYPH_BUCKETS;
+}
+
+/******************************************************************************
+function: Unlink a glyph from the age list
+parameter:
+******************************************************************************/
+static void Paint_GlyphUnlink(PAINT_GLYPH_CACHE *Cache, PAINT_GLYPH *Glyph)
+{
+    if (Glyph->Newer) Glyph->Newer->Older = Glyph->Older; else Cache->Newest = Glyph->Older;
+    if (Glyph->Older) Glyph->Older->Newer = Glyph->Newer; else Cache->Oldest = Glyph->Newer;
+    Glyph->Older = Glyph->Newer = NULL;
+}
+
+/******************************************************************************
+function: Make a glyph the most recently used
+parameter:
+******************************************************************************/
+static void Paint_GlyphTouch(PAINT_GLYPH_CACHE *Cache, PAINT_GLYPH *Glyph)
+{
+    Glyph->Older = Cache->Newest;
+    Glyph->Newer = NULL;
+    if (Cache->Newest)
+        Cache->Newest->Newer = Glyph;
+    else
+        Cache->Oldest = Glyph;
+    Cache->Newest = Glyph;
+}
+
+/******************************************************************************
+function: Drop a glyph from the cache
+parameter:
+******************************************************************************/
+static void Paint_GlyphFree(PAINT_GLYPH_CACHE *Cache, PAINT_GLYPH *Glyph)
+{
+    PAINT_GLYPH **Link = &Cache->Bucket[Glyph->Bucket];
+    while (*Link != Glyph)
+        Link = &(*Link)->Next;
+    *Link = Glyph->Next;
+    Paint_GlyphUnlink(Cache, Glyph);
+    Cache->Stats.Bytes -= Glyph->Size;
+    Cache->Stats.Glyphs--;
+    free(Glyph);
+}
+
+/******************************************************************************
+function: Empty the glyph cache
+parameter:
+******************************************************************************/
+void Paint_Ctx_FlushGlyphCache(Paint_Ctx *Ctx)
+{
+    PAINT_GLYPH_CACHE *Cache = Ctx->Glyphs;
+    while (Cache != NULL && Cache->Oldest)
+        Paint_GlyphFree(Cache, Cache->Oldest);
+}
+
+/******************************************************************************
+function: Set the memory the glyph cache may use
+parameter:
+    Max_Bytes : 0 turns the cache off
+******************************************************************************/
+void Paint_Ctx_SetGlyphCache(Paint_Ctx *Ctx, UDOUBLE Max_Bytes)
+{
+    PAINT_GLYPH_CACHE *Cache = Paint_GlyphCache(Ctx);
+    if (Cache == NULL)
+        return;
+    Cache->Max_Bytes = Max_Bytes;
+    Cache->Stats.Max_Bytes = Max_Bytes;
+    while (Cache->Oldest && Cache->Stats.Bytes > Max_Bytes) {
+        Paint_GlyphFree(Cache, Cache->Oldest);
+        Cache->Stats.Evictions++;
+    }
+}
+
+/******************************************************************************
+function: Get the glyph cache counters
+parameter:
+******************************************************************************/
+void Paint_Ctx_GetGlyphStats(Paint_Ctx *Ctx, PAINT_GLYPH_STATS *Stats)
+{
+    PAINT_GLYPH_CACHE *Cache = Paint_GlyphCache(Ctx);
+    if (Cache != NULL)
+        *Stats = Cache->Stats;
+    else
+        memset(Stats, 0, sizeof(*Stats));
+}
+
+/******************************************************************************
+function: Find a glyph, or render it into the cache
+parameter:
+    X0, Y0 : memory coordinates of the cell's top left corner in memory
+    ptr    : first byte of the character in the font table
+******************************************************************************/
+static PAINT_GLYPH *Paint_GetGlyph(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, UWORD X0, UWORD Y0, const unsigned char *ptr,
+                                   UWORD Width, UWORD Height, UWORD Foreground, UWORD Background)
+{
+    UWORD PPB = 8 / Ctx->BitsPerPixel, Phase = X0 % PPB;
+    UWORD Bucket = Paint_GlyphBucket(Ctx, ptr, Foreground, Background, Phase);
+    PAINT_GLYPH_CACHE *Cache = Ctx->Glyphs;
+    PAINT_GLYPH *Glyph;
+
+    for (Glyph = Cache->Bucket[Bucket]; Glyph != NULL; Glyph = Glyph->Next) {
+        if (Glyph->Bitmap == ptr && Glyph->Width == Width && Glyph->Height == Height &&
+            Glyph->Foreground == Foreground &&
+            Glyph->Background == Background && Glyph->Phase == Phase &&
+            Glyph->BitsPerPixel == Ctx->BitsPerPixel && Glyph->Rotate == Ctx->Rotate &&
+            Glyph->Mirror == Ctx->Mirror) {
+            Paint_GlyphUnlink(Cache, Glyph);
+            Paint_GlyphTouch(Cache, Glyph);
+            Cache->Stats.Hits++;
+            return Glyph;
+        }
+    }
+
+    //A rotated cell is Height wide and Width tall in memory
+    bool Turned = Ctx->Rotate == ROTATE_90 || Ctx->Rotate == ROTATE_270;
+    UWORD Columns = Turned ? Height : Width;
+    UWORD Rows = Turned ? Width : Height;
+    UWORD Bytes_Per_Row = (Phase + Columns + PPB - 1) / PPB;
+    UDOUBLE Size = sizeof(PAINT_GLYPH) + 2 * (UDOUBLE)Rows * Bytes_Per_Row;
+
+    Cache->Stats.Misses++;
+    if (Size > Cache->Max_Bytes)
+        return NULL;
+    while (Cache->Stats.Bytes + Size > Cache->Max_Bytes) {
+        Paint_GlyphFree(Cache, Cache->Oldest);
+        Cache->Stats.Evictions++;
+    }
+    Glyph = (PAINT_GLYPH *)calloc(1, Size);
+    if (Glyph == NULL)
+        return NULL;
+
+    Glyph->Bitmap = ptr;
+    Glyph->Width = Width;
+    Glyph->Height = Height;
+    Glyph->Foreground = Foreground;
+    Glyph->Background = Background;
+    Glyph->BitsPerPixel = Ctx->BitsPerPixel;
+    Glyph->Rotate = Ctx->Rotate;
+    Glyph->Mirror = Ctx->Mirror;
+    Glyph->Phase = Phase;
+    Glyph->Bucket = Bucket;
+    Glyph->Rows = Rows;
+    Glyph->Bytes_Per_Row = Bytes_Per_Row;
+    Glyph->Size = Size;
+    Glyph->Pixels = (UBYTE *)(Glyph + 1);
+    Glyph->Mask = Glyph->Pixels + (UDOUBLE)Rows * Bytes_Per_Row;
+
+    //Each font pixel goes where Paint_SetPixel() would put it
+    for (UWORD Page = 0; Page < Height; Page++) {
+        for (UWORD Column = 0; Column < Width; Column++) {
+            bool Set = ptr[Column / 8] & (0x80 >> (Column % 8));
+            UWORD X, Y;
+            if (!Set && FONT_BACKGROUND == Background)
+                continue;
+            if (!Paint_MapPoint(Ctx, Xpoint + Column, Ypoint + Page, &X, &Y))
+                continue;
+            X = X - X0 + Phase;
+            Y = Y - Y0;
+            Paint_PutPixel(Ctx, Glyph->Pixels + (UDOUBLE)Y * Bytes_Per_Row, X, Set ? Foreground : Background);
+            if (Ctx->BitsPerPixel == 8)
+                Glyph->Mask[(UDOUBLE)Y * Bytes_Per_Row + X] = 0xFF;
+            else
+                Paint_PutPixel(Ctx, Glyph->Mask + (UDOUBLE)Y * Bytes_Per_Row, X, 0xFF);
+            if (!Glyph->Ink) {
+                Glyph->Ink = true;
+                Glyph->Ink_X0 = Glyph->Ink_X1 = X - Phase;
+                Glyph->Ink_Y0 = Glyph->Ink_Y1 = Y;
+            } else {
+                if (X - Phase < Glyph->Ink_X0) Glyph->Ink_X0 = X - Phase;
+                if (X - Phase > Glyph->Ink_X1) Glyph->Ink_X1 = X - Phase;
+                if (Y < Glyph->Ink_Y0) Glyph->Ink_Y0 = Y;
+                if (Y > Glyph->Ink_Y1) Glyph->Ink_Y1 = Y;
+            }
+        }
+        ptr += Width / 8 + (Width % 8 ? 1 : 0);
+    }
+
+    Glyph->Next = Cache->Bucket[Bucket];
+    Cache->Bucket[Bucket] = Glyph;
+    Paint_GlyphTouch(Cache, Glyph);
+    Cache->Stats.Glyphs++;
+    Cache->Stats.Bytes += Size;
+    return Glyph;
+}
+
+/******************************************************************************
+function: Draw a character from the glyph cache
+parameter:
+return: false if the cell is not wholly on the image or the glyph is not cached
+******************************************************************************/
+static bool Paint_DrawGlyphCached(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, const unsigned char *ptr, UWORD Width, UWORD Height,
+                                  UWORD Color_Foreground, UWORD Color_Background)
+{
+    UWORD X0, Y0, X1, Y1;
+    const PAINT_RECT *Clip = &Ctx->Clip;
+    PAINT_GLYPH_CACHE *Cache = Paint_GlyphCache(Ctx);
+
+    if (Cache == NULL || Cache->Max_Bytes == 0 || Width == 0 || Height == 0 ||
+        Xpoint + Width > Ctx->Width || Ypoint + Height > Ctx->Height)
+        return false;
+    //Opposite corners of the cell in memory; both must be on the image
+    if (!Paint_MapPoint(Ctx, Xpoint, Ypoint, &X0, &Y0) ||
+        !Paint_MapPoint(Ctx, Xpoint + Width - 1, Ypoint + Height - 1, &X1, &Y1) ||
+        X0 >= Ctx->WidthMemory || Y0 >= Ctx->HeightMemory ||
+        X1 >= Ctx->WidthMemory || Y1 >= Ctx->HeightMemory)
+        return false;
+    if (X1 < X0) { UWORD T = X0; X0 = X1; X1 = T; }
+    if (Y1 < Y0) { UWORD T = Y0; Y0 = Y1; Y1 = T; }
+
+    //Rows outside the clip are skipped; a cell cut by its sides is drawn a pixel at a time
+    if (X1 < Clip->X || X0 - Clip->X >= Clip->W || Y1 < Clip->Y || Y0 - Clip->Y >= Clip->H)
+        return true;
+    if (X0 < Clip->X || X1 - Clip->X >= Clip->W)
+        return false;
+
+    PAINT_GLYPH *Glyph = Paint_GetGlyph(Ctx, Xpoint, Ypoint, X0, Y0, ptr, Width, Height,
+                                        Color_Foreground, Color_Background);
+    if (Glyph == NULL)
+        return false;
+    UWORD Top = Glyph->Ink_Y0, Bottom = Glyph->Ink_Y1;
+    if (Y0 < Clip->Y && Top < Clip->Y - Y0)
+        Top = Clip->Y - Y0;
+    if (Bottom > Clip->Y + Clip->H - 1 - Y0)
+        Bottom = Clip->Y + Clip->H - 1 - Y0;
+    if (!Glyph->Ink || Top > Bottom)
+        return true;
+
+    //Whole words under the mask, only on the rows with drawn pixels
+    UWORD Bpp = Ctx->BitsPerPixel;
+    for (UWORD Row = Top; Row <= Bottom; Row++) {
+        UBYTE *Dst = Ctx->Image + (UDOUBLE)(Y0 + Row) * Ctx->WidthByte + X0 * Bpp / 8;
+        const UBYTE *Pixels = Glyph->Pixels + (UDOUBLE)Row * Glyph->Bytes_Per_Row;
+        const UBYTE *Mask = Glyph->Mask + (UDOUBLE)Row * Glyph->Bytes_Per_Row;
+        UWORD i = 0;
+        for (; i + 8 <= Glyph->Bytes_Per_Row; i += 8) {
+            uint64_t D, P, M;
+            memcpy(&D, Dst + i, 8);
+            memcpy(&P, Pixels + i, 8);
+            memcpy(&M, Mask + i, 8);
+            D = (D & ~M) | P;
+            memcpy(Dst + i, &D, 8);
+        }
+        for (; i < Glyph->Bytes_Per_Row; i++)
+            Dst[i] = (Dst[i] & ~Mask[i]) | Pixels[i];
+    }
+    Paint_DamageGrow(Ctx, X0 + Glyph->Ink_X0, Y0 + Top);
+    Paint_DamageGrow(Ctx, X0 + Glyph->Ink_X1, Y0 + Bottom);
+    return true;
+}
+
+/******************************************************************************
+function: Draw a character from its bitmap in a font table
+parameter:
+    ptr           : first byte of the bitmap, rows of whole bytes, leftmost pixel in the high bit
+    Width, Height : size of the character
+******************************************************************************/
+static void Paint_DrawGlyph(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, const unsigned char *ptr, UWORD Width, UWORD Height,
+                            UWORD Color_Foreground, UWORD Color_Background)
+{
+    if (!Paint_DrawGlyphCached(Ctx, Xpoint, Ypoint, ptr, Width, Height, Color_Foreground, Color_Background))
+        Paint_DrawGlyphPixels(Ctx, Xpoint, Ypoint, ptr, Width, Height, Color_Foreground, Color_Background);
+}
+
+/******************************************************************************
+function: Show English characters
+parameter:
+    Xpoint           ：X coordinate
+    Ypoint           ：Y coordinate
+    Acsii_Char       ：To display the English characters
+    Font             ：A structure pointer that displays a character size
+    Color_Foreground : Select the foreground color
+    Color_Background : Select the background color
+******************************************************************************/
+void Paint_Ctx_DrawChar(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
+                        sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_CHAR, .X0 = Xpoint, .Y0 = Ypoint, .Number = Acsii_Char, .Font = Font,
+                       .Color = Color_Foreground, .Background = Color_Background};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
+    if (Xpoint > Ctx->Width || Ypoint > Ctx->Height) {
+        Debug("Paint_DrawChar Input exceeds the normal display range\r\n");
+        return;
+    }
+
+    uint32_t Char_Offset = (Acsii_Char - ' ') * Font->Height * (Font->Width / 8 + (Font->Width % 8 ? 1 : 0));
+    const unsigned char *ptr = &Font->table[Char_Offset];
+
+    Paint_Ctx_BeginDamage(Ctx);
+    Paint_DrawGlyph(Ctx, Xpoint, Ypoint, ptr, Font->Width, Font->Height, Color_Foreground, Color_Background);
+    Paint_Ctx_EndDamage(Ctx);
+}
+
 /******************************************************************************
 function:	Display the string
 parameter:
@@ -522,39 +2084,202 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString,
-                         sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+void Paint_Ctx_DrawString_EN(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, const char * pString,
+                             sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
 {
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_STRING_EN, .X0 = Xstart, .Y0 = Ystart, .Font = Font,
+                       .Color = Color_Foreground, .Background = Color_Background};
+        Paint_BatchAdd(Ctx->Batch, &Op, pString, strlen(pString) + 1);
+        return;
+    }
     UWORD Xpoint = Xstart;
     UWORD Ypoint = Ystart;
 
-    if (Xstart > Paint.Width || Ystart > Paint.Height) {
+    if (Xstart > Ctx->Width || Ystart > Ctx->Height) {
         Debug("Paint_DrawString_EN Input exceeds the normal display range\r\n");
         return;
     }
 
-    while (* pString != '\0') {
-        //if X direction filled , reposition to(Xstart,Ypoint),Ypoint is Y direction plus the Height of the character
-        if ((Xpoint + Font->Width ) > Paint.Width ) {
-            Xpoint = Xstart;
-            Ypoint += Font->Height;
-        }
+    Paint_Ctx_BeginDamage(Ctx);
+    while (* pString != '\0') {
+        //if X direction filled , reposition to(Xstart,Ypoint),Ypoint is Y direction plus the Height of the character
+        if ((Xpoint + Font->Width ) > Ctx->Width ) {
+            Xpoint = Xstart;
+            Ypoint += Font->Height;
+        }
+
+        // If the Y direction is full, reposition to(Xstart, Ystart)
+        if ((Ypoint  + Font->Height ) > Ctx->Height ) {
+            Xpoint = Xstart;
+            Ypoint = Ystart;
+        }
+        Paint_Ctx_DrawChar(Ctx, Xpoint, Ypoint, * pString, Font, Color_Foreground, Color_Background);
+
+        //The next character of the address
+        pString ++;
+
+        //The next word of the abscissa increases the font of the broadband
+        Xpoint += Font->Width;
+    }
+    Paint_Ctx_EndDamage(Ctx);
+}
+
+
+/******************************************************************************
+Chinese font index: built the first time a table is drawn, replacing a
+linear scan of the table for every character. ASCII characters match on
+their first index byte and are looked up directly; GB2312 characters match
+on both bytes and are found by binary search.
+******************************************************************************/
+typedef struct {
+    UWORD Key;      //First byte in the high half, second in the low half
+    UWORD Num;      //Entry in the font table
+} PAINT_CN_KEY;
+
+typedef struct {
+    const cFONT *Font;
+    const CH_CN *Table;     //Table and size the index was built from
+    uint16_t Size;
+    int32_t Ascii[128];     //Entry for each ASCII character, -1 if none
+    PAINT_CN_KEY *Keys;     //GB2312 entries sorted by key
+    UWORD Count;
+} PAINT_CN_INDEX;
+
+static PAINT_CN_INDEX CN_Index[PAINT_CN_INDEX_MAX];
+static UWORD CN_Index_Next;
+//Contexts on other threads share the indexes
+static pthread_mutex_t CN_Index_Lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int Paint_CNKeyCompare(const void *A, const void *B)
+{
+    const PAINT_CN_KEY *KA = A, *KB = B;
+    if (KA->Key != KB->Key)
+        return KA->Key < KB->Key ? -1 : 1;
+    //The first of duplicate entries wins, as with a scan of the table
+    return KA->Num < KB->Num ? -1 : KA->Num > KB->Num;
+}
+
+/******************************************************************************
+function: Build the index of a Chinese font table
+parameter:
+return: false if out of memory
+******************************************************************************/
+static bool Paint_CNIndexBuild(PAINT_CN_INDEX *Index, const cFONT *Font)
+{
+    UWORD Num;
+
+    free(Index->Keys);
+    memset(Index, 0, sizeof(*Index));
+    for (Num = 0; Num < 128; Num++)
+        Index->Ascii[Num] = -1;
+
+    if (Font->size > 0) {
+        Index->Keys = (PAINT_CN_KEY *)malloc(Font->size * sizeof(PAINT_CN_KEY));
+        if (Index->Keys == NULL) {
+            Debug("Paint_CNIndexBuild: no memory for %u entries\r\n", Font->size);
+            return false;
+        }
+    }
+    for (Num = 0; Num < Font->size; Num++) {
+        UBYTE First = (UBYTE)Font->table[Num].index[0];
+        UBYTE Second = (UBYTE)Font->table[Num].index[1];
+        if (First <= 0x7F) {
+            if (Index->Ascii[First] < 0)
+                Index->Ascii[First] = Num;
+        } else {
+            Index->Keys[Index->Count].Key = (First << 8) | Second;
+            Index->Keys[Index->Count].Num = Num;
+            Index->Count++;
+        }
+    }
+    qsort(Index->Keys, Index->Count, sizeof(PAINT_CN_KEY), Paint_CNKeyCompare);
+
+    Index->Font = Font;
+    Index->Table = Font->table;
+    Index->Size = Font->size;
+    return true;
+}
+
+/******************************************************************************
+function: Get the index of a Chinese font table, building it on first use
+parameter:
+return: NULL if out of memory
+******************************************************************************/
+static const PAINT_CN_INDEX *Paint_CNIndex(const cFONT *Font)
+{
+    PAINT_CN_INDEX *Index;
+    UWORD i;
+
+    for (i = 0; i < PAINT_CN_INDEX_MAX; i++) {
+        Index = &CN_Index[i];
+        if (Index->Font == Font) {
+            //Rebuilt if the font was pointed at another table
+            if (Index->Table != Font->table || Index->Size != Font->size)
+                break;
+            return Index;
+        }
+    }
+    if (i == PAINT_CN_INDEX_MAX) {
+        Index = &CN_Index[CN_Index_Next];
+        CN_Index_Next = (CN_Index_Next + 1) % PAINT_CN_INDEX_MAX;
+    }
+    return Paint_CNIndexBuild(Index, Font) ? Index : NULL;
+}
+
+/******************************************************************************
+function: Look a character up in the index of a Chinese font table
+parameter:
+    pText : the character, one ASCII byte or two GB2312 bytes
+return: entry in the table, or -1 if the font does not have it
+******************************************************************************/
+static int Paint_CNLookup(const cFONT *Font, const unsigned char *pText)
+{
+    const PAINT_CN_INDEX *Index = Paint_CNIndex(Font);
+    UWORD Key, Lo, Hi;
+    int Num;
 
-        // If the Y direction is full, reposition to(Xstart, Ystart)
-        if ((Ypoint  + Font->Height ) > Paint.Height ) {
-            Xpoint = Xstart;
-            Ypoint = Ystart;
+    if (Index == NULL) {
+        //Out of memory: scan the table
+        for (Num = 0; Num < Font->size; Num++) {
+            if (pText[0] == (UBYTE)Font->table[Num].index[0] &&
+                (pText[0] <= 0x7F || pText[1] == (UBYTE)Font->table[Num].index[1]))
+                return Num;
         }
-        Paint_DrawChar(Xpoint, Ypoint, * pString, Font, Color_Foreground, Color_Background);
+        return -1;
+    }
 
-        //The next character of the address
-        pString ++;
+    if (pText[0] <= 0x7F)
+        return Index->Ascii[pText[0]];
 
-        //The next word of the abscissa increases the font of the broadband
-        Xpoint += Font->Width;
+    Key = (pText[0] << 8) | pText[1];
+    Lo = 0;
+    Hi = Index->Count;
+    while (Lo < Hi) {
+        UWORD Mid = Lo + (Hi - Lo) / 2;
+        if (Index->Keys[Mid].Key < Key)
+            Lo = Mid + 1;
+        else
+            Hi = Mid;
     }
+    if (Lo < Index->Count && Index->Keys[Lo].Key == Key)
+        return Index->Keys[Lo].Num;
+    return -1;
 }
 
+/******************************************************************************
+function: Find a character in a Chinese font table
+parameter:
+    pText : the character, one ASCII byte or two GB2312 bytes
+return: entry in the table, or -1 if the font does not have it
+******************************************************************************/
+static int Paint_CNFind(const cFONT *Font, const unsigned char *pText)
+{
+    pthread_mutex_lock(&CN_Index_Lock);
+    int Num = Paint_CNLookup(Font, pText);
+    pthread_mutex_unlock(&CN_Index_Lock);
+    return Num;
+}
 
 /******************************************************************************
 function: Display the string
@@ -567,89 +2292,41 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font,
-                        UWORD Color_Foreground, UWORD Color_Background)
+void Paint_Ctx_DrawString_CN(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font,
+                            UWORD Color_Foreground, UWORD Color_Background)
 {
-    const char* p_text = pString;
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_STRING_CN, .X0 = Xstart, .Y0 = Ystart, .Font = font,
+                       .Color = Color_Foreground, .Background = Color_Background};
+        Paint_BatchAdd(Ctx->Batch, &Op, pString, strlen(pString) + 1);
+        return;
+    }
+    const unsigned char* p_text = (const unsigned char *)pString;
     int x = Xstart, y = Ystart;
-    int i, j,Num;
+    int Num;
 
     /* Send the string character by character on EPD */
+    Paint_Ctx_BeginDamage(Ctx);
     while (*p_text != 0) {
-        if(*p_text <= 0x7F) {  //ASCII < 126
-            for(Num = 0; Num < font->size; Num++) {
-                if(*p_text== font->table[Num].index[0]) {
-                    const char* ptr = &font->table[Num].matrix[0];
-
-                    for (j = 0; j < font->Height; j++) {
-                        for (i = 0; i < font->Width; i++) {
-                            if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            } else {
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                } else {
-                                    Paint_SetPixel(x + i, y + j, Color_Background);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            }
-                            if (i % 8 == 7) {
-                                ptr++;
-                            }
-                        }
-                        if (font->Width % 8 != 0) {
-                            ptr++;
-                        }
-                    }
-                    break;
-                }
-            }
+        //A lead byte at the end of the string is not a character
+        if (*p_text > 0x7F && p_text[1] == 0)
+            break;
+
+        Num = Paint_CNFind(font, p_text);
+        if (Num >= 0)
+            Paint_DrawGlyph(Ctx, x, y, (const unsigned char *)font->table[Num].matrix,
+                            font->Width, font->Height, Color_Foreground, Color_Background);
+
+        if (*p_text <= 0x7F) {  //ASCII < 126
             /* Point on the next character */
             p_text += 1;
-            /* Decrement the column position by 16 */
             x += font->ASCII_Width;
         } else {        //Chinese
-            for(Num = 0; Num < font->size; Num++) {
-                if((*p_text== font->table[Num].index[0]) && (*(p_text+1) == font->table[Num].index[1])) {
-                    const char* ptr = &font->table[Num].matrix[0];
-
-                    for (j = 0; j < font->Height; j++) {
-                        for (i = 0; i < font->Width; i++) {
-                            if (FONT_BACKGROUND == Color_Background) { //this process is to speed up the scan
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            } else {
-                                if (*ptr & (0x80 >> (i % 8))) {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                } else {
-                                    Paint_SetPixel(x + i, y + j, Color_Background);
-                                    // Paint_DrawPoint(x + i, y + j, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
-                                }
-                            }
-                            if (i % 8 == 7) {
-                                ptr++;
-                            }
-                        }
-                        if (font->Width % 8 != 0) {
-                            ptr++;
-                        }
-                    }
-                    break;
-                }
-            }
-            /* Point on the next character */
             p_text += 2;
-            /* Decrement the column position by 16 */
             x += font->Width;
         }
     }
+    Paint_Ctx_EndDamage(Ctx);
 }
 
 /******************************************************************************
@@ -663,15 +2340,21 @@ parameter:
     Color_Background : Select the background color
 ******************************************************************************/
 #define  ARRAY_LEN 255
-void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
-                   sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+void Paint_Ctx_DrawNum(Paint_Ctx *Ctx, UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
+                       sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
 {
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_NUM, .X0 = Xpoint, .Y0 = Ypoint, .Number = Nummber, .Font = Font,
+                       .Color = Color_Foreground, .Background = Color_Background};
+        Paint_BatchAdd(Ctx->Batch, &Op, NULL, 0);
+        return;
+    }
 
     int16_t Num_Bit = 0, Str_Bit = 0;
     uint8_t Str_Array[ARRAY_LEN] = {0}, Num_Array[ARRAY_LEN] = {0};
     uint8_t *pStr = Str_Array;
 
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height) {
+    if (Xpoint > Ctx->Width || Ypoint > Ctx->Height) {
         Debug("Paint_DisNum Input exceeds the normal display range\r\n");
         return;
     }
@@ -691,7 +2374,7 @@ void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
     }
 
     //show
-    Paint_DrawString_EN(Xpoint, Ypoint, (const char*)pStr, Font, Color_Foreground, Color_Background);
+    Paint_Ctx_DrawString_EN(Ctx, Xpoint, Ypoint, (const char*)pStr, Font, Color_Foreground, Color_Background);
 }
 
 /******************************************************************************
@@ -704,20 +2387,479 @@ parameter:
     Color_Foreground : Select the foreground color
     Color_Background : Select the background color
 ******************************************************************************/
-void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font,
-                    UWORD Color_Foreground, UWORD Color_Background)
+void Paint_Ctx_DrawTime(Paint_Ctx *Ctx, UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font,
+                        UWORD Color_Foreground, UWORD Color_Background)
 {
+    if (Ctx->Batch != NULL) {
+        PAINT_OP Op = {.Type = PAINT_OP_TIME, .X0 = Xstart, .Y0 = Ystart, .Font = Font,
+                       .Color = Color_Foreground, .Background = Color_Background};
+        Paint_BatchAdd(Ctx->Batch, &Op, pTime, sizeof(*pTime));
+        return;
+    }
     uint8_t value[10] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
 
     UWORD Dx = Font->Width;
 
     //Write data into the cache
-    Paint_DrawChar(Xstart                           , Ystart, value[pTime->Hour / 10], Font, Color_Foreground, Color_Background);
-    Paint_DrawChar(Xstart + Dx                      , Ystart, value[pTime->Hour % 10], Font, Color_Foreground, Color_Background);
-    Paint_DrawChar(Xstart + Dx  + Dx / 4 + Dx / 2   , Ystart, ':'                    , Font, Color_Foreground, Color_Background);
-    Paint_DrawChar(Xstart + Dx * 2 + Dx / 2         , Ystart, value[pTime->Min / 10] , Font, Color_Foreground, Color_Background);
-    Paint_DrawChar(Xstart + Dx * 3 + Dx / 2         , Ystart, value[pTime->Min % 10] , Font, Color_Foreground, Color_Background);
-    Paint_DrawChar(Xstart + Dx * 4 + Dx / 2 - Dx / 4, Ystart, ':'                    , Font, Color_Foreground, Color_Background);
-    Paint_DrawChar(Xstart + Dx * 5                  , Ystart, value[pTime->Sec / 10] , Font, Color_Foreground, Color_Background);
-    Paint_DrawChar(Xstart + Dx * 6                  , Ystart, value[pTime->Sec % 10] , Font, Color_Foreground, Color_Background);
+    Paint_Ctx_BeginDamage(Ctx);
+    Paint_Ctx_DrawChar(Ctx, Xstart                           , Ystart, value[pTime->Hour / 10], Font, Color_Foreground, Color_Background);
+    Paint_Ctx_DrawChar(Ctx, Xstart + Dx                      , Ystart, value[pTime->Hour % 10], Font, Color_Foreground, Color_Background);
+    Paint_Ctx_DrawChar(Ctx, Xstart + Dx  + Dx / 4 + Dx / 2   , Ystart, ':'                    , Font, Color_Foreground, Color_Background);
+    Paint_Ctx_DrawChar(Ctx, Xstart + Dx * 2 + Dx / 2         , Ystart, value[pTime->Min / 10] , Font, Color_Foreground, Color_Background);
+    Paint_Ctx_DrawChar(Ctx, Xstart + Dx * 3 + Dx / 2         , Ystart, value[pTime->Min % 10] , Font, Color_Foreground, Color_Background);
+    Paint_Ctx_DrawChar(Ctx, Xstart + Dx * 4 + Dx / 2 - Dx / 4, Ystart, ':'                    , Font, Color_Foreground, Color_Background);
+    Paint_Ctx_DrawChar(Ctx, Xstart + Dx * 5                  , Ystart, value[pTime->Sec / 10] , Font, Color_Foreground, Color_Background);
+    Paint_Ctx_DrawChar(Ctx, Xstart + Dx * 6                  , Ystart, value[pTime->Sec % 10] , Font, Color_Foreground, Color_Background);
+    Paint_Ctx_EndDamage(Ctx);
+}
+
+/******************************************************************************
+function: Find the area a recorded call can draw on
+parameter:
+    Box : receives the left, top, right and bottom edges, right and bottom
+          exclusive, in logical coordinates
+return: false if the call may draw anywhere
+******************************************************************************/
+static bool Paint_OpBounds(Paint_Ctx *Ctx, const PAINT_OP *Op, const UBYTE *Data, int32_t Box[4])
+{
+    const sFONT *Font = Op->Font;
+    const cFONT *CN_Font = Op->Font;
+    //Color blocks, and dots of lines and outlines, reach a little past the
+    //points they are drawn at
+    int32_t Pad = Ctx->IsColor ? 4 : 0;
+    int32_t Dot = Pad + Op->Width + 1;
+    int32_t Len, Cell;
+
+    switch (Op->Type) {
+    case PAINT_OP_POINT:
+    case PAINT_OP_COLOR:
+        Pad = Dot;
+        //fall through
+    case PAINT_OP_PIXEL:
+        Box[0] = Op->X0;
+        Box[1] = Op->Y0;
+        Box[2] = Op->X0 + 1;
+        Box[3] = Op->Y0 + 1;
+        break;
+    case PAINT_OP_SPAN:
+    case PAINT_OP_ROW:
+        Pad = 0;
+        Box[0] = Op->X0;
+        Box[1] = Op->Y0;
+        Box[2] = Op->X0 + Op->R0;
+        Box[3] = Op->Y0 + 1;
+        break;
+    case PAINT_OP_LINE:
+    case PAINT_OP_THICK_LINE:
+    case PAINT_OP_RECTANGLE:
+    case PAINT_OP_ROUNDED_RECTANGLE:
+        Pad = Dot;
+        //fall through
+    case PAINT_OP_CLEAR_WINDOWS:
+        Box[0] = Op->X0 < Op->X1 ? Op->X0 : Op->X1;
+        Box[1] = Op->Y0 < Op->Y1 ? Op->Y0 : Op->Y1;
+        Box[2] = (Op->X0 < Op->X1 ? Op->X1 : Op->X0) + 1;
+        Box[3] = (Op->Y0 < Op->Y1 ? Op->Y1 : Op->Y0) + 1;
+        break;
+    case PAINT_OP_CIRCLE:
+    case PAINT_OP_ELLIPSE:
+        Pad = Dot;
+        Len = Op->Type == PAINT_OP_CIRCLE ? Op->R0 : Op->R1;
+        Box[0] = Op->X0 - Op->R0;
+        Box[1] = Op->Y0 - Len;
+        Box[2] = Op->X0 + Op->R0 + 1;
+        Box[3] = Op->Y0 + Len + 1;
+        break;
+    case PAINT_OP_CHAR:
+    case PAINT_OP_TIME:
+        Len = Op->Type == PAINT_OP_CHAR ? 1 : 7;
+        Box[0] = Op->X0;
+        Box[1] = Op->Y0;
+        Box[2] = Op->X0 + Len * Font->Width;
+        Box[3] = Op->Y0 + Font->Height;
+        break;
+    case PAINT_OP_STRING_EN:
+    case PAINT_OP_NUM:
+        //Strings too long for the line wrap below it, then back to the top
+        Len = Op->Type == PAINT_OP_NUM ? 10 : (int32_t)strlen((const char *)Data);
+        Box[0] = Op->X0;
+        Box[1] = Op->Y0;
+        Box[2] = Op->X0 + Len * Font->Width;
+        Box[3] = Op->Y0 + Font->Height;
+        if (Box[2] > Ctx->Width) {
+            Box[2] = Ctx->Width;
+            Box[3] = Ctx->Height + Font->Height;
+        }
+        break;
+    case PAINT_OP_STRING_CN:
+        Cell = CN_Font->Width > CN_Font->ASCII_Width ? CN_Font->Width : CN_Font->ASCII_Width;
+        Box[0] = Op->X0;
+        Box[1] = Op->Y0;
+        Box[2] = Op->X0 + (int32_t)strlen((const char *)Data) * Cell + CN_Font->Width;
+        Box[3] = Op->Y0 + CN_Font->Height;
+        break;
+    default:
+        return false;
+    }
+    Box[0] -= Pad;
+    Box[1] -= Pad;
+    Box[2] += Pad;
+    Box[3] += Pad;
+    return true;
+}
+
+/******************************************************************************
+function: Find the area of image memory a recorded call can draw on
+parameter:
+    Rect : receives the area, the whole image if the call may draw anywhere
+return: false if the call draws nothing on the image
+******************************************************************************/
+static bool Paint_OpArea(Paint_Ctx *Ctx, const PAINT_OP *Op, const UBYTE *Data, PAINT_RECT *Rect)
+{
+    int32_t Box[4];
+    PAINT_RECT Image = {0, 0, Ctx->WidthMemory, Ctx->HeightMemory};
+
+    //Coordinates wrap at 65536, so negative ones are off the image as long
+    //as they stay below it once wrapped
+    if (!Paint_OpBounds(Ctx, Op, Data, Box) ||
+        Box[0] < (int32_t)Ctx->Width - 0x10000 || Box[1] < (int32_t)Ctx->Height - 0x10000 ||
+        Box[2] > 0xFFFF || Box[3] > 0xFFFF) {
+        *Rect = Image;
+        return Image.W > 0 && Image.H > 0;
+    }
+    if (Box[0] < 0)
+        Box[0] = 0;
+    if (Box[1] < 0)
+        Box[1] = 0;
+    return Paint_MapRect(Ctx, Box[0], Box[1], Box[2], Box[3], Rect);
+}
+
+/******************************************************************************
+function: Get the area of image memory a batch can draw on
+parameter:
+    Rect : receives the area
+return: false if the batch draws nothing on the image
+******************************************************************************/
+bool Paint_Ctx_BatchBounds(Paint_Ctx *Ctx, const PAINT_BATCH *Batch, PAINT_RECT *Rect)
+{
+    UDOUBLE X0 = 0xFFFF, Y0 = 0xFFFF, X1 = 0, Y1 = 0;
+    PAINT_RECT Area;
+
+    for (UDOUBLE i = 0; i < Batch->Count; i++) {
+        if (!Paint_OpArea(Ctx, &Batch->Ops[i], Batch->Data + Batch->Ops[i].Data, &Area))
+            continue;
+        if (Area.X < X0)
+            X0 = Area.X;
+        if (Area.Y < Y0)
+            Y0 = Area.Y;
+        if ((UDOUBLE)Area.X + Area.W > X1)
+            X1 = Area.X + Area.W;
+        if ((UDOUBLE)Area.Y + Area.H > Y1)
+            Y1 = Area.Y + Area.H;
+    }
+    if (X1 <= X0 || Y1 <= Y0)
+        return false;
+    Rect->X = X0;
+    Rect->Y = Y0;
+    Rect->W = X1 - X0;
+    Rect->H = Y1 - Y0;
+    return true;
+}
+
+/******************************************************************************
+function: Check whether two batches make the same calls
+parameter:
+******************************************************************************/
+bool Paint_Batch_Equal(const PAINT_BATCH *A, const PAINT_BATCH *B)
+{
+    if (A->Count != B->Count || A->Data_Len != B->Data_Len || A->Failed || B->Failed)
+        return false;
+    for (UDOUBLE i = 0; i < A->Count; i++) {
+        const PAINT_OP *Op_A = &A->Ops[i], *Op_B = &B->Ops[i];
+        if (Op_A->Type != Op_B->Type || Op_A->Style != Op_B->Style || Op_A->Cap != Op_B->Cap ||
+            Op_A->X0 != Op_B->X0 || Op_A->Y0 != Op_B->Y0 || Op_A->X1 != Op_B->X1 || Op_A->Y1 != Op_B->Y1 ||
+            Op_A->R0 != Op_B->R0 || Op_A->R1 != Op_B->R1 ||
+            Op_A->Color != Op_B->Color || Op_A->Background != Op_B->Background || Op_A->Width != Op_B->Width ||
+            Op_A->Number != Op_B->Number || Op_A->Font != Op_B->Font || Op_A->Data != Op_B->Data)
+            return false;
+    }
+    return A->Data_Len == 0 || memcmp(A->Data, B->Data, A->Data_Len) == 0;
+}
+
+/******************************************************************************
+function: Draw the calls recorded in a batch, skipping those wholly outside
+          the clip
+parameter:
+******************************************************************************/
+void Paint_Ctx_Replay(Paint_Ctx *Ctx, const PAINT_BATCH *Batch)
+{
+    for (UDOUBLE i = 0; i < Batch->Count; i++) {
+        const PAINT_OP *Op = &Batch->Ops[i];
+        const UBYTE *Data = Batch->Data + Op->Data;
+        PAINT_TIME Time;
+        PAINT_RECT Area;
+
+        if (!Paint_OpArea(Ctx, Op, Data, &Area) || !Paint_IntersectRect(&Area, &Ctx->Clip))
+            continue;
+
+        switch (Op->Type) {
+        case PAINT_OP_PIXEL:
+            Paint_Ctx_SetPixel(Ctx, Op->X0, Op->Y0, Op->Color);
+            break;
+        case PAINT_OP_SPAN:
+            Paint_Ctx_FillSpan(Ctx, Op->X0, Op->Y0, Op->R0, Op->Color);
+            break;
+        case PAINT_OP_ROW:
+            Paint_Ctx_BlitRow(Ctx, Op->X0, Op->Y0, Data, Op->R0, Op->Style);
+            break;
+        case PAINT_OP_CLEAR:
+            Paint_Ctx_Clear(Ctx, Op->Color);
+            break;
+        case PAINT_OP_CLEAR_WINDOWS:
+            Paint_Ctx_ClearWindows(Ctx, Op->X0, Op->Y0, Op->X1, Op->Y1, Op->Color);
+            break;
+        case PAINT_OP_POINT:
+            Paint_Ctx_DrawPoint(Ctx, Op->X0, Op->Y0, Op->Color, Op->Width, Op->Style);
+            break;
+        case PAINT_OP_LINE:
+            Paint_Ctx_DrawLine(Ctx, Op->X0, Op->Y0, Op->X1, Op->Y1, Op->Color, Op->Width, Op->Style);
+            break;
+        case PAINT_OP_THICK_LINE:
+            Paint_Ctx_DrawThickLine(Ctx, Op->X0, Op->Y0, Op->X1, Op->Y1, Op->Color, Op->Width, Op->Cap, Op->Style);
+            break;
+        case PAINT_OP_RECTANGLE:
+            Paint_Ctx_DrawRectangle(Ctx, Op->X0, Op->Y0, Op->X1, Op->Y1, Op->Color, Op->Width, Op->Style);
+            break;
+        case PAINT_OP_CIRCLE:
+            Paint_Ctx_DrawCircle(Ctx, Op->X0, Op->Y0, Op->R0, Op->Color, Op->Width, Op->Style);
+            break;
+        case PAINT_OP_ELLIPSE:
+            Paint_Ctx_DrawEllipse(Ctx, Op->X0, Op->Y0, Op->R0, Op->R1, Op->Color, Op->Width, Op->Style);
+            break;
+        case PAINT_OP_ROUNDED_RECTANGLE:
+            Paint_Ctx_DrawRoundedRectangle(Ctx, Op->X0, Op->Y0, Op->X1, Op->Y1, Op->R0, Op->Color, Op->Width, Op->Style);
+            break;
+        case PAINT_OP_CHAR:
+            Paint_Ctx_DrawChar(Ctx, Op->X0, Op->Y0, Op->Number, (sFONT *)Op->Font, Op->Color, Op->Background);
+            break;
+        case PAINT_OP_STRING_EN:
+            Paint_Ctx_DrawString_EN(Ctx, Op->X0, Op->Y0, (const char *)Data, (sFONT *)Op->Font, Op->Color, Op->Background);
+            break;
+        case PAINT_OP_STRING_CN:
+            Paint_Ctx_DrawString_CN(Ctx, Op->X0, Op->Y0, (const char *)Data, (cFONT *)Op->Font, Op->Color, Op->Background);
+            break;
+        case PAINT_OP_NUM:
+            Paint_Ctx_DrawNum(Ctx, Op->X0, Op->Y0, Op->Number, (sFONT *)Op->Font, Op->Color, Op->Background);
+            break;
+        case PAINT_OP_TIME:
+            memcpy(&Time, Data, sizeof(Time));
+            Paint_Ctx_DrawTime(Ctx, Op->X0, Op->Y0, &Time, (sFONT *)Op->Font, Op->Color, Op->Background);
+            break;
+        case PAINT_OP_COLOR:
+            Paint_Ctx_SetColor(Ctx, Op->X0, Op->Y0, Op->Color);
+            break;
+        }
+    }
+}
+
+/******************************************************************************
+The Paint_* functions draw into Paint
+******************************************************************************/
+static inline Paint_Ctx *Paint_Default(void)
+{
+    //isColor is set directly by the display setup
+    Paint.IsColor = isColor;
+    return &Paint;
+}
+
+void Paint_Record(PAINT_BATCH *Batch)
+{
+    Paint_Ctx_Record(Paint_Default(), Batch);
+}
+
+void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD Color)
+{
+    Paint_Ctx_NewImage(Paint_Default(), image, Width, Height, Rotate, Color);
+}
+
+void Paint_SelectImage(UBYTE *image)
+{
+    Paint_Ctx_SelectImage(Paint_Default(), image);
+}
+
+void Paint_SetRotate(UWORD Rotate)
+{
+    Paint_Ctx_SetRotate(Paint_Default(), Rotate);
+}
+
+void Paint_SetMirroring(UBYTE mirror)
+{
+    Paint_Ctx_SetMirroring(Paint_Default(), mirror);
+}
+
+void Paint_SetBitsPerPixel(UBYTE bpp)
+{
+    Paint_Ctx_SetBitsPerPixel(Paint_Default(), bpp);
+}
+
+void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    Paint_Ctx_SetPixel(Paint_Default(), Xpoint, Ypoint, Color);
+}
+
+void Paint_FillSpan(UWORD Xpoint, UWORD Ypoint, UWORD Len, UWORD Color)
+{
+    Paint_Ctx_FillSpan(Paint_Default(), Xpoint, Ypoint, Len, Color);
+}
+
+void Paint_BlitRow(UWORD Xpoint, UWORD Ypoint, const UBYTE *Src, UWORD Len, UBYTE Src_Bpp)
+{
+    Paint_Ctx_BlitRow(Paint_Default(), Xpoint, Ypoint, Src, Len, Src_Bpp);
+}
+
+void Paint_BeginDamage(void)
+{
+    Paint_Ctx_BeginDamage(Paint_Default());
+}
+
+void Paint_EndDamage(void)
+{
+    Paint_Ctx_EndDamage(Paint_Default());
+}
+
+void Paint_AddDamage(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
+{
+    Paint_Ctx_AddDamage(Paint_Default(), Xstart, Ystart, Xend, Yend);
+}
+
+void Paint_AddDamageRect(const PAINT_RECT *Rect)
+{
+    Paint_Ctx_AddDamageRect(Paint_Default(), Rect);
+}
+
+void Paint_SetClip(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend)
+{
+    Paint_Ctx_SetClip(Paint_Default(), Xstart, Ystart, Xend, Yend);
+}
+
+void Paint_ClearClip(void)
+{
+    Paint_Ctx_ClearClip(Paint_Default());
+}
+
+UWORD Paint_GetDamage(PAINT_RECT *Rects, UWORD Max, UWORD Align)
+{
+    return Paint_Ctx_GetDamage(Paint_Default(), Rects, Max, Align);
+}
+
+void Paint_ClearDamage(void)
+{
+    Paint_Ctx_ClearDamage(Paint_Default());
+}
+
+void Paint_SetColor(UWORD x, UWORD y, UWORD color)
+{
+    Paint_Ctx_SetColor(Paint_Default(), x, y, color);
+}
+
+void Paint_Clear(UWORD Color)
+{
+    Paint_Ctx_Clear(Paint_Default(), Color);
+}
+
+void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
+{
+    Paint_Ctx_ClearWindows(Paint_Default(), Xstart, Ystart, Xend, Yend, Color);
+}
+
+void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
+                     DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
+{
+    Paint_Ctx_DrawPoint(Paint_Default(), Xpoint, Ypoint, Color, Dot_Pixel, Dot_Style);
+}
+
+void Paint_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                    UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+{
+    Paint_Ctx_DrawLine(Paint_Default(), Xstart, Ystart, Xend, Yend, Color, Line_width, Line_Style);
+}
+
+void Paint_DrawThickLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                         UWORD Color, UWORD Line_width, LINE_CAP Cap, LINE_STYLE Line_Style)
+{
+    Paint_Ctx_DrawThickLine(Paint_Default(), Xstart, Ystart, Xend, Yend, Color, Line_width, Cap, Line_Style);
+}
+
+void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                         UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_Ctx_DrawRectangle(Paint_Default(), Xstart, Ystart, Xend, Yend, Color, Line_width, Draw_Fill);
+}
+
+void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
+                      UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_Ctx_DrawCircle(Paint_Default(), X_Center, Y_Center, Radius, Color, Line_width, Draw_Fill);
+}
+
+void Paint_DrawEllipse(UWORD X_Center, UWORD Y_Center, UWORD X_Radius, UWORD Y_Radius,
+                       UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_Ctx_DrawEllipse(Paint_Default(), X_Center, Y_Center, X_Radius, Y_Radius, Color, Line_width, Draw_Fill);
+}
+
+void Paint_DrawRoundedRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Radius,
+                                UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    Paint_Ctx_DrawRoundedRectangle(Paint_Default(), Xstart, Ystart, Xend, Yend, Radius, Color, Line_width, Draw_Fill);
+}
+
+void Paint_FlushGlyphCache(void)
+{
+    Paint_Ctx_FlushGlyphCache(Paint_Default());
+}
+
+void Paint_SetGlyphCache(UDOUBLE Max_Bytes)
+{
+    Paint_Ctx_SetGlyphCache(Paint_Default(), Max_Bytes);
+}
+
+void Paint_GetGlyphStats(PAINT_GLYPH_STATS *Stats)
+{
+    Paint_Ctx_GetGlyphStats(Paint_Default(), Stats);
+}
+
+void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
+                    sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_Ctx_DrawChar(Paint_Default(), Xpoint, Ypoint, Acsii_Char, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawString_EN(UWORD Xstart, UWORD Ystart, const char * pString,
+                         sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_Ctx_DrawString_EN(Paint_Default(), Xstart, Ystart, pString, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char * pString, cFONT* font,
+                        UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_Ctx_DrawString_CN(Paint_Default(), Xstart, Ystart, pString, font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawNum(UWORD Xpoint, UWORD Ypoint, int32_t Nummber,
+                   sFONT* Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_Ctx_DrawNum(Paint_Default(), Xpoint, Ypoint, Nummber, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_DrawTime(UWORD Xstart, UWORD Ystart, PAINT_TIME *pTime, sFONT* Font,
+                    UWORD Color_Foreground, UWORD Color_Background)
+{
+    Paint_Ctx_DrawTime(Paint_Default(), Xstart, Ystart, pTime, Font, Color_Foreground, Color_Background);
+}
+
+void Paint_Replay(const PAINT_BATCH *Batch)
+{
+    Paint_Ctx_Replay(Paint_Default(), Batch);
 }
@@ -0,0 +1,115 @@
+/**
+ * @file GUI_Paint_Bands.c
+ * @brief Drawing a batch on several threads, each into a band of the image.
+ */
+#include "GUI_Paint_Bands.h"
+#include "../../include/Debug.h"
+#include <string.h>
+#include <pthread.h>
+
+extern UBYTE isColor;
+
+typedef struct {
+    Paint_Ctx *Band;
+    const PAINT_BATCH *Batch;
+} PAINT_BAND_JOB;
+
+/******************************************************************************
+function: Set up bands
+parameter:
+    Count : number of bands
+******************************************************************************/
+int Paint_Bands_Init(PAINT_BANDS *Bands, UWORD Count)
+{
+    if (Count == 0 || Count > PAINT_BANDS_MAX) {
+        Debug("Paint_Bands_Init: %d bands, 1 to %d supported\r\n", Count, PAINT_BANDS_MAX);
+        return PAINT_BANDS_ERR_ARGS;
+    }
+    Bands->Count = Count;
+    for (UWORD i = 0; i < PAINT_BANDS_MAX; i++)
+        Paint_Ctx_Init(&Bands->Band[i]);
+    return 0;
+}
+
+/******************************************************************************
+function: Free the glyph caches of the bands
+parameter:
+******************************************************************************/
+void Paint_Bands_Release(PAINT_BANDS *Bands)
+{
+    for (UWORD i = 0; i < PAINT_BANDS_MAX; i++)
+        Paint_Ctx_Release(&Bands->Band[i]);
+    Bands->Count = 0;
+}
+
+/******************************************************************************
+function: Draw the batch into one band
+parameter:
+******************************************************************************/
+static void *Paint_Bands_Worker(void *Arg)
+{
+    PAINT_BAND_JOB *Job = Arg;
+
+    Paint_Ctx_Replay(Job->Band, Job->Batch);
+    return NULL;
+}
+
+/******************************************************************************
+function: Replay a batch into a context, one band per thread
+parameter:
+******************************************************************************/
+int Paint_Bands_Render(PAINT_BANDS *Bands, Paint_Ctx *Ctx, const PAINT_BATCH *Batch)
+{
+    PAINT_BAND_JOB Job[PAINT_BANDS_MAX];
+    pthread_t Thread[PAINT_BANDS_MAX];
+    bool Started[PAINT_BANDS_MAX];
+    PAINT_RECT Rects[PAINT_DAMAGE_MAX];
+    UWORD Count = Bands->Count;
+
+    if (Count == 0 || Count > PAINT_BANDS_MAX)
+        return PAINT_BANDS_ERR_ARGS;
+    if (Batch->Failed) {
+        Debug("Paint_Bands_Render: the batch is missing calls\r\n");
+        return PAINT_BANDS_ERR_BATCH;
+    }
+
+    //Each band is the context cut down to its rows, with its own glyph cache
+    for (UWORD i = 0; i < Count; i++) {
+        Paint_Ctx *Band = &Bands->Band[i];
+        struct PAINT_GLYPH_CACHE *Glyphs = Band->Glyphs;
+        UWORD Top = Ctx->Clip.Y + (UDOUBLE)Ctx->Clip.H * i / Count;
+        UWORD Bottom = Ctx->Clip.Y + (UDOUBLE)Ctx->Clip.H * (i + 1) / Count;
+
+        *Band = *Ctx;
+        Band->Glyphs = Glyphs;
+        Band->Batch = NULL;
+        if (Ctx == &Paint)
+            Band->IsColor = isColor;
+        memset(&Band->Damage, 0, sizeof(Band->Damage));
+        Band->Clip.Y = Top;
+        Band->Clip.H = Bottom - Top;
+        Job[i].Band = Band;
+        Job[i].Batch = Batch;
+    }
+
+    //A band whose thread cannot start is drawn by the caller
+    for (UWORD i = 1; i < Count; i++) {
+        Started[i] = pthread_create(&Thread[i], NULL, Paint_Bands_Worker, &Job[i]) == 0;
+        if (!Started[i])
+            Debug("Paint_Bands_Render: cannot start a thread for band %d\r\n", i);
+    }
+    Paint_Bands_Worker(&Job[0]);
+    for (UWORD i = 1; i < Count; i++) {
+        if (Started[i])
+            pthread_join(Thread[i], NULL);
+        else
+            Paint_Bands_Worker(&Job[i]);
+    }
+
+    for (UWORD i = 0; i < Count; i++) {
+        UWORD Num = Paint_Ctx_GetDamage(&Bands->Band[i], Rects, PAINT_DAMAGE_MAX, 1);
+        for (UWORD j = 0; j < Num; j++)
+            Paint_Ctx_AddDamageRect(Ctx, &Rects[j]);
+    }
+    return 0;
+}
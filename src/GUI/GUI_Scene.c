@@ -0,0 +1,341 @@
+/**
+ * @file GUI_Scene.c
+ * @brief Retained display list redrawn only where it changed.
+ *
+ * Each node keeps the drawing calls it makes as a PAINT_BATCH. Setting a
+ * node records the new calls and compares them with the old ones, and a
+ * commit redraws the old and new areas of the nodes that differ.
+ */
+#include "GUI_Scene.h"
+#include "GUI_BMPfile.h"
+#include "../../include/Debug.h"
+#include <stdlib.h>
+#include <string.h>
+
+extern UBYTE isColor;
+
+/******************************************************************************
+function: Set up an empty scene
+parameter:
+    Ctx        : context to draw into
+    Background : color of areas no node covers
+******************************************************************************/
+void Scene_Init(SCENE *Scene, Paint_Ctx *Ctx, UWORD Background)
+{
+    memset(Scene, 0, sizeof(*Scene));
+    Scene->Ctx = Ctx;
+    Scene->Background = Background;
+    Scene->Open = -1;
+    Scene->Redraw_All = true;
+    Paint_Batch_Init(&Scene->Scratch);
+}
+
+/******************************************************************************
+function: Free the nodes of a scene
+parameter:
+******************************************************************************/
+void Scene_Release(SCENE *Scene)
+{
+    if (Scene->Open >= 0)
+        Paint_Ctx_Record(Scene->Ctx, Scene->Saved);
+    for (UDOUBLE i = 0; i < Scene->Count; i++)
+        Paint_Batch_Release(&Scene->Nodes[i].Calls);
+    Paint_Batch_Release(&Scene->Scratch);
+    free(Scene->Nodes);
+    Scene->Nodes = NULL;
+    Scene->Count = 0;
+    Scene->Capacity = 0;
+    Scene->Open = -1;
+}
+
+/******************************************************************************
+function: Find the node with an ID
+parameter:
+return: its index, or -1
+******************************************************************************/
+static long Scene_Find(const SCENE *Scene, UDOUBLE Id)
+{
+    for (UDOUBLE i = 0; i < Scene->Count; i++)
+        if (Scene->Nodes[i].Id == Id)
+            return i;
+    return -1;
+}
+
+/******************************************************************************
+function: Start recording the calls of a node
+parameter:
+    Id : node ID, added at the top if new
+******************************************************************************/
+int Scene_BeginNode(SCENE *Scene, UDOUBLE Id)
+{
+    long Index;
+
+    if (Scene->Open >= 0)
+        return SCENE_ERR_BUSY;
+
+    Index = Scene_Find(Scene, Id);
+    if (Index < 0) {
+        if (Scene->Count == Scene->Capacity) {
+            UDOUBLE Capacity = Scene->Capacity ? Scene->Capacity * 2 : 16;
+            SCENE_NODE *Nodes = realloc(Scene->Nodes, Capacity * sizeof(SCENE_NODE));
+            if (Nodes == NULL) {
+                Debug("Scene_BeginNode: no memory for node %lu\r\n", (unsigned long)Id);
+                return SCENE_ERR_MEMORY;
+            }
+            Scene->Nodes = Nodes;
+            Scene->Capacity = Capacity;
+        }
+        //Not present until its calls are recorded
+        Index = Scene->Count++;
+        memset(&Scene->Nodes[Index], 0, sizeof(SCENE_NODE));
+        Scene->Nodes[Index].Id = Id;
+    }
+
+    Paint_Batch_Reset(&Scene->Scratch);
+    Scene->Saved = Scene->Ctx->Batch;
+    Paint_Ctx_Record(Scene->Ctx, &Scene->Scratch);
+    Scene->Open = Index;
+    return 0;
+}
+
+/******************************************************************************
+function: Stop recording, and keep the calls if they differ from the node's
+parameter:
+    Keep : false to drop the calls and leave the node as it was
+******************************************************************************/
+static int Scene_FinishNode(SCENE *Scene, bool Keep)
+{
+    SCENE_NODE *Node;
+    PAINT_BATCH Old;
+
+    if (Scene->Open < 0)
+        return SCENE_ERR_MISSING;
+    Node = &Scene->Nodes[Scene->Open];
+    Scene->Open = -1;
+    Paint_Ctx_Record(Scene->Ctx, Scene->Saved);
+
+    if (!Keep)
+        return 0;
+    if (Scene->Scratch.Failed) {
+        Debug("Scene_EndNode: no memory for the calls of node %lu\r\n", (unsigned long)Node->Id);
+        return SCENE_ERR_MEMORY;
+    }
+    if (Node->Present && Paint_Batch_Equal(&Node->Calls, &Scene->Scratch))
+        return 0;
+
+    //The old calls' memory is reused for the next node
+    Old = Node->Calls;
+    Node->Calls = Scene->Scratch;
+    Scene->Scratch = Old;
+    Node->Present = true;
+    Node->Changed = true;
+    return 0;
+}
+
+/******************************************************************************
+function: Finish setting a node
+parameter:
+******************************************************************************/
+int Scene_EndNode(SCENE *Scene)
+{
+    return Scene_FinishNode(Scene, true);
+}
+
+/******************************************************************************
+function: Set a node to an ASCII string
+parameter:
+******************************************************************************/
+int Scene_SetText(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, const char *pString,
+                  sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    int Ret = Scene_BeginNode(Scene, Id);
+    if (Ret != 0)
+        return Ret;
+    Paint_Ctx_DrawString_EN(Scene->Ctx, Xstart, Ystart, pString, Font, Color_Foreground, Color_Background);
+    return Scene_EndNode(Scene);
+}
+
+/******************************************************************************
+function: Set a node to a GB2312 and ASCII string
+parameter:
+******************************************************************************/
+int Scene_SetTextCN(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, const char *pString,
+                    cFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    int Ret = Scene_BeginNode(Scene, Id);
+    if (Ret != 0)
+        return Ret;
+    Paint_Ctx_DrawString_CN(Scene->Ctx, Xstart, Ystart, pString, Font, Color_Foreground, Color_Background);
+    return Scene_EndNode(Scene);
+}
+
+/******************************************************************************
+function: Set a node to a rectangle
+parameter:
+    Xend, Yend : bottom right corner, exclusive
+******************************************************************************/
+int Scene_SetRect(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                  UWORD Radius, UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    int Ret = Scene_BeginNode(Scene, Id);
+    if (Ret != 0)
+        return Ret;
+    Paint_Ctx_DrawRoundedRectangle(Scene->Ctx, Xstart, Ystart, Xend, Yend, Radius, Color, Line_width, Draw_Fill);
+    return Scene_EndNode(Scene);
+}
+
+/******************************************************************************
+function: Set a node to a circle
+parameter:
+******************************************************************************/
+int Scene_SetCircle(SCENE *Scene, UDOUBLE Id, UWORD X_Center, UWORD Y_Center, UWORD Radius,
+                    UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    int Ret = Scene_BeginNode(Scene, Id);
+    if (Ret != 0)
+        return Ret;
+    Paint_Ctx_DrawCircle(Scene->Ctx, X_Center, Y_Center, Radius, Color, Line_width, Draw_Fill);
+    return Scene_EndNode(Scene);
+}
+
+/******************************************************************************
+function: Set a node to a bitmap
+parameter:
+    Pixels : Height rows of Width pixels, each row starting on a byte
+    Bpp    : bits per source pixel
+******************************************************************************/
+int Scene_SetBitmap(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, UWORD Width, UWORD Height,
+                    const UBYTE *Pixels, UBYTE Bpp)
+{
+    UDOUBLE Row_Bytes = ((UDOUBLE)Width * Bpp + 7) / 8;
+    int Ret = Scene_BeginNode(Scene, Id);
+    if (Ret != 0)
+        return Ret;
+    for (UWORD y = 0; y < Height; y++)
+        Paint_Ctx_BlitRow(Scene->Ctx, Xstart, Ystart + y, Pixels + y * Row_Bytes, Width, Bpp);
+    return Scene_EndNode(Scene);
+}
+
+/******************************************************************************
+function: Set a node to a BMP file
+parameter:
+******************************************************************************/
+int Scene_SetBMP(SCENE *Scene, UDOUBLE Id, UWORD Xstart, UWORD Ystart, const char *Path)
+{
+    PAINT_BATCH *Paint_Batch;
+    int Ret = Scene_BeginNode(Scene, Id);
+    if (Ret != 0)
+        return Ret;
+
+    //GUI_ReadBmp() draws its rows into Paint, whichever context the scene uses
+    Paint_Batch = Paint.Batch;
+    Paint.Batch = &Scene->Scratch;
+    Ret = GUI_ReadBmp(Path, Xstart, Ystart);
+    Paint.Batch = Paint_Batch;
+    if (Ret != 0) {
+        Debug("Scene_SetBMP: cannot read %s\r\n", Path);
+        Scene_FinishNode(Scene, false);
+        return SCENE_ERR_FILE;
+    }
+    return Scene_EndNode(Scene);
+}
+
+/******************************************************************************
+function: Remove a node at the next commit
+parameter:
+******************************************************************************/
+int Scene_Remove(SCENE *Scene, UDOUBLE Id)
+{
+    long Index = Scene_Find(Scene, Id);
+
+    if (Index < 0 || !Scene->Nodes[Index].Present)
+        return SCENE_ERR_MISSING;
+    if (Scene->Open >= 0)
+        return SCENE_ERR_BUSY;
+    Scene->Nodes[Index].Present = false;
+    Scene->Nodes[Index].Changed = true;
+    return 0;
+}
+
+/******************************************************************************
+function: Redraw the whole scene at the next commit
+parameter:
+******************************************************************************/
+void Scene_Invalidate(SCENE *Scene)
+{
+    Scene->Redraw_All = true;
+}
+
+/******************************************************************************
+function: Check whether two areas of image memory overlap
+parameter:
+******************************************************************************/
+static bool Scene_Overlap(const PAINT_RECT *A, const PAINT_RECT *B)
+{
+    return A->X < B->X + B->W && B->X < A->X + A->W &&
+           A->Y < B->Y + B->H && B->Y < A->Y + A->H;
+}
+
+/******************************************************************************
+function: Redraw the areas that changed since the last commit
+parameter:
+    Rects : receives the redrawn areas, or NULL
+    Max   : size of Rects
+******************************************************************************/
+int Scene_Commit(SCENE *Scene, PAINT_RECT *Rects, UWORD Max)
+{
+    Paint_Ctx *Ctx = Scene->Ctx;
+    Paint_Ctx Dirty;
+    PAINT_RECT Regions[PAINT_DAMAGE_MAX], Clip = Ctx->Clip;
+    UDOUBLE Kept = 0;
+    UWORD Count;
+
+    if (Scene->Open >= 0)
+        return SCENE_ERR_BUSY;
+    if (Ctx == &Paint)
+        Paint.IsColor = isColor;
+
+    //The changed areas are merged like damage, in a copy of the context
+    Dirty = *Ctx;
+    Dirty.Glyphs = NULL;
+    Dirty.Batch = NULL;
+    memset(&Dirty.Damage, 0, sizeof(Dirty.Damage));
+    if (Scene->Redraw_All)
+        Paint_Ctx_AddDamageRect(&Dirty, &Clip);
+
+    //A changed node dirties where it was and where it is now
+    for (UDOUBLE i = 0; i < Scene->Count; i++) {
+        SCENE_NODE *Node = &Scene->Nodes[i];
+
+        if (Node->Changed || Scene->Redraw_All) {
+            if (Node->Was_Drawn)
+                Paint_Ctx_AddDamageRect(&Dirty, &Node->Drawn);
+            Node->Was_Drawn = Node->Present && Paint_Ctx_BatchBounds(Ctx, &Node->Calls, &Node->Drawn);
+            if (Node->Was_Drawn)
+                Paint_Ctx_AddDamageRect(&Dirty, &Node->Drawn);
+            Node->Changed = false;
+        }
+        if (!Node->Present) {
+            Paint_Batch_Release(&Node->Calls);
+            continue;
+        }
+        Scene->Nodes[Kept++] = *Node;
+    }
+    Scene->Count = Kept;
+    Scene->Redraw_All = false;
+
+    //Each area is drawn afresh: background, then the nodes reaching into it
+    Count = Paint_Ctx_GetDamage(&Dirty, Regions, PAINT_DAMAGE_MAX, 1);
+    for (UWORD i = 0; i < Count; i++) {
+        Ctx->Clip = Regions[i];
+        Paint_Ctx_Clear(Ctx, Scene->Background);
+        for (UDOUBLE j = 0; j < Scene->Count; j++) {
+            if (Scene->Nodes[j].Was_Drawn && Scene_Overlap(&Scene->Nodes[j].Drawn, &Regions[i]))
+                Paint_Ctx_Replay(Ctx, &Scene->Nodes[j].Calls);
+        }
+        if (Rects != NULL && i < Max)
+            Rects[i] = Regions[i];
+    }
+    Ctx->Clip = Clip;
+    return Count;
+}
@@ -10,6 +10,12 @@
  * @date 2019-09-17
  */
 #include "EPD_IT8951.h"
+#include "EPD_IT8951_AsyncTx.h"
+#include "EPD_IT8951_Diff.h"
+#include "EPD_IT8951_Waveform.h"
+#include "EPD_IT8951_Depth.h"
+#include "EPD_IT8951_Pack.h"
+#include <string.h>
 #include <time.h>
 #include <stdlib.h> // Added for getenv
 #include <stdio.h> // Added for printf and fflush
@@ -20,7 +26,7 @@ extern UBYTE isColor;
 // Global variable for 4-byte alignment (default to false)
 bool Four_Byte_Align = false;
 
-//basic mode definition
+//basic mode definition, kept for older code; EPD_IT8951_GetModeTable() has them all
 UBYTE INIT_Mode = 0;
 UBYTE GC16_Mode = 2;
 //A2_Mode's value is not fixed, is decide by firmware's LUT 
@@ -28,6 +34,115 @@ UBYTE A2_Mode = 6;
 
 static int write_data_call_count = 0;
 
+//Pixel words are staged here, byte-swapped into wire order, before a bulk SPI write
+#define EPD_SPI_STAGING_BYTES 65536
+static UBYTE Spi_Staging_Buf[EPD_SPI_STAGING_BYTES];
+
+//Driver counters; the async transmit fields live in EPD_IT8951_AsyncTx.c
+static EPD_IT8951_Stats Epd_Stats;
+
+//HRDY wait timeout and the sticky error set when it expires
+static UDOUBLE Busy_Timeout_ms = EPD_IT8951_BUSY_TIMEOUT_MS;
+static int Epd_Error = 0;
+
+//Start of the refresh most recently kicked off by a display command, and the
+//learned duration of each waveform mode (INIT, DU, GC16, GL16, GLR16, GLD16, A2, DU4)
+static uint64_t Refresh_Start_us = 0;
+static UWORD Refresh_Mode = 0;
+static bool Refresh_Pending = false;
+static UDOUBLE Refresh_Estimate_ms[EPD_IT8951_MODE_SLOTS] = { 2000, 260, 450, 450, 450, 450, 120, 290, 450 };
+
+//Host-side copy of the registers only this driver writes, so redundant
+//writes and the read half of read-modify-writes never reach the bus
+typedef struct {
+    UWORD Address;
+    UWORD Value;
+    bool  Valid;
+} EPD_IT8951_Shadow_Reg;
+
+static EPD_IT8951_Shadow_Reg Shadow_Regs[] = {
+    { UP1SR+2, 0, false },
+    { BGVR,    0, false },
+    { LISAR,   0, false },
+    { LISAR+2, 0, false },
+    { I80CPCR, 0, false },
+};
+static UWORD Shadow_VCOM = 0;
+static bool Shadow_VCOM_Valid = false;
+
+//Rotation applied by the controller while loading pixels, and the panel
+//the rotated areas are mapped onto
+static UWORD Load_Rotate = IT8951_ROTATE_0;
+static UWORD Rotate_Panel_W = 0;
+static UWORD Rotate_Panel_H = 0;
+
+//Host-side copy of the frame last uploaded by a *bp_Refresh, so the next one
+//with the same area only sends the tiles that changed
+typedef struct {
+    bool    Enabled;
+    bool    Valid;
+    UBYTE   *Buf;
+    UDOUBLE Size;
+    UDOUBLE Addr;
+    UWORD   X, Y, W, H;
+    UBYTE   Bits_Per_Pixel;
+    UWORD   Rotate;
+} EPD_IT8951_Frame_Shadow;
+
+static EPD_IT8951_Frame_Shadow Frame_Shadow = { false, false, NULL, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+//Let the *bp_Refresh functions pick their waveform from the pixels instead of GC16
+static bool Auto_Waveform = false;
+
+//Send frames with few grays at 1 or 2bpp
+static bool Adaptive_Depth = false;
+
+//Depth 8bpp frames are packed to before they are sent; 8 sends them as they are
+static UBYTE Upload_Depth = 8;
+
+//Dithering applied while packing to Upload_Depth
+static DITHER_MODE Upload_Dither = DITHER_NONE;
+
+/******************************************************************************
+function :	Monotonic time in microseconds
+parameter:
+******************************************************************************/
+static uint64_t EPD_IT8951_NowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/******************************************************************************
+function :	Find the shadow entry of a driver-owned register
+parameter:  Reg_Address
+******************************************************************************/
+static EPD_IT8951_Shadow_Reg *EPD_IT8951_ShadowLookup(UWORD Reg_Address)
+{
+    for(UWORD i = 0; i < sizeof(Shadow_Regs)/sizeof(Shadow_Regs[0]); i++)
+    {
+        if(Shadow_Regs[i].Address == Reg_Address)
+            return &Shadow_Regs[i];
+    }
+    return NULL;
+}
+
+
+/******************************************************************************
+function :	Forget every shadowed register value
+parameter:  
+Info:
+    Called on reset, when the controller's registers go back to defaults.
+******************************************************************************/
+static void EPD_IT8951_ShadowInvalidate(void)
+{
+    for(UWORD i = 0; i < sizeof(Shadow_Regs)/sizeof(Shadow_Regs[0]); i++)
+        Shadow_Regs[i].Valid = false;
+    Shadow_VCOM_Valid = false;
+}
+
+
 /******************************************************************************
 function :	Software reset
 parameter:
@@ -35,6 +150,7 @@ parameter:
 static void EPD_IT8951_Reset(void)
 {
     EPD_LOG_INFO("Starting hardware reset sequence");
+    EPD_IT8951_ShadowInvalidate();
     EPD_LOG_DEBUG("Setting RST_PIN HIGH");
     DEV_Digital_Write(EPD_RST_PIN, HIGH);
     EPD_LOG_DEBUG("Delaying 200ms");
@@ -54,17 +170,45 @@ static void EPD_IT8951_Reset(void)
 /******************************************************************************
 function :	Wait until the busy_pin goes HIGH
 parameter:
+Info:
+    HRDY is usually back within a few reads, so spin for a short, bounded
+    number of reads first and only then block on the platform's edge wait.
+    On timeout the error is made sticky: every later ReadBusy fails at once
+    so a dead controller costs one timeout, not one per word.
+    Return 0 idle, -1 timeout
 ******************************************************************************/
-static void EPD_IT8951_ReadBusy(void)
+static int EPD_IT8951_ReadBusy(void)
 {
-    EPD_LOG_TRACE("ReadBusy: Checking BUSY pin");
-    UBYTE Busy_State = DEV_Digital_Read(EPD_BUSY_PIN);
-    EPD_LOG_TRACE("ReadBusy: Initial state = %d", Busy_State);
+    if(Epd_Error != 0)
+        return -1;
+
     //0: busy, 1: idle
-    while(Busy_State == 0) {
-        Busy_State = DEV_Digital_Read(EPD_BUSY_PIN);
+    for(UDOUBLE Spin = 1; Spin <= EPD_IT8951_BUSY_SPIN_LIMIT; Spin++)
+    {
+        if(DEV_Digital_Read(EPD_BUSY_PIN) != 0)
+        {
+            Epd_Stats.Busy_Spin_Iterations += Spin;
+            Epd_Stats.Busy_Spin_Hits++;
+            return 0;
+        }
+    }
+    Epd_Stats.Busy_Spin_Iterations += EPD_IT8951_BUSY_SPIN_LIMIT;
+
+    EPD_LOG_TRACE("ReadBusy: still busy after %d reads, blocking", EPD_IT8951_BUSY_SPIN_LIMIT);
+    Epd_Stats.Busy_Blocking_Waits++;
+    uint64_t Start = EPD_IT8951_NowUs();
+    int Ret = DEV_Digital_WaitLevel(EPD_BUSY_PIN, HIGH, Busy_Timeout_ms * 1000);
+    Epd_Stats.Busy_Wait_us += EPD_IT8951_NowUs() - Start;
+
+    if(Ret != 0)
+    {
+        Epd_Stats.Busy_Timeouts++;
+        Epd_Error = EPD_IT8951_ERR_BUSY_TIMEOUT;
+        EPD_LOG_ERROR("ReadBusy: controller still busy after %u ms, aborting transfers", Busy_Timeout_ms);
+        return -1;
     }
     EPD_LOG_TRACE("ReadBusy: Released");
+    return 0;
 }
 
 
@@ -77,7 +221,8 @@ static void EPD_IT8951_WriteCommand(UWORD Command)
     //Set Preamble for Write Command
     UWORD Write_Preamble = 0x6000;
     
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+        return;
 
     DEV_Digital_Write(EPD_CS_PIN, LOW);
 
@@ -85,7 +230,11 @@ static void EPD_IT8951_WriteCommand(UWORD Command)
     DEV_SPI_WriteByte(Write_Preamble>>8);
     DEV_SPI_WriteByte(Write_Preamble);
     
-    EPD_IT8951_ReadBusy();    
+    if(EPD_IT8951_ReadBusy() != 0)
+    {
+        DEV_Digital_Write(EPD_CS_PIN, HIGH);
+        return;
+    }
     
     DEV_SPI_WriteByte(Command>>8);
     DEV_SPI_WriteByte(Command);
@@ -105,7 +254,8 @@ static void EPD_IT8951_WriteData(UWORD Data)
     if (write_data_call_count == 0) {
         EPD_LOG_TRACE("WriteData (first call): before ReadBusy 1");
     }
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+        return;
 
     if (write_data_call_count == 0) {
         EPD_LOG_TRACE("WriteData (first call): before CS LOW");
@@ -121,7 +271,11 @@ static void EPD_IT8951_WriteData(UWORD Data)
     if (write_data_call_count == 0) {
         EPD_LOG_TRACE("WriteData (first call): before ReadBusy 2");
     }
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+    {
+        DEV_Digital_Write(EPD_CS_PIN, HIGH);
+        return;
+    }
 
     if (write_data_call_count == 0) {
         EPD_LOG_TRACE("WriteData (first call): before data bytes");
@@ -150,19 +304,96 @@ static void EPD_IT8951_WriteMuitiData(UWORD* Data_Buf, UDOUBLE Length)
     //Set Preamble for Write Command
 	UWORD Write_Preamble = 0x0000;
 
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+        return;
 
     DEV_Digital_Write(EPD_CS_PIN, LOW);
 
 	DEV_SPI_WriteByte(Write_Preamble>>8);
 	DEV_SPI_WriteByte(Write_Preamble);
 
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+    {
+        DEV_Digital_Write(EPD_CS_PIN, HIGH);
+        return;
+    }
 
-    for(UDOUBLE i = 0; i<Length; i++)
+    //With the transmit worker running, the next chunk is packed while the
+    //previous one is on the wire
+    if(EPD_IT8951_AsyncTx_Running())
+    {
+        EPD_IT8951_AsyncTx_WriteWords(Data_Buf, Length);
+        DEV_Digital_Write(EPD_CS_PIN, HIGH);
+        return;
+    }
+
+    //The IT8951 expects every word MSB first, so swap into the staging buffer
+    //and hand whole chunks to the backend instead of one byte at a time
+    while(Length > 0)
+    {
+        UDOUBLE Words = Length;
+        if(Words > EPD_SPI_STAGING_BYTES/2)
+            Words = EPD_SPI_STAGING_BYTES/2;
+
+        for(UDOUBLE i = 0; i<Words; i++)
+        {
+            Spi_Staging_Buf[2*i]   = Data_Buf[i]>>8;
+            Spi_Staging_Buf[2*i+1] = Data_Buf[i];
+        }
+        DEV_SPI_WriteBuffer(Spi_Staging_Buf, Words*2);
+
+        Data_Buf += Words;
+        Length -= Words;
+    }
+    DEV_Digital_Write(EPD_CS_PIN, HIGH);
+}
+
+
+
+/******************************************************************************
+function :	write one word many times
+parameter:
+    Data   : word to repeat
+    Length : number of words
+Info:
+    The pattern is swapped into the staging buffer once and that buffer is
+    sent as often as needed, so a fill costs no host memory traffic.
+******************************************************************************/
+static void EPD_IT8951_WriteConstantData(UWORD Data, UDOUBLE Length)
+{
+    UWORD Write_Preamble = 0x0000;
+    UDOUBLE Pattern_Words = Length;
+
+    if(EPD_IT8951_ReadBusy() != 0)
+        return;
+
+    DEV_Digital_Write(EPD_CS_PIN, LOW);
+
+    DEV_SPI_WriteByte(Write_Preamble>>8);
+    DEV_SPI_WriteByte(Write_Preamble);
+
+    if(EPD_IT8951_ReadBusy() != 0)
     {
-	    DEV_SPI_WriteByte(Data_Buf[i]>>8);
-	    DEV_SPI_WriteByte(Data_Buf[i]);
+        DEV_Digital_Write(EPD_CS_PIN, HIGH);
+        return;
+    }
+
+    if(Pattern_Words > EPD_SPI_STAGING_BYTES/2)
+        Pattern_Words = EPD_SPI_STAGING_BYTES/2;
+    for(UDOUBLE i = 0; i<Pattern_Words; i++)
+    {
+        Spi_Staging_Buf[2*i]   = Data>>8;
+        Spi_Staging_Buf[2*i+1] = Data;
+    }
+
+    Epd_Stats.Fill_Words += Length;
+    while(Length > 0)
+    {
+        UDOUBLE Words = Length;
+        if(Words > Pattern_Words)
+            Words = Pattern_Words;
+        DEV_SPI_WriteBuffer(Spi_Staging_Buf, Words*2);
+        Length -= Words;
     }
     DEV_Digital_Write(EPD_CS_PIN, HIGH);
 }
@@ -179,20 +410,29 @@ static UWORD EPD_IT8951_ReadData()
 	UWORD Write_Preamble = 0x1000;
     UWORD Read_Dummy;
 
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+        return 0;
 
     DEV_Digital_Write(EPD_CS_PIN, LOW);
 
 	DEV_SPI_WriteByte(Write_Preamble>>8);
 	DEV_SPI_WriteByte(Write_Preamble);
 
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+    {
+        DEV_Digital_Write(EPD_CS_PIN, HIGH);
+        return 0;
+    }
 
     //dummy
     Read_Dummy = DEV_SPI_ReadByte()<<8;
     Read_Dummy |= DEV_SPI_ReadByte();
 
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+    {
+        DEV_Digital_Write(EPD_CS_PIN, HIGH);
+        return 0;
+    }
 
     ReadData = DEV_SPI_ReadByte()<<8;
     ReadData |= DEV_SPI_ReadByte();
@@ -214,25 +454,42 @@ static void EPD_IT8951_ReadMultiData(UWORD* Data_Buf, UDOUBLE Length)
 	UWORD Write_Preamble = 0x1000;
     UWORD Read_Dummy;
 
-    EPD_IT8951_ReadBusy();
+    //Callers parse the buffer, so leave it zeroed rather than stale on failure
+    if(EPD_IT8951_ReadBusy() != 0)
+    {
+        memset(Data_Buf, 0, Length*2);
+        return;
+    }
 
     DEV_Digital_Write(EPD_CS_PIN, LOW);
 
 	DEV_SPI_WriteByte(Write_Preamble>>8);
 	DEV_SPI_WriteByte(Write_Preamble);
 
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+    {
+        DEV_Digital_Write(EPD_CS_PIN, HIGH);
+        memset(Data_Buf, 0, Length*2);
+        return;
+    }
 
     //dummy
     Read_Dummy = DEV_SPI_ReadByte()<<8;
     Read_Dummy |= DEV_SPI_ReadByte();
 
-    EPD_IT8951_ReadBusy();
+    if(EPD_IT8951_ReadBusy() != 0)
+    {
+        DEV_Digital_Write(EPD_CS_PIN, HIGH);
+        memset(Data_Buf, 0, Length*2);
+        return;
+    }
 
+    //Read the whole block in one go, then turn the MSB-first words into host order
+    DEV_SPI_ReadBuffer((UBYTE*)Data_Buf, Length*2);
     for(UDOUBLE i = 0; i<Length; i++)
     {
-	    Data_Buf[i] = DEV_SPI_ReadByte()<<8;
-	    Data_Buf[i] |= DEV_SPI_ReadByte();
+        UBYTE* Bytes = (UBYTE*)&Data_Buf[i];
+        Data_Buf[i] = (Bytes[0]<<8) | Bytes[1];
     }
 
     DEV_Digital_Write(EPD_CS_PIN, HIGH);
@@ -268,14 +525,30 @@ static void EPD_IT8951_WriteMultiArg(UWORD Arg_Cmd, UWORD* Arg_Buf, UWORD Arg_Nu
 /******************************************************************************
 function :	Cmd4 ReadReg
 parameter:  
+Info:
+    Registers the driver owns are answered from the shadow once known.
 ******************************************************************************/
 static UWORD EPD_IT8951_ReadReg(UWORD Reg_Address)
 {
     UWORD Reg_Value;
+    EPD_IT8951_Shadow_Reg *Shadow = EPD_IT8951_ShadowLookup(Reg_Address);
+
+    if(Shadow != NULL && Shadow->Valid)
+    {
+        Epd_Stats.Reg_Reads_Elided++;
+        return Shadow->Value;
+    }
+
     EPD_IT8951_WriteCommand(IT8951_TCON_REG_RD);
     EPD_IT8951_WriteData(Reg_Address);
     Reg_Value =  EPD_IT8951_ReadData();
     EPD_LOG_TRACE("ReadReg(0x%04X) = 0x%04X", Reg_Address, Reg_Value);
+
+    if(Shadow != NULL && Epd_Error == 0)
+    {
+        Shadow->Value = Reg_Value;
+        Shadow->Valid = true;
+    }
     return Reg_Value;
 }
 
@@ -284,12 +557,29 @@ static UWORD EPD_IT8951_ReadReg(UWORD Reg_Address)
 /******************************************************************************
 function :	Cmd5 WriteReg
 parameter:  
+Info:
+    Write-through: a driver-owned register already holding Reg_Value is
+    not written again.
 ******************************************************************************/
 static void EPD_IT8951_WriteReg(UWORD Reg_Address,UWORD Reg_Value)
 {
+    EPD_IT8951_Shadow_Reg *Shadow = EPD_IT8951_ShadowLookup(Reg_Address);
+
+    if(Shadow != NULL && Shadow->Valid && Shadow->Value == Reg_Value)
+    {
+        Epd_Stats.Reg_Writes_Elided++;
+        return;
+    }
+
     EPD_IT8951_WriteCommand(IT8951_TCON_REG_WR);
     EPD_IT8951_WriteData(Reg_Address);
     EPD_IT8951_WriteData(Reg_Value);
+
+    if(Shadow != NULL)
+    {
+        Shadow->Value = Reg_Value;
+        Shadow->Valid = (Epd_Error == 0);
+    }
 }
 
 
@@ -301,9 +591,19 @@ parameter:
 static UWORD EPD_IT8951_GetVCOM(void)
 {
     UWORD VCOM;
+
+    if(Shadow_VCOM_Valid)
+    {
+        Epd_Stats.Reg_Reads_Elided++;
+        return Shadow_VCOM;
+    }
+
     EPD_IT8951_WriteCommand(USDEF_I80_CMD_VCOM);
     EPD_IT8951_WriteData(0x0000);
     VCOM =  EPD_IT8951_ReadData();
+
+    Shadow_VCOM = VCOM;
+    Shadow_VCOM_Valid = (Epd_Error == 0);
     return VCOM;
 }
 
@@ -315,9 +615,18 @@ parameter:
 ******************************************************************************/
 static void EPD_IT8951_SetVCOM(UWORD VCOM)
 {
+    if(Shadow_VCOM_Valid && Shadow_VCOM == VCOM)
+    {
+        Epd_Stats.Reg_Writes_Elided++;
+        return;
+    }
+
     EPD_IT8951_WriteCommand(USDEF_I80_CMD_VCOM);
     EPD_IT8951_WriteData(0x0001);
     EPD_IT8951_WriteData(VCOM);
+
+    Shadow_VCOM = VCOM;
+    Shadow_VCOM_Valid = (Epd_Error == 0);
 }
 
 
@@ -414,33 +723,136 @@ static void EPD_IT8951_SetTargetMemoryAddr(UDOUBLE Target_Memory_Addr)
 
 
 /******************************************************************************
-function :	EPD_IT8951_WaitForDisplayReady
-parameter:  
+function :	Refresh duration estimate slot for a waveform mode
+parameter:  Mode
 ******************************************************************************/
-static void EPD_IT8951_WaitForDisplayReady(void)
+static UDOUBLE *EPD_IT8951_RefreshEstimate(UWORD Mode)
+{
+    return &Refresh_Estimate_ms[(Mode < EPD_IT8951_MODE_SLOTS) ? Mode : EPD_IT8951_MODE_SLOTS - 1];
+}
+
+
+/******************************************************************************
+function :	Remember that a display command just started a refresh
+parameter:  Mode
+******************************************************************************/
+static void EPD_IT8951_MarkRefreshStart(UWORD Mode)
 {
+    Refresh_Start_us = EPD_IT8951_NowUs();
+    Refresh_Mode = Mode;
+    Refresh_Pending = true;
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_WaitForRefresh
+parameter:  Latency_us : receives the time from the display command to LUTAFSR
+                         reading idle, or 0 if no refresh was pending
+Info:
+    Polling LUTAFSR costs a full register read (two commands and a read,
+    each with HRDY waits), so instead of polling every millisecond we sleep
+    for most of the refresh this mode is expected to take, then poll with
+    exponential backoff. The per-mode estimate follows the measured latency
+    (EWMA); if the first poll after sleeping already reads idle we slept
+    too long and the estimate is shortened instead. A caller that comes back
+    after the sleep would have ended and finds the panel idle learns nothing
+    about how long the refresh took, so neither the estimate nor the latency
+    is updated.
+    Return 0 ready, -1 timeout, -2 transfers aborted by a HRDY timeout
+******************************************************************************/
+int EPD_IT8951_WaitForRefresh(UDOUBLE *Latency_us)
+{
+    uint64_t Start = Refresh_Pending ? Refresh_Start_us : EPD_IT8951_NowUs();
+    UDOUBLE *Estimate_ms = EPD_IT8951_RefreshEstimate(Refresh_Mode);
+    UDOUBLE Backoff_ms = 1;
+    UDOUBLE Busy_Polls = 0;
+    uint64_t Elapsed_us;
+    bool Slept = false;
+
+    if(Latency_us != NULL)
+        *Latency_us = 0;
+
+    if(Refresh_Pending)
+    {
+        uint64_t Sleep_us = (uint64_t)*Estimate_ms * 10 * EPD_IT8951_READY_SLEEP_PCT;
+        Elapsed_us = EPD_IT8951_NowUs() - Start;
+        if(Elapsed_us < Sleep_us)
+        {
+            Slept = true;
+            EPD_LOG_DEBUG("Refresh (mode %d) expected to take %u ms, sleeping %llu ms", Refresh_Mode, *Estimate_ms, (unsigned long long)(Sleep_us - Elapsed_us) / 1000);
+            DEV_Delay_ms((Sleep_us - Elapsed_us) / 1000);
+        }
+    }
+
     //Check IT8951 Register LUTAFSR => NonZero Busy, Zero - Free
-    EPD_LOG_DEBUG("Waiting for display to become ready...");
-    int timeout = 0;
-    const int max_timeout = 10000; // 10 second timeout
-    
-    while( EPD_IT8951_ReadReg(LUTAFSR) )
+    for(;;)
     {
-        //wait in idle state
-        timeout++;
-        if (timeout > max_timeout) {
-            EPD_LOG_ERROR("Display ready timeout - LUTAFSR register stuck at non-zero value");
-            break;
+        Epd_Stats.Ready_Polls++;
+        UWORD Lut_Busy = EPD_IT8951_ReadReg(LUTAFSR);
+        if(Epd_Error != 0)
+        {
+            Refresh_Pending = false;
+            return -2;
         }
-        if (timeout % 1000 == 0) {
-            EPD_LOG_WARN("Display still busy after %d ms", timeout);
+        if(Lut_Busy == 0)
+            break;
+
+        Busy_Polls++;
+        Elapsed_us = EPD_IT8951_NowUs() - Start;
+        if(Elapsed_us > (uint64_t)EPD_IT8951_READY_TIMEOUT_MS * 1000)
+        {
+            EPD_LOG_ERROR("Display ready timeout - LUTAFSR register stuck at non-zero value");
+            Refresh_Pending = false;
+            return -1;
         }
-        usleep(1000); // Sleep 1ms to avoid busy-waiting
+        DEV_Delay_ms(Backoff_ms);
+        if(Backoff_ms < EPD_IT8951_READY_BACKOFF_MAX_MS)
+            Backoff_ms *= 2;
     }
-    
-    if (timeout <= max_timeout) {
-        EPD_LOG_DEBUG("Display became ready after %d ms", timeout);
+
+    Elapsed_us = EPD_IT8951_NowUs() - Start;
+    if(Refresh_Pending && !Slept && Busy_Polls == 0)
+    {
+        EPD_LOG_DEBUG("Refresh (mode %d) was done before the wait, %llu us after the command", Refresh_Mode, (unsigned long long)Elapsed_us);
+        Refresh_Pending = false;
+    }
+    else if(Refresh_Pending)
+    {
+        UDOUBLE Measured_ms = Elapsed_us / 1000;
+        if(Busy_Polls == 0)
+            *Estimate_ms -= *Estimate_ms / 8;
+        else
+            *Estimate_ms = (*Estimate_ms * 7 + Measured_ms) / 8;
+
+        Epd_Stats.Ready_Waits++;
+        Epd_Stats.Ready_Last_Latency_us = Elapsed_us;
+        Refresh_Pending = false;
+        if(Latency_us != NULL)
+            *Latency_us = Elapsed_us;
+        EPD_LOG_DEBUG("Refresh (mode %d) done after %llu us, %u busy polls, next estimate %u ms", Refresh_Mode, (unsigned long long)Elapsed_us, Busy_Polls, *Estimate_ms);
     }
+    return 0;
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_GetRefreshEstimate
+parameter:  Mode
+******************************************************************************/
+UDOUBLE EPD_IT8951_GetRefreshEstimate(UWORD Mode)
+{
+    return *EPD_IT8951_RefreshEstimate(Mode);
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_WaitForDisplayReady
+parameter:  
+******************************************************************************/
+static void EPD_IT8951_WaitForDisplayReady(void)
+{
+    EPD_LOG_DEBUG("Waiting for display to become ready...");
+    EPD_IT8951_WaitForRefresh(NULL);
 }
 
 
@@ -454,7 +866,7 @@ parameter:
 static void EPD_IT8951_HostAreaPackedPixelWrite_1bp(IT8951_Load_Img_Info*Load_Img_Info,IT8951_Area_Img_Info*Area_Img_Info, bool Packed_Write)
 {
     UWORD Source_Buffer_Width, Source_Buffer_Height;
-    UWORD Source_Buffer_Length;
+    UDOUBLE Source_Buffer_Length;
 
     UWORD* Source_Buffer = (UWORD*)Load_Img_Info->Source_Buffer_Addr;
     EPD_IT8951_SetTargetMemoryAddr(Load_Img_Info->Target_Memory_Addr);
@@ -496,7 +908,7 @@ parameter:
 static void EPD_IT8951_HostAreaPackedPixelWrite_2bp(IT8951_Load_Img_Info*Load_Img_Info, IT8951_Area_Img_Info*Area_Img_Info, bool Packed_Write)
 {
     UWORD Source_Buffer_Width, Source_Buffer_Height;
-    UWORD Source_Buffer_Length;
+    UDOUBLE Source_Buffer_Length;
 
     UWORD* Source_Buffer = (UWORD*)Load_Img_Info->Source_Buffer_Addr;
     EPD_IT8951_SetTargetMemoryAddr(Load_Img_Info->Target_Memory_Addr);
@@ -539,7 +951,7 @@ static void EPD_IT8951_HostAreaPackedPixelWrite_4bp(IT8951_Load_Img_Info*Load_Im
     EPD_LOG_DEBUG("[HostAreaPackedPixelWrite_4bp] Entry: Target_Memory_Addr=0x%llX, Area=(%u,%u,%u,%u)", (unsigned long long)Load_Img_Info->Target_Memory_Addr, Area_Img_Info->Area_X, Area_Img_Info->Area_Y, Area_Img_Info->Area_W, Area_Img_Info->Area_H);
     
     UWORD Source_Buffer_Width, Source_Buffer_Height;
-    UWORD Source_Buffer_Length;
+    UDOUBLE Source_Buffer_Length;
 	
     UWORD* Source_Buffer = (UWORD*)Load_Img_Info->Source_Buffer_Addr;
     EPD_LOG_DEBUG("Setting target memory address");
@@ -648,6 +1060,7 @@ static void EPD_IT8951_Display_Area(UWORD X,UWORD Y,UWORD W,UWORD H,UWORD Mode)
     //0x0034
     EPD_LOG_DEBUG("Sending DPY_AREA command");
     EPD_IT8951_WriteMultiArg(USDEF_I80_CMD_DPY_AREA, Args,5);
+    EPD_IT8951_MarkRefreshStart(Mode);
     EPD_LOG_DEBUG("DPY_AREA command sent");
 }
 
@@ -670,6 +1083,7 @@ static void EPD_IT8951_Display_AreaBuf(UWORD X,UWORD Y,UWORD W,UWORD H,UWORD Mod
     Args[6] = (UWORD)(Target_Memory_Addr>>16);
     //0x0037
     EPD_IT8951_WriteMultiArg(USDEF_I80_CMD_DPY_BUF_AREA, Args,7); 
+    EPD_IT8951_MarkRefreshStart(Mode);
     EPD_LOG_DEBUG("[Display_AreaBuf] Exit");
 }
 
@@ -757,9 +1171,25 @@ parameter:
 ******************************************************************************/
 IT8951_Dev_Info EPD_IT8951_Init(UWORD VCOM)
 {
-    EPD_LOG_INFO("Starting initialization with VCOM=%d", VCOM);
+    return EPD_IT8951_InitEx(VCOM, 0);
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_InitEx
+parameter:  VCOM, Flags (EPD_IT8951_INIT_*)
+******************************************************************************/
+IT8951_Dev_Info EPD_IT8951_InitEx(UWORD VCOM, UDOUBLE Flags)
+{
+    EPD_LOG_INFO("Starting initialization with VCOM=%d, flags=0x%X", VCOM, Flags);
     IT8951_Dev_Info Dev_Info;
 
+    //A reset gives a wedged controller a fresh start
+    EPD_IT8951_ClearError();
+    Refresh_Pending = false;
+    Load_Rotate = IT8951_ROTATE_0;
+    Frame_Shadow.Valid = false;
+
     EPD_LOG_DEBUG("Calling EPD_IT8951_Reset()");
     EPD_IT8951_Reset();
     EPD_LOG_DEBUG("Reset completed");
@@ -771,6 +1201,7 @@ IT8951_Dev_Info EPD_IT8951_Init(UWORD VCOM)
     EPD_LOG_DEBUG("Calling EPD_IT8951_GetSystemInfo()");
     EPD_IT8951_GetSystemInfo(&Dev_Info);
     EPD_LOG_INFO("Got system info - Panel: %dx%d", Dev_Info.Panel_W, Dev_Info.Panel_H);
+    EPD_IT8951_Waveform_SelectTable(&Dev_Info);
     
     EPD_LOG_DEBUG("Enabling pack write");
     EPD_IT8951_WriteReg(I80CPCR,0x0001);
@@ -784,6 +1215,8 @@ IT8951_Dev_Info EPD_IT8951_Init(UWORD VCOM)
     {
         EPD_LOG_INFO("Setting VCOM to %d", VCOM);
         EPD_IT8951_SetVCOM(VCOM);
+        //Read back from the controller, not the shadow, to confirm the write
+        Shadow_VCOM_Valid = false;
         UWORD new_vcom = EPD_IT8951_GetVCOM();
         EPD_LOG_INFO("VCOM set to %d", new_vcom);
     }
@@ -791,6 +1224,16 @@ IT8951_Dev_Info EPD_IT8951_Init(UWORD VCOM)
     {
         EPD_LOG_DEBUG("VCOM already set correctly");
     }
+
+    if(Flags & EPD_IT8951_INIT_ASYNC_TX)
+    {
+        if(EPD_IT8951_AsyncTx_Start() != 0)
+            EPD_LOG_WARN("Transmit worker unavailable, using synchronous writes");
+    }
+    else
+    {
+        EPD_IT8951_AsyncTx_Stop();
+    }
     
     EPD_LOG_INFO("Initialization completed successfully");
     return Dev_Info;
@@ -798,78 +1241,650 @@ IT8951_Dev_Info EPD_IT8951_Init(UWORD VCOM)
 
 
 /******************************************************************************
-function :	EPD_IT8951_Clear_Refresh
-parameter:  
+function :	EPD_IT8951_GetStats
+parameter:  Stats
 ******************************************************************************/
-void EPD_IT8951_Clear_Refresh(IT8951_Dev_Info Dev_Info,UDOUBLE Target_Memory_Addr, UWORD Mode)
+void EPD_IT8951_GetStats(EPD_IT8951_Stats *Stats)
 {
-
-    UDOUBLE ImageSize = ((Dev_Info.Panel_W * 4 % 8 == 0)? (Dev_Info.Panel_W * 4 / 8 ): (Dev_Info.Panel_W * 4 / 8 + 1)) * Dev_Info.Panel_H;
-    UBYTE* Frame_Buf = malloc (ImageSize);
-    memset(Frame_Buf, 0xFF, ImageSize);
+    if(Stats == NULL)
+        return;
+    *Stats = Epd_Stats;
+    EPD_IT8951_AsyncTx_GetStats(Stats);
+}
 
 
-    IT8951_Load_Img_Info Load_Img_Info;
-    IT8951_Area_Img_Info Area_Img_Info;
+/******************************************************************************
+function :	EPD_IT8951_ResetStats
+parameter:  
+******************************************************************************/
+void EPD_IT8951_ResetStats(void)
+{
+    memset(&Epd_Stats, 0, sizeof(Epd_Stats));
+    EPD_IT8951_AsyncTx_ResetStats();
+}
 
-    EPD_IT8951_WaitForDisplayReady();
 
-    Load_Img_Info.Source_Buffer_Addr = Frame_Buf;
-    Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
-    Load_Img_Info.Pixel_Format = IT8951_4BPP;
-    Load_Img_Info.Rotate =  IT8951_ROTATE_0;
-    Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
+/******************************************************************************
+function :	EPD_IT8951_SetBusyTimeout
+parameter:  Timeout_ms : longest HRDY wait before transfers are aborted
+******************************************************************************/
+void EPD_IT8951_SetBusyTimeout(UDOUBLE Timeout_ms)
+{
+    Busy_Timeout_ms = Timeout_ms;
+}
 
-    Area_Img_Info.Area_X = 0;
-    Area_Img_Info.Area_Y = 0;
-    Area_Img_Info.Area_W = Dev_Info.Panel_W;
-    Area_Img_Info.Area_H = Dev_Info.Panel_H;
 
-    EPD_IT8951_HostAreaPackedPixelWrite_4bp(&Load_Img_Info, &Area_Img_Info, false);
+/******************************************************************************
+function :	EPD_IT8951_GetError
+parameter:  
+Info:
+    Return 0, or the EPD_IT8951_ERR_* code that aborted the transfers
+******************************************************************************/
+int EPD_IT8951_GetError(void)
+{
+    return Epd_Error;
+}
 
-    EPD_IT8951_Display_Area(0, 0, Dev_Info.Panel_W, Dev_Info.Panel_H, Mode);
 
-    free(Frame_Buf);
-    Frame_Buf = NULL;
+/******************************************************************************
+function :	EPD_IT8951_ClearError
+parameter:  
+******************************************************************************/
+void EPD_IT8951_ClearError(void)
+{
+    Epd_Error = 0;
 }
 
 
 /******************************************************************************
-function :	EPD_IT8951_1bp_Refresh
+function :	EPD_IT8951_SetRotate
 parameter:
+    Dev_Info : panel the rotated frames are shown on
+    Rotate   : 0, 90, 180 or 270 degrees, as for Paint_SetRotate()
 ******************************************************************************/
-void EPD_IT8951_1bp_Refresh(UBYTE* Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Mode, UDOUBLE Target_Memory_Addr, bool Packed_Write)
+int EPD_IT8951_SetRotate(IT8951_Dev_Info Dev_Info, UWORD Rotate)
 {
-    IT8951_Load_Img_Info Load_Img_Info;
-    IT8951_Area_Img_Info Area_Img_Info;
+    switch(Rotate)
+    {
+        case 0:
+            Load_Rotate = IT8951_ROTATE_0;
+            break;
+        case 90:
+            Load_Rotate = IT8951_ROTATE_90;
+            break;
+        case 180:
+            Load_Rotate = IT8951_ROTATE_180;
+            break;
+        case 270:
+            Load_Rotate = IT8951_ROTATE_270;
+            break;
+        default:
+            return -2;
+    }
+    Rotate_Panel_W = Dev_Info.Panel_W;
+    Rotate_Panel_H = Dev_Info.Panel_H;
+    return 0;
+}
 
-    EPD_IT8951_WaitForDisplayReady();
 
-    Load_Img_Info.Source_Buffer_Addr = Frame_Buf;
-    Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
-    //Use 8bpp to set 1bpp
-    Load_Img_Info.Pixel_Format = IT8951_8BPP;
-    Load_Img_Info.Rotate =  IT8951_ROTATE_0;
-    Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
+/******************************************************************************
+function :	EPD_IT8951_GetRotate
+parameter:
+******************************************************************************/
+UWORD EPD_IT8951_GetRotate(void)
+{
+    return Load_Rotate * 90;
+}
 
-    Area_Img_Info.Area_X = X/8;
-    Area_Img_Info.Area_Y = Y;
-    Area_Img_Info.Area_W = W/8;
-    Area_Img_Info.Area_H = H;
 
+/******************************************************************************
+function :	EPD_IT8951_RotateArea
+parameter:
+    X, Y, W, H : area of the rotated frame, replaced by the panel area
+Info:
+    Same mapping as Paint_SetPixel() uses for a rotated image.
+******************************************************************************/
+void EPD_IT8951_RotateArea(UWORD *X, UWORD *Y, UWORD *W, UWORD *H)
+{
+    UWORD X0 = *X, Y0 = *Y, W0 = *W, H0 = *H;
 
-    //clock_t start, finish;
-    //double duration;
+    switch(Load_Rotate)
+    {
+        case IT8951_ROTATE_90:
+            *X = Rotate_Panel_W - (Y0 + H0);
+            *Y = X0;
+            *W = H0;
+            *H = W0;
+            break;
+        case IT8951_ROTATE_180:
+            *X = Rotate_Panel_W - (X0 + W0);
+            *Y = Rotate_Panel_H - (Y0 + H0);
+            break;
+        case IT8951_ROTATE_270:
+            *X = Y0;
+            *Y = Rotate_Panel_H - (X0 + W0);
+            *W = H0;
+            *H = W0;
+            break;
+        default:
+            break;
+    }
+}
 
-    //start = clock();
 
-    EPD_IT8951_HostAreaPackedPixelWrite_1bp(&Load_Img_Info, &Area_Img_Info, Packed_Write);
+/******************************************************************************
+function :	EPD_IT8951_FrameShadowTouch
+parameter:
+    Target_Memory_Addr : image buffer about to be written
+Info:
+    Any other write into the shadowed buffer makes the shadow stale.
+******************************************************************************/
+static void EPD_IT8951_FrameShadowTouch(UDOUBLE Target_Memory_Addr)
+{
+    if(Frame_Shadow.Valid && Frame_Shadow.Addr == Target_Memory_Addr)
+        Frame_Shadow.Valid = false;
+}
 
-    //finish = clock();
-    //duration = (double)(finish - start) / CLOCKS_PER_SEC;
-	//Debug( "Write occupy %f second\n", duration );
 
-    //start = clock();
+/******************************************************************************
+function :	EPD_IT8951_HostAreaWrite
+parameter:
+    Bits_Per_Pixel : 2, 4 or 8
+******************************************************************************/
+static void EPD_IT8951_HostAreaWrite(IT8951_Load_Img_Info *Load_Img_Info, IT8951_Area_Img_Info *Area_Img_Info, UBYTE Bits_Per_Pixel, bool Packed_Write)
+{
+    switch(Bits_Per_Pixel)
+    {
+        case 2:
+            Load_Img_Info->Pixel_Format = IT8951_2BPP;
+            EPD_IT8951_HostAreaPackedPixelWrite_2bp(Load_Img_Info, Area_Img_Info, Packed_Write);
+            break;
+        case 4:
+            Load_Img_Info->Pixel_Format = IT8951_4BPP;
+            EPD_IT8951_HostAreaPackedPixelWrite_4bp(Load_Img_Info, Area_Img_Info, Packed_Write);
+            break;
+        default:
+            Load_Img_Info->Pixel_Format = IT8951_8BPP;
+            EPD_IT8951_HostAreaPackedPixelWrite_8bp(Load_Img_Info, Area_Img_Info);
+            break;
+    }
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_AutoMode
+parameter:
+    Old    : pixels the area currently shows, NULL if unknown
+    Stride : bytes per row of Old and New
+Info:
+    The fastest waveform that still shows New correctly, see
+    EPD_IT8951_Waveform_Classify().
+******************************************************************************/
+static UWORD EPD_IT8951_AutoMode(const UBYTE *Old, const UBYTE *New, UWORD W, UWORD H, UBYTE Bits_Per_Pixel, UDOUBLE Stride)
+{
+    EPD_IT8951_Wave Wave = EPD_IT8951_Waveform_Classify(Old, New, W, H, Bits_Per_Pixel, Stride);
+
+    switch(Wave)
+    {
+        case EPD_IT8951_WAVE_A2:
+            Epd_Stats.Auto_A2++;
+            break;
+        case EPD_IT8951_WAVE_GL16:
+            Epd_Stats.Auto_GL16++;
+            break;
+        case EPD_IT8951_WAVE_GC16:
+            Epd_Stats.Auto_GC16++;
+            break;
+        default:
+            Epd_Stats.Auto_DU++;
+            break;
+    }
+    EPD_LOG_DEBUG("Waveform class %d for a %ux%u area", Wave, W, H);
+    return EPD_IT8951_Waveform_Mode(Wave);
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_SetAutoWaveform
+parameter:
+    Enable : pick the *bp_Refresh waveform from the pixels
+******************************************************************************/
+void EPD_IT8951_SetAutoWaveform(bool Enable)
+{
+    Auto_Waveform = Enable;
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_Adaptive_Refresh
+parameter:
+    Bits_Per_Pixel : depth of Frame_Buf, 2, 4 or 8
+Info:
+    Sends a frame that uses two grays as 1bpp through the 8bpp trick, with
+    the grays in BGVR, and one whose grays 2bpp can hold as 2bpp. Returns
+    false, having sent nothing, when the frame has to go at its own depth.
+******************************************************************************/
+static bool EPD_IT8951_Adaptive_Refresh(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Bits_Per_Pixel,
+                                        UWORD Mode, bool Hold, UDOUBLE Target_Memory_Addr, bool Packed_Write)
+{
+    EPD_IT8951_Depth_Plan Plan;
+    IT8951_Load_Img_Info Load_Img_Info;
+    IT8951_Area_Img_Info Area_Img_Info;
+    UDOUBLE Stride = (UDOUBLE)W * Bits_Per_Pixel / 8;
+    UWORD Align = Four_Byte_Align ? 32 : 16;
+    UDOUBLE Packed_Bytes;
+    UBYTE *Packed;
+
+    if(Frame_Buf == NULL || W == 0 || H == 0 || (W * Bits_Per_Pixel) % 16 != 0)
+        return false;
+    if(EPD_IT8951_Depth_Analyze(Frame_Buf, W, H, Bits_Per_Pixel, Stride, &Plan) == Bits_Per_Pixel)
+        return false;
+
+    //The 8bpp trick sends 8 pixels per byte in whole words and cannot rotate;
+    //two grays 2bpp can hold still save half of a 4bpp upload
+    if(Plan.Bits_Per_Pixel == 1 && (Load_Rotate != IT8951_ROTATE_0 || X % Align != 0 || W % Align != 0))
+    {
+        if(Bits_Per_Pixel == 2 || Plan.Gray[0] % 0x55 != 0 || Plan.Gray[1] % 0x55 != 0)
+            return false;
+        Plan.Bits_Per_Pixel = 2;
+    }
+    if(Plan.Bits_Per_Pixel == 2 && W % 8 != 0)
+        return false;
+
+    Packed_Bytes = (UDOUBLE)W * Plan.Bits_Per_Pixel / 8 * H;
+    Packed = (UBYTE *)malloc(Packed_Bytes);
+    if(Packed == NULL)
+    {
+        EPD_LOG_WARN("Out of memory repacking a %ux%u area, sending it at %ubpp", W, H, Bits_Per_Pixel);
+        return false;
+    }
+    EPD_IT8951_Depth_Pack(Frame_Buf, W, H, Bits_Per_Pixel, Stride, &Plan, Packed);
+    EPD_LOG_DEBUG("Sending a %ux%u %ubpp area with %u grays as %ubpp", W, H, Bits_Per_Pixel, Plan.Levels, Plan.Bits_Per_Pixel);
+
+    EPD_IT8951_FrameShadowTouch(Target_Memory_Addr);
+    EPD_IT8951_WaitForDisplayReady();
+
+    Load_Img_Info.Source_Buffer_Addr = Packed;
+    Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
+    Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
+    Area_Img_Info.Area_Y = Y;
+    Area_Img_Info.Area_H = H;
+
+    if(Plan.Bits_Per_Pixel == 1)
+    {
+        //Use 8bpp to set 1bpp; bit 1 shows the back gray, bit 0 the front gray
+        Load_Img_Info.Pixel_Format = IT8951_8BPP;
+        Load_Img_Info.Rotate = IT8951_ROTATE_0;
+        Area_Img_Info.Area_X = X/8;
+        Area_Img_Info.Area_W = W/8;
+        EPD_IT8951_HostAreaPackedPixelWrite_1bp(&Load_Img_Info, &Area_Img_Info, Packed_Write);
+        free(Packed);
+
+        EPD_IT8951_Display_1bp(X, Y, W, H, Mode, Hold ? 0 : Target_Memory_Addr, Plan.Gray[1], Plan.Gray[0]);
+        Epd_Stats.Depth_1bpp_Uploads++;
+    }
+    else
+    {
+        Load_Img_Info.Pixel_Format = IT8951_2BPP;
+        Load_Img_Info.Rotate = Load_Rotate;
+        Area_Img_Info.Area_X = X;
+        Area_Img_Info.Area_W = W;
+        EPD_IT8951_HostAreaPackedPixelWrite_2bp(&Load_Img_Info, &Area_Img_Info, Packed_Write);
+        free(Packed);
+
+        EPD_IT8951_RotateArea(&X, &Y, &W, &H);
+        if(Hold == true)
+        {
+            EPD_IT8951_Display_Area(X, Y, W, H, Mode);
+        }
+        else
+        {
+            EPD_IT8951_Display_AreaBuf(X, Y, W, H, Mode, Target_Memory_Addr);
+        }
+        Epd_Stats.Depth_2bpp_Uploads++;
+    }
+    Epd_Stats.Depth_Bytes_Saved += Stride * H - Packed_Bytes;
+    return true;
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_SetAdaptiveDepth
+parameter:
+    Enable : send frames with few grays at 1 or 2bpp
+******************************************************************************/
+void EPD_IT8951_SetAdaptiveDepth(bool Enable)
+{
+    Adaptive_Depth = Enable;
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_SetUploadDepth
+parameter:
+    Bits_Per_Pixel : depth 8bpp frames are sent at
+******************************************************************************/
+int EPD_IT8951_SetUploadDepth(UBYTE Bits_Per_Pixel)
+{
+    if(Bits_Per_Pixel != 1 && Bits_Per_Pixel != 2 && Bits_Per_Pixel != 4 && Bits_Per_Pixel != 8)
+        return -2;
+    Upload_Depth = Bits_Per_Pixel;
+    return 0;
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_SetUploadDither
+parameter:
+    Mode : dithering applied when packing 8bpp frames to the upload depth
+******************************************************************************/
+int EPD_IT8951_SetUploadDither(DITHER_MODE Mode)
+{
+    if((unsigned)Mode >= DITHER_MODES)
+        return -2;
+    Upload_Dither = Mode;
+    return 0;
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_Incremental_Refresh
+parameter:
+    Bits_Per_Pixel : 2, 4 or 8, as for the calling *bp_Refresh
+Info:
+    Diffs the frame against the shadow of the last one uploaded to the same
+    area and buffer, uploads only the changed tiles and refreshes their
+    bounding box once. A frame with nothing changed is neither uploaded nor
+    refreshed. Returns false, having sent nothing, when the caller should do
+    a plain upload instead.
+******************************************************************************/
+static bool EPD_IT8951_Incremental_Refresh(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Bits_Per_Pixel,
+                                           bool Hold, UDOUBLE Target_Memory_Addr, bool Packed_Write)
+{
+    IT8951_Load_Img_Info Load_Img_Info;
+    IT8951_Area_Img_Info Areas[EPD_IT8951_DIFF_MAX_AREAS];
+    UDOUBLE Row_Bytes = (UDOUBLE)W * Bits_Per_Pixel / 8;
+    UDOUBLE Frame_Bytes = Row_Bytes * H;
+    UDOUBLE Sent_Bytes = 0;
+    UWORD Box_X0, Box_Y0, Box_X1 = 0, Box_Y1 = 0;
+    UBYTE *Area_Buf = NULL;
+    bool Diffed = false;
+    UWORD Mode = GC16_Mode;
+    int Count;
+
+    //Partial rows cannot be sent as whole words; leave those to the plain path
+    if(Frame_Buf == NULL || W == 0 || H == 0 || (W * Bits_Per_Pixel) % 16 != 0)
+        return false;
+
+    if(Frame_Shadow.Size < Frame_Bytes)
+    {
+        UBYTE *Buf = (UBYTE *)realloc(Frame_Shadow.Buf, Frame_Bytes);
+        if(Buf == NULL)
+        {
+            EPD_LOG_WARN("Out of memory for a %lu byte frame shadow, uploading in full", (unsigned long)Frame_Bytes);
+            Frame_Shadow.Valid = false;
+            return false;
+        }
+        Frame_Shadow.Buf = Buf;
+        Frame_Shadow.Size = Frame_Bytes;
+        Frame_Shadow.Valid = false;
+    }
+
+    if(Frame_Shadow.Valid && Frame_Shadow.Addr == Target_Memory_Addr && Frame_Shadow.X == X && Frame_Shadow.Y == Y &&
+       Frame_Shadow.W == W && Frame_Shadow.H == H && Frame_Shadow.Bits_Per_Pixel == Bits_Per_Pixel && Frame_Shadow.Rotate == Load_Rotate)
+    {
+        Count = EPD_IT8951_Diff_Areas(Frame_Shadow.Buf, Frame_Buf, W, H, Bits_Per_Pixel, Areas, EPD_IT8951_DIFF_MAX_AREAS);
+        Diffed = true;
+    }
+    else
+    {
+        //Nothing to compare against: the whole frame is one area
+        Areas[0].Area_X = 0;
+        Areas[0].Area_Y = 0;
+        Areas[0].Area_W = W;
+        Areas[0].Area_H = H;
+        Count = 1;
+    }
+
+    Epd_Stats.Diff_Updates++;
+    if(Count == 0)
+    {
+        EPD_LOG_DEBUG("Incremental refresh: frame unchanged, %lu bytes avoided", (unsigned long)Frame_Bytes);
+        Epd_Stats.Diff_Bytes_Avoided += Frame_Bytes;
+        Epd_Stats.Diff_Last_Bytes_Avoided = Frame_Bytes;
+        return true;
+    }
+
+    //Partial areas are gathered row by row into one buffer big enough for any of them
+    for(int i = 0; i < Count; i++)
+    {
+        if(Areas[i].Area_W != W && Area_Buf == NULL)
+        {
+            Area_Buf = (UBYTE *)malloc(Frame_Bytes);
+            if(Area_Buf == NULL)
+            {
+                EPD_LOG_WARN("Out of memory copying changed areas, uploading in full");
+                Areas[0].Area_X = 0;
+                Areas[0].Area_Y = 0;
+                Areas[0].Area_W = W;
+                Areas[0].Area_H = H;
+                Count = 1;
+            }
+            break;
+        }
+    }
+
+    EPD_IT8951_WaitForDisplayReady();
+
+    Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
+    Load_Img_Info.Rotate = Load_Rotate;
+    Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
+
+    Box_X0 = W;
+    Box_Y0 = H;
+    for(int i = 0; i < Count; i++)
+    {
+        IT8951_Area_Img_Info Area_Img_Info = Areas[i];
+        UDOUBLE Area_Row_Bytes = (UDOUBLE)Area_Img_Info.Area_W * Bits_Per_Pixel / 8;
+        UBYTE *Src = Frame_Buf + (UDOUBLE)Area_Img_Info.Area_Y * Row_Bytes + (UDOUBLE)Area_Img_Info.Area_X * Bits_Per_Pixel / 8;
+
+        if(Area_Img_Info.Area_X < Box_X0) Box_X0 = Area_Img_Info.Area_X;
+        if(Area_Img_Info.Area_Y < Box_Y0) Box_Y0 = Area_Img_Info.Area_Y;
+        if(Area_Img_Info.Area_X + Area_Img_Info.Area_W > Box_X1) Box_X1 = Area_Img_Info.Area_X + Area_Img_Info.Area_W;
+        if(Area_Img_Info.Area_Y + Area_Img_Info.Area_H > Box_Y1) Box_Y1 = Area_Img_Info.Area_Y + Area_Img_Info.Area_H;
+
+        //Full-width areas are already contiguous in the frame buffer
+        Load_Img_Info.Source_Buffer_Addr = Src;
+        if(Area_Row_Bytes != Row_Bytes)
+        {
+            for(UWORD y = 0; y < Area_Img_Info.Area_H; y++)
+                memcpy(Area_Buf + y * Area_Row_Bytes, Src + (UDOUBLE)y * Row_Bytes, Area_Row_Bytes);
+            Load_Img_Info.Source_Buffer_Addr = Area_Buf;
+        }
+
+        Area_Img_Info.Area_X += X;
+        Area_Img_Info.Area_Y += Y;
+        EPD_IT8951_HostAreaWrite(&Load_Img_Info, &Area_Img_Info, Bits_Per_Pixel, Packed_Write);
+        Sent_Bytes += Area_Row_Bytes * Area_Img_Info.Area_H;
+    }
+    free(Area_Buf);
+
+    if(EPD_IT8951_GetError() != 0)
+    {
+        Frame_Shadow.Valid = false;
+        return true;
+    }
+
+    //The old pixels are only known for a diffed frame, so only then is A2 an option
+    if(Auto_Waveform)
+    {
+        UDOUBLE Offset = (UDOUBLE)Box_Y0 * Row_Bytes + (UDOUBLE)Box_X0 * Bits_Per_Pixel / 8;
+        Mode = EPD_IT8951_AutoMode(Diffed ? Frame_Shadow.Buf + Offset : NULL, Frame_Buf + Offset,
+                                   Box_X1 - Box_X0, Box_Y1 - Box_Y0, Bits_Per_Pixel, Row_Bytes);
+    }
+
+    //Keep the shadow in step with controller memory before the refresh
+    memcpy(Frame_Shadow.Buf, Frame_Buf, Frame_Bytes);
+    Frame_Shadow.Valid = true;
+    Frame_Shadow.Addr = Target_Memory_Addr;
+    Frame_Shadow.X = X;
+    Frame_Shadow.Y = Y;
+    Frame_Shadow.W = W;
+    Frame_Shadow.H = H;
+    Frame_Shadow.Bits_Per_Pixel = Bits_Per_Pixel;
+    Frame_Shadow.Rotate = Load_Rotate;
+
+    Epd_Stats.Diff_Areas += Count;
+    Epd_Stats.Diff_Bytes_Sent += Sent_Bytes;
+    Epd_Stats.Diff_Bytes_Avoided += Frame_Bytes - Sent_Bytes;
+    Epd_Stats.Diff_Last_Bytes_Avoided = Frame_Bytes - Sent_Bytes;
+    EPD_LOG_DEBUG("Incremental refresh: %d areas, %lu bytes sent, %lu avoided",
+                  Count, (unsigned long)Sent_Bytes, (unsigned long)(Frame_Bytes - Sent_Bytes));
+
+    //One refresh over everything that changed, in panel coordinates
+    X += Box_X0;
+    Y += Box_Y0;
+    W = Box_X1 - Box_X0;
+    H = Box_Y1 - Box_Y0;
+    EPD_IT8951_RotateArea(&X, &Y, &W, &H);
+    if(Hold == true)
+    {
+        EPD_IT8951_Display_Area(X, Y, W, H, Mode);
+    }
+    else
+    {
+        EPD_IT8951_Display_AreaBuf(X, Y, W, H, Mode, Target_Memory_Addr);
+    }
+    return true;
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_SetIncremental
+parameter:
+    Enable : diff each *bp_Refresh against the previous one
+******************************************************************************/
+void EPD_IT8951_SetIncremental(bool Enable)
+{
+    Frame_Shadow.Enabled = Enable;
+    Frame_Shadow.Valid = false;
+    if(!Enable)
+    {
+        free(Frame_Shadow.Buf);
+        Frame_Shadow.Buf = NULL;
+        Frame_Shadow.Size = 0;
+    }
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_Clear_Refresh
+parameter:  
+******************************************************************************/
+void EPD_IT8951_Clear_Refresh(IT8951_Dev_Info Dev_Info,UDOUBLE Target_Memory_Addr, UWORD Mode)
+{
+    //Solid white straight from the fill pattern, no frame buffer needed
+    if(EPD_IT8951_Fill_Area(0, 0, Dev_Info.Panel_W, Dev_Info.Panel_H, 0xFF, Target_Memory_Addr) != 0)
+        return;
+
+    EPD_IT8951_Display_Area(0, 0, Dev_Info.Panel_W, Dev_Info.Panel_H, Mode);
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_Fill_Area
+parameter:
+    Gray : 0x00 black to 0xFF white, the top 4 bits are sent
+Info:
+    Each row of a 4bpp area load is a whole number of words, so a row of
+    W pixels takes (W*4+15)/16 words; all of them carry the same pattern.
+******************************************************************************/
+int EPD_IT8951_Fill_Area(UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Gray, UDOUBLE Target_Memory_Addr)
+{
+    IT8951_Load_Img_Info Load_Img_Info;
+    IT8951_Area_Img_Info Area_Img_Info;
+    UWORD Nibble = Gray >> 4;
+    UWORD Pattern = (Nibble<<12) | (Nibble<<8) | (Nibble<<4) | Nibble;
+
+    if(W == 0 || H == 0)
+        return -2;
+
+    EPD_IT8951_FrameShadowTouch(Target_Memory_Addr);
+    EPD_IT8951_WaitForDisplayReady();
+
+    Load_Img_Info.Source_Buffer_Addr = NULL;
+    Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
+    Load_Img_Info.Pixel_Format = IT8951_4BPP;
+    Load_Img_Info.Rotate =  IT8951_ROTATE_0;
+    Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
+
+    Area_Img_Info.Area_X = X;
+    Area_Img_Info.Area_Y = Y;
+    Area_Img_Info.Area_W = W;
+    Area_Img_Info.Area_H = H;
+
+    EPD_IT8951_SetTargetMemoryAddr(Load_Img_Info.Target_Memory_Addr);
+    EPD_IT8951_LoadImgAreaStart(&Load_Img_Info, &Area_Img_Info);
+    EPD_IT8951_WriteConstantData(Pattern, ((UDOUBLE)W*4 + 15)/16 * H);
+    EPD_IT8951_LoadImgEnd();
+
+    Epd_Stats.Fill_Areas++;
+    return EPD_IT8951_GetError();
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_Fill_Refresh
+parameter:
+******************************************************************************/
+int EPD_IT8951_Fill_Refresh(UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Gray, UWORD Mode, UDOUBLE Target_Memory_Addr)
+{
+    int Ret = EPD_IT8951_Fill_Area(X, Y, W, H, Gray, Target_Memory_Addr);
+    if(Ret != 0)
+        return Ret;
+
+    EPD_IT8951_Display_AreaBuf(X, Y, W, H, Mode, Target_Memory_Addr);
+    return EPD_IT8951_GetError();
+}
+
+
+/******************************************************************************
+function :	EPD_IT8951_1bp_Refresh
+parameter:
+******************************************************************************/
+void EPD_IT8951_1bp_Refresh(UBYTE* Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Mode, UDOUBLE Target_Memory_Addr, bool Packed_Write)
+{
+    IT8951_Load_Img_Info Load_Img_Info;
+    IT8951_Area_Img_Info Area_Img_Info;
+
+    EPD_IT8951_FrameShadowTouch(Target_Memory_Addr);
+    EPD_IT8951_WaitForDisplayReady();
+
+    Load_Img_Info.Source_Buffer_Addr = Frame_Buf;
+    Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
+    //Use 8bpp to set 1bpp
+    Load_Img_Info.Pixel_Format = IT8951_8BPP;
+    Load_Img_Info.Rotate =  IT8951_ROTATE_0;
+    Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
+
+    Area_Img_Info.Area_X = X/8;
+    Area_Img_Info.Area_Y = Y;
+    Area_Img_Info.Area_W = W/8;
+    Area_Img_Info.Area_H = H;
+
+
+    //clock_t start, finish;
+    //double duration;
+
+    //start = clock();
+
+    EPD_IT8951_HostAreaPackedPixelWrite_1bp(&Load_Img_Info, &Area_Img_Info, Packed_Write);
+
+    //finish = clock();
+    //duration = (double)(finish - start) / CLOCKS_PER_SEC;
+	//Debug( "Write occupy %f second\n", duration );
+
+    //start = clock();
 
     EPD_IT8951_Display_1bp(X,Y,W,H,Mode,Target_Memory_Addr,0xF0,0x00);
 
@@ -889,6 +1904,7 @@ void EPD_IT8951_1bp_Multi_Frame_Write(UBYTE* Frame_Buf, UWORD X, UWORD Y, UWORD
     IT8951_Load_Img_Info Load_Img_Info;
     IT8951_Area_Img_Info Area_Img_Info;
 
+    EPD_IT8951_FrameShadowTouch(Target_Memory_Addr);
     EPD_IT8951_WaitForDisplayReady();
 
     Load_Img_Info.Source_Buffer_Addr = Frame_Buf;
@@ -931,13 +1947,22 @@ void EPD_IT8951_2bp_Refresh(UBYTE* Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H
 {
     IT8951_Load_Img_Info Load_Img_Info;
     IT8951_Area_Img_Info Area_Img_Info;
+    UWORD Mode = GC16_Mode;
+
+    if(Frame_Shadow.Enabled && EPD_IT8951_Incremental_Refresh(Frame_Buf, X, Y, W, H, 2, Hold, Target_Memory_Addr, Packed_Write))
+        return;
+    EPD_IT8951_FrameShadowTouch(Target_Memory_Addr);
+    if(Auto_Waveform)
+        Mode = EPD_IT8951_AutoMode(NULL, Frame_Buf, W, H, 2, W*2/8);
+    if(Adaptive_Depth && EPD_IT8951_Adaptive_Refresh(Frame_Buf, X, Y, W, H, 2, Mode, Hold, Target_Memory_Addr, Packed_Write))
+        return;
 
     EPD_IT8951_WaitForDisplayReady();
 
     Load_Img_Info.Source_Buffer_Addr = Frame_Buf;
     Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
     Load_Img_Info.Pixel_Format = IT8951_2BPP;
-    Load_Img_Info.Rotate =  IT8951_ROTATE_0;
+    Load_Img_Info.Rotate = Load_Rotate;
     Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
 
     Area_Img_Info.Area_X = X;
@@ -947,13 +1972,15 @@ void EPD_IT8951_2bp_Refresh(UBYTE* Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H
 
     EPD_IT8951_HostAreaPackedPixelWrite_2bp(&Load_Img_Info, &Area_Img_Info,Packed_Write);
 
+    //The pixels went in rotated, the refresh is in panel coordinates
+    EPD_IT8951_RotateArea(&X, &Y, &W, &H);
     if(Hold == true)
     {
-        EPD_IT8951_Display_Area(X,Y,W,H, GC16_Mode);
+        EPD_IT8951_Display_Area(X,Y,W,H, Mode);
     }
     else
     {
-        EPD_IT8951_Display_AreaBuf(X,Y,W,H, GC16_Mode,Target_Memory_Addr);
+        EPD_IT8951_Display_AreaBuf(X,Y,W,H, Mode,Target_Memory_Addr);
     }
 }
 
@@ -969,13 +1996,21 @@ void EPD_IT8951_4bp_Refresh(UBYTE* Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H
     EPD_LOG_DEBUG("[4bp_Refresh] Entry: Frame_Buf=%p, X=%u, Y=%u, W=%u, H=%u, Hold=%d, Target_Memory_Addr=0x%llX, Packed_Write=%d", Frame_Buf, X, Y, W, H, Hold, (unsigned long long)Target_Memory_Addr, Packed_Write);
     IT8951_Load_Img_Info Load_Img_Info;
     IT8951_Area_Img_Info Area_Img_Info;
-
+    UWORD Mode = GC16_Mode;
+
+    if(Frame_Shadow.Enabled && EPD_IT8951_Incremental_Refresh(Frame_Buf, X, Y, W, H, 4, Hold, Target_Memory_Addr, Packed_Write))
+        return;
+    EPD_IT8951_FrameShadowTouch(Target_Memory_Addr);
+    if(Auto_Waveform)
+        Mode = EPD_IT8951_AutoMode(NULL, Frame_Buf, W, H, 4, W*4/8);
+    if(Adaptive_Depth && EPD_IT8951_Adaptive_Refresh(Frame_Buf, X, Y, W, H, 4, Mode, Hold, Target_Memory_Addr, Packed_Write))
+        return;
     EPD_IT8951_WaitForDisplayReady();
 
     Load_Img_Info.Source_Buffer_Addr = Frame_Buf;
     Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
     Load_Img_Info.Pixel_Format = IT8951_4BPP;
-    Load_Img_Info.Rotate =  IT8951_ROTATE_0;
+    Load_Img_Info.Rotate = Load_Rotate;
     Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
 
     Area_Img_Info.Area_X = X;
@@ -987,16 +2022,18 @@ void EPD_IT8951_4bp_Refresh(UBYTE* Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H
     EPD_IT8951_HostAreaPackedPixelWrite_4bp(&Load_Img_Info, &Area_Img_Info, Packed_Write);
     EPD_LOG_DEBUG("HostAreaPackedPixelWrite_4bp completed");
 
+    //The pixels went in rotated, the refresh is in panel coordinates
+    EPD_IT8951_RotateArea(&X, &Y, &W, &H);
     if(Hold == true)
     {
         EPD_LOG_DEBUG("Calling Display_Area");
-        EPD_IT8951_Display_Area(X,Y,W,H, GC16_Mode);
+        EPD_IT8951_Display_Area(X,Y,W,H, Mode);
         EPD_LOG_DEBUG("Display_Area completed");
     }
     else
     {
         EPD_LOG_DEBUG("Calling Display_AreaBuf");
-        EPD_IT8951_Display_AreaBuf(X,Y,W,H, GC16_Mode,Target_Memory_Addr);
+        EPD_IT8951_Display_AreaBuf(X,Y,W,H, Mode,Target_Memory_Addr);
         EPD_LOG_DEBUG("Display_AreaBuf completed");
     }
     EPD_LOG_DEBUG("[4bp_Refresh] Exit");
@@ -1011,13 +2048,22 @@ void EPD_IT8951_8bp_Refresh(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H
 {
     IT8951_Load_Img_Info Load_Img_Info;
     IT8951_Area_Img_Info Area_Img_Info;
+    UWORD Mode = GC16_Mode;
+
+    if(Frame_Shadow.Enabled && EPD_IT8951_Incremental_Refresh(Frame_Buf, X, Y, W, H, 8, Hold, Target_Memory_Addr, false))
+        return;
+    EPD_IT8951_FrameShadowTouch(Target_Memory_Addr);
+    if(Auto_Waveform)
+        Mode = EPD_IT8951_AutoMode(NULL, Frame_Buf, W, H, 8, W);
+    if(Adaptive_Depth && EPD_IT8951_Adaptive_Refresh(Frame_Buf, X, Y, W, H, 8, Mode, Hold, Target_Memory_Addr, false))
+        return;
 
     EPD_IT8951_WaitForDisplayReady();
 
     Load_Img_Info.Source_Buffer_Addr = Frame_Buf;
     Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
     Load_Img_Info.Pixel_Format = IT8951_8BPP;
-    Load_Img_Info.Rotate =  IT8951_ROTATE_0;
+    Load_Img_Info.Rotate = Load_Rotate;
     Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
 
     Area_Img_Info.Area_X = X;
@@ -1027,14 +2073,189 @@ void EPD_IT8951_8bp_Refresh(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H
 
     EPD_IT8951_HostAreaPackedPixelWrite_8bp(&Load_Img_Info, &Area_Img_Info);
 
+    //The pixels went in rotated, the refresh is in panel coordinates
+    EPD_IT8951_RotateArea(&X, &Y, &W, &H);
     if(Hold == true)
     {
-        EPD_IT8951_Display_Area(X, Y, W, H, GC16_Mode);
+        EPD_IT8951_Display_Area(X, Y, W, H, Mode);
+    }
+    else
+    {
+        EPD_IT8951_Display_AreaBuf(X, Y, W, H, Mode, Target_Memory_Addr);
+    }
+}
+
+/******************************************************************************
+function :	EPD_IT8951_Area_Load
+parameter:
+    Frame_Buf      : W x H packed pixels
+    Bits_Per_Pixel : 2, 4 or 8
+Info:
+    Only loads controller memory; nothing is refreshed.
+******************************************************************************/
+int EPD_IT8951_Area_Load(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Bits_Per_Pixel, UDOUBLE Target_Memory_Addr)
+{
+    IT8951_Load_Img_Info Load_Img_Info;
+    IT8951_Area_Img_Info Area_Img_Info;
+
+    //Packed rows are sent as whole 16 bit words
+    if(Frame_Buf == NULL || W == 0 || H == 0 ||
+       (Bits_Per_Pixel != 2 && Bits_Per_Pixel != 4 && Bits_Per_Pixel != 8) || (W * Bits_Per_Pixel) % 16 != 0)
+        return -2;
+
+    EPD_IT8951_FrameShadowTouch(Target_Memory_Addr);
+    EPD_IT8951_WaitForDisplayReady();
+
+    Load_Img_Info.Source_Buffer_Addr = Frame_Buf;
+    Load_Img_Info.Endian_Type = IT8951_LDIMG_L_ENDIAN;
+    Load_Img_Info.Rotate = Load_Rotate;
+    Load_Img_Info.Target_Memory_Addr = Target_Memory_Addr;
+
+    Area_Img_Info.Area_X = X;
+    Area_Img_Info.Area_Y = Y;
+    Area_Img_Info.Area_W = W;
+    Area_Img_Info.Area_H = H;
+
+    switch(Bits_Per_Pixel)
+    {
+        case 2:
+            Load_Img_Info.Pixel_Format = IT8951_2BPP;
+            EPD_IT8951_HostAreaPackedPixelWrite_2bp(&Load_Img_Info, &Area_Img_Info, false);
+            break;
+        case 4:
+            Load_Img_Info.Pixel_Format = IT8951_4BPP;
+            EPD_IT8951_HostAreaPackedPixelWrite_4bp(&Load_Img_Info, &Area_Img_Info, false);
+            break;
+        default:
+            Load_Img_Info.Pixel_Format = IT8951_8BPP;
+            EPD_IT8951_HostAreaPackedPixelWrite_8bp(&Load_Img_Info, &Area_Img_Info);
+            break;
+    }
+    return EPD_IT8951_GetError();
+}
+
+/******************************************************************************
+function :	EPD_IT8951_Buffer_Refresh
+parameter:
+    Target_Memory_Addr : image buffer the area is shown from
+Info:
+    A single DPY_BUF_AREA command; no pixels are sent.
+******************************************************************************/
+int EPD_IT8951_Buffer_Refresh(UWORD X, UWORD Y, UWORD W, UWORD H, UWORD Mode, UDOUBLE Target_Memory_Addr)
+{
+    if(W == 0 || H == 0)
+        return -2;
+    EPD_IT8951_WaitForDisplayReady();
+    EPD_IT8951_Display_AreaBuf(X, Y, W, H, Mode, Target_Memory_Addr);
+    return EPD_IT8951_GetError();
+}
+
+/******************************************************************************
+function :	EPD_IT8951_Packed_Refresh
+parameter:
+    Src    : first 8bpp pixel of the area
+    Stride : bytes from one row of Src to the next
+Info:
+    Packs the area to Upload_Depth, dithered with Upload_Dither, and
+    refreshes it with EPD_IT8951_Area_Refresh(). Bayer is placed by panel
+    position, so areas meet without seams; error diffusion starts afresh in
+    each area.
+******************************************************************************/
+static int EPD_IT8951_Packed_Refresh(const UBYTE *Src, UDOUBLE Stride, UWORD X, UWORD Y, UWORD W, UWORD H,
+                                     UWORD Mode, UDOUBLE Target_Memory_Addr)
+{
+    UDOUBLE Row_Bytes = (UDOUBLE)W * Upload_Depth / 8;
+    UBYTE *Packed;
+    int Ret;
+
+    if(W * Upload_Depth % 8 != 0)
+        return -2;
+    Packed = (UBYTE *)malloc(Row_Bytes * H);
+    if(Packed == NULL)
+    {
+        EPD_LOG_ERROR("Out of memory packing a %ux%u area to %ubpp", W, H, Upload_Depth);
+        return -11;
+    }
+    if(Upload_Dither == DITHER_NONE)
+    {
+        EPD_IT8951_Pack_Area(Src, Stride, W, H, Upload_Depth, Packed, Row_Bytes);
     }
     else
     {
-        EPD_IT8951_Display_AreaBuf(X, Y, W, H, GC16_Mode, Target_Memory_Addr);
+        DITHER Dither;
+        UBYTE *Row = (UBYTE *)malloc(W);
+
+        if(Row == NULL || Dither_Init(&Dither, Upload_Dither, Upload_Depth, W) != 0)
+        {
+            EPD_LOG_ERROR("Out of memory dithering a %ux%u area", W, H);
+            free(Row);
+            free(Packed);
+            return -11;
+        }
+        for(UWORD y = 0; y < H; y++)
+        {
+            //Paint keeps the top nibble; 0xF0 is white, as 0xFF
+            for(UWORD x = 0; x < W; x++)
+                Row[x] = Src[(UDOUBLE)y * Stride + x] | (Src[(UDOUBLE)y * Stride + x] >> 4);
+            Dither_Row(&Dither, Row, X, Y + y);
+            EPD_IT8951_Pack_Row(Row, Packed + (UDOUBLE)y * Row_Bytes, W, Upload_Depth);
+        }
+        Dither_Release(&Dither);
+        free(Row);
     }
+    Ret = EPD_IT8951_Area_Refresh(Packed, X, Y, W, H, Upload_Depth, Mode, Target_Memory_Addr);
+    free(Packed);
+    return Ret;
+}
+
+/******************************************************************************
+function :	EPD_IT8951_Area_Refresh
+parameter:
+    Frame_Buf      : W x H pixels, rows padded to whole bytes
+    Bits_Per_Pixel : 1, 2, 4 or 8
+    Mode           : waveform mode used for the refresh
+Info:
+    Unlike the *bp_Refresh functions the waveform mode is not fixed to GC16.
+******************************************************************************/
+int EPD_IT8951_Area_Refresh(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H, UBYTE Bits_Per_Pixel, UWORD Mode, UDOUBLE Target_Memory_Addr)
+{
+    int Ret;
+
+    //-1 is EPD_IT8951_ERR_BUSY_TIMEOUT
+    if(Frame_Buf == NULL || W == 0 || H == 0)
+        return -2;
+
+    if(Bits_Per_Pixel == 8 && Upload_Depth != 8)
+        return EPD_IT8951_Packed_Refresh(Frame_Buf, W, X, Y, W, H, Mode, Target_Memory_Addr);
+
+    //1bpp content is black and white, but what it replaces is unknown
+    if(Mode == EPD_IT8951_MODE_AUTO && Bits_Per_Pixel == 1)
+        Mode = EPD_IT8951_Waveform_Mode(EPD_IT8951_WAVE_DU);
+    else if(Mode == EPD_IT8951_MODE_AUTO && (Bits_Per_Pixel == 2 || Bits_Per_Pixel == 4 || Bits_Per_Pixel == 8))
+        Mode = EPD_IT8951_AutoMode(NULL, Frame_Buf, W, H, Bits_Per_Pixel, (UDOUBLE)W * Bits_Per_Pixel / 8);
+
+    if(Adaptive_Depth && (Bits_Per_Pixel == 2 || Bits_Per_Pixel == 4 || Bits_Per_Pixel == 8) &&
+       EPD_IT8951_Adaptive_Refresh(Frame_Buf, X, Y, W, H, Bits_Per_Pixel, Mode, false, Target_Memory_Addr, false))
+        return EPD_IT8951_GetError();
+
+    if(Bits_Per_Pixel == 1)
+    {
+        //The 8bpp trick packs 8 pixels per byte, which the controller cannot rotate
+        if(Load_Rotate != IT8951_ROTATE_0)
+            return -2;
+        //1bpp goes through the 8bpp trick, so X and W must be byte aligned
+        if(X % 8 != 0 || W % 8 != 0)
+            return -2;
+        EPD_IT8951_1bp_Refresh(Frame_Buf, X, Y, W, H, Mode, Target_Memory_Addr, false);
+        return EPD_IT8951_GetError();
+    }
+
+    Ret = EPD_IT8951_Area_Load(Frame_Buf, X, Y, W, H, Bits_Per_Pixel, Target_Memory_Addr);
+    if(Ret != 0)
+        return Ret;
+    EPD_IT8951_RotateArea(&X, &Y, &W, &H);
+    EPD_IT8951_Display_AreaBuf(X, Y, W, H, Mode, Target_Memory_Addr);
+    return EPD_IT8951_GetError();
 }
 
 /**
@@ -1050,6 +2271,7 @@ void EPD_IT8951_8bp_Refresh(UBYTE *Frame_Buf, UWORD X, UWORD Y, UWORD W, UWORD H
  * @return 0 on success, negative value on error.
  */
 #include "GUI_BMPfile.h"
+#include "GUI_Image.h"
 #include "GUI_Paint.h"
 
 /**
@@ -1103,17 +2325,55 @@ EPD_Config EPD_IT8951_ComputeConfig(UWORD mode) {
 }
 
 int EPD_IT8951_DisplayBMP(const char *path, UWORD VCOM, UWORD Mode) {
-    EPD_LOG_INFO("path=%s, VCOM=%d, Mode=%d", path, VCOM, Mode);
+    return EPD_IT8951_DisplayBMPEx(path, VCOM, Mode, NULL);
+}
+
+int EPD_IT8951_DisplayBMPEx(const char *path, UWORD VCOM, UWORD Mode, EPD_IT8951_Policy *Policy) {
+    EPD_LOG_INFO("path=%s, VCOM=%d, Mode=%d, Policy=%p", path, VCOM, Mode, (void *)Policy);
     // 1. Initialize the display and get device info
     IT8951_Dev_Info dev_info = EPD_IT8951_Init(VCOM);
+    if (EPD_IT8951_GetError() != 0) {
+        EPD_LOG_ERROR("Controller did not respond during initialization");
+        return -13; // Controller busy timeout
+    }
     if (dev_info.Panel_W == 0 || dev_info.Panel_H == 0) {
         EPD_LOG_ERROR("Failed to initialize display or get panel info");
         return -10; // Failed to init or get panel info
     }
-    // Unconditionally clear the panel with INIT_Mode, just like the demo
-    UDOUBLE target_memory_addr = dev_info.Memory_Addr_L | ((UDOUBLE)dev_info.Memory_Addr_H << 16);
-    EPD_IT8951_Clear_Refresh(dev_info, target_memory_addr, INIT_Mode);
     EPD_LOG_INFO("Initialized display, panel size: %dx%d", dev_info.Panel_W, dev_info.Panel_H);
+    // Without a policy, clear the panel with INIT_Mode every time, just like the demo
+    UDOUBLE target_memory_addr = dev_info.Memory_Addr_L | ((UDOUBLE)dev_info.Memory_Addr_H << 16);
+    if (Policy != NULL && (Policy->Panel_W != dev_info.Panel_W || Policy->Panel_H != dev_info.Panel_H)) {
+        if (Policy->Panel_W != 0 || Policy->Panel_H != 0) {
+            EPD_LOG_WARN("Refresh policy is for a %dx%d panel, resetting it", Policy->Panel_W, Policy->Panel_H);
+        }
+        UWORD budget[EPD_IT8951_POLICY_CLASSES];
+        memcpy(budget, Policy->Budget, sizeof(budget));
+        EPD_IT8951_Policy_Init(Policy, dev_info.Panel_W, dev_info.Panel_H);
+        memcpy(Policy->Budget, budget, sizeof(budget));
+    }
+    // The BMP is drawn over the whole panel with GC16
+    if (Policy == NULL || EPD_IT8951_Policy_NeedsClear(Policy, 0, 0, dev_info.Panel_W, dev_info.Panel_H, GC16_Mode)) {
+        EPD_IT8951_Clear_Refresh(dev_info, target_memory_addr, INIT_Mode);
+        if (Policy != NULL) {
+            EPD_LOG_INFO("Refresh policy: clearing the panel");
+            EPD_IT8951_Policy_Record(Policy, 0, 0, dev_info.Panel_W, dev_info.Panel_H, INIT_Mode);
+        }
+    }
+    int result = EPD_IT8951_DrawBMP(dev_info, path, Mode);
+    if (result == 0 && Policy != NULL) {
+        EPD_IT8951_Policy_Record(Policy, 0, 0, dev_info.Panel_W, dev_info.Panel_H, GC16_Mode);
+    }
+    return result;
+}
+
+int EPD_IT8951_DrawBMP(IT8951_Dev_Info dev_info, const char *path, UWORD Mode) {
+    EPD_LOG_INFO("path=%s, Mode=%d", path, Mode);
+    if (dev_info.Panel_W == 0 || dev_info.Panel_H == 0) {
+        EPD_LOG_ERROR("No panel info, initialize the display first");
+        return -10; // Failed to init or get panel info
+    }
+    UDOUBLE target_memory_addr = dev_info.Memory_Addr_L | ((UDOUBLE)dev_info.Memory_Addr_H << 16);
     EPD_Config cfg = EPD_IT8951_ComputeConfig(Mode);
     Paint_SetRotate(cfg.rotate);
     Paint_SetMirroring(cfg.mirror);
@@ -1124,6 +2384,20 @@ int EPD_IT8951_DisplayBMP(const char *path, UWORD VCOM, UWORD Mode) {
     if (Four_Byte_Align) {
         width = dev_info.Panel_W - (dev_info.Panel_W % 32);
     }
+    // Let the controller rotate the frame while loading it, so the BMP is
+    // drawn without a per-pixel remap; 1bpp frames cannot be rotated that way
+    UWORD saved_rotate = EPD_IT8951_GetRotate();
+    UWORD paint_rotate = cfg.rotate;
+    if (bits_per_pixel != 1 && EPD_IT8951_SetRotate(dev_info, cfg.rotate) == 0) {
+        paint_rotate = ROTATE_0;
+        if (cfg.rotate == ROTATE_90 || cfg.rotate == ROTATE_270) {
+            UWORD swap = width;
+            width = height;
+            height = swap;
+        }
+    } else {
+        EPD_IT8951_SetRotate(dev_info, ROTATE_0);
+    }
     UDOUBLE image_size;
     if (bits_per_pixel == 1) {
         image_size = (((width * 1) % 8 == 0) ? (width * 1 / 8) : (width * 1 / 8 + 1)) * height;
@@ -1138,17 +2412,19 @@ int EPD_IT8951_DisplayBMP(const char *path, UWORD VCOM, UWORD Mode) {
     UBYTE *frame_buf = (UBYTE*)malloc(image_size);
     if (!frame_buf) {
         EPD_LOG_ERROR("Out of memory allocating display buffer");
+        EPD_IT8951_SetRotate(dev_info, saved_rotate);
         return -11; // Out of memory
     }
-    Paint_NewImage(frame_buf, width, height, ROTATE_0, WHITE);
+    Paint_NewImage(frame_buf, width, height, paint_rotate, WHITE);
     Paint_SelectImage(frame_buf);
     Paint_SetBitsPerPixel(bits_per_pixel);
     Paint_Clear(WHITE);
-    int bmp_result = GUI_ReadBmp(path, 0, 0);
-    EPD_LOG_DEBUG("Loaded BMP file, result=%d", bmp_result);
+    int bmp_result = GUI_ReadImage(path, 0, 0);
+    EPD_LOG_DEBUG("Loaded image file, result=%d", bmp_result);
     if (bmp_result < 0) {
-        EPD_LOG_ERROR("Failed to load BMP file (error %d)", bmp_result);
+        EPD_LOG_ERROR("Failed to load image file (error %d)", bmp_result);
         free(frame_buf);
+        EPD_IT8951_SetRotate(dev_info, saved_rotate);
         return bmp_result; // Propagate error from BMP loader
     }
     // After loading BMP, before write loop
@@ -1174,8 +2450,78 @@ int EPD_IT8951_DisplayBMP(const char *path, UWORD VCOM, UWORD Mode) {
         default:
             EPD_LOG_ERROR("Invalid bit depth %d", bits_per_pixel);
             free(frame_buf);
+            EPD_IT8951_SetRotate(dev_info, saved_rotate);
             return -12; // Invalid bit depth
     }
     free(frame_buf);
+    EPD_IT8951_SetRotate(dev_info, saved_rotate);
+    if (EPD_IT8951_GetError() != 0) {
+        EPD_LOG_ERROR("Controller stopped responding during refresh");
+        return -13; // Controller busy timeout
+    }
     return 0;
 }
+
+/******************************************************************************
+function :	EPD_IT8951_RefreshDirty
+parameter:
+    Mode               : waveform mode used for every area
+    Target_Memory_Addr : image buffer the areas are loaded into
+Info:
+    Uploads and refreshes only the areas of the current Paint image that
+    changed since the damage was last cleared.
+******************************************************************************/
+int EPD_IT8951_RefreshDirty(UWORD Mode, UDOUBLE Target_Memory_Addr)
+{
+    PAINT_RECT Rects[PAINT_DAMAGE_MAX];
+    UBYTE Bits_Per_Pixel = Paint.BitsPerPixel;
+    UBYTE Depth = (Bits_Per_Pixel == 8) ? Upload_Depth : Bits_Per_Pixel;
+    //Rows go out as whole 16 bit words; 1bpp is sent as bytes of 8bpp pixels
+    UWORD Align = (Depth == 1) ? 16 : 16 / Depth;
+    UWORD Count;
+
+    if (Paint.Image == NULL)
+        return -2;
+    if (Four_Byte_Align && Align < 32)
+        Align = 32;
+
+    Count = Paint_GetDamage(Rects, PAINT_DAMAGE_MAX, Align);
+    for (UWORD i = 0; i < Count; i++) {
+        PAINT_RECT *Rect = &Rects[i];
+        UDOUBLE Row_Bytes = (UDOUBLE)Rect->W * Bits_Per_Pixel / 8;
+        UBYTE *Src = Paint.Image + (UDOUBLE)Rect->Y * Paint.WidthByte + (UDOUBLE)Rect->X * Bits_Per_Pixel / 8;
+        UBYTE *Area_Buf = Src;
+        int Ret;
+
+        //Packing reads the rows in place, so it needs no copy first
+        if (Depth != Bits_Per_Pixel) {
+            EPD_LOG_DEBUG("Refreshing dirty area %ux%u at (%u,%u) packed to %ubpp", Rect->W, Rect->H, Rect->X, Rect->Y, Depth);
+            Ret = EPD_IT8951_Packed_Refresh(Src, Paint.WidthByte, Rect->X, Rect->Y, Rect->W, Rect->H, Mode, Target_Memory_Addr);
+            if (Ret != 0)
+                return Ret;
+            continue;
+        }
+
+        //Full-width areas are already contiguous in the frame buffer
+        if (Row_Bytes != Paint.WidthByte) {
+            Area_Buf = (UBYTE *)malloc(Row_Bytes * Rect->H);
+            if (Area_Buf == NULL) {
+                EPD_LOG_ERROR("Out of memory copying a %ux%u dirty area", Rect->W, Rect->H);
+                return -11;
+            }
+            for (UWORD y = 0; y < Rect->H; y++)
+                memcpy(Area_Buf + y * Row_Bytes, Src + (UDOUBLE)y * Paint.WidthByte, Row_Bytes);
+        }
+
+        EPD_LOG_DEBUG("Refreshing dirty area %ux%u at (%u,%u)", Rect->W, Rect->H, Rect->X, Rect->Y);
+        Ret = EPD_IT8951_Area_Refresh(Area_Buf, Rect->X, Rect->Y, Rect->W, Rect->H, Bits_Per_Pixel, Mode, Target_Memory_Addr);
+        if (Area_Buf != Src)
+            free(Area_Buf);
+        //Keep the damage so the caller can retry
+        if (Ret != 0)
+            return Ret;
+    }
+
+    Paint_ClearDamage();
+    return Count;
+}
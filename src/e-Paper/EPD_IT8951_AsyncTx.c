@@ -0,0 +1,258 @@
+/**
+ * @file EPD_IT8951_AsyncTx.c
+ * @brief Double-buffered transmit worker for IT8951 pixel streams.
+ *
+ * The producer (the thread calling the refresh functions) owns Head, the worker
+ * owns Tail. Both are only ever advanced by their owner with release stores, so
+ * the handoff itself is lock-free; the two semaphores are used only to park a
+ * side that has nothing to do.
+ */
+#include "EPD_IT8951_AsyncTx.h"
+#include "Debug.h"
+#include <pthread.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+static UBYTE *Slot_Buf[EPD_IT8951_ASYNC_TX_SLOTS];
+static UDOUBLE Slot_Len[EPD_IT8951_ASYNC_TX_SLOTS];
+static UDOUBLE Head;    //next slot the producer fills
+static UDOUBLE Tail;    //next slot the worker sends
+static sem_t Slot_Free;
+static sem_t Slot_Filled;
+static pthread_t Worker;
+static bool Worker_Running = false;
+
+//Counters; the wire time is written by the worker, the rest by the producer
+static uint64_t Stat_Streams;
+static uint64_t Stat_Chunks;
+static uint64_t Stat_Slot_Waits;
+static uint64_t Stat_Pack_us;
+static uint64_t Stat_Wire_us;
+static uint64_t Stat_Wall_us;
+
+/******************************************************************************
+function :	Monotonic time in microseconds
+parameter:
+******************************************************************************/
+static uint64_t EPD_IT8951_AsyncTx_NowUs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/******************************************************************************
+function :	sem_wait that survives signals
+parameter:
+******************************************************************************/
+static void EPD_IT8951_AsyncTx_SemWait(sem_t *Sem)
+{
+    while(sem_wait(Sem) != 0 && errno == EINTR)
+        ;
+}
+
+/******************************************************************************
+function :	Worker thread: send filled slots in order
+parameter:
+Info:
+    A post on Slot_Filled without a new slot behind it is the stop request.
+******************************************************************************/
+static void *EPD_IT8951_AsyncTx_Worker(void *Arg)
+{
+    (void)Arg;
+    for(;;)
+    {
+        EPD_IT8951_AsyncTx_SemWait(&Slot_Filled);
+
+        UDOUBLE tail = __atomic_load_n(&Tail, __ATOMIC_RELAXED);
+        if(tail == __atomic_load_n(&Head, __ATOMIC_ACQUIRE))
+            break;
+
+        UDOUBLE index = tail % EPD_IT8951_ASYNC_TX_SLOTS;
+        uint64_t start = EPD_IT8951_AsyncTx_NowUs();
+        DEV_SPI_WriteBuffer(Slot_Buf[index], Slot_Len[index]);
+        __atomic_fetch_add(&Stat_Wire_us, EPD_IT8951_AsyncTx_NowUs() - start, __ATOMIC_RELAXED);
+
+        __atomic_store_n(&Tail, tail + 1, __ATOMIC_RELEASE);
+        sem_post(&Slot_Free);
+    }
+    return NULL;
+}
+
+/******************************************************************************
+function :	Allocate the slots and start the worker
+parameter:
+******************************************************************************/
+int EPD_IT8951_AsyncTx_Start(void)
+{
+    if(Worker_Running)
+        return 0;
+
+    for(int i = 0; i < EPD_IT8951_ASYNC_TX_SLOTS; i++)
+    {
+        Slot_Buf[i] = malloc(EPD_IT8951_ASYNC_TX_SLOT_BYTES);
+        if(Slot_Buf[i] == NULL)
+        {
+            EPD_LOG_ERROR("AsyncTx: cannot allocate %d byte slot", EPD_IT8951_ASYNC_TX_SLOT_BYTES);
+            while(i-- > 0)
+            {
+                free(Slot_Buf[i]);
+                Slot_Buf[i] = NULL;
+            }
+            return -1;
+        }
+    }
+
+    Head = 0;
+    Tail = 0;
+    sem_init(&Slot_Free, 0, EPD_IT8951_ASYNC_TX_SLOTS);
+    sem_init(&Slot_Filled, 0, 0);
+
+    if(pthread_create(&Worker, NULL, EPD_IT8951_AsyncTx_Worker, NULL) != 0)
+    {
+        EPD_LOG_ERROR("AsyncTx: cannot start transmit thread");
+        sem_destroy(&Slot_Free);
+        sem_destroy(&Slot_Filled);
+        for(int i = 0; i < EPD_IT8951_ASYNC_TX_SLOTS; i++)
+        {
+            free(Slot_Buf[i]);
+            Slot_Buf[i] = NULL;
+        }
+        return -2;
+    }
+
+    Worker_Running = true;
+    EPD_LOG_INFO("AsyncTx: transmit worker started (%d x %d byte slots)", EPD_IT8951_ASYNC_TX_SLOTS, EPD_IT8951_ASYNC_TX_SLOT_BYTES);
+    return 0;
+}
+
+/******************************************************************************
+function :	Stop the worker and free the slots
+parameter:
+******************************************************************************/
+void EPD_IT8951_AsyncTx_Stop(void)
+{
+    if(!Worker_Running)
+        return;
+
+    //WriteWords never returns with slots in flight, so the ring is empty here
+    sem_post(&Slot_Filled);
+    pthread_join(Worker, NULL);
+    sem_destroy(&Slot_Free);
+    sem_destroy(&Slot_Filled);
+
+    for(int i = 0; i < EPD_IT8951_ASYNC_TX_SLOTS; i++)
+    {
+        free(Slot_Buf[i]);
+        Slot_Buf[i] = NULL;
+    }
+    Worker_Running = false;
+    EPD_LOG_INFO("AsyncTx: transmit worker stopped");
+}
+
+/******************************************************************************
+function :	Report whether the worker is running
+parameter:
+******************************************************************************/
+bool EPD_IT8951_AsyncTx_Running(void)
+{
+    return Worker_Running;
+}
+
+/******************************************************************************
+function :	Pack words into slots while the worker sends the previous ones
+parameter:
+    Data_Buf : words to send, host order
+    Length   : number of words
+******************************************************************************/
+void EPD_IT8951_AsyncTx_WriteWords(const UWORD *Data_Buf, UDOUBLE Length)
+{
+    uint64_t stream_start = EPD_IT8951_AsyncTx_NowUs();
+
+    while(Length > 0)
+    {
+        UDOUBLE Words = Length;
+        if(Words > EPD_IT8951_ASYNC_TX_SLOT_BYTES/2)
+            Words = EPD_IT8951_ASYNC_TX_SLOT_BYTES/2;
+
+        if(sem_trywait(&Slot_Free) != 0)
+        {
+            Stat_Slot_Waits++;
+            EPD_IT8951_AsyncTx_SemWait(&Slot_Free);
+        }
+
+        UDOUBLE head = __atomic_load_n(&Head, __ATOMIC_RELAXED);
+        UDOUBLE index = head % EPD_IT8951_ASYNC_TX_SLOTS;
+        UBYTE *Slot = Slot_Buf[index];
+
+        uint64_t pack_start = EPD_IT8951_AsyncTx_NowUs();
+        for(UDOUBLE i = 0; i < Words; i++)
+        {
+            Slot[2*i]   = Data_Buf[i]>>8;
+            Slot[2*i+1] = Data_Buf[i];
+        }
+        Stat_Pack_us += EPD_IT8951_AsyncTx_NowUs() - pack_start;
+        Slot_Len[index] = Words*2;
+
+        __atomic_store_n(&Head, head + 1, __ATOMIC_RELEASE);
+        sem_post(&Slot_Filled);
+        Stat_Chunks++;
+
+        Data_Buf += Words;
+        Length -= Words;
+    }
+
+    //Wait for the worker to hand back every slot before CS is released
+    for(int i = 0; i < EPD_IT8951_ASYNC_TX_SLOTS; i++)
+        EPD_IT8951_AsyncTx_SemWait(&Slot_Free);
+    for(int i = 0; i < EPD_IT8951_ASYNC_TX_SLOTS; i++)
+        sem_post(&Slot_Free);
+
+    Stat_Streams++;
+    Stat_Wall_us += EPD_IT8951_AsyncTx_NowUs() - stream_start;
+}
+
+/******************************************************************************
+function :	Copy the worker counters into a stats struct
+parameter:
+Info:
+    Overlap is the share of packing time that ran while the bus was busy:
+    (pack + wire - wall) / pack, clamped to [0, 1].
+******************************************************************************/
+void EPD_IT8951_AsyncTx_GetStats(EPD_IT8951_Stats *Stats)
+{
+    Stats->Async_Streams   = Stat_Streams;
+    Stats->Async_Chunks    = Stat_Chunks;
+    Stats->Async_Slot_Waits = Stat_Slot_Waits;
+    Stats->Async_Pack_us   = Stat_Pack_us;
+    Stats->Async_Wire_us   = __atomic_load_n(&Stat_Wire_us, __ATOMIC_RELAXED);
+    Stats->Async_Wall_us   = Stat_Wall_us;
+    Stats->Async_Overlap   = 0.0f;
+
+    if(Stats->Async_Pack_us > 0)
+    {
+        double hidden = (double)Stats->Async_Pack_us + (double)Stats->Async_Wire_us - (double)Stats->Async_Wall_us;
+        double overlap = hidden / (double)Stats->Async_Pack_us;
+        if(overlap < 0.0)
+            overlap = 0.0;
+        if(overlap > 1.0)
+            overlap = 1.0;
+        Stats->Async_Overlap = (float)overlap;
+    }
+}
+
+/******************************************************************************
+function :	Zero the worker counters
+parameter:
+******************************************************************************/
+void EPD_IT8951_AsyncTx_ResetStats(void)
+{
+    Stat_Streams = 0;
+    Stat_Chunks = 0;
+    Stat_Slot_Waits = 0;
+    Stat_Pack_us = 0;
+    __atomic_store_n(&Stat_Wire_us, 0, __ATOMIC_RELAXED);
+    Stat_Wall_us = 0;
+}
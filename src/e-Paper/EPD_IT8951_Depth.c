@@ -0,0 +1,126 @@
+/**
+ * @file EPD_IT8951_Depth.c
+ * @brief Gray level histogram and repacking to 1 or 2bpp.
+ */
+#include "EPD_IT8951_Depth.h"
+#include <stdbool.h>
+#include <string.h>
+
+/******************************************************************************
+function :	Gray of one pixel, widened to 8 bits
+parameter:
+    X : pixel index in the row; 2/4bpp rows start in the low bits
+Info:
+    The panel shows the high nibble of an 8bpp pixel, and Paint stores
+    0x00, 0x50, 0xA0 and 0xF0 for the 2bpp grays, so 8bpp is widened from it.
+******************************************************************************/
+static inline UBYTE EPD_IT8951_Depth_Gray(const UBYTE *Row, UWORD X, UBYTE Bits_Per_Pixel)
+{
+    switch(Bits_Per_Pixel)
+    {
+        case 2:
+            return ((Row[X / 4] >> ((X % 4) * 2)) & 0x03) * 0x55;
+        case 4:
+            return ((Row[X / 2] >> ((X % 2) * 4)) & 0x0F) * 0x11;
+        default:
+            return (Row[X] >> 4) * 0x11;
+    }
+}
+
+/******************************************************************************
+function :	Histogram a frame and choose the depth to send it at
+parameter:
+******************************************************************************/
+UBYTE EPD_IT8951_Depth_Analyze(const UBYTE *Frame, UWORD W, UWORD H, UBYTE Bits_Per_Pixel, UDOUBLE Stride,
+                               EPD_IT8951_Depth_Plan *Plan)
+{
+    bool Seen[256];
+    UBYTE Levels = 0;
+    UBYTE Pixels_Per_Byte = 8 / Bits_Per_Pixel;
+
+    memset(Seen, 0, sizeof(Seen));
+    memset(Plan, 0, sizeof(*Plan));
+    Plan->Bits_Per_Pixel = Bits_Per_Pixel;
+
+    for(UWORD y = 0; y < H && Levels <= 4; y++)
+    {
+        const UBYTE *Row = Frame + (UDOUBLE)y * Stride;
+        int Last = -1;
+
+        for(UWORD x = 0; x < W && Levels <= 4; x += Pixels_Per_Byte)
+        {
+            UBYTE Count = (W - x < Pixels_Per_Byte) ? W - x : Pixels_Per_Byte;
+
+            //Runs of one byte are the common case on text and dashboards
+            if(Row[x / Pixels_Per_Byte] == Last && Count == Pixels_Per_Byte)
+                continue;
+            Last = Row[x / Pixels_Per_Byte];
+            for(UBYTE i = 0; i < Count; i++)
+            {
+                UBYTE Gray = EPD_IT8951_Depth_Gray(Row, x + i, Bits_Per_Pixel);
+                if(!Seen[Gray])
+                {
+                    Seen[Gray] = true;
+                    Levels++;
+                }
+            }
+        }
+    }
+    Plan->Levels = Levels;
+    if(Levels > 4)
+        return Plan->Bits_Per_Pixel;
+
+    Levels = 0;
+    for(int Gray = 0; Gray < 256; Gray++)
+        if(Seen[Gray])
+            Plan->Gray[Levels++] = Gray;
+
+    if(Levels <= 2 && Bits_Per_Pixel > 1)
+    {
+        //One gray still needs two entries for bit 0 and bit 1
+        if(Levels == 1)
+            Plan->Gray[1] = Plan->Gray[0];
+        Plan->Bits_Per_Pixel = 1;
+    }
+    else if(Bits_Per_Pixel > 2)
+    {
+        bool Fits = true;
+        for(UBYTE i = 0; i < Levels; i++)
+            if(Plan->Gray[i] % 0x55 != 0)
+                Fits = false;
+        if(Fits)
+            Plan->Bits_Per_Pixel = 2;
+    }
+    return Plan->Bits_Per_Pixel;
+}
+
+/******************************************************************************
+function :	Repack a frame at the planned depth
+parameter:
+******************************************************************************/
+void EPD_IT8951_Depth_Pack(const UBYTE *Frame, UWORD W, UWORD H, UBYTE Bits_Per_Pixel, UDOUBLE Stride,
+                           const EPD_IT8951_Depth_Plan *Plan, UBYTE *Out)
+{
+    UDOUBLE Out_Row_Bytes = (UDOUBLE)W * Plan->Bits_Per_Pixel / 8;
+
+    for(UWORD y = 0; y < H; y++)
+    {
+        const UBYTE *Row = Frame + (UDOUBLE)y * Stride;
+        UBYTE *Dst = Out + (UDOUBLE)y * Out_Row_Bytes;
+
+        memset(Dst, 0, Out_Row_Bytes);
+        for(UWORD x = 0; x < W; x++)
+        {
+            UBYTE Gray = EPD_IT8951_Depth_Gray(Row, x, Bits_Per_Pixel);
+            if(Plan->Bits_Per_Pixel == 1)
+            {
+                if(Gray == Plan->Gray[1] && Gray != Plan->Gray[0])
+                    Dst[x / 8] |= 0x01 << (x % 8);
+            }
+            else
+            {
+                Dst[x / 4] |= (Gray / 0x55) << ((x % 4) * 2);
+            }
+        }
+    }
+}
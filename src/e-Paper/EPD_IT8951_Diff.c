@@ -0,0 +1,131 @@
+/**
+ * @file EPD_IT8951_Diff.c
+ * @brief Tile diff between two packed frames.
+ */
+#include "EPD_IT8951_Diff.h"
+#include "Debug.h"
+#include <stdbool.h>
+#include <string.h>
+
+/******************************************************************************
+function :	Compare two byte runs, 8 bytes at a time
+parameter:
+******************************************************************************/
+static inline bool EPD_IT8951_Diff_Equal(const UBYTE *A, const UBYTE *B, UDOUBLE Len)
+{
+    UDOUBLE i = 0;
+    for(; i + 8 <= Len; i += 8)
+    {
+        uint64_t Word_A, Word_B;
+        //memcpy keeps unaligned rows legal and compiles to a single load
+        memcpy(&Word_A, A + i, 8);
+        memcpy(&Word_B, B + i, 8);
+        if(Word_A != Word_B)
+            return false;
+    }
+    for(; i < Len; i++)
+        if(A[i] != B[i])
+            return false;
+    return true;
+}
+
+/******************************************************************************
+function :	Find the areas where two frames differ
+parameter:
+******************************************************************************/
+int EPD_IT8951_Diff_Areas(const UBYTE *Old, const UBYTE *New, UWORD W, UWORD H, UBYTE Bits_Per_Pixel,
+                          IT8951_Area_Img_Info *Areas, UWORD Max)
+{
+    UDOUBLE Row_Bytes = (UDOUBLE)W * Bits_Per_Pixel / 8;
+    UDOUBLE Tile_Bytes = EPD_IT8951_DIFF_TILE * Bits_Per_Pixel / 8;
+    UWORD Tiles_X = (W + EPD_IT8951_DIFF_TILE - 1) / EPD_IT8951_DIFF_TILE;
+    UBYTE Changed[(65535 + EPD_IT8951_DIFF_TILE - 1) / EPD_IT8951_DIFF_TILE];
+    UWORD Count = 0;
+    bool Overflow = false;
+    UWORD Box_X0 = W, Box_Y0 = H, Box_X1 = 0, Box_Y1 = 0;
+
+    for(UDOUBLE Band = 0; Band < H; Band += EPD_IT8951_DIFF_TILE)
+    {
+        UWORD Band_H = (H - Band < EPD_IT8951_DIFF_TILE) ? H - Band : EPD_IT8951_DIFF_TILE;
+        UWORD Left = Tiles_X;
+
+        memset(Changed, 0, Tiles_X);
+        //Rows of the band, skipping tiles already known to differ
+        for(UWORD y = 0; y < Band_H && Left > 0; y++)
+        {
+            UDOUBLE Row = (Band + y) * Row_Bytes;
+            for(UWORD tx = 0; tx < Tiles_X; tx++)
+            {
+                UDOUBLE Start = tx * Tile_Bytes;
+                UDOUBLE Len = (Start + Tile_Bytes > Row_Bytes) ? Row_Bytes - Start : Tile_Bytes;
+                if(Changed[tx])
+                    continue;
+                if(!EPD_IT8951_Diff_Equal(Old + Row + Start, New + Row + Start, Len))
+                {
+                    Changed[tx] = 1;
+                    Left--;
+                }
+            }
+        }
+
+        //Runs of changed tiles, extending a rectangle with the same columns from the band above
+        for(UWORD tx = 0; tx < Tiles_X; )
+        {
+            UWORD Run_End;
+            UWORD X, Span_W;
+            bool Extended = false;
+
+            if(!Changed[tx])
+            {
+                tx++;
+                continue;
+            }
+            for(Run_End = tx; Run_End < Tiles_X && Changed[Run_End]; Run_End++)
+                ;
+            X = tx * EPD_IT8951_DIFF_TILE;
+            Span_W = ((UDOUBLE)Run_End * EPD_IT8951_DIFF_TILE > W) ? W - X : (Run_End - tx) * EPD_IT8951_DIFF_TILE;
+            tx = Run_End;
+
+            if(X < Box_X0) Box_X0 = X;
+            if(X + Span_W > Box_X1) Box_X1 = X + Span_W;
+            if(Band < Box_Y0) Box_Y0 = Band;
+            if(Band + Band_H > Box_Y1) Box_Y1 = Band + Band_H;
+            if(Overflow)
+                continue;
+
+            for(UWORD i = 0; i < Count; i++)
+            {
+                if(Areas[i].Area_X == X && Areas[i].Area_W == Span_W && Areas[i].Area_Y + Areas[i].Area_H == Band)
+                {
+                    Areas[i].Area_H += Band_H;
+                    Extended = true;
+                    break;
+                }
+            }
+            if(Extended)
+                continue;
+            if(Count == Max)
+            {
+                Overflow = true;
+                continue;
+            }
+            Areas[Count].Area_X = X;
+            Areas[Count].Area_Y = Band;
+            Areas[Count].Area_W = Span_W;
+            Areas[Count].Area_H = Band_H;
+            Count++;
+        }
+    }
+
+    if(Overflow)
+    {
+        //Too scattered to send piecewise; one area over all the changes
+        EPD_LOG_DEBUG("Diff produced more than %u areas, using their bounding box", Max);
+        Areas[0].Area_X = Box_X0;
+        Areas[0].Area_Y = Box_Y0;
+        Areas[0].Area_W = Box_X1 - Box_X0;
+        Areas[0].Area_H = Box_Y1 - Box_Y0;
+        Count = 1;
+    }
+    return Count;
+}
@@ -0,0 +1,374 @@
+/**
+ * @file EPD_IT8951_Pack.c
+ * @brief 8bpp to 4, 2 and 1bpp packing kernels and their runtime dispatch.
+ */
+#include "EPD_IT8951_Pack.h"
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define EPD_IT8951_PACK_X86 1
+#include <immintrin.h>
+#endif
+
+//The NEON kernels are in EPD_IT8951_Pack_NEON.c, which is built with NEON
+//on 32-bit ARM too; soft-float builds have none
+#if defined(__aarch64__) || (defined(__arm__) && defined(__ARM_FP))
+#define EPD_IT8951_PACK_ARM 1
+#if defined(__arm__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
+//Packs the first Pixels pixels of a row; a multiple of 8 for the SIMD kernels
+typedef void (*EPD_IT8951_Pack_Fn)(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels);
+
+typedef struct {
+    EPD_IT8951_Pack_Fn Pack_4bp;
+    EPD_IT8951_Pack_Fn Pack_2bp;
+    EPD_IT8951_Pack_Fn Pack_1bp;
+} EPD_IT8951_Pack_Set;
+
+/******************************************************************************
+function :	Scalar kernels
+parameter:
+Info:
+    Also pack the tail of a row the SIMD kernels leave, so they take any
+    number of pixels.
+******************************************************************************/
+static void EPD_IT8951_Pack_4bp_Scalar(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i;
+
+    for(i = 0; i + 2 <= Pixels; i += 2)
+        *Dst++ = (Src[i] >> 4) | (Src[i + 1] & 0xF0);
+    if(i < Pixels)
+        *Dst = Src[i] >> 4;
+}
+
+static void EPD_IT8951_Pack_2bp_Scalar(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    for(UDOUBLE i = 0; i < Pixels; i += 4)
+    {
+        UBYTE Byte = 0;
+        for(UBYTE k = 0; k < 4 && i + k < Pixels; k++)
+            Byte |= (Src[i + k] >> 6) << (k * 2);
+        *Dst++ = Byte;
+    }
+}
+
+static void EPD_IT8951_Pack_1bp_Scalar(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    for(UDOUBLE i = 0; i < Pixels; i += 8)
+    {
+        UBYTE Byte = 0;
+        for(UBYTE k = 0; k < 8 && i + k < Pixels; k++)
+            Byte |= (Src[i + k] >> 7) << k;
+        *Dst++ = Byte;
+    }
+}
+
+#ifdef EPD_IT8951_PACK_X86
+/******************************************************************************
+function :	SSE2 kernels
+parameter:
+Info:
+    In a 16 bit lane holding pixels p0 (low byte) and p1, (w >> 4) & 0x0F is
+    p0's top nibble and (w >> 8) & 0xF0 is p1's, so 32 pixels become 16 bytes
+    with two shifts and one saturating pack. 2bpp first narrows every byte to
+    its top 2 bits, then folds pairs of bytes and pairs of words. 1bpp is the
+    sign bit of every byte, which movemask gathers in pixel order.
+******************************************************************************/
+__attribute__((target("sse2")))
+static void EPD_IT8951_Pack_4bp_SSE2(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    const __m128i Low = _mm_set1_epi16(0x000F), High = _mm_set1_epi16(0x00F0);
+    UDOUBLE i;
+
+    for(i = 0; i + 32 <= Pixels; i += 32)
+    {
+        __m128i A = _mm_loadu_si128((const __m128i *)(Src + i));
+        __m128i B = _mm_loadu_si128((const __m128i *)(Src + i + 16));
+        A = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(A, 4), Low), _mm_and_si128(_mm_srli_epi16(A, 8), High));
+        B = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(B, 4), Low), _mm_and_si128(_mm_srli_epi16(B, 8), High));
+        _mm_storeu_si128((__m128i *)(Dst + i / 2), _mm_packus_epi16(A, B));
+    }
+    EPD_IT8951_Pack_4bp_Scalar(Src + i, Dst + i / 2, Pixels - i);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i EPD_IT8951_Pack_2bp_Lanes_SSE2(__m128i V)
+{
+    //Top 2 bits of each byte, then 4 pixels folded into the low byte of each 32 bit lane
+    V = _mm_and_si128(_mm_srli_epi16(V, 6), _mm_set1_epi8(0x03));
+    V = _mm_and_si128(_mm_or_si128(V, _mm_srli_epi16(V, 6)), _mm_set1_epi16(0x000F));
+    return _mm_and_si128(_mm_or_si128(V, _mm_srli_epi32(V, 12)), _mm_set1_epi32(0x000000FF));
+}
+
+__attribute__((target("sse2")))
+static void EPD_IT8951_Pack_2bp_SSE2(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i;
+
+    for(i = 0; i + 64 <= Pixels; i += 64)
+    {
+        __m128i A = EPD_IT8951_Pack_2bp_Lanes_SSE2(_mm_loadu_si128((const __m128i *)(Src + i)));
+        __m128i B = EPD_IT8951_Pack_2bp_Lanes_SSE2(_mm_loadu_si128((const __m128i *)(Src + i + 16)));
+        __m128i C = EPD_IT8951_Pack_2bp_Lanes_SSE2(_mm_loadu_si128((const __m128i *)(Src + i + 32)));
+        __m128i D = EPD_IT8951_Pack_2bp_Lanes_SSE2(_mm_loadu_si128((const __m128i *)(Src + i + 48)));
+        _mm_storeu_si128((__m128i *)(Dst + i / 4), _mm_packus_epi16(_mm_packs_epi32(A, B), _mm_packs_epi32(C, D)));
+    }
+    EPD_IT8951_Pack_2bp_Scalar(Src + i, Dst + i / 4, Pixels - i);
+}
+
+__attribute__((target("sse2")))
+static void EPD_IT8951_Pack_1bp_SSE2(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i;
+
+    for(i = 0; i + 16 <= Pixels; i += 16)
+    {
+        UWORD Bits = (UWORD)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(Src + i)));
+        Dst[i / 8] = (UBYTE)Bits;
+        Dst[i / 8 + 1] = (UBYTE)(Bits >> 8);
+    }
+    EPD_IT8951_Pack_1bp_Scalar(Src + i, Dst + i / 8, Pixels - i);
+}
+
+/******************************************************************************
+function :	AVX2 kernels
+parameter:
+Info:
+    As the SSE2 ones on 256 bit registers. The packs work within each 128
+    bit half, so the results are put back in order with a permute.
+******************************************************************************/
+__attribute__((target("avx2")))
+static void EPD_IT8951_Pack_4bp_AVX2(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    const __m256i Low = _mm256_set1_epi16(0x000F), High = _mm256_set1_epi16(0x00F0);
+    UDOUBLE i;
+
+    for(i = 0; i + 64 <= Pixels; i += 64)
+    {
+        __m256i A = _mm256_loadu_si256((const __m256i *)(Src + i));
+        __m256i B = _mm256_loadu_si256((const __m256i *)(Src + i + 32));
+        A = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(A, 4), Low), _mm256_and_si256(_mm256_srli_epi16(A, 8), High));
+        B = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(B, 4), Low), _mm256_and_si256(_mm256_srli_epi16(B, 8), High));
+        _mm256_storeu_si256((__m256i *)(Dst + i / 2), _mm256_permute4x64_epi64(_mm256_packus_epi16(A, B), 0xD8));
+    }
+    EPD_IT8951_Pack_4bp_SSE2(Src + i, Dst + i / 2, Pixels - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i EPD_IT8951_Pack_2bp_Lanes_AVX2(__m256i V)
+{
+    V = _mm256_and_si256(_mm256_srli_epi16(V, 6), _mm256_set1_epi8(0x03));
+    V = _mm256_and_si256(_mm256_or_si256(V, _mm256_srli_epi16(V, 6)), _mm256_set1_epi16(0x000F));
+    return _mm256_and_si256(_mm256_or_si256(V, _mm256_srli_epi32(V, 12)), _mm256_set1_epi32(0x000000FF));
+}
+
+__attribute__((target("avx2")))
+static void EPD_IT8951_Pack_2bp_AVX2(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    const __m256i Order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    UDOUBLE i;
+
+    for(i = 0; i + 128 <= Pixels; i += 128)
+    {
+        __m256i A = EPD_IT8951_Pack_2bp_Lanes_AVX2(_mm256_loadu_si256((const __m256i *)(Src + i)));
+        __m256i B = EPD_IT8951_Pack_2bp_Lanes_AVX2(_mm256_loadu_si256((const __m256i *)(Src + i + 32)));
+        __m256i C = EPD_IT8951_Pack_2bp_Lanes_AVX2(_mm256_loadu_si256((const __m256i *)(Src + i + 64)));
+        __m256i D = EPD_IT8951_Pack_2bp_Lanes_AVX2(_mm256_loadu_si256((const __m256i *)(Src + i + 96)));
+        __m256i Packed = _mm256_packus_epi16(_mm256_packs_epi32(A, B), _mm256_packs_epi32(C, D));
+        _mm256_storeu_si256((__m256i *)(Dst + i / 4), _mm256_permutevar8x32_epi32(Packed, Order));
+    }
+    EPD_IT8951_Pack_2bp_SSE2(Src + i, Dst + i / 4, Pixels - i);
+}
+
+__attribute__((target("avx2")))
+static void EPD_IT8951_Pack_1bp_AVX2(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i;
+
+    for(i = 0; i + 32 <= Pixels; i += 32)
+    {
+        UDOUBLE Bits = (UDOUBLE)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *)(Src + i)));
+        Dst[i / 8] = (UBYTE)Bits;
+        Dst[i / 8 + 1] = (UBYTE)(Bits >> 8);
+        Dst[i / 8 + 2] = (UBYTE)(Bits >> 16);
+        Dst[i / 8 + 3] = (UBYTE)(Bits >> 24);
+    }
+    EPD_IT8951_Pack_1bp_SSE2(Src + i, Dst + i / 8, Pixels - i);
+}
+#endif
+
+#ifdef EPD_IT8951_PACK_ARM
+/******************************************************************************
+function :	NEON kernels
+parameter:
+Info:
+    The NEON part of each row is packed in EPD_IT8951_Pack_NEON.c, the rest
+    here.
+******************************************************************************/
+UDOUBLE EPD_IT8951_Pack_4bp_NEON(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels);
+UDOUBLE EPD_IT8951_Pack_2bp_NEON(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels);
+UDOUBLE EPD_IT8951_Pack_1bp_NEON(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels);
+
+static void EPD_IT8951_Pack_4bp_NEON_Row(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i = EPD_IT8951_Pack_4bp_NEON(Src, Dst, Pixels);
+    EPD_IT8951_Pack_4bp_Scalar(Src + i, Dst + i / 2, Pixels - i);
+}
+
+static void EPD_IT8951_Pack_2bp_NEON_Row(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i = EPD_IT8951_Pack_2bp_NEON(Src, Dst, Pixels);
+    EPD_IT8951_Pack_2bp_Scalar(Src + i, Dst + i / 4, Pixels - i);
+}
+
+static void EPD_IT8951_Pack_1bp_NEON_Row(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i = EPD_IT8951_Pack_1bp_NEON(Src, Dst, Pixels);
+    EPD_IT8951_Pack_1bp_Scalar(Src + i, Dst + i / 8, Pixels - i);
+}
+#endif
+
+static const EPD_IT8951_Pack_Set Pack_Sets[EPD_IT8951_PACK_KERNELS] = {
+    [EPD_IT8951_PACK_SCALAR] = { EPD_IT8951_Pack_4bp_Scalar, EPD_IT8951_Pack_2bp_Scalar, EPD_IT8951_Pack_1bp_Scalar },
+#ifdef EPD_IT8951_PACK_X86
+    [EPD_IT8951_PACK_SSE2]   = { EPD_IT8951_Pack_4bp_SSE2, EPD_IT8951_Pack_2bp_SSE2, EPD_IT8951_Pack_1bp_SSE2 },
+    [EPD_IT8951_PACK_AVX2]   = { EPD_IT8951_Pack_4bp_AVX2, EPD_IT8951_Pack_2bp_AVX2, EPD_IT8951_Pack_1bp_AVX2 },
+#endif
+#ifdef EPD_IT8951_PACK_ARM
+    [EPD_IT8951_PACK_NEON]   = { EPD_IT8951_Pack_4bp_NEON_Row, EPD_IT8951_Pack_2bp_NEON_Row, EPD_IT8951_Pack_1bp_NEON_Row },
+#endif
+};
+
+static const char *Pack_Names[EPD_IT8951_PACK_KERNELS] = { "scalar", "sse2", "avx2", "neon" };
+
+static EPD_IT8951_Pack_Kernel Pack_Kernel = EPD_IT8951_PACK_SCALAR;
+static pthread_once_t Pack_Once = PTHREAD_ONCE_INIT;
+
+/******************************************************************************
+function :	EPD_IT8951_Pack_Supported
+parameter:
+******************************************************************************/
+bool EPD_IT8951_Pack_Supported(EPD_IT8951_Pack_Kernel Kernel)
+{
+    switch(Kernel)
+    {
+        case EPD_IT8951_PACK_SCALAR:
+            return true;
+#ifdef EPD_IT8951_PACK_X86
+        case EPD_IT8951_PACK_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case EPD_IT8951_PACK_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef EPD_IT8951_PACK_ARM
+        case EPD_IT8951_PACK_NEON:
+#if defined(__arm__)
+            return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+            return true;
+#endif
+#endif
+        default:
+            return false;
+    }
+}
+
+/******************************************************************************
+function :	Pick the fastest kernel set the CPU supports
+parameter:
+******************************************************************************/
+static void EPD_IT8951_Pack_Pick(void)
+{
+    for(int Kernel = EPD_IT8951_PACK_KERNELS - 1; Kernel > EPD_IT8951_PACK_SCALAR; Kernel--)
+    {
+        if(EPD_IT8951_Pack_Supported((EPD_IT8951_Pack_Kernel)Kernel))
+        {
+            Pack_Kernel = (EPD_IT8951_Pack_Kernel)Kernel;
+            return;
+        }
+    }
+}
+
+/******************************************************************************
+function :	EPD_IT8951_Pack_SetKernel
+parameter:
+******************************************************************************/
+int EPD_IT8951_Pack_SetKernel(EPD_IT8951_Pack_Kernel Kernel)
+{
+    pthread_once(&Pack_Once, EPD_IT8951_Pack_Pick);
+    if(!EPD_IT8951_Pack_Supported(Kernel))
+        return -2;
+    Pack_Kernel = Kernel;
+    return 0;
+}
+
+/******************************************************************************
+function :	EPD_IT8951_Pack_GetKernel
+parameter:
+******************************************************************************/
+EPD_IT8951_Pack_Kernel EPD_IT8951_Pack_GetKernel(void)
+{
+    pthread_once(&Pack_Once, EPD_IT8951_Pack_Pick);
+    return Pack_Kernel;
+}
+
+/******************************************************************************
+function :	EPD_IT8951_Pack_KernelName
+parameter:
+******************************************************************************/
+const char *EPD_IT8951_Pack_KernelName(EPD_IT8951_Pack_Kernel Kernel)
+{
+    if((unsigned)Kernel >= EPD_IT8951_PACK_KERNELS)
+        return "?";
+    return Pack_Names[Kernel];
+}
+
+/******************************************************************************
+function :	EPD_IT8951_Pack_Row
+parameter:
+******************************************************************************/
+void EPD_IT8951_Pack_Row(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels, UBYTE Bits_Per_Pixel)
+{
+    const EPD_IT8951_Pack_Set *Set = &Pack_Sets[EPD_IT8951_Pack_GetKernel()];
+
+    switch(Bits_Per_Pixel)
+    {
+        case 4:
+            Set->Pack_4bp(Src, Dst, Pixels);
+            break;
+        case 2:
+            Set->Pack_2bp(Src, Dst, Pixels);
+            break;
+        case 1:
+            Set->Pack_1bp(Src, Dst, Pixels);
+            break;
+        default:
+            memcpy(Dst, Src, Pixels);
+            break;
+    }
+}
+
+/******************************************************************************
+function :	EPD_IT8951_Pack_Area
+parameter:
+******************************************************************************/
+void EPD_IT8951_Pack_Area(const UBYTE *Src, UDOUBLE Src_Stride, UWORD W, UWORD H, UBYTE Bits_Per_Pixel,
+                          UBYTE *Dst, UDOUBLE Dst_Stride)
+{
+    //Rows back to back, as in a full-width area, go through the kernel as one
+    if(Src_Stride == W && (UDOUBLE)W * Bits_Per_Pixel == Dst_Stride * 8)
+    {
+        EPD_IT8951_Pack_Row(Src, Dst, (UDOUBLE)W * H, Bits_Per_Pixel);
+        return;
+    }
+    for(UWORD y = 0; y < H; y++)
+        EPD_IT8951_Pack_Row(Src + (UDOUBLE)y * Src_Stride, Dst + (UDOUBLE)y * Dst_Stride, W, Bits_Per_Pixel);
+}
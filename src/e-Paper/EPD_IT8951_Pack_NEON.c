@@ -0,0 +1,76 @@
+/**
+ * @file EPD_IT8951_Pack_NEON.c
+ * @brief NEON packing kernels, built apart so they can use NEON when the
+ *        rest of the build does not.
+ *
+ * armhf toolchains default to VFP without NEON, so on 32-bit ARM the Makefile
+ * builds this file alone with -mfpu=neon. EPD_IT8951_Pack.c only calls these
+ * kernels once the CPU reports NEON in its hwcaps.
+ */
+#include "DEV_Config.h"
+
+//The same test as EPD_IT8951_Pack.c; soft-float builds have no NEON kernels
+#if defined(__aarch64__) || (defined(__arm__) && defined(__ARM_FP))
+#if defined(__arm__) && !defined(__ARM_NEON)
+#error "EPD_IT8951_Pack_NEON.c must be built with -mfpu=neon on 32-bit ARM"
+#endif
+#include <arm_neon.h>
+
+/******************************************************************************
+function :	NEON kernels
+parameter:
+Info:
+    Each packs whole blocks and returns the pixels it packed; the caller
+    packs the rest of the row with the scalar kernel.
+    The structure loads split the pixels by their place in the output byte,
+    and shift-right-insert keeps the top bits of the later pixel while
+    filling the bits below with the earlier one. 1bpp builds 4 pixel nibbles
+    that way, then packs pairs of nibbles as 4bpp does.
+******************************************************************************/
+UDOUBLE EPD_IT8951_Pack_4bp_NEON(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i;
+
+    for(i = 0; i + 32 <= Pixels; i += 32)
+    {
+        uint8x16x2_t P = vld2q_u8(Src + i);
+        vst1q_u8(Dst + i / 2, vsriq_n_u8(P.val[1], P.val[0], 4));
+    }
+    return i;
+}
+
+UDOUBLE EPD_IT8951_Pack_2bp_NEON(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i;
+
+    for(i = 0; i + 64 <= Pixels; i += 64)
+    {
+        uint8x16x4_t P = vld4q_u8(Src + i);
+        uint8x16_t Byte = vsriq_n_u8(P.val[3], P.val[2], 2);
+        Byte = vsriq_n_u8(Byte, P.val[1], 4);
+        vst1q_u8(Dst + i / 4, vsriq_n_u8(Byte, P.val[0], 6));
+    }
+    return i;
+}
+
+static inline uint8x16_t EPD_IT8951_Pack_Nibbles_NEON(const UBYTE *Src)
+{
+    //Pixels 4k..4k+3 in bits 4..7 of byte k
+    uint8x16x4_t P = vld4q_u8(Src);
+    uint8x16_t Nibble = vsriq_n_u8(P.val[3], P.val[2], 1);
+    Nibble = vsriq_n_u8(Nibble, P.val[1], 2);
+    return vsriq_n_u8(Nibble, P.val[0], 3);
+}
+
+UDOUBLE EPD_IT8951_Pack_1bp_NEON(const UBYTE *Src, UBYTE *Dst, UDOUBLE Pixels)
+{
+    UDOUBLE i;
+
+    for(i = 0; i + 128 <= Pixels; i += 128)
+    {
+        uint8x16x2_t Pairs = vuzpq_u8(EPD_IT8951_Pack_Nibbles_NEON(Src + i), EPD_IT8951_Pack_Nibbles_NEON(Src + i + 64));
+        vst1q_u8(Dst + i / 8, vsriq_n_u8(Pairs.val[1], Pairs.val[0], 4));
+    }
+    return i;
+}
+#endif
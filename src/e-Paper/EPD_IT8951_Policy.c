@@ -0,0 +1,247 @@
+/**
+ * @file EPD_IT8951_Policy.c
+ * @brief Ghosting-aware refresh policy for IT8951 panels.
+ */
+#include "EPD_IT8951_Policy.h"
+#include "EPD_IT8951_Waveform.h"
+#include "Debug.h"
+#include <stdio.h>
+#include <string.h>
+
+#define EPD_IT8951_POLICY_MAGIC "IT8951POLICY"
+#define EPD_IT8951_POLICY_VERSION 1
+
+/******************************************************************************
+function :	Map a waveform mode to the class it is counted in
+parameter:
+    Mode : waveform mode, INIT returns -1
+Info:
+    Mode numbers differ between panels, so they are looked up in the
+    current mode table; A2 is 6 on the M841 family but 4 on M641.
+******************************************************************************/
+static int EPD_IT8951_Policy_Class(UWORD Mode)
+{
+    const EPD_IT8951_Mode_Table *Modes = EPD_IT8951_GetModeTable();
+
+    if(Mode == Modes->Init)
+        return -1;
+    if(Mode == Modes->A2)
+        return EPD_IT8951_POLICY_A2;
+    if(Mode == Modes->DU || Mode == Modes->DU4)
+        return EPD_IT8951_POLICY_DU;
+    return EPD_IT8951_POLICY_GC16;
+}
+
+/******************************************************************************
+function :	Grid cells touched by a span
+parameter:
+    Pos, Len : span on the panel
+    Size     : panel side
+    First    : receives the first cell
+    Last     : receives the last cell
+******************************************************************************/
+static bool EPD_IT8951_Policy_Cells(UWORD Pos, UWORD Len, UWORD Size, UWORD *First, UWORD *Last)
+{
+    UDOUBLE End = (UDOUBLE)Pos + Len;
+    if(Len == 0 || Size == 0 || Pos >= Size)
+        return false;
+    if(End > Size)
+        End = Size;
+    *First = (UDOUBLE)Pos * EPD_IT8951_POLICY_GRID / Size;
+    *Last = (End - 1) * EPD_IT8951_POLICY_GRID / Size;
+    return true;
+}
+
+/******************************************************************************
+function :	Check that a span covers a whole grid cell
+parameter:
+******************************************************************************/
+static bool EPD_IT8951_Policy_Covers(UWORD Pos, UWORD Len, UWORD Size, UWORD Cell)
+{
+    UDOUBLE Cell_Start = (UDOUBLE)Cell * Size / EPD_IT8951_POLICY_GRID;
+    UDOUBLE Cell_End = (UDOUBLE)(Cell + 1) * Size / EPD_IT8951_POLICY_GRID;
+    return Pos <= Cell_Start && (UDOUBLE)Pos + Len >= Cell_End;
+}
+
+/******************************************************************************
+function :	Set up a policy with the default budgets
+parameter:
+******************************************************************************/
+void EPD_IT8951_Policy_Init(EPD_IT8951_Policy *Policy, UWORD Panel_W, UWORD Panel_H)
+{
+    memset(Policy, 0, sizeof(*Policy));
+    Policy->Panel_W = Panel_W;
+    Policy->Panel_H = Panel_H;
+    EPD_IT8951_Policy_SetBudget(Policy, EPD_IT8951_POLICY_BUDGET_GC16, EPD_IT8951_POLICY_BUDGET_DU, EPD_IT8951_POLICY_BUDGET_A2);
+    //Nothing is known about what the panel shows yet
+    Policy->Clear_Requested = true;
+}
+
+/******************************************************************************
+function :	Change the budgets
+parameter:
+******************************************************************************/
+void EPD_IT8951_Policy_SetBudget(EPD_IT8951_Policy *Policy, UWORD GC16, UWORD DU, UWORD A2)
+{
+    Policy->Budget[EPD_IT8951_POLICY_GC16] = GC16;
+    Policy->Budget[EPD_IT8951_POLICY_DU] = DU;
+    Policy->Budget[EPD_IT8951_POLICY_A2] = A2;
+}
+
+/******************************************************************************
+function :	Ask for a clear before the next update
+parameter:
+******************************************************************************/
+void EPD_IT8951_Policy_RequestClear(EPD_IT8951_Policy *Policy)
+{
+    Policy->Clear_Requested = true;
+}
+
+/******************************************************************************
+function :	Check whether an update would overrun a region's budget
+parameter:
+******************************************************************************/
+bool EPD_IT8951_Policy_NeedsClear(const EPD_IT8951_Policy *Policy, UWORD X, UWORD Y, UWORD W, UWORD H, UWORD Mode)
+{
+    int Class = EPD_IT8951_Policy_Class(Mode);
+    UWORD X0, X1, Y0, Y1;
+
+    //An INIT update is a clear by itself
+    if(Class < 0)
+        return false;
+    if(Policy->Clear_Requested)
+        return true;
+    if(!EPD_IT8951_Policy_Cells(X, W, Policy->Panel_W, &X0, &X1) ||
+       !EPD_IT8951_Policy_Cells(Y, H, Policy->Panel_H, &Y0, &Y1))
+        return false;
+
+    for(UWORD y = Y0; y <= Y1; y++)
+        for(UWORD x = X0; x <= X1; x++)
+            if(Policy->Count[y][x][Class] >= Policy->Budget[Class])
+                return true;
+    return false;
+}
+
+/******************************************************************************
+function :	Count an update in every region it touched
+parameter:
+******************************************************************************/
+void EPD_IT8951_Policy_Record(EPD_IT8951_Policy *Policy, UWORD X, UWORD Y, UWORD W, UWORD H, UWORD Mode)
+{
+    int Class = EPD_IT8951_Policy_Class(Mode);
+    UWORD X0, X1, Y0, Y1;
+
+    if(!EPD_IT8951_Policy_Cells(X, W, Policy->Panel_W, &X0, &X1) ||
+       !EPD_IT8951_Policy_Cells(Y, H, Policy->Panel_H, &Y0, &Y1))
+        return;
+
+    if(Class < 0)
+    {
+        //Partly covered regions keep the ghosts of their uncovered part
+        for(UWORD y = Y0; y <= Y1; y++)
+        {
+            if(!EPD_IT8951_Policy_Covers(Y, H, Policy->Panel_H, y))
+                continue;
+            for(UWORD x = X0; x <= X1; x++)
+                if(EPD_IT8951_Policy_Covers(X, W, Policy->Panel_W, x))
+                    memset(Policy->Count[y][x], 0, sizeof(Policy->Count[y][x]));
+        }
+        if(X == 0 && Y == 0 && W >= Policy->Panel_W && H >= Policy->Panel_H)
+        {
+            Policy->Clear_Requested = false;
+            Policy->Clears++;
+        }
+        return;
+    }
+
+    for(UWORD y = Y0; y <= Y1; y++)
+        for(UWORD x = X0; x <= X1; x++)
+            if(Policy->Count[y][x][Class] < 0xFFFF)
+                Policy->Count[y][x][Class]++;
+    Policy->Updates++;
+}
+
+/******************************************************************************
+function :	Load the counts of a previous run
+parameter:
+******************************************************************************/
+int EPD_IT8951_Policy_Load(EPD_IT8951_Policy *Policy, const char *Path)
+{
+    FILE *fp = fopen(Path, "r");
+    char Magic[16];
+    int Version, Grid, Clear_Requested;
+    unsigned int W, H;
+    unsigned long Updates, Clears;
+    UWORD Count[EPD_IT8951_POLICY_GRID][EPD_IT8951_POLICY_GRID][EPD_IT8951_POLICY_CLASSES];
+
+    if(fp == NULL)
+    {
+        EPD_LOG_INFO("No refresh policy state at %s, clearing first", Path);
+        Policy->Clear_Requested = true;
+        return -1;
+    }
+
+    if(fscanf(fp, "%15s %d %u %u %d %d %lu %lu", Magic, &Version, &W, &H, &Grid, &Clear_Requested, &Updates, &Clears) != 8 ||
+       strcmp(Magic, EPD_IT8951_POLICY_MAGIC) != 0 || Version != EPD_IT8951_POLICY_VERSION ||
+       Grid != EPD_IT8951_POLICY_GRID ||
+       ((Policy->Panel_W != 0 || Policy->Panel_H != 0) && (W != Policy->Panel_W || H != Policy->Panel_H)))
+    {
+        EPD_LOG_WARN("Refresh policy state at %s does not match this panel, clearing first", Path);
+        fclose(fp);
+        Policy->Clear_Requested = true;
+        return -2;
+    }
+
+    for(int y = 0; y < EPD_IT8951_POLICY_GRID; y++)
+        for(int x = 0; x < EPD_IT8951_POLICY_GRID; x++)
+            for(int c = 0; c < EPD_IT8951_POLICY_CLASSES; c++)
+            {
+                unsigned int Value;
+                if(fscanf(fp, "%u", &Value) != 1 || Value > 0xFFFF)
+                {
+                    EPD_LOG_WARN("Refresh policy state at %s is truncated, clearing first", Path);
+                    fclose(fp);
+                    Policy->Clear_Requested = true;
+                    return -3;
+                }
+                Count[y][x][c] = Value;
+            }
+    fclose(fp);
+
+    memcpy(Policy->Count, Count, sizeof(Count));
+    Policy->Panel_W = W;
+    Policy->Panel_H = H;
+    Policy->Clear_Requested = Clear_Requested != 0;
+    Policy->Updates = Updates;
+    Policy->Clears = Clears;
+    return 0;
+}
+
+/******************************************************************************
+function :	Save the counts for the next run
+parameter:
+******************************************************************************/
+int EPD_IT8951_Policy_Save(const EPD_IT8951_Policy *Policy, const char *Path)
+{
+    FILE *fp = fopen(Path, "w");
+    if(fp == NULL)
+    {
+        EPD_LOG_WARN("Cannot write refresh policy state to %s", Path);
+        return -1;
+    }
+
+    fprintf(fp, "%s %d %u %u %d %d %lu %lu\n", EPD_IT8951_POLICY_MAGIC, EPD_IT8951_POLICY_VERSION,
+            Policy->Panel_W, Policy->Panel_H, EPD_IT8951_POLICY_GRID, Policy->Clear_Requested ? 1 : 0,
+            (unsigned long)Policy->Updates, (unsigned long)Policy->Clears);
+    for(int y = 0; y < EPD_IT8951_POLICY_GRID; y++)
+    {
+        for(int x = 0; x < EPD_IT8951_POLICY_GRID; x++)
+            for(int c = 0; c < EPD_IT8951_POLICY_CLASSES; c++)
+                fprintf(fp, "%u ", Policy->Count[y][x][c]);
+        fprintf(fp, "\n");
+    }
+
+    if(fclose(fp) != 0)
+        return -2;
+    return 0;
+}
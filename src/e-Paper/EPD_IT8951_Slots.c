@@ -0,0 +1,145 @@
+/**
+ * @file EPD_IT8951_Slots.c
+ * @brief Frames preloaded into spare IT8951 SDRAM.
+ */
+#include "EPD_IT8951_Slots.h"
+#include "Debug.h"
+#include <string.h>
+
+/******************************************************************************
+function :	Lay out the slots after the panel's image buffer
+parameter:
+    Memory_End : first address past the usable SDRAM
+******************************************************************************/
+int EPD_IT8951_Slots_Init(EPD_IT8951_Slots *Slots, IT8951_Dev_Info Dev_Info, UDOUBLE Memory_End)
+{
+    UDOUBLE Base = Dev_Info.Memory_Addr_L | ((UDOUBLE)Dev_Info.Memory_Addr_H << 16);
+    UDOUBLE Frame_Bytes = (UDOUBLE)Dev_Info.Panel_W * Dev_Info.Panel_H;
+    UDOUBLE First;
+
+    memset(Slots, 0, sizeof(*Slots));
+    Slots->Panel_W = Dev_Info.Panel_W;
+    Slots->Panel_H = Dev_Info.Panel_H;
+    Slots->Slot_Bytes = (Frame_Bytes + EPD_IT8951_SLOT_ALIGN - 1) & ~(UDOUBLE)(EPD_IT8951_SLOT_ALIGN - 1);
+
+    //The panel's own buffer stays untouched for normal drawing
+    First = (Base + Frame_Bytes + EPD_IT8951_SLOT_ALIGN - 1) & ~(UDOUBLE)(EPD_IT8951_SLOT_ALIGN - 1);
+    if(Frame_Bytes == 0 || First >= Memory_End || Memory_End - First < Slots->Slot_Bytes)
+    {
+        EPD_LOG_WARN("No room for preloaded frames between 0x%lX and 0x%lX", (unsigned long)First, (unsigned long)Memory_End);
+        return EPD_IT8951_SLOTS_ERR_NO_ROOM;
+    }
+
+    while(Slots->Count < EPD_IT8951_SLOTS_MAX && Memory_End - First >= (UDOUBLE)(Slots->Count + 1) * Slots->Slot_Bytes)
+    {
+        Slots->Slot[Slots->Count].Addr = First + Slots->Count * Slots->Slot_Bytes;
+        Slots->Count++;
+    }
+    EPD_LOG_INFO("%u frame slots of %lu bytes from 0x%lX", Slots->Count, (unsigned long)Slots->Slot_Bytes, (unsigned long)First);
+    return Slots->Count;
+}
+
+/******************************************************************************
+function :	Find the slot holding a frame
+parameter:
+******************************************************************************/
+int EPD_IT8951_Slots_Find(const EPD_IT8951_Slots *Slots, UDOUBLE Key)
+{
+    for(int i = 0; i < Slots->Count; i++)
+        if(Slots->Slot[i].Valid && Slots->Slot[i].Key == Key)
+            return i;
+    return -1;
+}
+
+/******************************************************************************
+function :	Pick the slot for a new frame: a free one, else the least recently used
+parameter:
+******************************************************************************/
+static int EPD_IT8951_Slots_Victim(const EPD_IT8951_Slots *Slots)
+{
+    int Victim = 0;
+    for(int i = 0; i < Slots->Count; i++)
+    {
+        if(!Slots->Slot[i].Valid)
+            return i;
+        if(Slots->Slot[i].Last_Used < Slots->Slot[Victim].Last_Used)
+            Victim = i;
+    }
+    return Victim;
+}
+
+/******************************************************************************
+function :	Upload a frame into a slot
+parameter:
+******************************************************************************/
+int EPD_IT8951_Slots_Preload(EPD_IT8951_Slots *Slots, UDOUBLE Key, UBYTE *Frame_Buf, UBYTE Bits_Per_Pixel)
+{
+    int Index, Ret;
+    UWORD W, H;
+    EPD_IT8951_Slot *Slot;
+
+    if(Slots->Count == 0)
+        return EPD_IT8951_SLOTS_ERR_NO_ROOM;
+
+    Index = EPD_IT8951_Slots_Find(Slots, Key);
+    if(Index < 0)
+    {
+        Index = EPD_IT8951_Slots_Victim(Slots);
+        if(Slots->Slot[Index].Valid)
+        {
+            EPD_LOG_DEBUG("Evicting frame %lu from slot %d", (unsigned long)Slots->Slot[Index].Key, Index);
+            Slots->Evictions++;
+        }
+    }
+    Slot = &Slots->Slot[Index];
+
+    //A frame drawn for a rotated panel is loaded with its own width
+    W = Slots->Panel_W;
+    H = Slots->Panel_H;
+    if(EPD_IT8951_GetRotate() == 90 || EPD_IT8951_GetRotate() == 270)
+    {
+        W = Slots->Panel_H;
+        H = Slots->Panel_W;
+    }
+
+    //A failed upload leaves the slot half written
+    Slot->Valid = false;
+    Ret = EPD_IT8951_Area_Load(Frame_Buf, 0, 0, W, H, Bits_Per_Pixel, Slot->Addr);
+    if(Ret != 0)
+        return Ret;
+
+    Slot->Key = Key;
+    Slot->Valid = true;
+    Slot->Last_Used = ++Slots->Clock;
+    Slots->Preloads++;
+    return Index;
+}
+
+/******************************************************************************
+function :	Show a preloaded frame
+parameter:
+******************************************************************************/
+int EPD_IT8951_Slots_Show(EPD_IT8951_Slots *Slots, UDOUBLE Key, UWORD Mode)
+{
+    int Index = EPD_IT8951_Slots_Find(Slots, Key);
+    if(Index < 0)
+    {
+        Slots->Misses++;
+        return EPD_IT8951_SLOTS_ERR_MISSING;
+    }
+
+    Slots->Hits++;
+    Slots->Slot[Index].Last_Used = ++Slots->Clock;
+    return EPD_IT8951_Buffer_Refresh(0, 0, Slots->Panel_W, Slots->Panel_H, Mode, Slots->Slot[Index].Addr);
+}
+
+/******************************************************************************
+function :	Forget a frame
+parameter:
+******************************************************************************/
+void EPD_IT8951_Slots_Drop(EPD_IT8951_Slots *Slots, UDOUBLE Key)
+{
+    int Index = EPD_IT8951_Slots_Find(Slots, Key);
+    if(Index >= 0)
+        Slots->Slot[Index].Valid = false;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file EPD_IT8951_Waveform.c
+ * @brief Waveform mode tables and the update classifier.
+ */
+#include "EPD_IT8951_Waveform.h"
+#include "Debug.h"
+#include <string.h>
+
+//Globals from EPD_IT8951.c, kept in step with the table
+extern UBYTE INIT_Mode;
+extern UBYTE GC16_Mode;
+extern UBYTE A2_Mode;
+
+typedef struct {
+    const char *LUT;
+    EPD_IT8951_Mode_Table Modes;
+} EPD_IT8951_Panel_Modes;
+
+//M641 ships with the 6" (800x600) panels and has five modes;
+//the M841 family (6" HD, 7.8", 9.7", 10.3") has all eight
+static const EPD_IT8951_Panel_Modes Panel_Modes[] = {
+    { "M641", { 0, 1, 2, 3, 3, 3, 4, 1 } },
+};
+static const EPD_IT8951_Mode_Table Default_Modes = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+static EPD_IT8951_Mode_Table Modes = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+/******************************************************************************
+function :	Replace the mode table
+parameter:
+******************************************************************************/
+void EPD_IT8951_SetModeTable(const EPD_IT8951_Mode_Table *Table)
+{
+    Modes = *Table;
+    INIT_Mode = Modes.Init;
+    GC16_Mode = Modes.GC16;
+    A2_Mode = Modes.A2;
+}
+
+/******************************************************************************
+function :	Get the current mode table
+parameter:
+******************************************************************************/
+const EPD_IT8951_Mode_Table *EPD_IT8951_GetModeTable(void)
+{
+    return &Modes;
+}
+
+/******************************************************************************
+function :	Pick the mode table from the panel's LUT version
+parameter:
+******************************************************************************/
+void EPD_IT8951_Waveform_SelectTable(const IT8951_Dev_Info *Dev_Info)
+{
+    char LUT[sizeof(Dev_Info->LUT_Version) + 1];
+
+    memcpy(LUT, Dev_Info->LUT_Version, sizeof(Dev_Info->LUT_Version));
+    LUT[sizeof(Dev_Info->LUT_Version)] = '\0';
+
+    for(size_t i = 0; i < sizeof(Panel_Modes) / sizeof(Panel_Modes[0]); i++)
+    {
+        if(strcmp(LUT, Panel_Modes[i].LUT) == 0)
+        {
+            EPD_LOG_INFO("Waveform modes for LUT %s", LUT);
+            EPD_IT8951_SetModeTable(&Panel_Modes[i].Modes);
+            return;
+        }
+    }
+    EPD_LOG_DEBUG("Default waveform modes for LUT '%s'", LUT);
+    EPD_IT8951_SetModeTable(&Default_Modes);
+}
+
+/******************************************************************************
+function :	Mode number of a waveform class
+parameter:
+******************************************************************************/
+UWORD EPD_IT8951_Waveform_Mode(EPD_IT8951_Wave Wave)
+{
+    switch(Wave)
+    {
+        case EPD_IT8951_WAVE_A2:
+            return Modes.A2;
+        case EPD_IT8951_WAVE_GL16:
+            return Modes.GL16;
+        case EPD_IT8951_WAVE_GC16:
+            return Modes.GC16;
+        default:
+            return Modes.DU;
+    }
+}
+
+/******************************************************************************
+function :	Find the fastest waveform class for an update
+parameter:
+    Old : pixels on the panel, NULL if unknown
+Info:
+    Only changed pixels limit the mode; unchanged pixels are not driven by
+    A2 or DU. The white share covers the whole new area. At 8bpp the panel
+    shows the high nibble, so 0x0? is black and 0xF? white.
+******************************************************************************/
+EPD_IT8951_Wave EPD_IT8951_Waveform_Classify(const UBYTE *Old, const UBYTE *New, UWORD W, UWORD H,
+                                             UBYTE Bits_Per_Pixel, UDOUBLE Stride)
+{
+    UBYTE Mask = (1 << Bits_Per_Pixel) - 1;
+    UBYTE Level_Shift = (Bits_Per_Pixel == 8) ? 4 : 0;
+    UBYTE White = Mask >> Level_Shift;
+    UBYTE Pixels_Per_Byte = 8 / Bits_Per_Pixel;
+    UDOUBLE Whites = 0, Changed = 0;
+    bool To_Mono = true, From_Mono = (Old != NULL);
+
+    for(UWORD y = 0; y < H; y++)
+    {
+        const UBYTE *New_Row = New + (UDOUBLE)y * Stride;
+        const UBYTE *Old_Row = (Old != NULL) ? Old + (UDOUBLE)y * Stride : NULL;
+
+        for(UWORD x = 0; x < W; x += Pixels_Per_Byte)
+        {
+            UBYTE New_Byte = New_Row[x / Pixels_Per_Byte];
+            UBYTE Count = (W - x < Pixels_Per_Byte) ? W - x : Pixels_Per_Byte;
+
+            //Whole bytes of unchanged pixels only add to the white share
+            if(Old_Row != NULL && Old_Row[x / Pixels_Per_Byte] == New_Byte && Count == Pixels_Per_Byte)
+            {
+                if(New_Byte == 0xFF)
+                {
+                    Whites += Pixels_Per_Byte;
+                    continue;
+                }
+                for(UBYTE i = 0; i < Count; i++)
+                    if((((New_Byte >> (i * Bits_Per_Pixel)) & Mask) >> Level_Shift) == White)
+                        Whites++;
+                continue;
+            }
+
+            for(UBYTE i = 0; i < Count; i++)
+            {
+                UBYTE New_Pixel = ((New_Byte >> (i * Bits_Per_Pixel)) & Mask) >> Level_Shift;
+                UBYTE Old_Pixel;
+
+                if(New_Pixel == White)
+                    Whites++;
+                if(Old_Row != NULL)
+                {
+                    Old_Pixel = ((Old_Row[x / Pixels_Per_Byte] >> (i * Bits_Per_Pixel)) & Mask) >> Level_Shift;
+                    if(Old_Pixel == New_Pixel)
+                        continue;
+                    if(Old_Pixel != 0 && Old_Pixel != White)
+                        From_Mono = false;
+                }
+                Changed++;
+                if(New_Pixel != 0 && New_Pixel != White)
+                    To_Mono = false;
+            }
+        }
+    }
+
+    if(Changed == 0)
+        return EPD_IT8951_WAVE_NONE;
+    if(To_Mono && From_Mono)
+        return EPD_IT8951_WAVE_A2;
+    if(To_Mono)
+        return EPD_IT8951_WAVE_DU;
+    if(Whites * 100 >= (UDOUBLE)W * H * EPD_IT8951_WAVE_TEXT_WHITE_PCT)
+        return EPD_IT8951_WAVE_GL16;
+    return EPD_IT8951_WAVE_GC16;
+}
@@ -2,11 +2,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <libgen.h>
 #include "../include/EPD_IT8951.h"
+#include "../include/GUI_BMPfile.h"
+#include "../include/GUI_Image.h"
 #include "../include/Debug.h"
 #include "../include/DEV_Config.h"
+#include "../include/epdrawd_protocol.h"
 
 #define MAX_PATH 1024
 #define MAX_CMD 2048
@@ -28,30 +36,31 @@ int is_bmp_file(const char *filename) {
 }
 
 /**
- * @brief Check if ImageMagick is available (try both 'magick' and 'convert' commands)
- * @return 1 if available, 0 if not
+ * @brief Get the ImageMagick command, probed once and cached
+ * @return "magick", "convert", or NULL if neither is installed
  */
-int check_imagemagick() {
-    // Try modern 'magick' command first
-    if (system("magick --version > /dev/null 2>&1") == 0) {
-        return 1;
-    }
-    // Try legacy 'convert' command
-    if (system("convert --version > /dev/null 2>&1") == 0) {
-        return 1;
+const char* get_imagemagick_cmd() {
+    static int probed = 0;
+    static const char *magick_cmd = NULL;
+
+    if (!probed) {
+        probed = 1;
+        // Try modern 'magick' command first, then legacy 'convert'
+        if (system("magick --version > /dev/null 2>&1") == 0) {
+            magick_cmd = "magick";
+        } else if (system("convert --version > /dev/null 2>&1") == 0) {
+            magick_cmd = "convert";
+        }
     }
-    return 0;
+    return magick_cmd;
 }
 
 /**
- * @brief Get the appropriate ImageMagick command
- * @return "magick" or "convert" depending on what's available
+ * @brief Check if ImageMagick is available (either 'magick' or 'convert')
+ * @return 1 if available, 0 if not
  */
-const char* get_imagemagick_cmd() {
-    if (system("magick --version > /dev/null 2>&1") == 0) {
-        return "magick";
-    }
-    return "convert";
+int check_imagemagick() {
+    return get_imagemagick_cmd() != NULL;
 }
 
 /**
@@ -59,7 +68,7 @@ const char* get_imagemagick_cmd() {
  * @param input_path Path to input image (any format supported by ImageMagick)
  * @param output_path Path for output BMP file
  * @param rotation Rotation in degrees (-90, 0, 90, 180)
- * @param colors Number of colors (16 for grayscale, 256 for color)
+ * @param colors 16 for grayscale (kept at 256 grays, dithered when drawn), 256 for color
  * @param mirror 1 for horizontal mirroring, 0 for no mirroring
  * @return 0 on success, -1 on failure
  */
@@ -67,17 +76,21 @@ int convert_image_to_bmp(const char *input_path, const char *output_path, int ro
     char cmd[MAX_CMD];
     const char* magick_cmd = get_imagemagick_cmd();
     
+    if (magick_cmd == NULL) {
+        return -1;
+    }
+    
     // Build ImageMagick command with appropriate settings
     if (colors == 16) {
-        // Grayscale conversion with dithering, force 4bpp BMP output
+        // 8 bit grayscale, undithered; the BMP loader dithers to the panel's levels
         if (mirror) {
             snprintf(cmd, sizeof(cmd), 
-                "%s \"%s\" -colors %d -dither FloydSteinberg -colorspace Gray -type Palette -define bmp:format=bmp3 -depth 4 -rotate %d -flop \"%s\"",
-                magick_cmd, input_path, colors, rotation, output_path);
+                "%s \"%s\" -colorspace Gray -type Grayscale -define bmp:format=bmp3 -depth 8 -rotate %d -flop \"%s\"",
+                magick_cmd, input_path, rotation, output_path);
         } else {
             snprintf(cmd, sizeof(cmd), 
-                "%s \"%s\" -colors %d -dither FloydSteinberg -colorspace Gray -type Palette -define bmp:format=bmp3 -depth 4 -rotate %d \"%s\"",
-                magick_cmd, input_path, colors, rotation, output_path);
+                "%s \"%s\" -colorspace Gray -type Grayscale -define bmp:format=bmp3 -depth 8 -rotate %d \"%s\"",
+                magick_cmd, input_path, rotation, output_path);
         }
     } else {
         // Color conversion (for color e-Paper)
@@ -103,6 +116,97 @@ int convert_image_to_bmp(const char *input_path, const char *output_path, int ro
     return 0;
 }
 
+/**
+ * @brief Print a description of a DisplayBMP/daemon error code
+ * @param result Negative error code
+ */
+void print_display_error(int result) {
+    fprintf(stderr, "epdraw: ERROR: Failed to display image (error code %d)\n", result);
+    if (result == -10) fprintf(stderr, "epdraw: ERROR: Failed to initialize display or get panel info\n");
+    else if (result == -11) fprintf(stderr, "epdraw: ERROR: Out of memory allocating display buffer\n");
+    else if (result == -12) fprintf(stderr, "epdraw: ERROR: Invalid bit depth\n");
+    else if (result == -13) fprintf(stderr, "epdraw: ERROR: Display controller stopped responding (BUSY timeout)\n");
+    else if (result == EPDRAWD_ERR_PROTOCOL) fprintf(stderr, "epdraw: ERROR: Daemon rejected the request\n");
+    else if (result == EPDRAWD_ERR_NO_REFRESH) fprintf(stderr, "epdraw: ERROR: Display did not report refresh completion\n");
+    else if (result == -1) fprintf(stderr, "epdraw: ERROR: BMP file not found or could not be opened\n");
+    else if (result == -2) fprintf(stderr, "epdraw: ERROR: BMP file header read error\n");
+    else if (result == -3) fprintf(stderr, "epdraw: ERROR: Not a BMP, PNG or JPEG file\n");
+    else if (result == -4) fprintf(stderr, "epdraw: ERROR: BMP info header read error\n");
+    else if (result == -5) fprintf(stderr, "epdraw: ERROR: BMP palette read error or out of memory\n");
+    else if (result == GUI_IMAGE_ERR_DECODE) fprintf(stderr, "epdraw: ERROR: Image data damaged or truncated\n");
+    // Add more as needed
+}
+
+/**
+ * @brief Hand a BMP, PNG or JPEG file to a running epdrawd
+ * @param image_path Path to the image file (resolved to an absolute path)
+ * @param mode Display mode
+ * @param force_clear 1 to clear the panel with INIT mode first
+ * @param dither Dithering the daemon draws the image with
+ * @param transform Rotation and mirroring for PNG and JPEG files (EPDRAWD_TRANSFORM_*)
+ * @param result Receives the daemon's status
+ * @return 0 if the daemon served the request, -1 if no daemon is reachable
+ */
+int display_via_daemon(const char *image_path, int mode, int force_clear, DITHER_MODE dither, int transform, int *result) {
+    char abs_path[PATH_MAX];
+    struct sockaddr_un addr;
+    const char *socket_path = epdrawd_socket_path();
+    struct timespec t0, t1;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path) || realpath(image_path, abs_path) == NULL) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    // Report a daemon that goes away mid-request instead of dying on the write
+    signal(SIGPIPE, SIG_IGN);
+
+    EPDRAWD_Request req;
+    EPDRAWD_Response resp;
+    memset(&req, 0, sizeof(req));
+    req.Magic = EPDRAWD_MAGIC;
+    req.Type = EPDRAWD_REQ_FILE;
+    req.Mode = mode;
+    req.Flags = force_clear ? EPDRAWD_FLAG_CLEAR : 0;
+    req.Dither = dither;
+    req.Transform = transform;
+    req.Payload_Len = strlen(abs_path) + 1;
+
+    printf("epdraw: Sending %s to daemon at %s\n", abs_path, socket_path);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (epdrawd_write_full(fd, &req, sizeof(req), NULL) != 0 ||
+        epdrawd_write_full(fd, abs_path, req.Payload_Len, NULL) != 0 ||
+        epdrawd_read_full(fd, &resp, sizeof(resp), NULL) != 0 ||
+        resp.Magic != EPDRAWD_MAGIC) {
+        // The daemon may have served part of the request, so do not redo it locally
+        fprintf(stderr, "epdraw: ERROR: Lost connection to daemon\n");
+        close(fd);
+        *result = EPDRAWD_ERR_PROTOCOL;
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    close(fd);
+
+    long round_trip_ms = (t1.tv_sec - t0.tv_sec) * 1000 + (t1.tv_nsec - t0.tv_nsec) / 1000000;
+    if (resp.Clear_us != 0) {
+        printf("Panel cleared with INIT mode (refresh policy) in %u ms\n", resp.Clear_us / 1000);
+    }
+    printf("Daemon latency: draw %u ms, refresh %u ms, total %u ms (round trip %ld ms)\n",
+           resp.Draw_us / 1000, resp.Refresh_us / 1000, resp.Total_us / 1000, round_trip_ms);
+    *result = resp.Status;
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     // Initialize logging system
@@ -118,25 +222,53 @@ int main(int argc, char *argv[])
         log_init(log_level);
     }
 
-    // --- Parse --stay-awake flag ---
+    // --- Parse option flags ---
     int stay_awake = 0;
-    int arg_offset = 0;
+    int use_daemon = 1;
+    int force_clear = 0;
+    int clear_budget = -1;
+    const char *policy_state = EPD_IT8951_POLICY_STATE_PATH;
+    DITHER_MODE dither = DITHER_FLOYD_STEINBERG;
     for (int i = 1; i < argc; ++i) {
+        int consumed = 1;
         if (strcmp(argv[i], "--stay-awake") == 0) {
             stay_awake = 1;
-            // Remove the flag from argv for positional parsing
-            for (int j = i; j < argc - 1; ++j) {
-                argv[j] = argv[j + 1];
+        } else if (strcmp(argv[i], "--no-daemon") == 0) {
+            use_daemon = 0;
+        } else if (strcmp(argv[i], "--clear") == 0) {
+            force_clear = 1;
+        } else if (strcmp(argv[i], "--clear-budget") == 0 && i + 1 < argc) {
+            clear_budget = atoi(argv[i + 1]);
+            consumed = 2;
+        } else if (strcmp(argv[i], "--policy-state") == 0 && i + 1 < argc) {
+            policy_state = argv[i + 1];
+            consumed = 2;
+        } else if (strcmp(argv[i], "--dither") == 0 && i + 1 < argc) {
+            if (Dither_ParseMode(argv[i + 1], &dither) != 0) {
+                fprintf(stderr, "Error: Unknown dithering '%s'. Use none, bayer, fs or atkinson.\n", argv[i + 1]);
+                return 2;
             }
-            argc--;
-            break;
+            consumed = 2;
+        } else {
+            continue;
         }
+        // Remove the flag from argv for positional parsing
+        for (int j = i; j + consumed < argc; ++j) {
+            argv[j] = argv[j + consumed];
+        }
+        argc -= consumed;
+        i--;
     }
 
     if (argc < 2 || (argc == 2 && (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0))) {
-        printf("Usage: epdraw [--stay-awake] <image_path> [vcom] [mode]\n");
+        printf("Usage: epdraw [--stay-awake] [--no-daemon] [--clear] [--clear-budget <n>] [--policy-state <file>] [--dither <method>] <image_path> [vcom] [mode]\n");
         printf("  [--stay-awake]: Do not put the display to sleep after update (default: sleep after update)\n");
-        printf("  <image_path>: Path to image file (any format: PNG, JPG, BMP, etc. - will be auto-converted)\n");
+        printf("  [--no-daemon]: Drive the display directly even if epdrawd is running\n");
+        printf("  [--clear]: Clear the panel with INIT mode before this image\n");
+        printf("  [--clear-budget <n>]: Images drawn between INIT clears (default: %d, 0: clear every time)\n", EPD_IT8951_POLICY_BUDGET_GC16);
+        printf("  [--policy-state <file>]: Where the update counts are kept between runs (default: %s)\n", EPD_IT8951_POLICY_STATE_PATH);
+        printf("  [--dither <method>]: none, bayer, fs (Floyd-Steinberg, default) or atkinson, to the panel's gray levels\n");
+        printf("  <image_path>: Path to image file (BMP, PNG and baseline JPEG are drawn directly; other formats are converted with ImageMagick)\n");
         printf("  [vcom]: VCOM voltage (default: 0, use panel default)\n");
         printf("          Can be integer (2510) or float (-1.18V)\n");
         printf("  [mode]: Display mode (default: 2, GC16)\n");
@@ -152,9 +284,14 @@ int main(int argc, char *argv[])
         printf("  - Rotation and mirroring\n");
         printf("  - Color vs grayscale mode\n");
         printf("\nExamples:\n");
-        printf("  epdraw photo.jpg                    # Any image format, auto-converted and displayed\n");
+        printf("  epdraw photo.jpg                    # PNG or JPEG, decoded in process and displayed\n");
+        printf("  epdraw drawing.webp                 # Other formats, converted with ImageMagick\n");
         printf("  epdraw --stay-awake photo.png -1.18 2 # Custom VCOM (-1.18V), mode, and stay awake\n");
         printf("  epdraw image.bmp                    # Direct BMP display (no conversion needed)\n");
+        printf("\nThe panel is only cleared with INIT mode when --clear is given or the clear budget\n");
+        printf("runs out, instead of before every image.\n");
+        printf("\nIf epdrawd is listening on $%s (default %s), the image is handed to it\n", EPDRAWD_SOCKET_ENV, EPDRAWD_SOCKET_PATH);
+        printf("and the panel stays initialized; VCOM, --stay-awake and the clear budget are then up to the daemon.\n");
         return 1;
     }
     
@@ -192,21 +329,47 @@ int main(int argc, char *argv[])
         return 2;
     }
     
-    char bmp_path[MAX_PATH];
+    // Rotation and colors the image is prepared with, by mode
+    int rotation = -90; // Default e-Paper rotation
+    int colors = 16;    // Default grayscale
+    int mirror = 0;
+    if (mode == 3) {
+        colors = 256; // Color mode
+    }
+    // For mode 2, enable horizontal mirroring
+    if (mode == 2) {
+        mirror = 1;
+        rotation = 90; // Keep previous logic if needed
+    } else if (mode == 1 || mode == 6) {
+        // Optionally keep mirroring for these modes if desired
+        mirror = 1;
+        rotation = 90;
+    }
+
+    char draw_path[MAX_PATH];
     int need_conversion = 0;
+    int transform = 0;
     
     // Check if input is already a BMP file
     if (is_bmp_file(input_path)) {
-        strncpy(bmp_path, input_path, sizeof(bmp_path) - 1);
-        bmp_path[sizeof(bmp_path) - 1] = '\0';
-        printf("Using existing BMP file: %s\n", bmp_path);
+        strncpy(draw_path, input_path, sizeof(draw_path) - 1);
+        draw_path[sizeof(draw_path) - 1] = '\0';
+        printf("Using existing BMP file: %s\n", draw_path);
+    } else if (GUI_CheckImage(input_path) == 0) {
+        // PNG and baseline JPEG are decoded, rotated and mirrored in memory
+        strncpy(draw_path, input_path, sizeof(draw_path) - 1);
+        draw_path[sizeof(draw_path) - 1] = '\0';
+        GUI_SetImageTransform(rotation, mirror);
+        transform = ((rotation / 90) & EPDRAWD_TRANSFORM_ROTATE_MASK) | (mirror ? EPDRAWD_TRANSFORM_MIRROR : 0);
+        printf("Decoding %s in process (rotation: %d°, mirror: %d)\n", draw_path, rotation, mirror);
     } else {
         // Need to convert the image
         need_conversion = 1;
         
         // Check if ImageMagick is available
         if (!check_imagemagick()) {
-            fprintf(stderr, "Error: ImageMagick not found. Please install ImageMagick:\n");
+            fprintf(stderr, "Error: ImageMagick not found. PNG and baseline JPEG files are drawn without it;\n");
+            fprintf(stderr, "for other formats, please install ImageMagick:\n");
             fprintf(stderr, "  Ubuntu/Debian: sudo apt-get install imagemagick\n");
             fprintf(stderr, "  macOS: brew install imagemagick\n");
             fprintf(stderr, "  Or provide a BMP file directly.\n");
@@ -223,43 +386,41 @@ int main(int argc, char *argv[])
         char *dot = strrchr(base, '.');
         if (dot) *dot = '\0';
         
-        snprintf(bmp_path, sizeof(bmp_path), "%s/%s.bmp", dir, base);
+        snprintf(draw_path, sizeof(draw_path), "%s/%s.bmp", dir, base);
         free(input_copy);
         free(base_copy);
         
-        // Determine rotation and colors based on mode
-        int rotation = -90; // Default e-Paper rotation
-        int colors = 16;    // Default grayscale
-        int mirror = 0;
-        if (mode == 3) {
-            colors = 256; // Color mode
-        }
-        // For mode 2, enable horizontal mirroring
-        if (mode == 2) {
-            mirror = 1;
-            rotation = 90; // Keep previous logic if needed
-        } else if (mode == 1 || mode == 6) {
-            // Optionally keep mirroring for these modes if desired
-            mirror = 1;
-            rotation = 90;
-        }
-        printf("Converting %s to %s (rotation: %d°, colors: %d, mirror: %d)...\n", input_path, bmp_path, rotation, colors, mirror);
+        printf("Converting %s to %s (rotation: %d°, colors: %d, mirror: %d)...\n", input_path, draw_path, rotation, colors, mirror);
         
         // Convert the image
-        if (convert_image_to_bmp(input_path, bmp_path, rotation, colors, mirror) != 0) {
+        if (convert_image_to_bmp(input_path, draw_path, rotation, colors, mirror) != 0) {
             fprintf(stderr, "Error: Failed to convert image\n");
             return 2;
         }
     }
     
-    // Check if the BMP file exists before proceeding
-    FILE *fp = fopen(bmp_path, "rb");
+    // Check if the image file exists before proceeding
+    FILE *fp = fopen(draw_path, "rb");
     if (!fp) {
-        fprintf(stderr, "Error: BMP file '%s' not found or not readable.\n", bmp_path);
+        fprintf(stderr, "Error: Image file '%s' not found or not readable.\n", draw_path);
         return 2;
     }
     fclose(fp);
     
+    int result;
+    if (use_daemon && display_via_daemon(draw_path, mode, force_clear, dither, transform, &result) == 0) {
+        if (result == 0) {
+            printf("Image displayed successfully!\n");
+        } else {
+            print_display_error(result);
+        }
+        if (need_conversion) {
+            printf("Cleaning up temporary file: %s\n", draw_path);
+            unlink(draw_path);
+        }
+        return result;
+    }
+
     printf("epdraw: Initializing hardware (GPIO, SPI)...\n");
     if (DEV_Module_Init() != 0) {
         fprintf(stderr, "epdraw: ERROR: Failed to initialize hardware\n");
@@ -269,14 +430,39 @@ int main(int argc, char *argv[])
     printf("BUSY pin state after init: %d\n", DEV_Digital_Read(EPD_BUSY_PIN));
     printf("epdraw: Hardware initialization completed\n");
     
-    printf("epdraw: Displaying BMP: %s, VCOM: %d, mode: %d\n", bmp_path, vcom, mode);
-    int result = EPD_IT8951_DisplayBMP(bmp_path, vcom, mode);
+    printf("epdraw: Displaying image: %s, VCOM: %d, mode: %d\n", draw_path, vcom, mode);
+    // The counts carry over between runs in the state file; the panel size comes from it too
+    EPD_IT8951_Policy policy;
+    EPD_IT8951_Policy_Init(&policy, 0, 0);
+    EPD_IT8951_Policy_Load(&policy, policy_state);
+    if (clear_budget >= 0) {
+        EPD_IT8951_Policy_SetBudget(&policy, clear_budget, EPD_IT8951_POLICY_BUDGET_DU, EPD_IT8951_POLICY_BUDGET_A2);
+    }
+    if (force_clear) {
+        EPD_IT8951_Policy_RequestClear(&policy);
+    }
+    GUI_SetBmpDither(dither);
+    UDOUBLE clears_before = policy.Clears;
+    result = EPD_IT8951_DisplayBMPEx(draw_path, vcom, mode, &policy);
+    if (policy.Clears != clears_before) {
+        printf("Panel cleared with INIT mode (refresh policy)\n");
+    }
+    // A failed update leaves the panel in an unknown state
+    if (result != 0) {
+        EPD_IT8951_Policy_RequestClear(&policy);
+    }
+    EPD_IT8951_Policy_Save(&policy, policy_state);
     if (result == 0) {
         printf("Image displayed successfully!\n");
         // E-paper displays need time to physically update.
         // If the program exits or powers down the panel too quickly after sending the image, the update may not complete.
-        // The delay ensures the panel has time to finish the refresh before any shutdown or further commands.
-        DEV_Delay_ms(5000);
+        // Wait until the controller reports the refresh done before any shutdown or further commands.
+        UDOUBLE latency_us = 0;
+        if (EPD_IT8951_WaitForRefresh(&latency_us) == 0) {
+            printf("Refresh completed in %u ms\n", latency_us / 1000);
+        } else {
+            fprintf(stderr, "epdraw: WARNING: Display did not report refresh completion\n");
+        }
         if (!stay_awake) {
             printf("Putting display to sleep...\n");
             EPD_IT8951_Sleep();
@@ -285,20 +471,11 @@ int main(int argc, char *argv[])
         }
          // Clean up temporary BMP file if we created it
         if (need_conversion) {
-            printf("Cleaning up temporary file: %s\n", bmp_path);
-            unlink(bmp_path);
+            printf("Cleaning up temporary file: %s\n", draw_path);
+            unlink(draw_path);
         }
     } else {
-        fprintf(stderr, "epdraw: ERROR: Failed to display image (error code %d)\n", result);
-        if (result == -10) fprintf(stderr, "epdraw: ERROR: Failed to initialize display or get panel info\n");
-        else if (result == -11) fprintf(stderr, "epdraw: ERROR: Out of memory allocating display buffer\n");
-        else if (result == -12) fprintf(stderr, "epdraw: ERROR: Invalid bit depth\n");
-        else if (result == -1) fprintf(stderr, "epdraw: ERROR: BMP file not found or could not be opened\n");
-        else if (result == -2) fprintf(stderr, "epdraw: ERROR: BMP file header read error\n");
-        else if (result == -3) fprintf(stderr, "epdraw: ERROR: Not a BMP file\n");
-        else if (result == -4) fprintf(stderr, "epdraw: ERROR: BMP info header read error\n");
-        else if (result == -5) fprintf(stderr, "epdraw: ERROR: BMP palette read error or out of memory\n");
-        // Add more as needed
+        print_display_error(result);
     }
     
     printf("epdraw: Cleaning up hardware resources...\n");
@@ -306,4 +483,4 @@ int main(int argc, char *argv[])
     printf("epdraw: Hardware cleanup completed\n");
     
     return result;
-} 
\ No newline at end of file
+}
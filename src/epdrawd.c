@@ -0,0 +1,353 @@
+/**
+ * @file epdrawd.c
+ * @brief Display daemon: keeps the IT8951 initialized and serves epdraw requests.
+ *
+ * Reset, GetSystemInfo, the VCOM setup and the INIT mode clear are paid once at
+ * startup instead of on every image. Requests arrive on a Unix domain socket
+ * (see epdrawd_protocol.h) and are served one at a time; between requests the
+ * controller is kept in standby. A refresh policy decides when the panel needs
+ * an INIT clear again.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "../include/EPD_IT8951.h"
+#include "../include/GUI_BMPfile.h"
+#include "../include/GUI_Image.h"
+#include "../include/Debug.h"
+#include "../include/DEV_Config.h"
+#include "../include/epdrawd_protocol.h"
+
+extern UBYTE INIT_Mode;
+extern UBYTE GC16_Mode;
+
+static volatile sig_atomic_t stop_requested = 0;
+static EPD_IT8951_Policy policy;
+
+static void handle_stop(int sig)
+{
+    (void)sig;
+    stop_requested = 1;
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Parse a VCOM argument, in millivolts (2510) or volts (-2.51).
+ */
+static int parse_vcom(const char *arg)
+{
+    char *endptr;
+    double vcom_float = strtod(arg, &endptr);
+    if (*endptr != '\0') {
+        return atoi(arg);
+    }
+    if (vcom_float < 0) {
+        vcom_float = -vcom_float;
+    }
+    // Values below 10 are volts, larger ones are already millivolts
+    return (vcom_float < 10.0) ? (int)(vcom_float * 1000) : (int)vcom_float;
+}
+
+/**
+ * @brief Create the listening socket, replacing a stale one.
+ * @return Socket fd, or -1 on error.
+ */
+static int open_listener(const char *path)
+{
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "epdrawd: ERROR: socket path too long: %s\n", path);
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("epdrawd: socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    // A socket left behind by a crashed daemon refuses connections; a live one does not
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe >= 0 && connect(probe, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        fprintf(stderr, "epdrawd: ERROR: another daemon is already listening on %s\n", path);
+        close(probe);
+        close(fd);
+        return -1;
+    }
+    if (probe >= 0) {
+        close(probe);
+    }
+    unlink(path);
+
+    // Owner and group may connect
+    mode_t old_mask = umask(0117);
+    int rc = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old_mask);
+    if (rc != 0 || listen(fd, 4) != 0) {
+        perror("epdrawd: bind/listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Check a framebuffer request against the panel and its payload.
+ */
+static int check_framebuffer(const EPDRAWD_Request *req, IT8951_Dev_Info dev_info)
+{
+    UBYTE bpp = req->Bits_Per_Pixel;
+    if (bpp != 1 && bpp != 2 && bpp != 4 && bpp != 8) {
+        return EPDRAWD_ERR_PROTOCOL;
+    }
+    if (req->W == 0 || req->H == 0 ||
+        (UDOUBLE)req->X + req->W > dev_info.Panel_W ||
+        (UDOUBLE)req->Y + req->H > dev_info.Panel_H) {
+        return EPDRAWD_ERR_RECT;
+    }
+    // What EPD_IT8951_Area_Refresh() can send: 1bpp in whole bytes, other rows in 16 bit words
+    if (bpp == 1 ? (req->X % 8 != 0 || req->W % 8 != 0) : ((UDOUBLE)req->W * bpp) % 16 != 0) {
+        return EPDRAWD_ERR_RECT;
+    }
+    UDOUBLE stride = ((UDOUBLE)req->W * bpp + 7) / 8;
+    if (req->Payload_Len != stride * req->H) {
+        return EPDRAWD_ERR_PROTOCOL;
+    }
+    return 0;
+}
+
+/**
+ * @brief Serve one request whose header has been read.
+ * @return 0 to keep the connection, -1 to drop it.
+ */
+static int serve_request(int fd, const EPDRAWD_Request *req, IT8951_Dev_Info dev_info, UDOUBLE target_memory_addr, uint64_t request_us)
+{
+    uint64_t start_us = request_us;
+    EPDRAWD_Response resp;
+    UBYTE *payload = NULL;
+    memset(&resp, 0, sizeof(resp));
+    resp.Magic = EPDRAWD_MAGIC;
+
+    if (req->Magic != EPDRAWD_MAGIC || req->Payload_Len > EPDRAWD_MAX_PAYLOAD || req->Dither >= DITHER_MODES ||
+        (req->Transform & ~(EPDRAWD_TRANSFORM_ROTATE_MASK | EPDRAWD_TRANSFORM_MIRROR)) != 0 ||
+        (req->Type != EPDRAWD_REQ_FILE && req->Type != EPDRAWD_REQ_FRAMEBUFFER)) {
+        resp.Status = EPDRAWD_ERR_PROTOCOL;
+        epdrawd_write_full(fd, &resp, sizeof(resp), &stop_requested);
+        return -1;
+    }
+
+    if (req->Payload_Len > 0) {
+        payload = malloc(req->Payload_Len + 1);
+        if (payload == NULL) {
+            return -1;
+        }
+        if (epdrawd_read_full(fd, payload, req->Payload_Len, &stop_requested) != 0) {
+            free(payload);
+            return -1;
+        }
+        payload[req->Payload_Len] = '\0';
+    }
+
+    if (req->Type == EPDRAWD_REQ_FRAMEBUFFER) {
+        resp.Status = check_framebuffer(req, dev_info);
+    } else if (payload == NULL || payload[0] != '/') {
+        resp.Status = EPDRAWD_ERR_PROTOCOL;
+    }
+
+    if (resp.Status == 0) {
+        // A file covers the whole panel and is drawn with GC16
+        UWORD x = 0, y = 0, w = dev_info.Panel_W, h = dev_info.Panel_H, waveform = GC16_Mode;
+        if (req->Type == EPDRAWD_REQ_FRAMEBUFFER) {
+            x = req->X;
+            y = req->Y;
+            w = req->W;
+            h = req->H;
+            waveform = req->Mode;
+        }
+        if (req->Flags & EPDRAWD_FLAG_CLEAR) {
+            EPD_IT8951_Policy_RequestClear(&policy);
+        }
+
+        EPD_IT8951_SystemRun();
+        if (EPD_IT8951_Policy_NeedsClear(&policy, x, y, w, h, waveform)) {
+            uint64_t clear_start = now_us();
+            EPD_IT8951_Clear_Refresh(dev_info, target_memory_addr, INIT_Mode);
+            EPD_IT8951_WaitForRefresh(NULL);
+            EPD_IT8951_Policy_Record(&policy, 0, 0, dev_info.Panel_W, dev_info.Panel_H, INIT_Mode);
+            resp.Clear_us = (uint32_t)(now_us() - clear_start);
+            start_us += resp.Clear_us;
+        }
+
+        if (req->Type == EPDRAWD_REQ_FILE) {
+            GUI_SetBmpDither((DITHER_MODE)req->Dither);
+            GUI_SetImageTransform((req->Transform & EPDRAWD_TRANSFORM_ROTATE_MASK) * 90,
+                                  (req->Transform & EPDRAWD_TRANSFORM_MIRROR) != 0);
+            resp.Status = EPD_IT8951_DrawBMP(dev_info, (const char *)payload, req->Mode);
+        } else {
+            resp.Status = EPD_IT8951_Area_Refresh(payload, req->X, req->Y, req->W, req->H,
+                                                  req->Bits_Per_Pixel, req->Mode, target_memory_addr);
+        }
+        resp.Draw_us = (uint32_t)(now_us() - start_us);
+
+        if (resp.Status == 0) {
+            UDOUBLE latency_us = 0;
+            if (EPD_IT8951_WaitForRefresh(&latency_us) != 0) {
+                resp.Status = EPDRAWD_ERR_NO_REFRESH;
+            }
+            resp.Refresh_us = latency_us;
+        }
+        if (resp.Status == 0) {
+            EPD_IT8951_Policy_Record(&policy, x, y, w, h, waveform);
+        } else {
+            // What the panel shows after a failed update is unknown
+            EPD_IT8951_Policy_RequestClear(&policy);
+        }
+        EPD_IT8951_Standby();
+    }
+    free(payload);
+
+    if (EPD_IT8951_GetError() != 0) {
+        // Keep serving; the next request may succeed once the controller recovers
+        EPD_LOG_WARN("Controller stopped responding, clearing the error");
+        EPD_IT8951_ClearError();
+    }
+
+    resp.Total_us = (uint32_t)(now_us() - request_us);
+    printf("epdrawd: %s request, mode %u: status %d, clear %u ms, draw %u ms, refresh %u ms, total %u ms\n",
+           req->Type == EPDRAWD_REQ_FILE ? "file" : "framebuffer", req->Mode, resp.Status,
+           resp.Clear_us / 1000, resp.Draw_us / 1000, resp.Refresh_us / 1000, resp.Total_us / 1000);
+    fflush(stdout);
+
+    return epdrawd_write_full(fd, &resp, sizeof(resp), &stop_requested);
+}
+
+int main(int argc, char *argv[])
+{
+    const char* log_level_str = getenv("LOG_LEVEL");
+    if (log_level_str) {
+        log_level_t log_level;
+        if (strcmp(log_level_str, "ERROR") == 0) log_level = LOG_LEVEL_ERROR;
+        else if (strcmp(log_level_str, "WARN") == 0) log_level = LOG_LEVEL_WARN;
+        else if (strcmp(log_level_str, "INFO") == 0) log_level = LOG_LEVEL_INFO;
+        else if (strcmp(log_level_str, "DEBUG") == 0) log_level = LOG_LEVEL_DEBUG;
+        else if (strcmp(log_level_str, "TRACE") == 0) log_level = LOG_LEVEL_TRACE;
+        else log_level = LOG_LEVEL_WARN;
+        log_init(log_level);
+    }
+
+    const char *socket_path = epdrawd_socket_path();
+    const char *policy_state = EPD_IT8951_POLICY_STATE_PATH;
+    int clear = 1;
+    int clear_budget = -1;
+    int vcom = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-clear") == 0) {
+            clear = 0;
+        } else if (strcmp(argv[i], "--clear-budget") == 0 && i + 1 < argc) {
+            clear_budget = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--policy-state") == 0 && i + 1 < argc) {
+            policy_state = argv[++i];
+        } else if (argv[i][0] != '-' || (argv[i][1] >= '0' && argv[i][1] <= '9')) {
+            vcom = parse_vcom(argv[i]);
+        } else {
+            printf("Usage: epdrawd [--socket <path>] [--no-clear] [--clear-budget <n>] [--policy-state <file>] [vcom]\n");
+            printf("  [--socket <path>]: Socket to listen on (default: $%s or %s)\n", EPDRAWD_SOCKET_ENV, EPDRAWD_SOCKET_PATH);
+            printf("  [--no-clear]: Skip the INIT mode clear at startup and continue from the saved update counts\n");
+            printf("  [--clear-budget <n>]: GC16 updates per region between INIT clears (default: %d, 0: clear every time)\n", EPD_IT8951_POLICY_BUDGET_GC16);
+            printf("  [--policy-state <file>]: Update counts saved on exit (default: %s)\n", EPD_IT8951_POLICY_STATE_PATH);
+            printf("  [vcom]: VCOM voltage (default: 0, use panel default)\n");
+            return 1;
+        }
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_stop;
+    sigemptyset(&sa.sa_mask);
+    // No SA_RESTART: accept() and read() must return so the loop sees the flag
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int listen_fd = open_listener(socket_path);
+    if (listen_fd < 0) {
+        return 2;
+    }
+
+    uint64_t init_start = now_us();
+    if (DEV_Module_Init() != 0) {
+        fprintf(stderr, "epdrawd: ERROR: Failed to initialize hardware\n");
+        close(listen_fd);
+        unlink(socket_path);
+        return 2;
+    }
+    IT8951_Dev_Info dev_info = EPD_IT8951_Init(vcom);
+    if (EPD_IT8951_GetError() != 0 || dev_info.Panel_W == 0 || dev_info.Panel_H == 0) {
+        fprintf(stderr, "epdrawd: ERROR: Failed to initialize display or get panel info\n");
+        DEV_Module_Exit();
+        close(listen_fd);
+        unlink(socket_path);
+        return 2;
+    }
+    UDOUBLE target_memory_addr = dev_info.Memory_Addr_L | ((UDOUBLE)dev_info.Memory_Addr_H << 16);
+    EPD_IT8951_Policy_Init(&policy, dev_info.Panel_W, dev_info.Panel_H);
+    if (clear) {
+        EPD_IT8951_Clear_Refresh(dev_info, target_memory_addr, INIT_Mode);
+        EPD_IT8951_WaitForRefresh(NULL);
+        EPD_IT8951_Policy_Record(&policy, 0, 0, dev_info.Panel_W, dev_info.Panel_H, INIT_Mode);
+    } else {
+        EPD_IT8951_Policy_Load(&policy, policy_state);
+    }
+    if (clear_budget >= 0) {
+        EPD_IT8951_Policy_SetBudget(&policy, clear_budget, EPD_IT8951_POLICY_BUDGET_DU, EPD_IT8951_POLICY_BUDGET_A2);
+    }
+    EPD_IT8951_Standby();
+    printf("epdrawd: panel %ux%u ready in %u ms, listening on %s\n",
+           dev_info.Panel_W, dev_info.Panel_H, (unsigned)((now_us() - init_start) / 1000), socket_path);
+    fflush(stdout);
+
+    while (!stop_requested) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        // Clients are served one at a time, so an idle one is dropped
+        struct timeval timeout = { EPDRAWD_CLIENT_TIMEOUT_S, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        EPDRAWD_Request req;
+        while (!stop_requested && epdrawd_read_full(fd, &req, sizeof(req), &stop_requested) == 0) {
+            if (serve_request(fd, &req, dev_info, target_memory_addr, now_us()) != 0) {
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    printf("epdrawd: shutting down after %u updates and %u clears\n", policy.Updates, policy.Clears);
+    EPD_IT8951_Policy_Save(&policy, policy_state);
+    close(listen_fd);
+    unlink(socket_path);
+    EPD_IT8951_Sleep();
+    DEV_Module_Exit();
+    return 0;
+}
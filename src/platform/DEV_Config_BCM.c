@@ -10,6 +10,16 @@
 #include <fcntl.h>
 #include <errno.h> // Added for errno
 #include <stdlib.h> // Added for getenv
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Sleep steps, in microseconds, used while polling a GPIO level.
+ *
+ * bcm2835 has no edge notification without /dev/mem interrupts, so the wait
+ * backs off from short naps to 1 ms ones instead of spinning on the register.
+ */
+static const UDOUBLE Wait_Ladder_us[] = { 10, 20, 50, 100, 200, 500, 1000 };
 
 /**
  * @brief Write a digital value to a GPIO pin.
@@ -34,6 +44,34 @@ UBYTE DEV_Digital_Read(UWORD Pin) {
     return value;
 }
 
+/**
+ * @brief Wait until a GPIO input reads the given level.
+ * @param Pin GPIO pin number.
+ * @param Value Level to wait for (HIGH or LOW).
+ * @param Timeout_us Give up after this many microseconds.
+ * @return 0 once the pin reads Value, -1 on timeout.
+ */
+int DEV_Digital_WaitLevel(UWORD Pin, UBYTE Value, UDOUBLE Timeout_us) {
+    struct timespec now, start;
+    UDOUBLE step = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (;;) {
+        if (bcm2835_gpio_lev(Pin) == Value) {
+            return 0;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t elapsed_us = (uint64_t)(now.tv_sec - start.tv_sec) * 1000000ULL + (now.tv_nsec - start.tv_nsec) / 1000;
+        if (elapsed_us >= Timeout_us) {
+            return (bcm2835_gpio_lev(Pin) == Value) ? 0 : -1;
+        }
+        usleep(Wait_Ladder_us[step]);
+        if (step + 1 < sizeof(Wait_Ladder_us) / sizeof(Wait_Ladder_us[0])) {
+            step++;
+        }
+    }
+}
+
 /**
  * @brief Write a byte over the SPI bus.
  * @param Value Byte to send.
@@ -50,6 +88,25 @@ UBYTE DEV_SPI_ReadByte() {
     return bcm2835_spi_transfer(0x00);
 }
 
+/**
+ * @brief Write a block of bytes over the SPI bus.
+ * @param pData Bytes to send.
+ * @param Len Number of bytes to send.
+ */
+void DEV_SPI_WriteBuffer(const UBYTE *pData, UDOUBLE Len) {
+    bcm2835_spi_writenb((const char *)pData, Len);
+}
+
+/**
+ * @brief Read a block of bytes from the SPI bus.
+ * @param pData Destination buffer.
+ * @param Len Number of bytes to read.
+ */
+void DEV_SPI_ReadBuffer(UBYTE *pData, UDOUBLE Len) {
+    memset(pData, 0x00, Len);
+    bcm2835_spi_transfern((char *)pData, Len);
+}
+
 /**
  * @brief Delay for a specified number of milliseconds.
  * @param xms Number of milliseconds to delay.
@@ -10,8 +10,13 @@
 #include "../../include/dev_hardware_SPI.h"
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
 #include <unistd.h>
 
+// Set when the BUSY line was requested for edge events
+static bool Busy_Events = false;
+
 /**
  * @brief Write a digital value to a GPIO pin.
  * @param Pin GPIO pin number.
@@ -30,6 +35,36 @@ UBYTE DEV_Digital_Read(UWORD Pin) {
     return GPIOD_Read(Pin);
 }
 
+/**
+ * @brief Wait until a GPIO input reads the given level.
+ *
+ * The BUSY pin blocks on gpiod line events; other pins, or BUSY when events
+ * could not be requested, are polled every 100 us.
+ *
+ * @param Pin GPIO pin number.
+ * @param Value Level to wait for (HIGH or LOW).
+ * @param Timeout_us Give up after this many microseconds.
+ * @return 0 once the pin reads Value, -1 on timeout or error.
+ */
+int DEV_Digital_WaitLevel(UWORD Pin, UBYTE Value, UDOUBLE Timeout_us) {
+    struct timespec start, now;
+
+    if (Busy_Events && Pin == EPD_BUSY_PIN) {
+        return (GPIOD_Wait_Level(Pin, Value, Timeout_us) == 0) ? 0 : -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (GPIOD_Read(Pin) != Value) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t elapsed_us = (uint64_t)(now.tv_sec - start.tv_sec) * 1000000ULL + (now.tv_nsec - start.tv_nsec) / 1000;
+        if (elapsed_us >= Timeout_us) {
+            return -1;
+        }
+        usleep(100);
+    }
+    return 0;
+}
+
 /**
  * @brief Write a byte over the SPI bus.
  * @param Value Byte to send.
@@ -46,6 +81,24 @@ UBYTE DEV_SPI_ReadByte() {
     return DEV_HARDWARE_SPI_TransferByte(0x00);
 }
 
+/**
+ * @brief Write a block of bytes over the SPI bus.
+ * @param pData Bytes to send.
+ * @param Len Number of bytes to send.
+ */
+void DEV_SPI_WriteBuffer(const UBYTE *pData, UDOUBLE Len) {
+    DEV_HARDWARE_SPI_Write(pData, Len);
+}
+
+/**
+ * @brief Read a block of bytes from the SPI bus.
+ * @param pData Destination buffer.
+ * @param Len Number of bytes to read.
+ */
+void DEV_SPI_ReadBuffer(UBYTE *pData, UDOUBLE Len) {
+    DEV_HARDWARE_SPI_Read(pData, Len);
+}
+
 /**
  * @brief Delay for a specified number of milliseconds.
  * @param xms Number of milliseconds to delay.
@@ -82,7 +135,13 @@ static void DEV_GPIO_Mode(UWORD Pin, UWORD Mode) {
  * @brief Initialize all required GPIO pins for the e-Paper display.
  */
 static void DEV_GPIO_Init(void) {
-    DEV_GPIO_Mode(EPD_BUSY_PIN, 0);
+    if (GPIOD_Direction_Events(EPD_BUSY_PIN) == 0) {
+        Busy_Events = true;
+    } else {
+        DEV_LOG_WARN("BUSY line events unavailable, polling instead");
+        Busy_Events = false;
+        DEV_GPIO_Mode(EPD_BUSY_PIN, 0);
+    }
     DEV_GPIO_Mode(EPD_RST_PIN, 1);
     DEV_GPIO_Mode(EPD_CS_PIN, 1);
     DEV_Digital_Write(EPD_CS_PIN, 1);
@@ -9,10 +9,23 @@
 #include <lgpio.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
 
 int GPIO_Handle;
 int SPI_Handle;
 
+// BUSY edges are delivered by lgpio's alert thread and wake DEV_Digital_WaitLevel
+static bool Busy_Alerts = false;
+static pthread_mutex_t Busy_Lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Busy_Cond;
+static pthread_once_t Busy_Cond_Once = PTHREAD_ONCE_INIT;
+
+// spidev rejects single transfers larger than its bufsiz (4096 bytes by default)
+#define LGPIO_SPI_MAX_XFER 4096
+
 /**
  * @brief Write a digital value to a GPIO pin.
  * @param Pin GPIO pin number.
@@ -31,6 +44,67 @@ UBYTE DEV_Digital_Read(UWORD Pin) {
     return lgGpioRead(GPIO_Handle, Pin);
 }
 
+/**
+ * @brief lgpio alert callback for the BUSY pin: wake any waiter.
+ */
+static void DEV_Busy_Alert(int num_alerts, lgGpioAlert_p alerts, void *userdata) {
+    (void)num_alerts;
+    (void)alerts;
+    (void)userdata;
+    pthread_mutex_lock(&Busy_Lock);
+    pthread_cond_broadcast(&Busy_Cond);
+    pthread_mutex_unlock(&Busy_Lock);
+}
+
+/**
+ * @brief Wait until a GPIO input reads the given level.
+ *
+ * The BUSY pin blocks on its lgpio alert; other pins, or BUSY when alerts
+ * could not be claimed, are polled every 100 us.
+ *
+ * @param Pin GPIO pin number.
+ * @param Value Level to wait for (HIGH or LOW).
+ * @param Timeout_us Give up after this many microseconds.
+ * @return 0 once the pin reads Value, -1 on timeout or error.
+ */
+int DEV_Digital_WaitLevel(UWORD Pin, UBYTE Value, UDOUBLE Timeout_us) {
+    struct timespec deadline;
+    int rc = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += Timeout_us / 1000000;
+    deadline.tv_nsec += (Timeout_us % 1000000) * 1000;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    if (!Busy_Alerts || Pin != EPD_BUSY_PIN) {
+        struct timespec now;
+        while (lgGpioRead(GPIO_Handle, Pin) != Value) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec)) {
+                return -1;
+            }
+            lguSleep(0.0001);
+        }
+        return 0;
+    }
+
+    //The level is read under the lock, so an edge after the read is not missed
+    pthread_mutex_lock(&Busy_Lock);
+    while (lgGpioRead(GPIO_Handle, Pin) != Value) {
+        rc = pthread_cond_timedwait(&Busy_Cond, &Busy_Lock, &deadline);
+        if (rc == ETIMEDOUT) {
+            rc = (lgGpioRead(GPIO_Handle, Pin) == Value) ? 0 : -1;
+            break;
+        }
+        rc = 0;
+    }
+    pthread_mutex_unlock(&Busy_Lock);
+    return rc;
+}
+
 /**
  * @brief Write a byte over the SPI bus.
  * @param Value Byte to send.
@@ -49,6 +123,40 @@ UBYTE DEV_SPI_ReadByte() {
     return Read_Value;
 }
 
+/**
+ * @brief Write a block of bytes over the SPI bus.
+ * @param pData Bytes to send.
+ * @param Len Number of bytes to send.
+ */
+void DEV_SPI_WriteBuffer(const UBYTE *pData, UDOUBLE Len) {
+    while (Len > 0) {
+        UDOUBLE Count = (Len > LGPIO_SPI_MAX_XFER) ? LGPIO_SPI_MAX_XFER : Len;
+        if (lgSpiWrite(SPI_Handle, (const char*)pData, Count) < 0) {
+            DEV_LOG_WARN("lgSpiWrite of %u bytes failed", Count);
+            return;
+        }
+        pData += Count;
+        Len -= Count;
+    }
+}
+
+/**
+ * @brief Read a block of bytes from the SPI bus.
+ * @param pData Destination buffer.
+ * @param Len Number of bytes to read.
+ */
+void DEV_SPI_ReadBuffer(UBYTE *pData, UDOUBLE Len) {
+    while (Len > 0) {
+        UDOUBLE Count = (Len > LGPIO_SPI_MAX_XFER) ? LGPIO_SPI_MAX_XFER : Len;
+        if (lgSpiRead(SPI_Handle, (char*)pData, Count) < 0) {
+            DEV_LOG_WARN("lgSpiRead of %u bytes failed", Count);
+            return;
+        }
+        pData += Count;
+        Len -= Count;
+    }
+}
+
 /**
  * @brief Delay for a specified number of milliseconds.
  * @param xms Number of milliseconds to delay.
@@ -78,11 +186,34 @@ static void DEV_GPIO_Mode(UWORD Pin, UWORD Mode) {
     }
 }
 
+/**
+ * @brief Create Busy_Cond on the monotonic clock.
+ *
+ * Run once per process: DEV_Module_Exit() leaves the BUSY alert in place, so
+ * the alert thread may still signal the condition after it.
+ */
+static void DEV_Busy_Cond_Init(void) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&Busy_Cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
 /**
  * @brief Initialize all required GPIO pins for the e-Paper display.
  */
 static void DEV_GPIO_Init(void) {
-    DEV_GPIO_Mode(EPD_BUSY_PIN, 0);
+    pthread_once(&Busy_Cond_Once, DEV_Busy_Cond_Init);
+
+    if (lgGpioClaimAlert(GPIO_Handle, LFLAGS, LG_BOTH_EDGES, EPD_BUSY_PIN, -1) >= 0 &&
+        lgGpioSetAlertsFunc(GPIO_Handle, EPD_BUSY_PIN, DEV_Busy_Alert, NULL) >= 0) {
+        Busy_Alerts = true;
+    } else {
+        DEV_LOG_WARN("BUSY alerts unavailable, polling instead");
+        Busy_Alerts = false;
+        DEV_GPIO_Mode(EPD_BUSY_PIN, 0);
+    }
     DEV_GPIO_Mode(EPD_RST_PIN, 1);
     DEV_GPIO_Mode(EPD_CS_PIN, 1);
     DEV_Digital_Write(EPD_CS_PIN, 1);
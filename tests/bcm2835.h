@@ -13,6 +13,9 @@ void bcm2835_close(void);
 void bcm2835_gpio_write(int pin, int value);
 int bcm2835_gpio_lev(int pin);
 unsigned char bcm2835_spi_transfer(unsigned char value);
+void bcm2835_spi_writenb(const char *buf, unsigned int len);
+void bcm2835_spi_transfern(char *buf, unsigned int len);
+unsigned int bcm2835_version(void);
 void bcm2835_delay(unsigned int ms);
 void bcm2835_delayMicroseconds(unsigned int us);
 void bcm2835_gpio_fsel(int pin, int mode);
@@ -22,6 +25,7 @@ void bcm2835_gpio_fsel(int pin, int mode);
 #define BCM2835_GPIO_FSEL_OUTP 1
 #define BCM2835_SPI_BIT_ORDER_MSBFIRST 0
 #define BCM2835_SPI_MODE0 0
+#define BCM2835_SPI_CLOCK_DIVIDER_16 16
 #define BCM2835_SPI_CLOCK_DIVIDER_32 32
 
 #endif // BCM2835_H_MOCK 
\ No newline at end of file
@@ -0,0 +1,86 @@
+// Benchmark for adaptive bit depth: SPI bytes and wire time of a 4bpp upload
+// of a text page and a dashboard, sent as drawn and after the driver repacks
+// them to the fewest bits their grays need. Wire time is costed at
+// BENCH_SPI_HZ against the mock SPI byte count; host time covers the
+// histogram and repack, so no hardware is needed.
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../include/EPD_IT8951.h"
+#include "../include/GUI_Paint.h"
+
+#define PANEL_W 1872
+#define PANEL_H 1404
+#define BENCH_SPI_HZ 24000000.0
+#define TEST_ADDR 0x001236E0
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+void mock_spi_tx_reset(void);
+
+static UBYTE *frame;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Black text on white
+static void text_page(void) {
+    Paint_Clear(WHITE);
+    for (UWORD y = 40; y + 24 < PANEL_H - 40; y += 30) {
+        Paint_DrawString_EN(40, y, "The quick brown fox jumps over the lazy dog. 0123456789 The quick brown fox", &Font24, BLACK, WHITE);
+    }
+}
+
+// Text and gauges in 2bpp grays
+static void dashboard(void) {
+    Paint_Clear(WHITE);
+    for (UWORD i = 0; i < 6; i++) {
+        UWORD x = 40 + (i % 3) * 600, y = 60 + (i / 3) * 660;
+        Paint_DrawRectangle(x, y, x + 560, y + 600, 0xA0, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
+        Paint_DrawRectangle(x + 20, y + 400, x + 20 + 80 * (i + 1), y + 460, 0x50, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawString_EN(x + 20, y + 20, "Sensor 21.5 C 48%", &Font24, BLACK, WHITE);
+        Paint_DrawString_EN(x + 20, y + 60, "Updated 12:34", &Font12, 0x50, WHITE);
+    }
+}
+
+static void run(const char *name, void (*draw)(void)) {
+    uint32_t bytes[2];
+    double host_ms[2];
+
+    draw();
+    for (int adaptive = 0; adaptive < 2; adaptive++) {
+        double start;
+        EPD_IT8951_SetAdaptiveDepth(adaptive);
+        mock_spi_tx_reset();
+        start = now_ms();
+        EPD_IT8951_4bp_Refresh(frame, 0, 0, PANEL_W, PANEL_H, false, TEST_ADDR, true);
+        host_ms[adaptive] = now_ms() - start;
+        bytes[adaptive] = mock_spi_tx_bytes;
+        printf("%-10s %-9s %9u bytes %7.1f ms on the wire %6.1f ms host\n", name,
+               adaptive ? "adaptive" : "4bpp", bytes[adaptive],
+               bytes[adaptive] * 8 / BENCH_SPI_HZ * 1000.0, host_ms[adaptive]);
+    }
+    assert(bytes[1] < bytes[0]);
+    printf("%-10s saved %.1f ms (%.0f%%)\n\n", name,
+           (double)(bytes[0] - bytes[1]) * 8 / BENCH_SPI_HZ * 1000.0,
+           100.0 * (bytes[0] - bytes[1]) / bytes[0]);
+}
+
+int main(void) {
+    frame = (UBYTE *)malloc(PANEL_W * PANEL_H / 2);
+    assert(frame != NULL);
+    EPD_IT8951_Init(0);
+    Paint_NewImage(frame, PANEL_W, PANEL_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(4);
+
+    printf("One full-panel upload, %dx%d panel, SPI %.0f MHz\n", PANEL_W, PANEL_H, BENCH_SPI_HZ / 1e6);
+    run("text", text_page);
+    run("dashboard", dashboard);
+    EPD_IT8951_SetAdaptiveDepth(false);
+    free(frame);
+    return 0;
+}
@@ -0,0 +1,50 @@
+// Benchmark for the 8bpp to panel depth packing kernels: GB/s of 8bpp pixels
+// read while packing a panel-sized frame to 4, 2 and 1bpp, for every kernel
+// set this CPU supports.
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../include/EPD_IT8951_Pack.h"
+
+#define PANEL_W 1872
+#define PANEL_H 1404
+#define REPEAT 50
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    UDOUBLE pixels = (UDOUBLE)PANEL_W * PANEL_H;
+    UBYTE *surface = malloc(pixels);
+    UBYTE *packed = malloc(pixels / 2);
+    if (surface == NULL || packed == NULL)
+        return 1;
+    for (UDOUBLE i = 0; i < pixels; i++)
+        surface[i] = (UBYTE)(i * 2654435761u >> 24) & 0xF0;
+
+    printf("Packing a %dx%d 8bpp frame, best of %d, GB/s of 8bpp pixels read\n", PANEL_W, PANEL_H, REPEAT);
+    printf("%-8s %8s %8s %8s\n", "kernel", "4bpp", "2bpp", "1bpp");
+    for (int k = 0; k < EPD_IT8951_PACK_KERNELS; k++) {
+        if (EPD_IT8951_Pack_SetKernel(k) != 0)
+            continue;
+        printf("%-8s", EPD_IT8951_Pack_KernelName(k));
+        for (UBYTE bpp = 4; bpp >= 1; bpp /= 2) {
+            double best = 1e9;
+            for (int i = 0; i < REPEAT; i++) {
+                double start = now_s();
+                EPD_IT8951_Pack_Area(surface, PANEL_W, PANEL_W, PANEL_H, bpp, packed, PANEL_W * bpp / 8);
+                double s = now_s() - start;
+                if (s < best)
+                    best = s;
+            }
+            printf(" %8.2f", pixels / best / 1e9);
+        }
+        printf("\n");
+    }
+    free(surface);
+    free(packed);
+    return 0;
+}
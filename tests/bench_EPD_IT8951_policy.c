@@ -0,0 +1,96 @@
+// Benchmark for the refresh policy: simulated time per 100 updates with an INIT
+// clear before every update (the old DisplayBMP behaviour) and with the default
+// clear budgets. Waveform times are the driver's default per-mode estimates and
+// uploads are costed at BENCH_SPI_HZ, so no hardware is needed.
+#include <assert.h>
+#include <stdio.h>
+#include "../include/EPD_IT8951.h"
+
+#define PANEL_W 1872
+#define PANEL_H 1404
+#define UPDATES 100
+#define BENCH_SPI_HZ 24000000.0
+
+#define INIT 0
+#define DU 1
+#define GC16 2
+#define A2 6
+
+typedef struct {
+    UWORD X, Y, W, H, Mode;
+} Update;
+
+typedef struct {
+    double ms;
+    int clears;
+} Result;
+
+// 4bpp upload over SPI
+static double upload_ms(UWORD W, UWORD H) {
+    return (double)W * H / 2 * 8 / BENCH_SPI_HZ * 1000.0;
+}
+
+static double update_ms(UWORD W, UWORD H, UWORD Mode) {
+    return upload_ms(W, H) + EPD_IT8951_GetRefreshEstimate(Mode);
+}
+
+static Result run(const char *workload, Update (*next)(int), int always_clear) {
+    EPD_IT8951_Policy policy;
+    Result r = {0.0, 0};
+
+    EPD_IT8951_Policy_Init(&policy, PANEL_W, PANEL_H);
+    if (always_clear) {
+        EPD_IT8951_Policy_SetBudget(&policy, 0, 0, 0);
+    }
+    for (int i = 0; i < UPDATES; i++) {
+        Update u = next(i);
+        if (EPD_IT8951_Policy_NeedsClear(&policy, u.X, u.Y, u.W, u.H, u.Mode)) {
+            // Clear_Refresh uploads a full 0xFF frame and refreshes it with INIT
+            r.ms += update_ms(PANEL_W, PANEL_H, INIT);
+            r.clears++;
+            EPD_IT8951_Policy_Record(&policy, 0, 0, PANEL_W, PANEL_H, INIT);
+        }
+        r.ms += update_ms(u.W, u.H, u.Mode);
+        EPD_IT8951_Policy_Record(&policy, u.X, u.Y, u.W, u.H, u.Mode);
+    }
+    printf("%-12s %-14s %4d clears %10.0f ms total %8.0f ms/update\n",
+           workload, always_clear ? "always clear" : "budget policy", r.clears, r.ms, r.ms / UPDATES);
+    return r;
+}
+
+// A full-panel GC16 image every time (epdraw photo frame)
+static Update photo_frame(int i) {
+    (void)i;
+    return (Update){0, 0, PANEL_W, PANEL_H, GC16};
+}
+
+// Widgets updated with DU, a full GC16 redraw every 10th update
+static Update dashboard(int i) {
+    if (i % 10 == 0) {
+        return (Update){0, 0, PANEL_W, PANEL_H, GC16};
+    }
+    UWORD widget = i % 4;
+    return (Update){(UWORD)(widget * (PANEL_W / 4)), 0, PANEL_W / 4, PANEL_H / 3, DU};
+}
+
+// A small A2 clock in one corner
+static Update clock_face(int i) {
+    (void)i;
+    return (Update){PANEL_W - 480, 0, 480, 160, A2};
+}
+
+int main(void) {
+    Update (*workloads[])(int) = {photo_frame, dashboard, clock_face};
+    const char *names[] = {"photo frame", "dashboard", "clock"};
+
+    printf("Simulated time per %d updates, %dx%d panel, SPI %.0f MHz\n",
+           UPDATES, PANEL_W, PANEL_H, BENCH_SPI_HZ / 1e6);
+    for (int w = 0; w < 3; w++) {
+        Result always = run(names[w], workloads[w], 1);
+        Result policy = run(names[w], workloads[w], 0);
+        assert(always.clears == UPDATES);
+        assert(policy.clears < always.clears);
+        printf("%-12s saved %.0f%%\n\n", names[w], 100.0 * (always.ms - policy.ms) / always.ms);
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Benchmark for in-memory dithering: Mpixels/s of each method dithering a
+// panel-sized gray photo-like frame to 4, 2 and 1bpp, row by row.
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../include/GUI_Dither.h"
+
+#define PANEL_W 1872
+#define PANEL_H 1404
+#define REPEAT 5
+
+static const char *names[DITHER_MODES] = { "none", "bayer", "fs", "atkinson" };
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    UDOUBLE pixels = (UDOUBLE)PANEL_W * PANEL_H;
+    UBYTE *source = malloc(pixels);
+    UBYTE *frame = malloc(pixels);
+    if (source == NULL || frame == NULL)
+        return 1;
+    // A diagonal gradient with some noise
+    for (UDOUBLE i = 0; i < pixels; i++)
+        source[i] = (UBYTE)((i % PANEL_W + i / PANEL_W) * 255 / (PANEL_W + PANEL_H) + (i * 2654435761u >> 29));
+
+    printf("Dithering a %dx%d 8 bit gray frame, best of %d, Mpixels/s\n", PANEL_W, PANEL_H, REPEAT);
+    printf("%-10s %8s %8s %8s\n", "method", "4bpp", "2bpp", "1bpp");
+    for (int m = 0; m < DITHER_MODES; m++) {
+        printf("%-10s", names[m]);
+        for (UBYTE bpp = 4; bpp >= 1; bpp /= 2) {
+            double best = 1e9;
+            for (int i = 0; i < REPEAT; i++) {
+                DITHER d;
+                if (Dither_Init(&d, (DITHER_MODE)m, bpp, PANEL_W) != 0)
+                    return 1;
+                for (UDOUBLE j = 0; j < pixels; j++)
+                    frame[j] = source[j];
+                double start = now_s();
+                for (UWORD y = 0; y < PANEL_H; y++)
+                    Dither_Row(&d, frame + (UDOUBLE)y * PANEL_W, 0, y);
+                double s = now_s() - start;
+                Dither_Release(&d);
+                if (s < best)
+                    best = s;
+            }
+            printf(" %8.1f", pixels / best / 1e6);
+        }
+        printf("\n");
+    }
+    free(source);
+    free(frame);
+    return 0;
+}
@@ -0,0 +1,88 @@
+// Benchmark for band rendering: time to replay a page of text and shapes on
+// a panel-sized image with 1 to N threads, each drawing a band of the image.
+// N is the number of CPUs, or the first argument.
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/GUI_Paint.h"
+#include "../include/GUI_Paint_Bands.h"
+
+#define PANEL_W 1872
+#define PANEL_H 1404
+#define REPEAT 5
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static const char *line = "The quick brown fox jumps over the lazy dog; PACK MY BOX WITH FIVE DOZEN LIQUOR JUGS 0123456789 (+-*/=) ";
+
+// A dashboard: a text column, boxed panels, gauges and a chart
+static void record_page(PAINT_BATCH *batch) {
+    Paint_Record(batch);
+    Paint_Clear(WHITE);
+    for (UWORD y = 0; y + Font16.Height <= PANEL_H; y += Font16.Height)
+        Paint_DrawString_EN(0, y, line, &Font16, BLACK, WHITE);
+    for (UWORD i = 0; i < 12; i++) {
+        UWORD x = 1000 + (i % 3) * 290, y = 20 + (i / 3) * 340;
+        Paint_DrawRoundedRectangle(x, y, x + 270, y + 320, 16, 0x40, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
+        Paint_DrawCircle(x + 135, y + 130, 90, 0xC0, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        Paint_DrawEllipse(x + 135, y + 130, 110, 60, BLACK, DOT_PIXEL_3X3, DRAW_FILL_EMPTY);
+        Paint_DrawThickLine(x + 135, y + 130, x + 60 + i * 12, y + 60, BLACK, 6, LINE_CAP_SQUARE, LINE_STYLE_SOLID);
+        Paint_DrawNum(x + 20, y + 250, 1000 + i * 37, &Font24, BLACK, WHITE);
+        for (UWORD k = 0; k < 10; k++)
+            Paint_DrawLine(x + 20 + k * 24, y + 300, x + 44 + k * 24, y + 230 + (k * 37 + i * 11) % 60,
+                           0x80, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+    }
+    Paint_Record(NULL);
+}
+
+static double time_ms(PAINT_BANDS *bands, const PAINT_BATCH *batch) {
+    double best = 1e9;
+    for (int i = 0; i < REPEAT; i++) {
+        Paint_ClearDamage();
+        double start = now_ms();
+        Paint_Bands_Render(bands, &Paint, batch);
+        double ms = now_ms() - start;
+        if (ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    UBYTE *image = malloc((size_t)PANEL_W * PANEL_H);
+    long cpus = argc > 1 ? atol(argv[1]) : sysconf(_SC_NPROCESSORS_ONLN);
+    UWORD max = cpus < 1 ? 1 : cpus > PAINT_BANDS_MAX ? PAINT_BANDS_MAX : cpus;
+    PAINT_BATCH batch;
+    PAINT_BANDS bands;
+    if (image == NULL)
+        return 1;
+
+    Paint_Batch_Init(&batch);
+    printf("A page of text and shapes on a %dx%d image, best of %d, up to %d threads\n", PANEL_W, PANEL_H, REPEAT, max);
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        Paint_NewImage(image, PANEL_W, PANEL_H, ROTATE_0, WHITE);
+        Paint_SetBitsPerPixel(bpp);
+        Paint_Batch_Reset(&batch);
+        record_page(&batch);
+
+        double one = 0;
+        for (UWORD threads = 1; threads <= max; threads *= 2) {
+            Paint_Bands_Init(&bands, threads);
+            double ms = time_ms(&bands, &batch);
+            if (threads == 1)
+                one = ms;
+            printf("%dbpp  %2d threads %7.2f ms  %4.1fx\n", bpp, threads, ms, one / ms);
+            Paint_Bands_Release(&bands);
+            if (threads < max && threads * 2 > max)
+                threads = max / 2;
+        }
+    }
+    Paint_Batch_Release(&batch);
+    free(image);
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Benchmark for Chinese font lookup: time to draw a page of mixed GB2312 and
+// ASCII text from a font the size of the full GB2312 set, scanning the table
+// and drawing a pixel at a time as Paint did before, through the index with
+// the glyph cache off, and through the index and the glyph cache.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/GUI_Paint.h"
+
+#define PANEL_W 1872
+#define PANEL_H 1404
+#define REPEAT 5
+
+// The 6763 hanzi of GB2312 sit in rows 0xB0 to 0xF7 of 94 characters each
+#define HANZI_ROWS 72
+#define HANZI (HANZI_ROWS * 94)
+#define ASCII 95
+
+static CH_CN *table;
+static cFONT font = {NULL, HANZI + ASCII, 24, 32, 41};
+static char page_text[PANEL_H / 41][PANEL_W / 24 * 2 + 1];
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// Random bitmaps stand in for the glyphs, ASCII after the hanzi as in the
+// font files
+static int make_font(void) {
+    table = calloc(font.size, sizeof(CH_CN));
+    if (table == NULL)
+        return -1;
+    for (int i = 0; i < HANZI; i++) {
+        char *index = (char *)table[i].index;
+        index[0] = (char)(0xB0 + i / 94);
+        index[1] = (char)(0xA1 + i % 94);
+    }
+    for (int i = 0; i < ASCII; i++)
+        ((char *)table[HANZI + i].index)[0] = (char)(' ' + i);
+    for (int i = 0; i < font.size; i++) {
+        for (size_t b = 0; b < sizeof(table[i].matrix); b++)
+            ((char *)table[i].matrix)[b] = (char)(rand() & rand());
+    }
+    font.table = table;
+    return 0;
+}
+
+// Lines of about two thirds hanzi, drawn from the common first rows
+static void make_page(void) {
+    for (int line = 0; line < PANEL_H / 41; line++) {
+        char *p = page_text[line];
+        for (int x = 0; x + 32 <= PANEL_W;) {
+            if (rand() % 3 != 0) {
+                int i = rand() % (HANZI / 4);
+                *p++ = table[i].index[0];
+                *p++ = table[i].index[1];
+                x += 32;
+            } else {
+                *p++ = (char)(' ' + rand() % ASCII);
+                x += 24;
+            }
+        }
+        *p = 0;
+    }
+}
+
+// Paint_DrawString_CN before the index
+static void scan_string(int x, int y, const unsigned char *p) {
+    while (*p != 0) {
+        for (int num = 0; num < font.size; num++) {
+            if (p[0] != (unsigned char)table[num].index[0] ||
+                (p[0] > 0x7F && p[1] != (unsigned char)table[num].index[1]))
+                continue;
+            const unsigned char *ptr = (const unsigned char *)table[num].matrix;
+            for (int j = 0; j < font.Height; j++) {
+                for (int i = 0; i < font.Width; i++) {
+                    if (*ptr & (0x80 >> (i % 8)))
+                        Paint_SetPixel(x + i, y + j, BLACK);
+                    if (i % 8 == 7)
+                        ptr++;
+                }
+            }
+            break;
+        }
+        x += *p <= 0x7F ? font.ASCII_Width : font.Width;
+        p += *p <= 0x7F ? 1 : 2;
+    }
+}
+
+static void scan_page(void) {
+    for (int line = 0; line < PANEL_H / 41; line++)
+        scan_string(0, line * 41, (const unsigned char *)page_text[line]);
+}
+
+static void index_page(void) {
+    for (int line = 0; line < PANEL_H / 41; line++)
+        Paint_DrawString_CN(0, line * 41, page_text[line], &font, BLACK, WHITE);
+}
+
+static double time_ms(void (*page)(void)) {
+    double best = 1e9;
+    for (int i = 0; i < REPEAT; i++) {
+        Paint_Clear(WHITE);
+        Paint_ClearDamage();
+        double start = now_ms();
+        page();
+        double ms = now_ms() - start;
+        if (ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+int main(void) {
+    UBYTE *image = malloc((size_t)PANEL_W * PANEL_H);
+    if (image == NULL || make_font() != 0)
+        return 1;
+    make_page();
+
+    printf("A page of mixed text from a %d character font on a %dx%d image, best of %d\n",
+           font.size, PANEL_W, PANEL_H, REPEAT);
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        Paint_NewImage(image, PANEL_W, PANEL_H, ROTATE_0, WHITE);
+        Paint_SetBitsPerPixel(bpp);
+
+        Paint_SetGlyphCache(0);
+        double scan = time_ms(scan_page);
+        double indexed = time_ms(index_page);
+        Paint_SetGlyphCache(4 * 1024 * 1024);
+        double cached = time_ms(index_page);
+        printf("%dbpp  scan %7.2f ms  index %7.2f ms  index+cache %6.2f ms  %5.1fx\n",
+               bpp, scan, indexed, cached, scan / cached);
+    }
+    free(table);
+    free(image);
+    return 0;
+}
@@ -0,0 +1,158 @@
+// Benchmark for filled shapes and table grids: pixels per second of the
+// scanline fills against drawing the same shapes a point at a time, as Paint
+// did before, on a full panel image at each bit depth.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/GUI_Paint.h"
+
+#define PANEL_W 1872
+#define PANEL_H 1404
+#define REPEAT 5
+
+static UBYTE *image;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// The filled rectangle as a line of points per row
+static void rect_points(void) {
+    for (UWORD y = 200; y < 1100; y++)
+        Paint_DrawLine(300, y, 1500, y, BLACK, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+}
+
+static void rect_spans(void) {
+    Paint_DrawRectangle(300, 200, 1500, 1100, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+}
+
+// The filled circle as eight points per step of each octant column
+static void circle_points(void) {
+    int X_Center = 936, Y_Center = 702, Radius = 600;
+    int XCurrent = 0, YCurrent = Radius, Esp = 3 - (Radius << 1);
+    while (XCurrent <= YCurrent) {
+        for (int s = XCurrent; s <= YCurrent; s++) {
+            Paint_DrawPoint(X_Center + XCurrent, Y_Center + s, BLACK, DOT_PIXEL_1X1, DOT_STYLE_DFT);
+            Paint_DrawPoint(X_Center - XCurrent, Y_Center + s, BLACK, DOT_PIXEL_1X1, DOT_STYLE_DFT);
+            Paint_DrawPoint(X_Center - s, Y_Center + XCurrent, BLACK, DOT_PIXEL_1X1, DOT_STYLE_DFT);
+            Paint_DrawPoint(X_Center - s, Y_Center - XCurrent, BLACK, DOT_PIXEL_1X1, DOT_STYLE_DFT);
+            Paint_DrawPoint(X_Center - XCurrent, Y_Center - s, BLACK, DOT_PIXEL_1X1, DOT_STYLE_DFT);
+            Paint_DrawPoint(X_Center + XCurrent, Y_Center - s, BLACK, DOT_PIXEL_1X1, DOT_STYLE_DFT);
+            Paint_DrawPoint(X_Center + s, Y_Center - XCurrent, BLACK, DOT_PIXEL_1X1, DOT_STYLE_DFT);
+            Paint_DrawPoint(X_Center + s, Y_Center + XCurrent, BLACK, DOT_PIXEL_1X1, DOT_STYLE_DFT);
+        }
+        if (Esp < 0)
+            Esp += 4 * XCurrent + 6;
+        else {
+            Esp += 10 + 4 * (XCurrent - YCurrent);
+            YCurrent--;
+        }
+        XCurrent++;
+    }
+}
+
+static void circle_spans(void) {
+    Paint_DrawCircle(936, 702, 600, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+}
+
+// The ellipse and rounded rectangle a pixel at a time
+static int inside_ellipse(long long dx, long long dy, long long rx, long long ry) {
+    long long a = (2 * rx + 1) * (2 * rx + 1), b = (2 * ry + 1) * (2 * ry + 1);
+    return 4 * dx * dx * b + 4 * dy * dy * a <= a * b;
+}
+
+static void ellipse_points(void) {
+    for (int y = 702 - 500; y <= 702 + 500; y++)
+        for (int x = 936 - 800; x <= 936 + 800; x++)
+            if (inside_ellipse(x - 936, y - 702, 800, 500))
+                Paint_SetPixel(x, y, BLACK);
+}
+
+static void ellipse_spans(void) {
+    Paint_DrawEllipse(936, 702, 800, 500, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+}
+
+static void rounded_points(void) {
+    for (int y = 200; y < 1100; y++)
+        for (int x = 300; x < 1500; x++) {
+            int cx = x < 380 ? 380 : (x > 1419 ? 1419 : x);
+            int cy = y < 280 ? 280 : (y > 1019 ? 1019 : y);
+            if (inside_ellipse(x - cx, y - cy, 80, 80))
+                Paint_SetPixel(x, y, BLACK);
+        }
+}
+
+static void rounded_spans(void) {
+    Paint_DrawRoundedRectangle(300, 200, 1500, 1100, 80, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+}
+
+// Table borders: 2 pixel wide dots along 36 rows and 12 columns
+static void grid_points(void) {
+    for (UWORD y = 100; y <= 1300; y += 34)
+        for (UWORD x = 100; x <= 1780; x++)
+            Paint_DrawPoint(x, y, BLACK, DOT_PIXEL_2X2, DOT_STYLE_DFT);
+    for (UWORD x = 100; x <= 1780; x += 140)
+        for (UWORD y = 100; y <= 1300; y++)
+            Paint_DrawPoint(x, y, BLACK, DOT_PIXEL_2X2, DOT_STYLE_DFT);
+}
+
+static void grid_spans(void) {
+    for (UWORD y = 100; y <= 1300; y += 34)
+        Paint_DrawLine(100, y, 1780, y, BLACK, DOT_PIXEL_2X2, LINE_STYLE_SOLID);
+    for (UWORD x = 100; x <= 1780; x += 140)
+        Paint_DrawLine(x, 100, x, 1300, BLACK, DOT_PIXEL_2X2, LINE_STYLE_SOLID);
+}
+
+// Pixels the shape covers, counted on an 8bpp image
+static unsigned long covered(void (*draw)(void)) {
+    unsigned long n = 0;
+    Paint_SetBitsPerPixel(8);
+    Paint_Clear(WHITE);
+    draw();
+    for (UDOUBLE i = 0; i < (UDOUBLE)PANEL_W * PANEL_H; i++)
+        n += image[i] == BLACK;
+    return n;
+}
+
+static double time_ms(void (*draw)(void), UBYTE bpp) {
+    double best = 1e9;
+    Paint_SetBitsPerPixel(bpp);
+    for (int i = 0; i < REPEAT; i++) {
+        Paint_Clear(WHITE);
+        Paint_ClearDamage();
+        double start = now_ms();
+        draw();
+        double ms = now_ms() - start;
+        if (ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+static void run(const char *name, void (*points)(void), void (*spans)(void)) {
+    unsigned long pixels = covered(spans);
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        double before = time_ms(points, bpp), after = time_ms(spans, bpp);
+        printf("%-17s %dbpp %8lu px  points %8.1f Mpx/s  spans %8.1f Mpx/s  %6.1fx\n", name, bpp, pixels,
+               pixels / before / 1e3, pixels / after / 1e3, before / after);
+    }
+}
+
+int main(void) {
+    image = malloc((size_t)PANEL_W * PANEL_H);
+    if (image == NULL)
+        return 1;
+    Paint_NewImage(image, PANEL_W, PANEL_H, ROTATE_0, WHITE);
+
+    printf("Filled shapes on a %dx%d image, best of %d\n", PANEL_W, PANEL_H, REPEAT);
+    run("rectangle", rect_points, rect_spans);
+    run("circle", circle_points, circle_spans);
+    run("ellipse", ellipse_points, ellipse_spans);
+    run("rounded rectangle", rounded_points, rounded_spans);
+    run("table grid", grid_points, grid_spans);
+    free(image);
+    return 0;
+}
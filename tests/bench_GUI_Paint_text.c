@@ -0,0 +1,64 @@
+// Benchmark for the glyph cache: time to draw a full page of Font16 text on a
+// panel-sized image at each bit depth, a pixel at a time with the cache off
+// and from the cache once it holds the page's glyphs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../include/GUI_Paint.h"
+
+#define PANEL_W 1872
+#define PANEL_H 1404
+#define REPEAT 5
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static const char *line = "The quick brown fox jumps over the lazy dog; PACK MY BOX WITH FIVE DOZEN LIQUOR JUGS 0123456789 (+-*/=) ";
+
+static void text_page(void) {
+    for (UWORD y = 0; y + Font16.Height <= PANEL_H; y += Font16.Height) {
+        for (UWORD x = 0; x + Font16.Width <= PANEL_W; x += 100 * Font16.Width)
+            Paint_DrawString_EN(x, y, line, &Font16, BLACK, WHITE);
+    }
+}
+
+static double time_ms(void) {
+    double best = 1e9;
+    for (int i = 0; i < REPEAT; i++) {
+        Paint_Clear(WHITE);
+        Paint_ClearDamage();
+        double start = now_ms();
+        text_page();
+        double ms = now_ms() - start;
+        if (ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+int main(void) {
+    UBYTE *image = malloc((size_t)PANEL_W * PANEL_H);
+    PAINT_GLYPH_STATS stats;
+    if (image == NULL)
+        return 1;
+
+    printf("A page of Font16 text on a %dx%d image, best of %d\n", PANEL_W, PANEL_H, REPEAT);
+    for (UWORD rotate = ROTATE_0; rotate <= ROTATE_90; rotate += 90)
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        Paint_NewImage(image, PANEL_W, PANEL_H, rotate, WHITE);
+        Paint_SetBitsPerPixel(bpp);
+
+        Paint_SetGlyphCache(0);
+        double pixels = time_ms();
+        Paint_SetGlyphCache(PAINT_GLYPH_CACHE_BYTES);
+        double cached = time_ms();
+        Paint_GetGlyphStats(&stats);
+        printf("rotate %3d %dbpp  per pixel %7.2f ms  cached %6.2f ms  %5.1fx  (%lu glyphs, %lu bytes)\n",
+               rotate, bpp, pixels, cached, pixels / cached, (unsigned long)stats.Glyphs, (unsigned long)stats.Bytes);
+    }
+    free(image);
+    return 0;
+}
@@ -0,0 +1,127 @@
+// Benchmark for the spidev transfer path: counts SPI_IOC_MESSAGE syscalls per
+// megabyte for the old per-byte loop and for the bufsiz-chunked bulk write.
+// The spidev fd is /dev/null and ioctl() is replaced by a mock that enforces
+// the kernel's whole-message bufsiz limit, so no hardware is needed.
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define DEV_HARDWARE_SPI_BUFSIZ_PATH bench_bufsiz_path
+#include "dev_hardware_SPI.h"
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+
+static char bench_bufsiz_path[64];
+static unsigned long bench_bufsiz;
+static unsigned long bench_messages;
+static unsigned long bench_bytes;
+
+static int bench_ioctl(int fd, unsigned long request, void *arg)
+{
+    (void)fd;
+    if (_IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0) {
+        struct spi_ioc_transfer *xfer = arg;
+        unsigned n = _IOC_SIZE(request) / sizeof(*xfer);
+        unsigned long total = 0;
+        unsigned i;
+
+        for (i = 0; i < n; i++) {
+            total += xfer[i].len;
+        }
+        bench_messages++;
+        // spidev_message() sums every transfer against bufsiz
+        if (total > bench_bufsiz) {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        bench_bytes += total;
+        return (int)total;
+    }
+    return 0;
+}
+
+#define ioctl bench_ioctl
+#include "../src/Config/dev_hardware_SPI.c"
+#undef ioctl
+
+#define BENCH_BYTES (1872 * 1404 / 2) // one full 4bpp frame of the 10.3" panel
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void set_bufsiz(unsigned long bufsiz)
+{
+    FILE *fp = fopen(bench_bufsiz_path, "w");
+    assert(fp != NULL);
+    fprintf(fp, "%lu\n", bufsiz);
+    fclose(fp);
+    bench_bufsiz = bufsiz;
+    DEV_HARDWARE_SPI_begin("/dev/null");
+    assert(DEV_HARDWARE_SPI_GetBufsiz() <= bufsiz);
+}
+
+static void report(const char *name, double ms)
+{
+    double mb = bench_bytes / (1024.0 * 1024.0);
+    printf("%-28s %10lu syscalls %10.1f syscalls/MB %8.2f ms\n",
+           name, bench_messages, bench_messages / mb, ms);
+}
+
+static void bench_per_byte(const uint8_t *frame)
+{
+    double t0;
+    uint32_t i;
+
+    set_bufsiz(DEV_HARDWARE_SPI_DEFAULT_BUFSIZ);
+    bench_messages = 0;
+    bench_bytes = 0;
+    t0 = now_ms();
+    for (i = 0; i < BENCH_BYTES; i++) {
+        DEV_HARDWARE_SPI_TransferByte(frame[i]);
+    }
+    report("TransferByte loop", now_ms() - t0);
+    assert(bench_bytes == BENCH_BYTES);
+    DEV_HARDWARE_SPI_end();
+}
+
+static void bench_bulk(const uint8_t *frame, unsigned long bufsiz)
+{
+    char name[64];
+    double t0;
+
+    set_bufsiz(bufsiz);
+    bench_messages = 0;
+    bench_bytes = 0;
+    t0 = now_ms();
+    assert(DEV_HARDWARE_SPI_Write(frame, BENCH_BYTES) == 1);
+    snprintf(name, sizeof(name), "Write, bufsiz %lu", bufsiz);
+    report(name, now_ms() - t0);
+    assert(bench_bytes == BENCH_BYTES);
+    assert(bench_messages == (BENCH_BYTES + DEV_HARDWARE_SPI_GetBufsiz() - 1) / DEV_HARDWARE_SPI_GetBufsiz());
+    DEV_HARDWARE_SPI_end();
+}
+
+int main(void)
+{
+    static uint8_t frame[BENCH_BYTES];
+    uint32_t i;
+
+    snprintf(bench_bufsiz_path, sizeof(bench_bufsiz_path), "/tmp/bench_spidev_bufsiz.%d", (int)getpid());
+    for (i = 0; i < BENCH_BYTES; i++) {
+        frame[i] = (uint8_t)i;
+    }
+
+    bench_per_byte(frame);
+    bench_bulk(frame, 4096);
+    bench_bulk(frame, 65536);
+    bench_bulk(frame, 1048576);
+
+    unlink(bench_bufsiz_path);
+    return 0;
+}
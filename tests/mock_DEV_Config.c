@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string.h>
 #include "../include/DEV_Config.h"
 
 void DEV_Delay_us(uint32_t xus) { (void)xus; }
@@ -6,8 +7,25 @@ void DEV_Delay_ms(uint32_t xms) { (void)xms; }
 
 // Stubs for other functions if needed by tests
 void DEV_Digital_Write(uint16_t Pin, uint8_t Value) { (void)Pin; (void)Value; }
-uint8_t DEV_Digital_Read(uint16_t Pin) { (void)Pin; return 0; }
-void DEV_SPI_WriteByte(uint8_t Value) { (void)Value; }
-uint8_t DEV_SPI_ReadByte(void) { return 0; }
+// BUSY reads back idle (1) so driver calls never spin; tests set it to 0 to
+// simulate a controller that never becomes ready
+uint8_t mock_busy_level = 1;
+uint32_t mock_busy_waits = 0;
+uint8_t DEV_Digital_Read(uint16_t Pin) { (void)Pin; return mock_busy_level; }
+int DEV_Digital_WaitLevel(uint16_t Pin, uint8_t Value, uint32_t Timeout_us) { (void)Pin; (void)Timeout_us; mock_busy_waits++; return mock_busy_level == Value ? 0 : -1; }
+
+// Every byte written to the bus is folded into an FNV-1a hash so tests can
+// compare what two code paths put on the wire
+uint32_t mock_spi_tx_bytes = 0;
+uint32_t mock_spi_tx_hash = 2166136261u;
+static void mock_spi_tx(uint8_t Value) { mock_spi_tx_hash = (mock_spi_tx_hash ^ Value) * 16777619u; mock_spi_tx_bytes++; }
+void mock_spi_tx_reset(void) { mock_spi_tx_bytes = 0; mock_spi_tx_hash = 2166136261u; }
+
+void DEV_SPI_WriteByte(uint8_t Value) { mock_spi_tx(Value); }
+// The next mock_spi_read_busy_bytes reads return 0xFF (e.g. LUTAFSR busy), then 0
+uint32_t mock_spi_read_busy_bytes = 0;
+uint8_t DEV_SPI_ReadByte(void) { if (mock_spi_read_busy_bytes > 0) { mock_spi_read_busy_bytes--; return 0xFF; } return 0; }
+void DEV_SPI_WriteBuffer(const uint8_t *pData, uint32_t Len) { for (uint32_t i = 0; i < Len; i++) mock_spi_tx(pData[i]); }
+void DEV_SPI_ReadBuffer(uint8_t *pData, uint32_t Len) { memset(pData, 0, Len); }
 unsigned char DEV_Module_Init(void) { return 0; }
 void DEV_Module_Exit(void) {} 
\ No newline at end of file
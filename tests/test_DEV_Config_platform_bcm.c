@@ -20,7 +20,13 @@ void bcm2835_spi_setDataMode(int x) { bcm2835_spi_setDataMode_called = 1; }
 void bcm2835_spi_setClockDivider(int x) { bcm2835_spi_setClockDivider_called = 1; }
 void bcm2835_spi_end() { bcm2835_spi_end_called = 1; }
 void bcm2835_close() { bcm2835_close_called = 1; }
-unsigned char bcm2835_spi_transfer(unsigned char value) { return 0; }
+int bcm2835_spi_transfer_calls = 0;
+int bcm2835_spi_writenb_calls = 0;
+unsigned int bcm2835_spi_writenb_len = 0;
+unsigned char bcm2835_spi_transfer(unsigned char value) { (void)value; bcm2835_spi_transfer_calls++; return 0; }
+void bcm2835_spi_writenb(const char *buf, unsigned int len) { (void)buf; bcm2835_spi_writenb_calls++; bcm2835_spi_writenb_len += len; }
+void bcm2835_spi_transfern(char *buf, unsigned int len) { for (unsigned int i = 0; i < len; i++) buf[i] = (char)0xA5; }
+unsigned int bcm2835_version(void) { return 10000; }
 void bcm2835_gpio_write(int pin, int value) { (void)pin; (void)value; }
 int bcm2835_gpio_lev(int pin) { (void)pin; return 0; }
 void bcm2835_delay(unsigned int ms) { (void)ms; }
@@ -62,9 +68,28 @@ void test_bcm_platform_error() {
     bcm2835_init_should_fail = 0;
 }
 
+void test_bcm_spi_buffer() {
+    unsigned char tx[4096];
+    unsigned char rx[16];
+    bcm2835_spi_transfer_calls = 0;
+    bcm2835_spi_writenb_calls = 0;
+    bcm2835_spi_writenb_len = 0;
+    DEV_SPI_WriteBuffer(tx, sizeof(tx));
+    // A whole buffer goes out as one library call, not one call per byte
+    assert(bcm2835_spi_writenb_calls == 1);
+    assert(bcm2835_spi_writenb_len == sizeof(tx));
+    assert(bcm2835_spi_transfer_calls == 0);
+    DEV_SPI_ReadBuffer(rx, sizeof(rx));
+    for (unsigned int i = 0; i < sizeof(rx); i++) {
+        assert(rx[i] == 0xA5);
+    }
+    assert(bcm2835_spi_transfer_calls == 0);
+}
+
 int main() {
     test_bcm_platform_success();
     test_bcm_platform_error();
+    test_bcm_spi_buffer();
     printf("DEV_Config BCM platform selection and error handling tests passed!\n");
     return 0;
 } 
\ No newline at end of file
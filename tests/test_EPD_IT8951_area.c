@@ -0,0 +1,58 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/EPD_IT8951.h"
+
+extern UBYTE GC16_Mode;
+extern UBYTE A2_Mode;
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+
+static UBYTE frame[64 * 16];
+
+void test_rejects_bad_areas(void) {
+    EPD_IT8951_Init(0);
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Area_Refresh(NULL, 0, 0, 64, 16, 4, GC16_Mode, TEST_ADDR) == -2);
+    assert(EPD_IT8951_Area_Refresh(frame, 0, 0, 0, 16, 4, GC16_Mode, TEST_ADDR) == -2);
+    assert(EPD_IT8951_Area_Refresh(frame, 0, 0, 64, 16, 3, GC16_Mode, TEST_ADDR) == -2);
+    // 4bpp rows must be whole words, 1bpp areas whole bytes
+    assert(EPD_IT8951_Area_Refresh(frame, 0, 0, 6, 16, 4, GC16_Mode, TEST_ADDR) == -2);
+    assert(EPD_IT8951_Area_Refresh(frame, 4, 0, 64, 16, 1, A2_Mode, TEST_ADDR) == -2);
+    // Nothing reaches the bus for a rejected area
+    assert(mock_spi_tx_bytes == 0);
+}
+
+void test_refresh_uses_requested_mode(void) {
+    UDOUBLE a2_before = EPD_IT8951_GetRefreshEstimate(A2_Mode);
+    UDOUBLE gc16_before = EPD_IT8951_GetRefreshEstimate(GC16_Mode);
+
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        mock_spi_tx_reset();
+        assert(EPD_IT8951_Area_Refresh(frame, 0, 0, 64, 16, bpp, A2_Mode, TEST_ADDR) == 0);
+        assert(mock_spi_tx_bytes > 0);
+        assert(EPD_IT8951_WaitForRefresh(NULL) == 0);
+    }
+    // Only the A2 estimate learned from these refreshes
+    assert(EPD_IT8951_GetRefreshEstimate(A2_Mode) < a2_before);
+    assert(EPD_IT8951_GetRefreshEstimate(GC16_Mode) == gc16_before);
+}
+
+void test_draw_bmp_needs_panel_info(void) {
+    IT8951_Dev_Info dev_info;
+    memset(&dev_info, 0, sizeof(dev_info));
+    assert(EPD_IT8951_DrawBMP(dev_info, "assets/test.bmp", 0) == -10);
+}
+
+int main(void) {
+    memset(frame, 0xFF, sizeof(frame));
+    test_rejects_bad_areas();
+    test_refresh_uses_requested_mode();
+    test_draw_bmp_needs_panel_info();
+    printf("All EPD_IT8951 area refresh tests passed!\n");
+    return 0;
+}
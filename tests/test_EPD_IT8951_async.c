@@ -0,0 +1,66 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../include/EPD_IT8951.h"
+#include "../include/EPD_IT8951_AsyncTx.h"
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+extern uint32_t mock_spi_tx_hash;
+void mock_spi_tx_reset(void);
+
+#define TEST_W 800
+#define TEST_H 600
+#define TEST_ADDR 0x001236E0
+
+static UBYTE *make_frame(void) {
+    UBYTE *frame = malloc(TEST_W * TEST_H / 2);
+    assert(frame != NULL);
+    for (int i = 0; i < TEST_W * TEST_H / 2; i++) {
+        frame[i] = (UBYTE)(i * 7 + (i >> 9));
+    }
+    return frame;
+}
+
+void test_async_matches_sync(void) {
+    UBYTE *frame = make_frame();
+    uint32_t sync_hash, sync_bytes;
+    EPD_IT8951_Stats stats;
+
+    EPD_IT8951_Init(0);
+    assert(!EPD_IT8951_AsyncTx_Running());
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, true);
+    sync_hash = mock_spi_tx_hash;
+    sync_bytes = mock_spi_tx_bytes;
+    // Full frame is more than 16 bit worth of words
+    assert(sync_bytes > TEST_W * TEST_H / 2);
+
+    EPD_IT8951_InitEx(0, EPD_IT8951_INIT_ASYNC_TX);
+    assert(EPD_IT8951_AsyncTx_Running());
+    EPD_IT8951_ResetStats();
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, true);
+    assert(mock_spi_tx_bytes == sync_bytes);
+    assert(mock_spi_tx_hash == sync_hash);
+
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Async_Streams == 1);
+    assert(stats.Async_Chunks == (TEST_W * TEST_H / 2 + EPD_IT8951_ASYNC_TX_SLOT_BYTES - 1) / EPD_IT8951_ASYNC_TX_SLOT_BYTES);
+    assert(stats.Async_Overlap >= 0.0f && stats.Async_Overlap <= 1.0f);
+
+    EPD_IT8951_ResetStats();
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Async_Chunks == 0);
+
+    // Re-initialising without the flag stops the worker
+    EPD_IT8951_Init(0);
+    assert(!EPD_IT8951_AsyncTx_Running());
+    free(frame);
+}
+
+int main(void) {
+    test_async_matches_sync();
+    printf("All EPD_IT8951 async transmit tests passed!\n");
+    return 0;
+}
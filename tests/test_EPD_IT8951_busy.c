@@ -0,0 +1,71 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/EPD_IT8951.h"
+
+// Provided by mock_DEV_Config.c
+extern uint8_t mock_busy_level;
+extern uint32_t mock_busy_waits;
+
+void test_idle_controller_never_blocks(void) {
+    EPD_IT8951_Stats stats;
+
+    mock_busy_level = 1;
+    mock_busy_waits = 0;
+    EPD_IT8951_ResetStats();
+    EPD_IT8951_Init(0);
+
+    EPD_IT8951_GetStats(&stats);
+    assert(EPD_IT8951_GetError() == 0);
+    assert(stats.Busy_Spin_Hits > 0);
+    assert(stats.Busy_Spin_Iterations == stats.Busy_Spin_Hits);
+    assert(stats.Busy_Blocking_Waits == 0);
+    assert(stats.Busy_Timeouts == 0);
+    assert(mock_busy_waits == 0);
+}
+
+void test_stuck_busy_times_out_once(void) {
+    EPD_IT8951_Stats stats;
+    UBYTE frame[64 * 16 / 2];
+
+    memset(frame, 0xFF, sizeof(frame));
+    mock_busy_level = 1;
+    EPD_IT8951_Init(0);
+
+    mock_busy_level = 0;
+    mock_busy_waits = 0;
+    EPD_IT8951_SetBusyTimeout(10);
+    EPD_IT8951_ResetStats();
+    // Unpacked write: two HRDY waits per word if nothing short-circuits
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, 64, 16, false, 0x001236E0, false);
+
+    EPD_IT8951_GetStats(&stats);
+    assert(EPD_IT8951_GetError() == EPD_IT8951_ERR_BUSY_TIMEOUT);
+    assert(stats.Busy_Timeouts == 1);
+    assert(stats.Busy_Blocking_Waits == 1);
+    assert(stats.Busy_Spin_Hits == 0);
+    assert(stats.Busy_Spin_Iterations == EPD_IT8951_BUSY_SPIN_LIMIT);
+    assert(mock_busy_waits == 1);
+
+    EPD_IT8951_ClearError();
+    assert(EPD_IT8951_GetError() == 0);
+    mock_busy_level = 1;
+    EPD_IT8951_SetBusyTimeout(EPD_IT8951_BUSY_TIMEOUT_MS);
+}
+
+void test_displaybmp_reports_timeout(void) {
+    mock_busy_level = 0;
+    assert(EPD_IT8951_DisplayBMP("assets/test.bmp", 0, 2) == -13);
+    mock_busy_level = 1;
+    EPD_IT8951_Init(0);
+    assert(EPD_IT8951_GetError() == 0);
+}
+
+int main(void) {
+    test_idle_controller_never_blocks();
+    test_stuck_busy_times_out_once();
+    test_displaybmp_reports_timeout();
+    printf("All EPD_IT8951 busy wait tests passed!\n");
+    return 0;
+}
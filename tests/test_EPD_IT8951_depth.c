@@ -0,0 +1,190 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/EPD_IT8951.h"
+#include "../include/EPD_IT8951_Depth.h"
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+extern uint32_t mock_spi_tx_hash;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+#define TEST_W 128
+#define TEST_H 64
+#define ROW (TEST_W / 2)
+
+static UBYTE frame[ROW * TEST_H];
+static UBYTE packed[ROW * TEST_H];
+
+// 4bpp, even pixels in the low nibble
+static void set_pixel(UWORD x, UWORD y, UBYTE gray) {
+    UBYTE *b = &frame[y * ROW + x / 2];
+    if (x % 2)
+        *b = (*b & 0x0F) | (gray << 4);
+    else
+        *b = (*b & 0xF0) | gray;
+}
+
+static UBYTE analyze(EPD_IT8951_Depth_Plan *plan) {
+    return EPD_IT8951_Depth_Analyze(frame, TEST_W, TEST_H, 4, ROW, plan);
+}
+
+void test_analyze(void) {
+    EPD_IT8951_Depth_Plan plan;
+
+    memset(frame, 0xFF, sizeof(frame));
+    assert(analyze(&plan) == 1);
+    assert(plan.Levels == 1);
+
+    // Text: black on white
+    set_pixel(3, 2, 0x0);
+    assert(analyze(&plan) == 1);
+    assert(plan.Levels == 2 && plan.Gray[0] == 0x00 && plan.Gray[1] == 0xFF);
+
+    // Two grays 2bpp can hold
+    set_pixel(4, 2, 0x5);
+    set_pixel(5, 2, 0xA);
+    assert(analyze(&plan) == 2);
+    assert(plan.Levels == 4);
+
+    // 0x8 is not a 2bpp gray
+    set_pixel(5, 2, 0x8);
+    assert(analyze(&plan) == 4);
+
+    // Five grays
+    set_pixel(6, 2, 0xA);
+    assert(analyze(&plan) == 4);
+    assert(plan.Levels == 5);
+
+    // Any two grays fit 1bpp through BGVR
+    memset(frame, 0x88, sizeof(frame));
+    set_pixel(0, 0, 0x3);
+    assert(analyze(&plan) == 1);
+    assert(plan.Gray[0] == 0x33 && plan.Gray[1] == 0x88);
+}
+
+void test_pack(void) {
+    EPD_IT8951_Depth_Plan plan;
+
+    memset(frame, 0xFF, sizeof(frame));
+    set_pixel(0, 0, 0x0);
+    set_pixel(9, 1, 0x0);
+    assert(analyze(&plan) == 1);
+    EPD_IT8951_Depth_Pack(frame, TEST_W, TEST_H, 4, ROW, &plan, packed);
+    // Leftmost pixel in the low bit, white is 1, as Paint draws 1bpp
+    assert(packed[0] == 0xFE && packed[1] == 0xFF);
+    assert(packed[TEST_W / 8 + 1] == 0xFD);
+
+    set_pixel(1, 0, 0x5);
+    set_pixel(2, 0, 0xA);
+    assert(analyze(&plan) == 2);
+    EPD_IT8951_Depth_Pack(frame, TEST_W, TEST_H, 4, ROW, &plan, packed);
+    // Leftmost pixel in the low bits: 0, 1, 2, 3
+    assert(packed[0] == 0xE4 && packed[1] == 0xFF);
+}
+
+void test_8bpp(void) {
+    static UBYTE frame8[TEST_W * TEST_H];
+    EPD_IT8951_Depth_Plan plan;
+
+    // Paint keeps the high nibble at 8bpp
+    memset(frame8, 0xF0, sizeof(frame8));
+    frame8[3] = 0x00;
+    assert(EPD_IT8951_Depth_Analyze(frame8, TEST_W, TEST_H, 8, TEST_W, &plan) == 1);
+    assert(plan.Gray[0] == 0x00 && plan.Gray[1] == 0xFF);
+
+    frame8[1] = 0x50;
+    frame8[2] = 0xA0;
+    frame8[0] = 0x00;
+    frame8[3] = 0xF7;
+    assert(EPD_IT8951_Depth_Analyze(frame8, TEST_W, TEST_H, 8, TEST_W, &plan) == 2);
+    assert(plan.Levels == 4);
+    EPD_IT8951_Depth_Pack(frame8, TEST_W, TEST_H, 8, TEST_W, &plan, packed);
+    assert(packed[0] == 0xE4 && packed[1] == 0xFF);
+
+    frame8[4] = 0x80;
+    assert(EPD_IT8951_Depth_Analyze(frame8, TEST_W, TEST_H, 8, TEST_W, &plan) == 8);
+}
+
+void test_refresh(void) {
+    EPD_IT8951_Depth_Plan plan;
+    EPD_IT8951_Stats stats;
+    IT8951_Dev_Info info;
+    uint32_t full_bytes, expected;
+
+    memset(&info, 0, sizeof(info));
+    info.Panel_W = TEST_W;
+    info.Panel_H = TEST_H;
+
+    memset(frame, 0xFF, sizeof(frame));
+    set_pixel(20, 20, 0x0);
+
+    // Warm the register shadow before counting bytes
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    full_bytes = mock_spi_tx_bytes;
+
+    // Text goes out as 1bpp, a quarter of the pixel bytes
+    EPD_IT8951_SetAdaptiveDepth(true);
+    EPD_IT8951_ResetStats();
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    assert(mock_spi_tx_bytes < full_bytes - sizeof(frame) / 2);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Depth_1bpp_Uploads == 2);
+    assert(stats.Depth_Bytes_Saved == 2 * sizeof(frame) * 3 / 4);
+    assert(EPD_IT8951_Area_Refresh(frame, 0, 0, TEST_W, TEST_H, 4, 2, TEST_ADDR) == 0);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Depth_1bpp_Uploads == 3);
+
+    // A dashboard with 2bpp grays is the same upload as a 2bpp frame
+    set_pixel(21, 20, 0x5);
+    set_pixel(22, 20, 0xA);
+    assert(analyze(&plan) == 2);
+    EPD_IT8951_Depth_Pack(frame, TEST_W, TEST_H, 4, ROW, &plan, packed);
+    EPD_IT8951_SetAdaptiveDepth(false);
+    mock_spi_tx_reset();
+    EPD_IT8951_2bp_Refresh(packed, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    expected = mock_spi_tx_hash;
+
+    EPD_IT8951_SetAdaptiveDepth(true);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    assert(mock_spi_tx_hash == expected);
+
+    // Rotated black and white falls back to 2bpp
+    memset(frame, 0xFF, sizeof(frame));
+    set_pixel(20, 20, 0x0);
+    EPD_IT8951_ResetStats();
+    assert(EPD_IT8951_SetRotate(info, 180) == 0);
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    assert(EPD_IT8951_SetRotate(info, 0) == 0);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Depth_1bpp_Uploads == 0 && stats.Depth_2bpp_Uploads == 1);
+
+    // Photos are sent as they are
+    for (UWORD x = 0; x < 16; x++)
+        set_pixel(x, 0, (UBYTE)x);
+    EPD_IT8951_ResetStats();
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    assert(mock_spi_tx_bytes == full_bytes);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Depth_Bytes_Saved == 0);
+
+    EPD_IT8951_SetAdaptiveDepth(false);
+    assert(EPD_IT8951_GetError() == 0);
+}
+
+int main(void) {
+    test_analyze();
+    test_pack();
+    test_8bpp();
+    EPD_IT8951_Init(0);
+    test_refresh();
+    printf("All EPD_IT8951 adaptive depth tests passed!\n");
+    return 0;
+}
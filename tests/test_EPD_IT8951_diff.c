@@ -0,0 +1,149 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/EPD_IT8951.h"
+#include "../include/EPD_IT8951_Diff.h"
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+extern uint32_t mock_spi_tx_hash;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+#define TEST_W 320
+#define TEST_H 240
+#define ROW (TEST_W / 2)
+
+static UBYTE old_frame[TEST_W * TEST_H / 2];
+static UBYTE new_frame[TEST_W * TEST_H / 2];
+
+static void set_pixel(UBYTE *frame, UWORD x, UWORD y) {
+    frame[y * ROW + x / 2] ^= (x % 2) ? 0xF0 : 0x0F;
+}
+
+void test_identical(void) {
+    IT8951_Area_Img_Info areas[8];
+    memset(old_frame, 0xFF, sizeof(old_frame));
+    memcpy(new_frame, old_frame, sizeof(new_frame));
+    assert(EPD_IT8951_Diff_Areas(old_frame, new_frame, TEST_W, TEST_H, 4, areas, 8) == 0);
+}
+
+void test_single_tile(void) {
+    IT8951_Area_Img_Info areas[8];
+    memcpy(new_frame, old_frame, sizeof(new_frame));
+    set_pixel(new_frame, 70, 100);
+    assert(EPD_IT8951_Diff_Areas(old_frame, new_frame, TEST_W, TEST_H, 4, areas, 8) == 1);
+    assert(areas[0].Area_X == 64 && areas[0].Area_Y == 96);
+    assert(areas[0].Area_W == 32 && areas[0].Area_H == 32);
+}
+
+// Neighbouring tiles in a row become one area, and so do equal spans in consecutive rows
+void test_merge(void) {
+    IT8951_Area_Img_Info areas[8];
+    memcpy(new_frame, old_frame, sizeof(new_frame));
+    set_pixel(new_frame, 10, 5);
+    set_pixel(new_frame, 40, 5);
+    assert(EPD_IT8951_Diff_Areas(old_frame, new_frame, TEST_W, TEST_H, 4, areas, 8) == 1);
+    assert(areas[0].Area_X == 0 && areas[0].Area_W == 64 && areas[0].Area_H == 32);
+
+    set_pixel(new_frame, 10, 40);
+    set_pixel(new_frame, 40, 40);
+    set_pixel(new_frame, 10, 70);
+    set_pixel(new_frame, 40, 70);
+    assert(EPD_IT8951_Diff_Areas(old_frame, new_frame, TEST_W, TEST_H, 4, areas, 8) == 1);
+    assert(areas[0].Area_X == 0 && areas[0].Area_Y == 0);
+    assert(areas[0].Area_W == 64 && areas[0].Area_H == 96);
+
+    // A different span starts a second area
+    set_pixel(new_frame, 200, 70);
+    assert(EPD_IT8951_Diff_Areas(old_frame, new_frame, TEST_W, TEST_H, 4, areas, 8) == 2);
+}
+
+// The last tile row is clipped to the frame
+void test_edge_clip(void) {
+    IT8951_Area_Img_Info areas[8];
+    memcpy(new_frame, old_frame, sizeof(new_frame));
+    set_pixel(new_frame, 310, 239);
+    assert(EPD_IT8951_Diff_Areas(old_frame, new_frame, TEST_W, 232, 4, areas, 8) == 0);
+    assert(EPD_IT8951_Diff_Areas(old_frame, new_frame, TEST_W, TEST_H, 4, areas, 8) == 1);
+    assert(areas[0].Area_X == 288 && areas[0].Area_W == 32);
+    assert(areas[0].Area_Y == 224 && areas[0].Area_H == 16);
+}
+
+// Too many areas fold into their bounding box
+void test_overflow(void) {
+    IT8951_Area_Img_Info areas[2];
+    memcpy(new_frame, old_frame, sizeof(new_frame));
+    set_pixel(new_frame, 0, 0);
+    set_pixel(new_frame, 100, 50);
+    set_pixel(new_frame, 200, 150);
+    assert(EPD_IT8951_Diff_Areas(old_frame, new_frame, TEST_W, TEST_H, 4, areas, 2) == 1);
+    assert(areas[0].Area_X == 0 && areas[0].Area_Y == 0);
+    assert(areas[0].Area_W == 224 && areas[0].Area_H == 160);
+}
+
+void test_incremental_refresh(void) {
+    EPD_IT8951_Stats stats;
+    uint32_t full_bytes;
+
+    memset(old_frame, 0xFF, sizeof(old_frame));
+    // Warm the register shadow before counting bytes
+    EPD_IT8951_4bp_Refresh(old_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, true);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(old_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, true);
+    full_bytes = mock_spi_tx_bytes;
+
+    EPD_IT8951_SetIncremental(true);
+    EPD_IT8951_ResetStats();
+
+    // First frame: nothing to compare against
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(old_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, true);
+    assert(mock_spi_tx_bytes == full_bytes);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Diff_Updates == 1 && stats.Diff_Last_Bytes_Avoided == 0);
+
+    // Same frame again: no upload and no refresh
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(old_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, true);
+    assert(mock_spi_tx_bytes == 0);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Diff_Last_Bytes_Avoided == sizeof(old_frame));
+
+    // One pixel: one 32x32 tile of 512 bytes plus commands
+    memcpy(new_frame, old_frame, sizeof(new_frame));
+    set_pixel(new_frame, 150, 120);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(new_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, true);
+    assert(mock_spi_tx_bytes > 512);
+    assert(mock_spi_tx_bytes < 512 + 128);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Diff_Areas == 2);
+    assert(stats.Diff_Bytes_Sent == sizeof(old_frame) + 512);
+    assert(stats.Diff_Last_Bytes_Avoided == sizeof(old_frame) - 512);
+    assert(EPD_IT8951_GetError() == 0);
+
+    // A fill into the same buffer makes the copy stale
+    assert(EPD_IT8951_Fill_Area(0, 0, 32, 32, 0x00, TEST_ADDR) == 0);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(new_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, true);
+    assert(mock_spi_tx_bytes == full_bytes);
+
+    // Back to plain uploads
+    EPD_IT8951_SetIncremental(false);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(new_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, true);
+    assert(mock_spi_tx_bytes == full_bytes);
+}
+
+int main(void) {
+    test_identical();
+    test_single_tile();
+    test_merge();
+    test_edge_clip();
+    test_overflow();
+    EPD_IT8951_Init(0);
+    test_incremental_refresh();
+    printf("All EPD_IT8951 frame diff tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/EPD_IT8951.h"
+#include "../include/GUI_Paint.h"
+
+extern UBYTE GC16_Mode;
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+extern uint32_t mock_spi_tx_hash;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+#define TEST_W 320
+#define TEST_H 240
+
+static UBYTE frame[TEST_W * TEST_H / 2];
+
+// A full-image clear sends the same bytes as refreshing the whole frame
+void test_full_damage_matches_area_refresh(void) {
+    uint32_t full_hash, full_bytes;
+
+    Paint_NewImage(frame, TEST_W, TEST_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(4);
+    Paint_Clear(WHITE);
+
+    // Warm the register shadow so both runs skip the same writes
+    assert(EPD_IT8951_Area_Refresh(frame, 0, 0, TEST_W, TEST_H, 4, GC16_Mode, TEST_ADDR) == 0);
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Area_Refresh(frame, 0, 0, TEST_W, TEST_H, 4, GC16_Mode, TEST_ADDR) == 0);
+    full_hash = mock_spi_tx_hash;
+    full_bytes = mock_spi_tx_bytes;
+
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_RefreshDirty(GC16_Mode, TEST_ADDR) == 1);
+    assert(mock_spi_tx_bytes == full_bytes);
+    assert(mock_spi_tx_hash == full_hash);
+
+    // Nothing changed since
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_RefreshDirty(GC16_Mode, TEST_ADDR) == 0);
+    assert(mock_spi_tx_bytes == 0);
+}
+
+// Redrawing a clock sends only the clock
+void test_small_update(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    uint32_t expected;
+
+    Paint_DrawString_EN(101, 50, "12:34", &Font12, BLACK, WHITE);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 4) == 1);
+    assert(rects[0].X % 4 == 0 && rects[0].W % 4 == 0);
+    // 4 pixels per 16 bit word
+    expected = (uint32_t)rects[0].W / 4 * rects[0].H * 2;
+
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_RefreshDirty(GC16_Mode, TEST_ADDR) == 1);
+    assert(mock_spi_tx_bytes > expected);
+    assert(mock_spi_tx_bytes < expected + 256);
+    assert(mock_spi_tx_bytes < TEST_W * TEST_H / 2 / 10);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 4) == 0);
+}
+
+void test_separate_areas(void) {
+    Paint_ClearWindows(0, 0, 8, 8, BLACK);
+    Paint_ClearWindows(300, 200, 310, 230, BLACK);
+    assert(EPD_IT8951_RefreshDirty(GC16_Mode, TEST_ADDR) == 2);
+}
+
+int main(void) {
+    EPD_IT8951_Init(0);
+    test_full_damage_matches_area_refresh();
+    test_small_update();
+    test_separate_areas();
+    printf("All EPD_IT8951 dirty area tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/EPD_IT8951.h"
+
+extern UBYTE GC16_Mode;
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+extern uint32_t mock_spi_tx_hash;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+
+// A fill must put the same bytes on the wire as a packed upload of a solid frame
+static void check_fill_matches_upload(UWORD w, UWORD h, UBYTE gray) {
+    UDOUBLE size = (UDOUBLE)w * h / 2;
+    UBYTE *frame = malloc(size);
+    uint32_t upload_hash, upload_bytes;
+    EPD_IT8951_Stats stats;
+
+    assert(frame != NULL);
+    memset(frame, (gray & 0xF0) | (gray >> 4), size);
+    // Warm the register shadow so both runs skip the same writes
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, w, h, false, TEST_ADDR, true);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, w, h, false, TEST_ADDR, true);
+    upload_hash = mock_spi_tx_hash;
+    upload_bytes = mock_spi_tx_bytes;
+    free(frame);
+
+    EPD_IT8951_ResetStats();
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Fill_Refresh(0, 0, w, h, gray, GC16_Mode, TEST_ADDR) == 0);
+    assert(mock_spi_tx_bytes == upload_bytes);
+    assert(mock_spi_tx_hash == upload_hash);
+
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Fill_Areas == 1);
+    assert(stats.Fill_Words == size / 2);
+}
+
+void test_fill_matches_upload(void) {
+    EPD_IT8951_Init(0);
+    check_fill_matches_upload(64, 16, 0xFF);
+    check_fill_matches_upload(64, 16, 0x80);
+    // Larger than the staging buffer, so the pattern is sent many times
+    check_fill_matches_upload(1872, 1404, 0xFF);
+}
+
+void test_fill_rows_are_whole_words(void) {
+    EPD_IT8951_Stats stats;
+    EPD_IT8951_ResetStats();
+    // 6 pixels at 4bpp is 24 bits, padded to two words per row
+    assert(EPD_IT8951_Fill_Area(2, 3, 6, 10, 0x00, TEST_ADDR) == 0);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Fill_Words == 2 * 10);
+    assert(EPD_IT8951_Fill_Area(0, 0, 0, 10, 0x00, TEST_ADDR) == -2);
+}
+
+void test_clear_uses_fill(void) {
+    IT8951_Dev_Info dev_info;
+    EPD_IT8951_Stats stats;
+    memset(&dev_info, 0, sizeof(dev_info));
+    dev_info.Panel_W = 1872;
+    dev_info.Panel_H = 1404;
+
+    EPD_IT8951_ResetStats();
+    EPD_IT8951_Clear_Refresh(dev_info, TEST_ADDR, 0);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Fill_Areas == 1);
+    assert(stats.Fill_Words == 1872 * 1404 / 4);
+}
+
+int main(void) {
+    test_fill_matches_upload();
+    test_fill_rows_are_whole_words();
+    test_clear_uses_fill();
+    printf("All EPD_IT8951 fill tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/EPD_IT8951.h"
+#include "../include/EPD_IT8951_Pack.h"
+#include "../include/GUI_Paint.h"
+
+extern UBYTE GC16_Mode;
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+extern uint32_t mock_spi_tx_hash;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+#define TEST_W 320
+#define TEST_H 240
+#define ROW_MAX 600
+
+static UBYTE surface[TEST_W * TEST_H];
+static UBYTE frame[TEST_W * TEST_H];
+static UBYTE packed[TEST_W * TEST_H];
+
+// One pixel at a time, as Paint_SetPixel() stores it at the lower depth
+static void reference_row(const UBYTE *src, UBYTE *dst, UDOUBLE pixels, UBYTE bpp) {
+    memset(dst, 0, (pixels * bpp + 7) / 8);
+    for (UDOUBLE x = 0; x < pixels; x++)
+        dst[x * bpp / 8] |= (src[x] >> (8 - bpp)) << (x * bpp % 8);
+}
+
+// Every kernel against the reference, at every length and source alignment
+void test_kernels_match_reference(void) {
+    static UBYTE src[ROW_MAX + 16];
+    static UBYTE want[ROW_MAX + 8], got[ROW_MAX + 8];
+    int kernels = 0;
+
+    srand(7);
+    for (int i = 0; i < (int)sizeof(src); i++)
+        src[i] = (UBYTE)rand();
+    for (int k = 0; k < EPD_IT8951_PACK_KERNELS; k++) {
+        if (!EPD_IT8951_Pack_Supported(k)) {
+            assert(EPD_IT8951_Pack_SetKernel(k) == -2);
+            continue;
+        }
+        assert(EPD_IT8951_Pack_SetKernel(k) == 0);
+        assert(EPD_IT8951_Pack_GetKernel() == (EPD_IT8951_Pack_Kernel)k);
+        kernels++;
+        for (UBYTE bpp = 1; bpp <= 8; bpp *= 2)
+            for (UDOUBLE pixels = 0; pixels <= ROW_MAX; pixels += (pixels < 300 ? 1 : 37))
+                for (int offset = 0; offset < 16; offset += 5) {
+                    UDOUBLE bytes = (pixels * bpp + 7) / 8;
+                    if (bpp == 8)
+                        memcpy(want, src + offset, pixels);
+                    else
+                        reference_row(src + offset, want, pixels, bpp);
+                    memset(got, 0xA5, sizeof(got));
+                    EPD_IT8951_Pack_Row(src + offset, got, pixels, bpp);
+                    assert(memcmp(got, want, bytes) == 0);
+                    // Nothing past the row is written
+                    assert(got[bytes] == 0xA5);
+                }
+    }
+    printf("Pack kernels checked: %d\n", kernels);
+    assert(EPD_IT8951_Pack_SetKernel(EPD_IT8951_PACK_KERNELS) == -2);
+    assert(strcmp(EPD_IT8951_Pack_KernelName(EPD_IT8951_PACK_SCALAR), "scalar") == 0);
+    assert(strcmp(EPD_IT8951_Pack_KernelName(EPD_IT8951_PACK_KERNELS), "?") == 0);
+}
+
+static void draw_page(UBYTE bpp, UBYTE *image) {
+    Paint_NewImage(image, TEST_W, TEST_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(bpp);
+    Paint_Clear(WHITE);
+    Paint_DrawString_EN(10, 10, "Packed at upload", &Font16, BLACK, WHITE);
+    Paint_DrawRectangle(20, 40, 300, 200, 0x80, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
+    Paint_DrawCircle(160, 120, 60, 0x40, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    for (UWORD x = 0; x < 256; x++)
+        Paint_DrawLine(32 + x, 210, 32 + x, 230, x, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+}
+
+// A page drawn at 8bpp and packed is the page drawn at the lower depth
+void test_area_matches_paint(void) {
+    draw_page(8, surface);
+    for (UBYTE bpp = 1; bpp <= 4; bpp *= 2) {
+        UDOUBLE row = TEST_W * bpp / 8;
+        draw_page(bpp, frame);
+        for (int k = 0; k < EPD_IT8951_PACK_KERNELS; k++) {
+            if (EPD_IT8951_Pack_SetKernel(k) != 0)
+                continue;
+            memset(packed, 0, sizeof(packed));
+            EPD_IT8951_Pack_Area(surface, TEST_W, TEST_W, TEST_H, bpp, packed, row);
+            assert(memcmp(packed, frame, row * TEST_H) == 0);
+
+            // An area inside the image, row by row
+            memset(packed, 0, sizeof(packed));
+            EPD_IT8951_Pack_Area(surface + 40 * TEST_W + 64, TEST_W, 160, 100, bpp, packed, TEST_W);
+            for (int y = 0; y < 100; y++)
+                assert(memcmp(packed + y * TEST_W, frame + (40 + y) * row + 64 * bpp / 8, 160 * bpp / 8) == 0);
+        }
+    }
+}
+
+// The bus carries the same bytes whether Paint drew at 4bpp or at 8bpp with
+// the upload depth set to 4
+void test_upload_depth(void) {
+    uint32_t hash, bytes;
+
+    assert(EPD_IT8951_SetUploadDepth(3) == -2);
+    for (UBYTE bpp = 1; bpp <= 4; bpp *= 2) {
+        draw_page(bpp, frame);
+        assert(EPD_IT8951_Area_Refresh(frame, 0, 0, TEST_W, TEST_H, bpp, GC16_Mode, TEST_ADDR) == 0);
+        mock_spi_tx_reset();
+        assert(EPD_IT8951_Area_Refresh(frame, 0, 0, TEST_W, TEST_H, bpp, GC16_Mode, TEST_ADDR) == 0);
+        hash = mock_spi_tx_hash;
+        bytes = mock_spi_tx_bytes;
+
+        draw_page(8, surface);
+        assert(EPD_IT8951_SetUploadDepth(bpp) == 0);
+        mock_spi_tx_reset();
+        assert(EPD_IT8951_Area_Refresh(surface, 0, 0, TEST_W, TEST_H, 8, GC16_Mode, TEST_ADDR) == 0);
+        assert(mock_spi_tx_bytes == bytes && mock_spi_tx_hash == hash);
+
+        // The whole page is damaged, so the dirty refresh sends it too
+        mock_spi_tx_reset();
+        assert(EPD_IT8951_RefreshDirty(GC16_Mode, TEST_ADDR) == 1);
+        assert(mock_spi_tx_bytes == bytes && mock_spi_tx_hash == hash);
+
+        // A small change is packed from the image in place
+        Paint_DrawString_EN(101, 100, "12:34", &Font12, BLACK, WHITE);
+        mock_spi_tx_reset();
+        assert(EPD_IT8951_RefreshDirty(GC16_Mode, TEST_ADDR) == 1);
+        assert(mock_spi_tx_bytes > 0 && mock_spi_tx_bytes < bytes / 4);
+        assert(EPD_IT8951_SetUploadDepth(8) == 0);
+    }
+}
+
+int main(void) {
+    EPD_IT8951_Init(0);
+    test_kernels_match_reference();
+    test_area_matches_paint();
+    test_upload_depth();
+    printf("All EPD_IT8951 pack tests passed!\n");
+    return 0;
+}
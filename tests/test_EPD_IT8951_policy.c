@@ -0,0 +1,166 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../include/EPD_IT8951_Policy.h"
+#include "../include/EPD_IT8951_Waveform.h"
+
+#define PANEL_W 1872
+#define PANEL_H 1404
+#define INIT 0
+#define DU 1
+#define GC16 2
+#define A2 6
+#define M641_A2 4
+
+static void cleared_policy(EPD_IT8951_Policy *policy) {
+    EPD_IT8951_Policy_Init(policy, PANEL_W, PANEL_H);
+    EPD_IT8951_Policy_Record(policy, 0, 0, PANEL_W, PANEL_H, INIT);
+}
+
+void test_unknown_panel_is_cleared_first(void) {
+    EPD_IT8951_Policy policy;
+    EPD_IT8951_Policy_Init(&policy, PANEL_W, PANEL_H);
+    assert(EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, 100, 100, GC16));
+    // An INIT update never needs a clear before it
+    assert(!EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, PANEL_W, PANEL_H, INIT));
+
+    EPD_IT8951_Policy_Record(&policy, 0, 0, PANEL_W, PANEL_H, INIT);
+    assert(!EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, PANEL_W, PANEL_H, GC16));
+    assert(policy.Clears == 1);
+}
+
+void test_budget_runs_out(void) {
+    EPD_IT8951_Policy policy;
+    cleared_policy(&policy);
+    EPD_IT8951_Policy_SetBudget(&policy, 3, 2, 1);
+
+    for (int i = 0; i < 3; i++) {
+        assert(!EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, PANEL_W, PANEL_H, GC16));
+        EPD_IT8951_Policy_Record(&policy, 0, 0, PANEL_W, PANEL_H, GC16);
+    }
+    assert(EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, PANEL_W, PANEL_H, GC16));
+    // Each class has its own budget
+    assert(!EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, PANEL_W, PANEL_H, DU));
+    assert(!EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, PANEL_W, PANEL_H, A2));
+    assert(policy.Updates == 3);
+
+    // A zero budget clears before every update
+    EPD_IT8951_Policy_SetBudget(&policy, 0, 0, 0);
+    cleared_policy(&policy);
+    EPD_IT8951_Policy_SetBudget(&policy, 0, 0, 0);
+    assert(EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, 8, 8, GC16));
+}
+
+void test_regions_are_independent(void) {
+    EPD_IT8951_Policy policy;
+    cleared_policy(&policy);
+    EPD_IT8951_Policy_SetBudget(&policy, 20, 10, 2);
+
+    // A clock in the top left corner
+    EPD_IT8951_Policy_Record(&policy, 0, 0, 200, 100, A2);
+    EPD_IT8951_Policy_Record(&policy, 0, 0, 200, 100, A2);
+    assert(EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, 200, 100, A2));
+    // ...leaves the bottom right alone
+    assert(!EPD_IT8951_Policy_NeedsClear(&policy, PANEL_W - 200, PANEL_H - 100, 200, 100, A2));
+    // ...but any update touching the corner sees it
+    assert(EPD_IT8951_Policy_NeedsClear(&policy, 150, 50, 400, 400, A2));
+}
+
+void test_partial_init_resets_covered_regions(void) {
+    EPD_IT8951_Policy policy;
+    UWORD cell_w = PANEL_W / EPD_IT8951_POLICY_GRID;
+    UWORD cell_h = PANEL_H / EPD_IT8951_POLICY_GRID;
+    cleared_policy(&policy);
+    EPD_IT8951_Policy_SetBudget(&policy, 1, 1, 1);
+
+    EPD_IT8951_Policy_Record(&policy, 0, 0, 3 * cell_w, cell_h, GC16);
+    assert(EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, cell_w, cell_h, GC16));
+
+    // INIT over exactly the first two cells
+    EPD_IT8951_Policy_Record(&policy, 0, 0, 2 * cell_w, cell_h, INIT);
+    assert(!EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, 2 * cell_w, cell_h, GC16));
+    // The third cell was not covered
+    assert(EPD_IT8951_Policy_NeedsClear(&policy, 2 * cell_w, 0, cell_w, cell_h, GC16));
+    // Only a full-panel INIT counts as a clear
+    assert(policy.Clears == 1);
+}
+
+void test_request_clear(void) {
+    EPD_IT8951_Policy policy;
+    cleared_policy(&policy);
+    EPD_IT8951_Policy_RequestClear(&policy);
+    assert(EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, 8, 8, DU));
+    EPD_IT8951_Policy_Record(&policy, 0, 0, PANEL_W, PANEL_H, INIT);
+    assert(!EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, 8, 8, DU));
+}
+
+void test_state_file(void) {
+    EPD_IT8951_Policy saved, loaded;
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/test_epd_policy.%d", (int)getpid());
+    unlink(path);
+
+    // No state yet: the panel must be cleared
+    EPD_IT8951_Policy_Init(&loaded, PANEL_W, PANEL_H);
+    loaded.Clear_Requested = false;
+    assert(EPD_IT8951_Policy_Load(&loaded, path) == -1);
+    assert(loaded.Clear_Requested);
+
+    cleared_policy(&saved);
+    EPD_IT8951_Policy_Record(&saved, 100, 100, 300, 300, DU);
+    EPD_IT8951_Policy_Record(&saved, 0, 0, PANEL_W, PANEL_H, GC16);
+    assert(EPD_IT8951_Policy_Save(&saved, path) == 0);
+
+    // A 0x0 policy takes the panel size from the file
+    EPD_IT8951_Policy_Init(&loaded, 0, 0);
+    EPD_IT8951_Policy_SetBudget(&loaded, 7, 8, 9);
+    assert(EPD_IT8951_Policy_Load(&loaded, path) == 0);
+    assert(loaded.Panel_W == PANEL_W && loaded.Panel_H == PANEL_H);
+    assert(!loaded.Clear_Requested);
+    assert(memcmp(loaded.Count, saved.Count, sizeof(saved.Count)) == 0);
+    assert(loaded.Updates == 2 && loaded.Clears == 1);
+    // Budgets are not part of the state
+    assert(loaded.Budget[EPD_IT8951_POLICY_GC16] == 7);
+
+    // Another panel size
+    EPD_IT8951_Policy_Init(&loaded, 1200, 825);
+    loaded.Clear_Requested = false;
+    assert(EPD_IT8951_Policy_Load(&loaded, path) == -2);
+    assert(loaded.Clear_Requested);
+
+    unlink(path);
+}
+
+// Modes are classed through the panel's table: on M641 A2 is mode 4
+void test_m641_modes(void) {
+    EPD_IT8951_Policy policy;
+    IT8951_Dev_Info info;
+
+    memset(&info, 0, sizeof(info));
+    memcpy(info.LUT_Version, "M641", 5);
+    EPD_IT8951_Waveform_SelectTable(&info);
+
+    cleared_policy(&policy);
+    EPD_IT8951_Policy_SetBudget(&policy, 5, 5, 1);
+    EPD_IT8951_Policy_Record(&policy, 0, 0, PANEL_W, PANEL_H, M641_A2);
+    assert(EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, PANEL_W, PANEL_H, M641_A2));
+    assert(!EPD_IT8951_Policy_NeedsClear(&policy, 0, 0, PANEL_W, PANEL_H, GC16));
+    assert(policy.Count[0][0][EPD_IT8951_POLICY_A2] == 1);
+    assert(policy.Count[0][0][EPD_IT8951_POLICY_GC16] == 0);
+
+    memcpy(info.LUT_Version, "M841", 5);
+    EPD_IT8951_Waveform_SelectTable(&info);
+}
+
+int main(void) {
+    test_unknown_panel_is_cleared_first();
+    test_budget_runs_out();
+    test_regions_are_independent();
+    test_partial_init_resets_covered_regions();
+    test_request_clear();
+    test_state_file();
+    test_m641_modes();
+    printf("All EPD_IT8951 refresh policy tests passed!\n");
+    return 0;
+}
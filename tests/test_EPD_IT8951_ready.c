@@ -0,0 +1,93 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../include/EPD_IT8951.h"
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_read_busy_bytes;
+
+#define TEST_ADDR 0x001236E0
+// A register read clocks in a dummy word and the value word
+#define BYTES_PER_REG_READ 4
+
+static UBYTE frame[64 * 16 / 2];
+
+void test_nothing_pending(void) {
+    UDOUBLE latency_us = 1234;
+    EPD_IT8951_Init(0);
+    assert(EPD_IT8951_WaitForRefresh(&latency_us) == 0);
+    assert(latency_us == 0);
+}
+
+void test_estimate_shrinks_when_first_poll_is_idle(void) {
+    EPD_IT8951_Stats stats;
+    UDOUBLE latency_us;
+    UDOUBLE before = EPD_IT8951_GetRefreshEstimate(2);
+
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, 64, 16, false, TEST_ADDR, true);
+    EPD_IT8951_ResetStats();
+    assert(EPD_IT8951_WaitForRefresh(&latency_us) == 0);
+
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Ready_Waits == 1);
+    assert(stats.Ready_Polls == 1);
+    assert(stats.Ready_Last_Latency_us == latency_us);
+    assert(EPD_IT8951_GetRefreshEstimate(2) == before - before / 8);
+}
+
+void test_backoff_polls_until_idle(void) {
+    EPD_IT8951_Stats stats;
+    UDOUBLE before = EPD_IT8951_GetRefreshEstimate(2);
+
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, 64, 16, false, TEST_ADDR, true);
+    EPD_IT8951_ResetStats();
+    mock_spi_read_busy_bytes = 3 * BYTES_PER_REG_READ;
+    assert(EPD_IT8951_WaitForRefresh(NULL) == 0);
+
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Ready_Polls == 4);
+    assert(stats.Ready_Waits == 1);
+    // Measured latency is ~0 with mocked delays, so the EWMA moves down
+    assert(EPD_IT8951_GetRefreshEstimate(2) < before);
+    assert(EPD_IT8951_GetRefreshEstimate(2) >= before * 7 / 8 - 1);
+}
+
+// Coming back after the refresh is over says nothing about how long it took
+void test_late_wait_keeps_estimate(void) {
+    EPD_IT8951_Stats stats;
+    UDOUBLE latency_us = 1234;
+    UDOUBLE before = EPD_IT8951_GetRefreshEstimate(2);
+
+    EPD_IT8951_4bp_Refresh(frame, 0, 0, 64, 16, false, TEST_ADDR, true);
+    EPD_IT8951_ResetStats();
+    usleep((before + 20) * 1000);
+    assert(EPD_IT8951_WaitForRefresh(&latency_us) == 0);
+
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Ready_Polls == 1);
+    assert(stats.Ready_Waits == 0);
+    assert(stats.Ready_Last_Latency_us == 0);
+    assert(latency_us == 0);
+    assert(EPD_IT8951_GetRefreshEstimate(2) == before);
+
+    // Nothing is left pending for the next wait
+    assert(EPD_IT8951_WaitForRefresh(NULL) == 0);
+    assert(EPD_IT8951_GetRefreshEstimate(2) == before);
+}
+
+void test_modes_have_separate_estimates(void) {
+    assert(EPD_IT8951_GetRefreshEstimate(0) > EPD_IT8951_GetRefreshEstimate(6));
+    assert(EPD_IT8951_GetRefreshEstimate(100) == EPD_IT8951_GetRefreshEstimate(EPD_IT8951_MODE_SLOTS - 1));
+}
+
+int main(void) {
+    memset(frame, 0xFF, sizeof(frame));
+    test_nothing_pending();
+    test_estimate_shrinks_when_first_poll_is_idle();
+    test_backoff_polls_until_idle();
+    test_late_wait_keeps_estimate();
+    test_modes_have_separate_estimates();
+    printf("All EPD_IT8951 refresh wait tests passed!\n");
+    return 0;
+}
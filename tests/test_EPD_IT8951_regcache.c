@@ -0,0 +1,58 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/EPD_IT8951.h"
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+#define A2 6
+
+static UBYTE frame[128 * 16 / 8];
+
+static uint32_t send_1bp_frame(EPD_IT8951_Stats *stats) {
+    EPD_IT8951_ResetStats();
+    mock_spi_tx_reset();
+    EPD_IT8951_1bp_Refresh(frame, 0, 0, 128, 16, A2, TEST_ADDR, true);
+    EPD_IT8951_GetStats(stats);
+    return mock_spi_tx_bytes;
+}
+
+void test_repeated_frames_skip_register_traffic(void) {
+    EPD_IT8951_Stats first, second;
+    uint32_t first_bytes, second_bytes;
+
+    EPD_IT8951_Init(0);
+    first_bytes = send_1bp_frame(&first);
+    // The second UP1SR read of the read-modify-write pair comes from the shadow
+    assert(first.Reg_Reads_Elided == 1);
+    assert(first.Reg_Writes_Elided == 0);
+
+    second_bytes = send_1bp_frame(&second);
+    // Both UP1SR reads, both LISAR halves and BGVR are skipped
+    assert(second.Reg_Reads_Elided == 2);
+    assert(second.Reg_Writes_Elided == 3);
+    assert(second_bytes < first_bytes);
+}
+
+void test_reset_invalidates_shadow(void) {
+    EPD_IT8951_Stats stats;
+    uint32_t before, after;
+
+    EPD_IT8951_Init(0);
+    before = send_1bp_frame(&stats);
+    EPD_IT8951_Init(0);
+    after = send_1bp_frame(&stats);
+    assert(after == before);
+    assert(stats.Reg_Writes_Elided == 0);
+}
+
+int main(void) {
+    memset(frame, 0xAA, sizeof(frame));
+    test_repeated_frames_skip_register_traffic();
+    test_reset_invalidates_shadow();
+    printf("All EPD_IT8951 register shadow tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/EPD_IT8951_Slots.h"
+
+extern UBYTE GC16_Mode;
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+#define TEST_W 1448
+#define TEST_H 1072
+
+static IT8951_Dev_Info test_dev_info(void) {
+    IT8951_Dev_Info dev_info;
+    memset(&dev_info, 0, sizeof(dev_info));
+    dev_info.Panel_W = TEST_W;
+    dev_info.Panel_H = TEST_H;
+    dev_info.Memory_Addr_L = TEST_ADDR & 0xFFFF;
+    dev_info.Memory_Addr_H = TEST_ADDR >> 16;
+    return dev_info;
+}
+
+void test_slots_layout(void) {
+    EPD_IT8951_Slots slots;
+    UDOUBLE frame = (UDOUBLE)TEST_W * TEST_H;
+
+    // 8 MiB holds the panel buffer plus three more frames
+    assert(EPD_IT8951_Slots_Init(&slots, test_dev_info(), EPD_IT8951_SDRAM_END) == 3);
+    assert(slots.Slot[0].Addr >= TEST_ADDR + frame);
+    for (int i = 0; i < slots.Count; i++) {
+        assert(slots.Slot[i].Addr % EPD_IT8951_SLOT_ALIGN == 0);
+        assert(slots.Slot[i].Addr + frame <= EPD_IT8951_SDRAM_END);
+        if (i > 0)
+            assert(slots.Slot[i].Addr >= slots.Slot[i - 1].Addr + frame);
+    }
+
+    // The panel buffer alone does not leave room for a slot
+    assert(EPD_IT8951_Slots_Init(&slots, test_dev_info(), TEST_ADDR + frame + 100) == EPD_IT8951_SLOTS_ERR_NO_ROOM);
+    assert(EPD_IT8951_Slots_Preload(&slots, 1, (UBYTE *)"", 4) == EPD_IT8951_SLOTS_ERR_NO_ROOM);
+}
+
+void test_slots_show_is_one_command(void) {
+    EPD_IT8951_Slots slots;
+    UBYTE *frame = calloc((size_t)TEST_W * TEST_H / 2, 1);
+    uint32_t preload_bytes;
+
+    assert(frame != NULL);
+    assert(EPD_IT8951_Slots_Init(&slots, test_dev_info(), EPD_IT8951_SDRAM_END) == 3);
+
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Slots_Preload(&slots, 7, frame, 4) == 0);
+    preload_bytes = mock_spi_tx_bytes;
+    assert(preload_bytes > (uint32_t)TEST_W * TEST_H / 2);
+
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Slots_Show(&slots, 7, GC16_Mode) == 0);
+    // One DPY_BUF_AREA command with its arguments, not a frame
+    assert(mock_spi_tx_bytes <= 64);
+    assert(slots.Hits == 1);
+
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Slots_Show(&slots, 8, GC16_Mode) == EPD_IT8951_SLOTS_ERR_MISSING);
+    assert(mock_spi_tx_bytes == 0);
+    assert(slots.Misses == 1);
+
+    // Bad frames are rejected by the upload path
+    assert(EPD_IT8951_Slots_Preload(&slots, 9, NULL, 4) == -2);
+    assert(EPD_IT8951_Slots_Preload(&slots, 9, frame, 1) == -2);
+    assert(EPD_IT8951_Slots_Find(&slots, 9) == -1);
+    free(frame);
+}
+
+void test_slots_lru_eviction(void) {
+    EPD_IT8951_Slots slots;
+    UBYTE *frame = calloc((size_t)TEST_W * TEST_H, 1);
+
+    assert(frame != NULL);
+    assert(EPD_IT8951_Slots_Init(&slots, test_dev_info(), EPD_IT8951_SDRAM_END) == 3);
+    assert(EPD_IT8951_Slots_Preload(&slots, 1, frame, 8) == 0);
+    assert(EPD_IT8951_Slots_Preload(&slots, 2, frame, 8) == 1);
+    assert(EPD_IT8951_Slots_Preload(&slots, 3, frame, 8) == 2);
+
+    // Showing frame 1 makes frame 2 the least recently used
+    assert(EPD_IT8951_Slots_Show(&slots, 1, GC16_Mode) == 0);
+    assert(EPD_IT8951_Slots_Preload(&slots, 4, frame, 8) == 1);
+    assert(EPD_IT8951_Slots_Find(&slots, 2) == -1);
+    assert(slots.Evictions == 1);
+
+    // Preloading a frame again reuses its slot
+    assert(EPD_IT8951_Slots_Preload(&slots, 3, frame, 8) == 2);
+    assert(slots.Evictions == 1);
+
+    // A dropped frame frees its slot without an eviction
+    EPD_IT8951_Slots_Drop(&slots, 1);
+    assert(EPD_IT8951_Slots_Find(&slots, 1) == -1);
+    assert(EPD_IT8951_Slots_Preload(&slots, 5, frame, 8) == 0);
+    assert(slots.Evictions == 1);
+    assert(slots.Preloads == 6);
+    free(frame);
+}
+
+int main(void) {
+    EPD_IT8951_Init(0);
+    test_slots_layout();
+    test_slots_show_is_one_command();
+    test_slots_lru_eviction();
+    printf("All EPD_IT8951 slot tests passed!\n");
+    return 0;
+}
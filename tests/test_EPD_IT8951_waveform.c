@@ -0,0 +1,170 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/EPD_IT8951.h"
+#include "../include/EPD_IT8951_Waveform.h"
+
+extern UBYTE GC16_Mode;
+extern UBYTE A2_Mode;
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+extern uint32_t mock_spi_tx_hash;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+#define TEST_W 64
+#define TEST_H 32
+#define ROW (TEST_W / 2)
+
+static UBYTE old_frame[ROW * TEST_H];
+static UBYTE new_frame[ROW * TEST_H];
+
+static void set_pixel(UBYTE *frame, UWORD x, UWORD y, UBYTE gray) {
+    UBYTE *b = &frame[y * ROW + x / 2];
+    if (x % 2)
+        *b = (*b & 0x0F) | (gray << 4);
+    else
+        *b = (*b & 0xF0) | gray;
+}
+
+static EPD_IT8951_Wave classify(const UBYTE *old) {
+    return EPD_IT8951_Waveform_Classify(old, new_frame, TEST_W, TEST_H, 4, ROW);
+}
+
+void test_mode_tables(void) {
+    IT8951_Dev_Info info;
+    const EPD_IT8951_Mode_Table *modes;
+
+    memset(&info, 0, sizeof(info));
+    memcpy(info.LUT_Version, "M641", 5);
+    EPD_IT8951_Waveform_SelectTable(&info);
+    modes = EPD_IT8951_GetModeTable();
+    assert(modes->A2 == 4 && modes->GC16 == 2 && modes->GL16 == 3);
+    assert(A2_Mode == 4);
+
+    memcpy(info.LUT_Version, "M841_TFA5210", 13);
+    EPD_IT8951_Waveform_SelectTable(&info);
+    modes = EPD_IT8951_GetModeTable();
+    assert(modes->A2 == 6 && modes->DU == 1 && modes->GL16 == 3);
+    assert(A2_Mode == 6 && GC16_Mode == 2);
+    assert(EPD_IT8951_Waveform_Mode(EPD_IT8951_WAVE_GL16) == 3);
+}
+
+void test_classify(void) {
+    // White page
+    memset(old_frame, 0xFF, sizeof(old_frame));
+    memcpy(new_frame, old_frame, sizeof(new_frame));
+    assert(classify(old_frame) == EPD_IT8951_WAVE_NONE);
+
+    // Black text on white: black and white only
+    set_pixel(new_frame, 3, 3, 0x0);
+    set_pixel(new_frame, 40, 20, 0x0);
+    assert(classify(old_frame) == EPD_IT8951_WAVE_A2);
+    // Without the old pixels A2 is not safe
+    assert(classify(NULL) == EPD_IT8951_WAVE_DU);
+
+    // Gray replaced by black: DU
+    set_pixel(old_frame, 3, 3, 0x8);
+    assert(classify(old_frame) == EPD_IT8951_WAVE_DU);
+
+    // Anti-aliased text on white: GL16
+    set_pixel(new_frame, 10, 10, 0x7);
+    assert(classify(old_frame) == EPD_IT8951_WAVE_GL16);
+
+    // A gray picture: GC16
+    memset(new_frame, 0x77, sizeof(new_frame));
+    assert(classify(old_frame) == EPD_IT8951_WAVE_GC16);
+    assert(classify(NULL) == EPD_IT8951_WAVE_GC16);
+
+    // Unchanged gray pixels do not matter
+    memcpy(old_frame, new_frame, sizeof(old_frame));
+    set_pixel(new_frame, 0, 0, 0xF);
+    assert(classify(old_frame) == EPD_IT8951_WAVE_DU);
+}
+
+// 8bpp keeps the gray in the high nibble, as Paint stores it
+void test_classify_8bpp(void) {
+    static UBYTE old8[TEST_W * TEST_H], new8[TEST_W * TEST_H];
+
+    memset(old8, 0xF0, sizeof(old8));
+    memcpy(new8, old8, sizeof(new8));
+    assert(EPD_IT8951_Waveform_Classify(old8, new8, TEST_W, TEST_H, 8, TEST_W) == EPD_IT8951_WAVE_NONE);
+
+    // Black text on 0xF0 white is still A2, and the page counts as white
+    new8[3 * TEST_W + 3] = 0x00;
+    new8[20 * TEST_W + 40] = 0x0F;
+    assert(EPD_IT8951_Waveform_Classify(old8, new8, TEST_W, TEST_H, 8, TEST_W) == EPD_IT8951_WAVE_A2);
+
+    new8[10 * TEST_W + 10] = 0x70;
+    assert(EPD_IT8951_Waveform_Classify(old8, new8, TEST_W, TEST_H, 8, TEST_W) == EPD_IT8951_WAVE_GL16);
+
+    memset(new8, 0x70, sizeof(new8));
+    assert(EPD_IT8951_Waveform_Classify(old8, new8, TEST_W, TEST_H, 8, TEST_W) == EPD_IT8951_WAVE_GC16);
+}
+
+// An automatic refresh sends the same bytes as an explicit one with the picked mode
+void test_auto_refresh(void) {
+    const EPD_IT8951_Mode_Table *modes = EPD_IT8951_GetModeTable();
+    EPD_IT8951_Stats stats;
+    uint32_t expected;
+
+    memset(new_frame, 0xFF, sizeof(new_frame));
+    set_pixel(new_frame, 5, 5, 0x0);
+
+    // Warm the register shadow before comparing hashes
+    assert(EPD_IT8951_Area_Refresh(new_frame, 0, 0, TEST_W, TEST_H, 4, modes->DU, TEST_ADDR) == 0);
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Area_Refresh(new_frame, 0, 0, TEST_W, TEST_H, 4, modes->DU, TEST_ADDR) == 0);
+    expected = mock_spi_tx_hash;
+
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Area_Refresh(new_frame, 0, 0, TEST_W, TEST_H, 4, EPD_IT8951_MODE_AUTO, TEST_ADDR) == 0);
+    assert(mock_spi_tx_hash == expected);
+
+    EPD_IT8951_ResetStats();
+    EPD_IT8951_SetAutoWaveform(true);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(new_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    assert(mock_spi_tx_hash == expected);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Auto_DU == 1);
+
+    // Off again: GC16 as before
+    EPD_IT8951_SetAutoWaveform(false);
+    mock_spi_tx_reset();
+    EPD_IT8951_4bp_Refresh(new_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    assert(mock_spi_tx_hash != expected);
+}
+
+// Incremental uploads know the old pixels, which allows A2
+void test_auto_incremental(void) {
+    EPD_IT8951_Stats stats;
+
+    memset(old_frame, 0xFF, sizeof(old_frame));
+    EPD_IT8951_SetIncremental(true);
+    EPD_IT8951_SetAutoWaveform(true);
+    EPD_IT8951_4bp_Refresh(old_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+
+    EPD_IT8951_ResetStats();
+    memcpy(new_frame, old_frame, sizeof(new_frame));
+    set_pixel(new_frame, 50, 20, 0x0);
+    EPD_IT8951_4bp_Refresh(new_frame, 0, 0, TEST_W, TEST_H, false, TEST_ADDR, false);
+    EPD_IT8951_GetStats(&stats);
+    assert(stats.Auto_A2 == 1);
+    assert(stats.Diff_Areas == 1);
+
+    EPD_IT8951_SetAutoWaveform(false);
+    EPD_IT8951_SetIncremental(false);
+}
+
+int main(void) {
+    test_mode_tables();
+    test_classify();
+    test_classify_8bpp();
+    EPD_IT8951_Init(0);
+    test_auto_refresh();
+    test_auto_incremental();
+    printf("All EPD_IT8951 waveform tests passed!\n");
+    return 0;
+}
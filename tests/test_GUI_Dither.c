@@ -0,0 +1,265 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/GUI_Dither.h"
+#include "../include/GUI_BMPfile.h"
+#include "../include/GUI_Paint.h"
+#include "../include/EPD_IT8951.h"
+
+extern UBYTE GC16_Mode;
+extern UBYTE isColor;
+
+// Provided by mock_DEV_Config.c
+extern uint32_t mock_spi_tx_bytes;
+extern uint32_t mock_spi_tx_hash;
+void mock_spi_tx_reset(void);
+
+#define TEST_ADDR 0x001236E0
+#define IMG_W 256
+#define IMG_H 64
+#define BMP_FILE "dither_test.bmp"
+
+static const DITHER_MODE modes[] = { DITHER_NONE, DITHER_BAYER, DITHER_FLOYD_STEINBERG, DITHER_ATKINSON };
+
+static UBYTE image[IMG_W * IMG_H];
+static UBYTE frame[IMG_W * IMG_H];
+
+// Every pixel comes out as one of the depth's levels, and levels stay as they are
+void test_levels(void) {
+    UBYTE row[IMG_W], levels[IMG_W];
+    DITHER d;
+
+    assert(Dither_Init(&d, DITHER_BAYER, 3, IMG_W) == DITHER_ERR_ARGS);
+    assert(Dither_Init(&d, DITHER_MODES, 4, IMG_W) == DITHER_ERR_ARGS);
+    assert(Dither_Init(&d, DITHER_ATKINSON, 4, 0) == DITHER_ERR_ARGS);
+    srand(3);
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        UBYTE step = (bpp == 8) ? 17 : 255 / ((1 << bpp) - 1);
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            assert(Dither_Init(&d, modes[m], bpp, IMG_W) == 0);
+            for (UWORD y = 0; y < IMG_H; y++) {
+                for (int x = 0; x < IMG_W; x++)
+                    row[x] = (UBYTE)rand();
+                Dither_Row(&d, row, 0, y);
+                for (int x = 0; x < IMG_W; x++)
+                    assert(row[x] % step == 0);
+            }
+
+            Dither_Reset(&d);
+            for (UWORD y = 0; y < IMG_H; y++) {
+                for (int x = 0; x < IMG_W; x++)
+                    levels[x] = row[x] = (UBYTE)(rand() % (255 / step + 1) * step);
+                Dither_Row(&d, row, 0, y);
+                assert(memcmp(row, levels, IMG_W) == 0);
+            }
+            Dither_Release(&d);
+        }
+    }
+}
+
+// A flat gray comes out with about the same mean, where cutting it would not
+void test_mean_kept(void) {
+    UBYTE row[IMG_W];
+    DITHER d;
+
+    for (size_t m = 1; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for (int gray = 16; gray <= 240; gray += 7) {
+            long sum = 0;
+            assert(Dither_Init(&d, modes[m], 1, IMG_W) == 0);
+            for (UWORD y = 0; y < IMG_H; y++) {
+                memset(row, gray, IMG_W);
+                Dither_Row(&d, row, 0, y);
+                for (int x = 0; x < IMG_W; x++)
+                    sum += row[x];
+            }
+            Dither_Release(&d);
+            // Atkinson drops a quarter of the error: the darkest grays go
+            // black, the lightest white, and the rest spread apart a little
+            long mean = sum / (IMG_W * IMG_H);
+            long tolerance = (modes[m] == DITHER_ATKINSON) ? 12 : 4;
+            if (modes[m] == DITHER_ATKINSON && (gray < 80 || gray > 176))
+                continue;
+            assert(mean >= gray - tolerance && mean <= gray + tolerance);
+        }
+    }
+}
+
+// Bayer depends on the position only, so areas dithered apart fit together
+void test_bayer_by_position(void) {
+    UBYTE whole[IMG_W], parts[IMG_W];
+    DITHER d, left, right;
+
+    assert(Dither_Init(&d, DITHER_BAYER, 2, IMG_W) == 0);
+    assert(Dither_Init(&left, DITHER_BAYER, 2, 100) == 0);
+    assert(Dither_Init(&right, DITHER_BAYER, 2, IMG_W - 100) == 0);
+    for (UWORD y = 0; y < 16; y++) {
+        for (int x = 0; x < IMG_W; x++)
+            whole[x] = parts[x] = (UBYTE)x;
+        Dither_Row(&d, whole, 0, y + 5);
+        Dither_Row(&left, parts, 0, y + 5);
+        Dither_Row(&right, parts + 100, 100, y + 5);
+        assert(memcmp(whole, parts, IMG_W) == 0);
+    }
+    Dither_Release(&d);
+    Dither_Release(&left);
+    Dither_Release(&right);
+}
+
+// Resetting starts the error over, as a new state would
+void test_reset(void) {
+    UBYTE first[IMG_W], again[IMG_W];
+    DITHER d;
+
+    assert(Dither_Init(&d, DITHER_FLOYD_STEINBERG, 1, IMG_W) == 0);
+    memset(first, 100, IMG_W);
+    Dither_Row(&d, first, 0, 0);
+    Dither_Reset(&d);
+    memset(again, 100, IMG_W);
+    Dither_Row(&d, again, 0, 0);
+    assert(memcmp(first, again, IMG_W) == 0);
+    Dither_Release(&d);
+}
+
+void test_parse(void) {
+    DITHER_MODE mode;
+
+    assert(Dither_ParseMode("fs", &mode) == 0 && mode == DITHER_FLOYD_STEINBERG);
+    assert(Dither_ParseMode("floyd-steinberg", &mode) == 0 && mode == DITHER_FLOYD_STEINBERG);
+    assert(Dither_ParseMode("atkinson", &mode) == 0 && mode == DITHER_ATKINSON);
+    assert(Dither_ParseMode("bayer", &mode) == 0 && mode == DITHER_BAYER);
+    assert(Dither_ParseMode("none", &mode) == 0 && mode == DITHER_NONE);
+    assert(Dither_ParseMode("ordered", &mode) == DITHER_ERR_ARGS);
+}
+
+// An 8bpp gray BMP with a left to right gradient
+static void write_gradient_bmp(void) {
+    static UBYTE bmp[1078 + IMG_W * IMG_H];
+    UDOUBLE size = sizeof(bmp);
+    FILE *f;
+
+    memset(bmp, 0, sizeof(bmp));
+    bmp[0] = 'B';
+    bmp[1] = 'M';
+    memcpy(bmp + 2, &size, 4);
+    bmp[10] = 1078 & 0xFF;
+    bmp[11] = 1078 >> 8;
+    bmp[14] = 40;
+    bmp[18] = IMG_W & 0xFF;
+    bmp[19] = IMG_W >> 8;
+    bmp[22] = IMG_H;
+    bmp[26] = 1;
+    bmp[28] = 8;
+    for (int i = 0; i < 256; i++)
+        memset(bmp + 54 + i * 4, i, 3);
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            bmp[1078 + y * IMG_W + x] = (UBYTE)x;
+    f = fopen(BMP_FILE, "wb");
+    assert(f);
+    fwrite(bmp, 1, sizeof(bmp), f);
+    fclose(f);
+}
+
+// White pixels in a 1bpp image, over columns X0 to X1
+static long whites(UWORD X0, UWORD X1) {
+    long count = 0;
+    for (UWORD y = 0; y < IMG_H; y++)
+        for (UWORD x = X0; x < X1; x++)
+            count += (image[y * (IMG_W / 8) + x / 8] >> (x % 8)) & 1;
+    return count;
+}
+
+// The loader dithers as it draws: at 1bpp the gradient keeps its grays
+void test_bmp_loader(void) {
+    write_gradient_bmp();
+    Paint_NewImage(image, IMG_W, IMG_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(1);
+
+    assert(GUI_SetBmpDither(DITHER_MODES) == -2);
+    assert(GUI_SetBmpDither(DITHER_NONE) == 0);
+    assert(GUI_ReadBmp(BMP_FILE, 0, 0) == 0);
+    assert(whites(0, 64) == 0 && whites(192, 256) == 64 * IMG_H);
+
+    for (size_t m = 1; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        assert(GUI_SetBmpDither(modes[m]) == 0);
+        Paint_Clear(BLACK);
+        assert(GUI_ReadBmp(BMP_FILE, 0, 0) == 0);
+        // A quarter of the darker band and three quarters of the lighter one
+        assert(labs(whites(32, 96) - 64 * IMG_H / 4) < 64 * IMG_H / 10);
+        assert(labs(whites(160, 224) - 64 * IMG_H * 3 / 4) < 64 * IMG_H / 10);
+    }
+
+    // Color panels halve every third column, which error diffusion would spread
+    isColor = 1;
+    assert(GUI_SetBmpDither(DITHER_BAYER) == 0);
+    Paint_Clear(BLACK);
+    assert(GUI_ReadBmp(BMP_FILE, 0, 0) == 0);
+    memcpy(frame, image, IMG_W / 8 * IMG_H);
+    for (size_t m = 2; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        assert(GUI_SetBmpDither(modes[m]) == 0);
+        Paint_Clear(BLACK);
+        assert(GUI_ReadBmp(BMP_FILE, 0, 0) == 0);
+        assert(memcmp(frame, image, IMG_W / 8 * IMG_H) == 0);
+    }
+    isColor = 0;
+    assert(GUI_SetBmpDither(DITHER_NONE) == 0);
+    remove(BMP_FILE);
+}
+
+// An 8bpp frame packed with dithering is sent as the same frame dithered
+// to 1bpp beforehand
+void test_upload_dither(void) {
+    uint32_t hash, bytes;
+    UBYTE row[IMG_W];
+    DITHER d;
+
+    Paint_NewImage(frame, IMG_W, IMG_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(8);
+    for (UWORD x = 0; x < IMG_W; x++)
+        Paint_DrawLine(x, 0, x, IMG_H, x, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+
+    // What is expected: the 16 grays Paint kept, dithered to 1bpp
+    Paint_NewImage(image, IMG_W, IMG_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(1);
+    assert(Dither_Init(&d, DITHER_BAYER, 1, IMG_W) == 0);
+    for (UWORD y = 0; y < IMG_H; y++) {
+        for (UWORD x = 0; x < IMG_W; x++)
+            row[x] = frame[y * IMG_W + x] | (frame[y * IMG_W + x] >> 4);
+        Dither_Row(&d, row, 0, y);
+        Paint_BlitRow(0, y, row, IMG_W, 8);
+    }
+    Dither_Release(&d);
+    assert(EPD_IT8951_Area_Refresh(image, 0, 0, IMG_W, IMG_H, 1, GC16_Mode, TEST_ADDR) == 0);
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Area_Refresh(image, 0, 0, IMG_W, IMG_H, 1, GC16_Mode, TEST_ADDR) == 0);
+    hash = mock_spi_tx_hash;
+    bytes = mock_spi_tx_bytes;
+
+    assert(EPD_IT8951_SetUploadDither(DITHER_MODES) == -2);
+    assert(EPD_IT8951_SetUploadDepth(1) == 0);
+    assert(EPD_IT8951_SetUploadDither(DITHER_BAYER) == 0);
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Area_Refresh(frame, 0, 0, IMG_W, IMG_H, 8, GC16_Mode, TEST_ADDR) == 0);
+    assert(mock_spi_tx_bytes == bytes && mock_spi_tx_hash == hash);
+
+    // Without dithering the grays are cut, and the bus differs
+    assert(EPD_IT8951_SetUploadDither(DITHER_NONE) == 0);
+    mock_spi_tx_reset();
+    assert(EPD_IT8951_Area_Refresh(frame, 0, 0, IMG_W, IMG_H, 8, GC16_Mode, TEST_ADDR) == 0);
+    assert(mock_spi_tx_bytes == bytes && mock_spi_tx_hash != hash);
+    assert(EPD_IT8951_SetUploadDepth(8) == 0);
+}
+
+int main(void) {
+    EPD_IT8951_Init(0);
+    test_levels();
+    test_mean_kept();
+    test_bayer_by_position();
+    test_reset();
+    test_parse();
+    test_bmp_loader();
+    test_upload_dither();
+    printf("All GUI_Dither tests passed!\n");
+    return 0;
+}
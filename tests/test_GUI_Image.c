@@ -0,0 +1,277 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/GUI_Image.h"
+#include "../include/GUI_BMPfile.h"
+#include "../include/GUI_Paint.h"
+
+// The assets are 64x48 and hold these patterns
+#define IMG_W 64
+#define IMG_H 48
+
+static UBYTE frame[IMG_W * IMG_H];
+
+static UBYTE luma(UDOUBLE r, UDOUBLE g, UDOUBLE b) {
+    return (UBYTE)((r * 299 + g * 587 + b * 114 + 500) / 1000);
+}
+
+static UBYTE over_white(UDOUBLE gray, UDOUBLE alpha) {
+    return (UBYTE)((gray * alpha + 255 * (255 - alpha) + 127) / 255);
+}
+
+static UBYTE gray_at(int x, int y) {
+    return (UBYTE)((x * 4 + y * 3) & 255);
+}
+
+static UBYTE rgb_at(int x, int y) {
+    return luma(x * 4, y * 5, (x + y) * 2);
+}
+
+static UBYTE *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    UBYTE *data;
+
+    assert(f);
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc(*len);
+    assert(data && fread(data, 1, *len, f) == *len);
+    fclose(f);
+    return data;
+}
+
+// Every PNG color type decodes to exactly the gray of its pixels
+void test_png(void) {
+    GUI_IMAGE img;
+
+    assert(GUI_LoadImage("assets/gray8.png", &img) == 0);
+    assert(img.Width == IMG_W && img.Height == IMG_H);
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            assert(img.Gray[y * IMG_W + x] == gray_at(x, y));
+    GUI_FreeImage(&img);
+
+    // 16 bit samples keep their high byte, 2 bit ones are scaled up
+    assert(GUI_LoadImage("assets/gray16.png", &img) == 0);
+    for (int i = 0; i < IMG_W * IMG_H; i++)
+        assert(img.Gray[i] == gray_at(i % IMG_W, i / IMG_W));
+    GUI_FreeImage(&img);
+    assert(GUI_LoadImage("assets/gray2.png", &img) == 0);
+    for (int i = 0; i < IMG_W * IMG_H; i++)
+        assert(img.Gray[i] == (gray_at(i % IMG_W, i / IMG_W) >> 6) * 85);
+    GUI_FreeImage(&img);
+
+    assert(GUI_LoadImage("assets/rgb8.png", &img) == 0);
+    for (int i = 0; i < IMG_W * IMG_H; i++)
+        assert(img.Gray[i] == rgb_at(i % IMG_W, i / IMG_W));
+    GUI_FreeImage(&img);
+
+    // Transparency is over white
+    assert(GUI_LoadImage("assets/rgba8.png", &img) == 0);
+    for (int i = 0; i < IMG_W * IMG_H; i++) {
+        int x = i % IMG_W;
+        assert(img.Gray[i] == over_white(rgb_at(x, i / IMG_W), (x * 8) & 255));
+    }
+    GUI_FreeImage(&img);
+
+    // 16 entry palette at 4 bits, the first 4 entries partly transparent
+    assert(GUI_LoadImage("assets/palette4.png", &img) == 0);
+    for (int i = 0; i < IMG_W * IMG_H; i++) {
+        int k = (i % IMG_W + i / IMG_W) % 16;
+        UBYTE gray = luma(k * 17, 255 - k * 17, k * 8);
+        assert(img.Gray[i] == (k < 4 ? over_white(gray, k * 85) : gray));
+    }
+    GUI_FreeImage(&img);
+}
+
+// JPEGs decode to their luma, within what quality 90 keeps
+void test_jpeg(void) {
+    GUI_IMAGE img;
+
+    assert(GUI_LoadImage("assets/gray.jpg", &img) == 0);
+    assert(img.Width == IMG_W && img.Height == IMG_H);
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            assert(abs(img.Gray[y * IMG_W + x] - (x * 2 + y * 2)) <= 3);
+    GUI_FreeImage(&img);
+
+    // YCbCr 4:2:0 with a restart marker every 2 MCUs
+    assert(GUI_LoadImage("assets/color_rst.jpg", &img) == 0);
+    assert(img.Width == IMG_W && img.Height == IMG_H);
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            assert(abs(img.Gray[y * IMG_W + x] - rgb_at(x, y)) <= 3);
+    GUI_FreeImage(&img);
+}
+
+// Kinds not decoded here are told apart from damage, for the fallback
+void test_not_decoded(void) {
+    GUI_IMAGE img;
+
+    assert(GUI_CheckImage("assets/gray8.png") == 0);
+    assert(GUI_CheckImage("assets/palette4.png") == 0);
+    assert(GUI_CheckImage("assets/color_rst.jpg") == 0);
+    assert(GUI_CheckImage("assets/test.bmp") == 0);
+    assert(GUI_CheckImage("assets/interlaced.png") == GUI_IMAGE_ERR_FORMAT);
+    assert(GUI_CheckImage("assets/progressive.jpg") == GUI_IMAGE_ERR_FORMAT);
+    // Sequential, but each component in a scan of its own
+    assert(GUI_CheckImage("assets/multiscan.jpg") == GUI_IMAGE_ERR_FORMAT);
+    assert(GUI_CheckImage("test_GUI_Image.c") == GUI_IMAGE_ERR_FORMAT);
+    assert(GUI_CheckImage("assets/missing.png") == GUI_IMAGE_ERR_OPEN);
+
+    assert(GUI_LoadImage("assets/interlaced.png", &img) == GUI_IMAGE_ERR_FORMAT);
+    assert(GUI_LoadImage("assets/progressive.jpg", &img) == GUI_IMAGE_ERR_FORMAT);
+    assert(GUI_LoadImage("assets/multiscan.jpg", &img) == GUI_IMAGE_ERR_FORMAT);
+    assert(GUI_LoadImage("assets/test.bmp", &img) == GUI_IMAGE_ERR_FORMAT);
+    assert(img.Gray == NULL);
+}
+
+// Cut short or damaged files fail cleanly; JPEGs show what arrived
+void test_damaged(void) {
+    const char *files[] = { "assets/gray8.png", "assets/rgba8.png", "assets/gray.jpg", "assets/color_rst.jpg" };
+    GUI_IMAGE img;
+
+    for (size_t f = 0; f < sizeof(files) / sizeof(files[0]); f++) {
+        size_t len;
+        UBYTE *data = read_file(files[f], &len);
+        bool png = GUI_ImageFormat(data, len) == GUI_IMAGE_PNG;
+
+        for (size_t cut = 0; cut < len; cut++) {
+            UBYTE *copy = malloc(cut + 1);
+            int ret;
+            memcpy(copy, data, cut);
+            ret = png ? GUI_DecodePNG(copy, cut, &img) : GUI_DecodeJPEG(copy, cut, &img);
+            assert(ret == 0 || ret == GUI_IMAGE_ERR_FORMAT || ret == GUI_IMAGE_ERR_DECODE);
+            if (ret == 0)
+                GUI_FreeImage(&img);
+            else
+                assert(img.Gray == NULL);
+            // A PNG needs all of its data
+            if (png && cut < len - 12)
+                assert(ret != 0);
+            free(copy);
+        }
+
+        srand(5);
+        for (int i = 0; i < 500; i++) {
+            int ret;
+            data[rand() % len] ^= 1 << (rand() % 8);
+            ret = png ? GUI_DecodePNG(data, len, &img) : GUI_DecodeJPEG(data, len, &img);
+            if (ret == 0)
+                GUI_FreeImage(&img);
+        }
+        free(data);
+    }
+
+    // A Huffman table with more codes than its lengths allow, 255 one bit
+    // codes, put first or in place of a table defined before the scan
+    {
+        size_t len, at[2] = { 2, 0 };
+        UBYTE *data = read_file("assets/gray.jpg", &len);
+        UBYTE dht[276] = { 0xFF, 0xC4, (2 + 17 + 255) >> 8, (2 + 17 + 255) & 0xFF, 0x00, 255 };
+        UBYTE *bad = malloc(len + sizeof(dht));
+
+        for (int i = 0; i < 255; i++)
+            dht[21 + i] = (UBYTE)i;
+        for (size_t i = 2; i + 1 < len; i++)
+            if (data[i] == 0xFF && data[i + 1] == 0xDA && at[1] == 0)
+                at[1] = i;
+        assert(at[1] != 0);
+        for (int t = 0; t < 2; t++) {
+            memcpy(bad, data, at[t]);
+            memcpy(bad + at[t], dht, sizeof(dht));
+            memcpy(bad + at[t] + sizeof(dht), data + at[t], len - at[t]);
+            assert(GUI_DecodeJPEG(bad, len + sizeof(dht), &img) == GUI_IMAGE_ERR_DECODE);
+            assert(img.Gray == NULL);
+        }
+        free(bad);
+        free(data);
+    }
+
+    // About half the scan of a JPEG: the top decodes, the rest is middle gray
+    {
+        size_t len;
+        UBYTE *data = read_file("assets/gray.jpg", &len);
+        assert(GUI_DecodeJPEG(data, len - 150, &img) == 0);
+        assert(img.Gray[0] <= 3);
+        assert(img.Gray[IMG_W * IMG_H - 1] == 128);
+        GUI_FreeImage(&img);
+        free(data);
+    }
+}
+
+// Rotation is clockwise, and mirroring comes after it
+void test_transform(void) {
+    GUI_IMAGE img;
+
+    for (int rotation = -90; rotation <= 360; rotation += 90) {
+        for (int mirror = 0; mirror <= 1; mirror++) {
+            int r = ((rotation % 360) + 360) % 360;
+            assert(GUI_LoadImage("assets/gray8.png", &img) == 0);
+            assert(GUI_TransformImage(&img, rotation, mirror) == 0);
+            if (r == 90 || r == 270)
+                assert(img.Width == IMG_H && img.Height == IMG_W);
+            else
+                assert(img.Width == IMG_W && img.Height == IMG_H);
+            for (int y = 0; y < img.Height; y++) {
+                for (int x = 0; x < img.Width; x++) {
+                    // Where this pixel came from
+                    int ux = mirror ? img.Width - 1 - x : x, sx, sy;
+                    if (r == 0) {
+                        sx = ux;
+                        sy = y;
+                    } else if (r == 90) {
+                        sx = y;
+                        sy = IMG_H - 1 - ux;
+                    } else if (r == 180) {
+                        sx = IMG_W - 1 - ux;
+                        sy = IMG_H - 1 - y;
+                    } else {
+                        sx = IMG_W - 1 - y;
+                        sy = ux;
+                    }
+                    assert(img.Gray[y * img.Width + x] == gray_at(sx, sy));
+                }
+            }
+            GUI_FreeImage(&img);
+        }
+    }
+    assert(GUI_LoadImage("assets/gray8.png", &img) == 0);
+    assert(GUI_TransformImage(&img, 45, false) == -2);
+    GUI_FreeImage(&img);
+    assert(GUI_SetImageTransform(45, false) == -2);
+}
+
+// GUI_ReadImage draws a PNG or JPEG as GUI_ReadBmp would draw it
+void test_read_image(void) {
+    Paint_NewImage(frame, IMG_H, IMG_W, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(8);
+    Paint_Clear(WHITE);
+    assert(GUI_SetBmpDither(DITHER_NONE) == 0);
+
+    // Turned a quarter clockwise, into a 48x64 image
+    assert(GUI_SetImageTransform(90, false) == 0);
+    assert(GUI_ReadImage("assets/gray8.png", 0, 0) == 0);
+    for (int y = 0; y < IMG_W; y++)
+        for (int x = 0; x < IMG_H; x++)
+            assert(frame[y * IMG_H + x] == (gray_at(y, IMG_H - 1 - x) & 0xF0));
+
+    // BMP files are drawn as they are, whatever the transform
+    assert(GUI_ReadImage("assets/test.bmp", 0, 0) == 0);
+    assert(GUI_ReadImage("assets/missing.png", 0, 0) == GUI_IMAGE_ERR_OPEN);
+    assert(GUI_ReadImage("assets/progressive.jpg", 0, 0) == GUI_IMAGE_ERR_FORMAT);
+    assert(GUI_SetImageTransform(0, false) == 0);
+}
+
+int main(void) {
+    test_png();
+    test_jpeg();
+    test_not_decoded();
+    test_damaged();
+    test_transform();
+    test_read_image();
+    printf("All GUI_Image tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,314 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/GUI_Paint.h"
+#include "../include/GUI_Paint_Bands.h"
+
+#define IMG_W 160
+#define IMG_H 100
+
+extern UBYTE isColor;
+
+static unsigned char buf[IMG_W * IMG_H];
+static unsigned char ref[IMG_W * IMG_H];
+static UBYTE row[64];
+static char cn_text[16];
+
+static const UWORD rotates[] = {ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270};
+
+// Every kind of drawing call, some of them running off the image
+static void scene_ctx(Paint_Ctx *ctx) {
+    PAINT_TIME time = {2024, 5, 17, 12, 34, 56};
+
+    Paint_Ctx_ClearWindows(ctx, 4, 4, 70, 40, 0xC0);
+    Paint_Ctx_SetPixel(ctx, 1, 1, BLACK);
+    Paint_Ctx_FillSpan(ctx, 10, 42, 120, 0x40);
+    Paint_Ctx_BlitRow(ctx, 3, 44, row, 64, 8);
+    Paint_Ctx_DrawPoint(ctx, 80, 10, BLACK, DOT_PIXEL_3X3, DOT_FILL_AROUND);
+    Paint_Ctx_DrawLine(ctx, 0, 0, 150, 90, BLACK, DOT_PIXEL_2X2, LINE_STYLE_DOTTED);
+    Paint_Ctx_DrawThickLine(ctx, 5, 90, 140, 20, 0x80, 7, LINE_CAP_SQUARE, LINE_STYLE_SOLID);
+    Paint_Ctx_DrawRectangle(ctx, 20, 20, 90, 70, 0x30, DOT_PIXEL_1X1, DRAW_FILL_EMPTY);
+    Paint_Ctx_DrawCircle(ctx, 40, 50, 30, 0x60, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    Paint_Ctx_DrawEllipse(ctx, 100, 60, 50, 20, BLACK, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
+    Paint_Ctx_DrawRoundedRectangle(ctx, 60, 5, 150, 35, 8, 0xA0, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    Paint_Ctx_DrawChar(ctx, 2, 60, 'Q', &Font24, BLACK, WHITE);
+    Paint_Ctx_DrawString_EN(ctx, 30, 25, "Bands 0123", &Font12, BLACK, FONT_BACKGROUND);
+    Paint_Ctx_DrawString_CN(ctx, 70, 45, cn_text, &Font12CN, BLACK, 0xE0);
+    Paint_Ctx_DrawNum(ctx, 100, 80, -4096, &Font12, 0x20, WHITE);
+    Paint_Ctx_DrawTime(ctx, 0, 80, &time, &Font12, BLACK, WHITE);
+    Paint_Ctx_SetColor(ctx, 130, 50, 0x0F);
+}
+
+// The same scene through the Paint_* functions
+static void scene_default(void) {
+    PAINT_TIME time = {2024, 5, 17, 12, 34, 56};
+
+    Paint_ClearWindows(4, 4, 70, 40, 0xC0);
+    Paint_SetPixel(1, 1, BLACK);
+    Paint_FillSpan(10, 42, 120, 0x40);
+    Paint_BlitRow(3, 44, row, 64, 8);
+    Paint_DrawPoint(80, 10, BLACK, DOT_PIXEL_3X3, DOT_FILL_AROUND);
+    Paint_DrawLine(0, 0, 150, 90, BLACK, DOT_PIXEL_2X2, LINE_STYLE_DOTTED);
+    Paint_DrawThickLine(5, 90, 140, 20, 0x80, 7, LINE_CAP_SQUARE, LINE_STYLE_SOLID);
+    Paint_DrawRectangle(20, 20, 90, 70, 0x30, DOT_PIXEL_1X1, DRAW_FILL_EMPTY);
+    Paint_DrawCircle(40, 50, 30, 0x60, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    Paint_DrawEllipse(100, 60, 50, 20, BLACK, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
+    Paint_DrawRoundedRectangle(60, 5, 150, 35, 8, 0xA0, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    Paint_DrawChar(2, 60, 'Q', &Font24, BLACK, WHITE);
+    Paint_DrawString_EN(30, 25, "Bands 0123", &Font12, BLACK, FONT_BACKGROUND);
+    Paint_DrawString_CN(70, 45, cn_text, &Font12CN, BLACK, 0xE0);
+    Paint_DrawNum(100, 80, -4096, &Font12, 0x20, WHITE);
+    Paint_DrawTime(0, 80, &time, &Font12, BLACK, WHITE);
+    Paint_SetColor(130, 50, 0x0F);
+}
+
+static void setup(void) {
+    int n = 0;
+    for (int i = 0; i < 64; i++)
+        row[i] = (UBYTE)(i * 4);
+    for (int i = 0; i < 4 && i < Font12CN.size; i++) {
+        cn_text[n++] = Font12CN.table[i].index[0];
+        if ((unsigned char)Font12CN.table[i].index[0] > 0x7F)
+            cn_text[n++] = Font12CN.table[i].index[1];
+    }
+    cn_text[n] = 0;
+}
+
+static void new_ctx(Paint_Ctx *ctx, UBYTE *image, UWORD rotate, UBYTE mirror, UBYTE bpp, UBYTE color) {
+    Paint_Ctx_NewImage(ctx, image, IMG_W, IMG_H, rotate, WHITE);
+    Paint_Ctx_SetBitsPerPixel(ctx, bpp);
+    Paint_Ctx_SetMirroring(ctx, mirror);
+    ctx->IsColor = color;
+    memset(image, 0x5A, sizeof(buf));
+}
+
+static bool same_damage(Paint_Ctx *a, Paint_Ctx *b) {
+    PAINT_RECT ra[PAINT_DAMAGE_MAX], rb[PAINT_DAMAGE_MAX];
+    UWORD na = Paint_Ctx_GetDamage(a, ra, PAINT_DAMAGE_MAX, 1);
+    UWORD nb = Paint_Ctx_GetDamage(b, rb, PAINT_DAMAGE_MAX, 1);
+    return na == nb && memcmp(ra, rb, na * sizeof(PAINT_RECT)) == 0;
+}
+
+// Marks the memory pixels inside the damaged areas
+static void damage_mask(Paint_Ctx *ctx, unsigned char *mask) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    UWORD n = Paint_Ctx_GetDamage(ctx, rects, PAINT_DAMAGE_MAX, 1);
+    memset(mask, 0, IMG_W * IMG_H);
+    for (UWORD i = 0; i < n; i++)
+        for (UWORD y = rects[i].Y; y < rects[i].Y + rects[i].H; y++)
+            memset(mask + y * IMG_W + rects[i].X, 1, rects[i].W);
+}
+
+void test_ctx_matches_default(void) {
+    Paint_Ctx ctx;
+
+    Paint_Ctx_Init(&ctx);
+    for (int r = 0; r < 4; r++)
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2)
+    for (UBYTE color = 0; color < 2; color++) {
+        new_ctx(&ctx, ref, rotates[r], MIRROR_HORIZONTAL, bpp, color);
+        scene_ctx(&ctx);
+
+        Paint_NewImage(buf, IMG_W, IMG_H, rotates[r], WHITE);
+        Paint_SetBitsPerPixel(bpp);
+        Paint_SetMirroring(MIRROR_HORIZONTAL);
+        isColor = color;
+        memset(buf, 0x5A, sizeof(buf));
+        scene_default();
+        assert(memcmp(buf, ref, sizeof(buf)) == 0);
+        assert(same_damage(&Paint, &ctx));
+    }
+    isColor = 0;
+    Paint_Ctx_Release(&ctx);
+}
+
+void test_clip(void) {
+    Paint_Ctx full, clipped;
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+
+    Paint_Ctx_Init(&full);
+    Paint_Ctx_Init(&clipped);
+    for (int r = 0; r < 4; r++)
+    for (UBYTE mirror = MIRROR_NONE; mirror <= MIRROR_ORIGIN; mirror++)
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        new_ctx(&full, ref, rotates[r], mirror, 8, 0);
+        scene_ctx(&full);
+
+        // At 8bpp the clip can be checked byte by byte in memory coordinates
+        new_ctx(&clipped, buf, rotates[r], mirror, 8, 0);
+        Paint_Ctx_SetClip(&clipped, 15, 12, 77, 61);
+        PAINT_RECT clip = clipped.Clip;
+        assert(clip.W == (r % 2 ? 49 : 62) && clip.H == (r % 2 ? 62 : 49));
+        scene_ctx(&clipped);
+        for (int y = 0; y < IMG_H; y++)
+            for (int x = 0; x < IMG_W; x++) {
+                bool inside = x >= clip.X && x < clip.X + clip.W && y >= clip.Y && y < clip.Y + clip.H;
+                assert(buf[y * IMG_W + x] == (inside ? ref[y * IMG_W + x] : 0x5A));
+            }
+        UWORD n = Paint_Ctx_GetDamage(&clipped, rects, PAINT_DAMAGE_MAX, 1);
+        for (UWORD i = 0; i < n; i++)
+            assert(rects[i].X >= clip.X && rects[i].X + rects[i].W <= clip.X + clip.W &&
+                   rects[i].Y >= clip.Y && rects[i].Y + rects[i].H <= clip.Y + clip.H);
+
+        // Clearing the clip draws everywhere again, at any depth
+        new_ctx(&full, ref, rotates[r], mirror, bpp, 0);
+        scene_ctx(&full);
+        new_ctx(&clipped, buf, rotates[r], mirror, bpp, 0);
+        Paint_Ctx_SetClip(&clipped, 0, 0, 0, 0);
+        assert(clipped.Clip.W == 0 || clipped.Clip.H == 0);
+        scene_ctx(&clipped);
+        for (size_t i = 0; i < sizeof(buf); i++)
+            assert(buf[i] == 0x5A);
+        assert(Paint_Ctx_GetDamage(&clipped, rects, PAINT_DAMAGE_MAX, 1) == 0);
+        Paint_Ctx_ClearClip(&clipped);
+        scene_ctx(&clipped);
+        assert(memcmp(buf, ref, sizeof(buf)) == 0);
+    }
+    Paint_Ctx_Release(&full);
+    Paint_Ctx_Release(&clipped);
+}
+
+void test_record_and_replay(void) {
+    Paint_Ctx direct, replayed;
+    PAINT_BATCH batch;
+
+    Paint_Ctx_Init(&direct);
+    Paint_Ctx_Init(&replayed);
+    Paint_Batch_Init(&batch);
+    for (int r = 0; r < 4; r++)
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        new_ctx(&direct, ref, rotates[r], MIRROR_VERTICAL, bpp, 0);
+        scene_ctx(&direct);
+
+        // Recording draws nothing and copies what the calls point to
+        new_ctx(&replayed, buf, rotates[r], MIRROR_VERTICAL, bpp, 0);
+        Paint_Batch_Reset(&batch);
+        Paint_Ctx_Record(&replayed, &batch);
+        scene_ctx(&replayed);
+        Paint_Ctx_Record(&replayed, NULL);
+        assert(batch.Count == 17 && !batch.Failed);
+        for (size_t i = 0; i < sizeof(buf); i++)
+            assert(buf[i] == 0x5A);
+        assert(replayed.Damage.Count == 0);
+        memset(row, 0, sizeof(row));
+        char saved = cn_text[0];
+        cn_text[0] = 'x';
+
+        Paint_Ctx_Replay(&replayed, &batch);
+        setup();
+        assert(cn_text[0] == saved);
+        assert(memcmp(buf, ref, sizeof(buf)) == 0);
+        assert(same_damage(&direct, &replayed));
+    }
+
+    // The default context records and replays too
+    Paint_NewImage(buf, IMG_W, IMG_H, ROTATE_90, WHITE);
+    memset(buf, 0x5A, sizeof(buf));
+    Paint_Batch_Reset(&batch);
+    Paint_Record(&batch);
+    Paint_DrawLine(0, 0, 99, 99, BLACK, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+    Paint_Record(NULL);
+    assert(batch.Count == 1 && buf[0] == 0x5A);
+    Paint_Replay(&batch);
+    assert(memchr(buf, BLACK, sizeof(buf)) != NULL);
+
+    Paint_Batch_Release(&batch);
+    assert(batch.Ops == NULL && batch.Count == 0);
+    Paint_Ctx_Release(&direct);
+    Paint_Ctx_Release(&replayed);
+}
+
+void test_bands_match_one_thread(void) {
+    static unsigned char single_mask[IMG_W * IMG_H], band_mask[IMG_W * IMG_H];
+    Paint_Ctx single, target;
+    PAINT_BATCH batch;
+    PAINT_BANDS bands;
+
+    Paint_Ctx_Init(&single);
+    Paint_Ctx_Init(&target);
+    Paint_Batch_Init(&batch);
+    Paint_Ctx_Record(&target, &batch);
+    scene_ctx(&target);
+    Paint_Ctx_Record(&target, NULL);
+
+    for (UWORD count = 1; count <= 7; count += 2) {
+        assert(Paint_Bands_Init(&bands, count) == 0);
+        for (int r = 0; r < 4; r++)
+        for (UBYTE mirror = MIRROR_NONE; mirror <= MIRROR_ORIGIN; mirror += 3)
+        for (UBYTE bpp = 1; bpp <= 8; bpp *= 2)
+        for (int clip = 0; clip < 2; clip++) {
+            new_ctx(&single, ref, rotates[r], mirror, bpp, count == 3);
+            new_ctx(&target, buf, rotates[r], mirror, bpp, count == 3);
+            if (clip) {
+                Paint_Ctx_SetClip(&single, 7, 3, 120, 83);
+                Paint_Ctx_SetClip(&target, 7, 3, 120, 83);
+            }
+            Paint_Ctx_Replay(&single, &batch);
+            assert(Paint_Bands_Render(&bands, &target, &batch) == 0);
+            assert(memcmp(buf, ref, sizeof(buf)) == 0);
+
+            // The bands' damage lies within the single thread's and covers
+            // every byte that changed
+            damage_mask(&single, single_mask);
+            damage_mask(&target, band_mask);
+            for (int y = 0; y < IMG_H; y++)
+                for (int x = 0; x < IMG_W; x++) {
+                    int i = y * IMG_W + x;
+                    assert(!band_mask[i] || single_mask[i]);
+                    if (bpp == 8 && buf[i] != 0x5A)
+                        assert(band_mask[i]);
+                }
+        }
+        Paint_Bands_Release(&bands);
+    }
+
+    // The default context can be the target
+    assert(Paint_Bands_Init(&bands, 4) == 0);
+    new_ctx(&single, ref, ROTATE_270, MIRROR_NONE, 4, 0);
+    Paint_Ctx_Replay(&single, &batch);
+    Paint_NewImage(buf, IMG_W, IMG_H, ROTATE_270, WHITE);
+    Paint_SetBitsPerPixel(4);
+    memset(buf, 0x5A, sizeof(buf));
+    assert(Paint_Bands_Render(&bands, &Paint, &batch) == 0);
+    assert(memcmp(buf, ref, sizeof(buf)) == 0);
+    Paint_Bands_Release(&bands);
+
+    Paint_Batch_Release(&batch);
+    Paint_Ctx_Release(&single);
+    Paint_Ctx_Release(&target);
+}
+
+void test_bands_errors(void) {
+    PAINT_BANDS bands;
+    PAINT_BATCH batch;
+    Paint_Ctx ctx;
+
+    assert(Paint_Bands_Init(&bands, 0) == PAINT_BANDS_ERR_ARGS);
+    assert(Paint_Bands_Init(&bands, PAINT_BANDS_MAX + 1) == PAINT_BANDS_ERR_ARGS);
+
+    // A batch that lost calls is not drawn at all
+    assert(Paint_Bands_Init(&bands, 2) == 0);
+    Paint_Ctx_Init(&ctx);
+    new_ctx(&ctx, buf, ROTATE_0, MIRROR_NONE, 8, 0);
+    Paint_Batch_Init(&batch);
+    Paint_Ctx_Record(&ctx, &batch);
+    Paint_Ctx_Clear(&ctx, BLACK);
+    Paint_Ctx_Record(&ctx, NULL);
+    batch.Failed = true;
+    assert(Paint_Bands_Render(&bands, &ctx, &batch) == PAINT_BANDS_ERR_BATCH);
+    assert(buf[0] == 0x5A);
+    Paint_Batch_Release(&batch);
+    Paint_Bands_Release(&bands);
+    Paint_Ctx_Release(&ctx);
+}
+
+int main(void) {
+    setup();
+    test_ctx_matches_default();
+    test_clip();
+    test_record_and_replay();
+    test_bands_match_one_thread();
+    test_bands_errors();
+    printf("All GUI_Paint context and band tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/GUI_Paint.h"
+
+#define IMG_W 200
+#define IMG_H 120
+
+static unsigned char buf[IMG_W * IMG_H];
+static unsigned char ref[IMG_W * IMG_H];
+
+// A string of the font's entries in reverse table order, with an ASCII
+// character and a GB2312 character the font does not have
+static void make_text(const cFONT *font, char *text) {
+    int n = 0;
+    for (int i = font->size - 1; i >= 0; i--) {
+        text[n++] = font->table[i].index[0];
+        if ((unsigned char)font->table[i].index[0] > 0x7F)
+            text[n++] = font->table[i].index[1];
+        if (i == font->size / 2) {
+            text[n++] = '~';
+            text[n++] = (char)0xB0;
+            text[n++] = (char)0xA1;
+        }
+    }
+    text[n] = 0;
+}
+
+// The table scan and per pixel drawing the index replaced
+static void reference_string(int x, int y, const unsigned char *p, const cFONT *font,
+                             UWORD foreground, UWORD background) {
+    while (*p != 0) {
+        for (int num = 0; num < font->size; num++) {
+            const CH_CN *entry = &font->table[num];
+            if (p[0] != (unsigned char)entry->index[0] ||
+                (p[0] > 0x7F && p[1] != (unsigned char)entry->index[1]))
+                continue;
+            const unsigned char *ptr = (const unsigned char *)entry->matrix;
+            for (int j = 0; j < font->Height; j++) {
+                for (int i = 0; i < font->Width; i++) {
+                    if (*ptr & (0x80 >> (i % 8)))
+                        Paint_SetPixel(x + i, y + j, foreground);
+                    else if (background != FONT_BACKGROUND)
+                        Paint_SetPixel(x + i, y + j, background);
+                    if (i % 8 == 7)
+                        ptr++;
+                }
+                if (font->Width % 8 != 0)
+                    ptr++;
+            }
+            break;
+        }
+        if (*p <= 0x7F) {
+            p += 1;
+            x += font->ASCII_Width;
+        } else {
+            p += 2;
+            x += font->Width;
+        }
+    }
+}
+
+static void new_page(UBYTE *image, UWORD rotate, UBYTE mirror, UBYTE bpp) {
+    Paint_NewImage(image, IMG_W, IMG_H, rotate, WHITE);
+    Paint_SetBitsPerPixel(bpp);
+    Paint_SetMirroring(mirror);
+    memset(image, 0x5A, sizeof(buf));
+}
+
+void test_matches_scan(void) {
+    static const UWORD rotates[] = {ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270};
+    char text12[128], text24[128];
+
+    make_text(&Font12CN, text12);
+    make_text(&Font24CN, text24);
+    for (int r = 0; r < 4; r++)
+    for (UBYTE mirror = MIRROR_NONE; mirror <= MIRROR_ORIGIN; mirror++)
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2)
+    for (int cache = 0; cache < 2; cache++)
+    for (int opaque = 0; opaque < 2; opaque++) {
+        UWORD background = opaque ? 0x33 : WHITE;
+
+        new_page(ref, rotates[r], mirror, bpp);
+        reference_string(3, 2, (const unsigned char *)text12, &Font12CN, BLACK, background);
+        reference_string(-5, 30, (const unsigned char *)text24, &Font24CN, 0x80, background);
+
+        Paint_SetGlyphCache(cache ? PAINT_GLYPH_CACHE_BYTES : 0);
+        new_page(buf, rotates[r], mirror, bpp);
+        Paint_DrawString_CN(3, 2, text12, &Font12CN, BLACK, background);
+        // Runs off the right edge, and wraps from the left at 65531
+        Paint_DrawString_CN(-5, 30, text24, &Font24CN, 0x80, background);
+        assert(memcmp(buf, ref, sizeof(buf)) == 0);
+    }
+    Paint_SetGlyphCache(PAINT_GLYPH_CACHE_BYTES);
+}
+
+void test_missing_and_trailing(void) {
+    char text[8];
+
+    // An unknown character leaves its cell alone but still advances
+    new_page(ref, ROTATE_0, MIRROR_NONE, 8);
+    text[0] = 'a';
+    text[1] = 0;
+    reference_string(Font24CN.ASCII_Width + Font24CN.Width, 0, (const unsigned char *)text, &Font24CN, BLACK, 0x33);
+    new_page(buf, ROTATE_0, MIRROR_NONE, 8);
+    text[0] = '\x01';
+    text[1] = (char)0xB0;
+    text[2] = (char)0xA1;
+    text[3] = 'a';
+    text[4] = 0;
+    Paint_DrawString_CN(0, 0, text, &Font24CN, BLACK, 0x33);
+    assert(memcmp(buf, ref, sizeof(buf)) == 0);
+
+    // A lead byte at the end of the string is dropped, not read past
+    text[0] = 'a';
+    text[1] = Font24CN.table[0].index[0];
+    text[2] = 0;
+    text[3] = Font24CN.table[0].index[1];
+    new_page(buf, ROTATE_0, MIRROR_NONE, 8);
+    Paint_DrawString_CN(Font24CN.ASCII_Width + Font24CN.Width, 0, text, &Font24CN, BLACK, 0x33);
+    assert(memcmp(buf, ref, sizeof(buf)) == 0);
+}
+
+void test_duplicates_and_new_table(void) {
+    static const CH_CN table[] = {
+        {{'a', 0}, {(char)0x80}},
+        {{(char)0xC4, (char)0xE3}, {(char)0x40}},
+        {{'a', 0}, {(char)0x20}},
+        {{(char)0xC4, (char)0xE3}, {(char)0x10}},
+    };
+    static const CH_CN other[] = {
+        {{(char)0xC4, (char)0xE3}, {(char)0x08}},
+    };
+    cFONT font = {table, 4, 8, 8, 1};
+    const char text[] = "a\xC4\xE3";
+
+    // The first of duplicate entries is drawn, as with a scan
+    new_page(buf, ROTATE_0, MIRROR_NONE, 8);
+    Paint_DrawString_CN(0, 0, text, &font, BLACK, WHITE);
+    for (int x = 0; x < 16; x++)
+        assert(buf[x] == ((x == 0 || x == 9) ? 0x00 : 0x5A));
+
+    // The index follows the font to another table
+    font.table = other;
+    font.size = 1;
+    new_page(buf, ROTATE_0, MIRROR_NONE, 8);
+    Paint_DrawString_CN(0, 0, text, &font, BLACK, WHITE);
+    for (int x = 0; x < 16; x++)
+        assert(buf[x] == (x == 12 ? 0x00 : 0x5A));
+}
+
+void test_damage(void) {
+    PAINT_RECT rect;
+    const char text[] = {Font12CN.table[0].index[0], Font12CN.table[0].index[1], 0};
+
+    new_page(buf, ROTATE_0, MIRROR_NONE, 8);
+    Paint_ClearDamage();
+    Paint_DrawString_CN(10, 20, text, &Font12CN, BLACK, 0x33);
+    assert(Paint_GetDamage(&rect, 1, 1) == 1);
+    assert(rect.X == 10 && rect.Y == 20);
+    assert(rect.W == Font12CN.Width && rect.H == Font12CN.Height);
+}
+
+int main(void) {
+    test_matches_scan();
+    test_missing_and_trailing();
+    test_duplicates_and_new_table();
+    test_damage();
+    printf("All GUI_Paint Chinese font tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/GUI_Paint.h"
+
+static unsigned char buf[800 * 600];
+
+static void new_image(UWORD w, UWORD h, UWORD rotate, UBYTE bpp) {
+    Paint_NewImage(buf, w, h, rotate, WHITE);
+    Paint_SetBitsPerPixel(bpp);
+}
+
+static void assert_rect(const PAINT_RECT *r, UWORD x, UWORD y, UWORD w, UWORD h) {
+    assert(r->X == x && r->Y == y && r->W == w && r->H == h);
+}
+
+void test_string_damage(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    new_image(800, 600, ROTATE_0, 4);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 0);
+
+    // A background color sets every pixel of each character cell
+    Paint_DrawString_EN(100, 200, "12:34", &Font12, BLACK, 0x80);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 1);
+    assert_rect(&rects[0], 100, 200, 5 * Font12.Width, Font12.Height);
+
+    Paint_ClearDamage();
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 0);
+}
+
+void test_far_areas_stay_apart(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    new_image(800, 600, ROTATE_0, 4);
+
+    // Points are drawn one pixel up and left of their coordinates
+    Paint_DrawRectangle(10, 10, 20, 20, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 1);
+    assert_rect(&rects[0], 9, 9, 11, 10);
+    Paint_ClearWindows(600, 400, 700, 450, BLACK);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 2);
+
+    // Neighbours are cheaper to refresh together
+    Paint_ClearWindows(24, 10, 30, 20, BLACK);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 2);
+    assert((rects[0].X == 9 && rects[0].W == 21) || (rects[1].X == 9 && rects[1].W == 21));
+
+    // A whole-image clear swallows everything
+    Paint_Clear(WHITE);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 1);
+    assert_rect(&rects[0], 0, 0, 800, 600);
+}
+
+void test_overlap_merges(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    new_image(800, 600, ROTATE_0, 8);
+
+    Paint_ClearWindows(0, 0, 400, 300, BLACK);
+    Paint_ClearWindows(399, 299, 800, 600, BLACK);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 1);
+    assert_rect(&rects[0], 0, 0, 800, 600);
+}
+
+void test_list_folds_when_full(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    UWORD count;
+    new_image(800, 600, ROTATE_0, 1);
+
+    // 48 isolated points, far more areas than the list holds
+    for (UWORD y = 0; y < 6; y++)
+        for (UWORD x = 0; x < 8; x++)
+            Paint_DrawPoint(x * 100 + 50, y * 100 + 50, BLACK, DOT_PIXEL_1X1, DOT_FILL_RIGHTUP);
+    count = Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1);
+    assert(count >= 1 && count <= PAINT_DAMAGE_MAX);
+    for (UWORD y = 0; y < 6; y++)
+        for (UWORD x = 0; x < 8; x++) {
+            UWORD px = x * 100 + 49, py = y * 100 + 49, hits = 0;
+            for (UWORD i = 0; i < count; i++)
+                if (px >= rects[i].X && px < rects[i].X + rects[i].W &&
+                    py >= rects[i].Y && py < rects[i].Y + rects[i].H)
+                    hits++;
+            assert(hits == 1);
+        }
+}
+
+void test_rotated_damage(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    // 100 wide in memory, drawn as a 50x100 image turned by 90 degrees
+    new_image(100, 50, ROTATE_90, 8);
+    Paint_AddDamage(10, 20, 15, 30);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 1);
+    // Paint_SetPixel maps (x, y) to (WidthMemory - y - 1, x)
+    assert_rect(&rects[0], 100 - 30, 10, 10, 5);
+
+    Paint_ClearDamage();
+    Paint_SetPixel(3, 7, BLACK);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 1) == 1);
+    assert_rect(&rects[0], 100 - 7 - 1, 3, 1, 1);
+}
+
+void test_alignment(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    new_image(798, 600, ROTATE_0, 4);
+
+    Paint_AddDamage(5, 10, 8, 20);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 4) == 1);
+    assert_rect(&rects[0], 4, 10, 4, 10);
+
+    // Widening stops at the edge of the image
+    Paint_ClearDamage();
+    Paint_AddDamage(790, 0, 798, 5);
+    assert(Paint_GetDamage(rects, PAINT_DAMAGE_MAX, 16) == 1);
+    assert_rect(&rects[0], 784, 0, 14, 5);
+}
+
+void test_set_pixel_bounds(void) {
+    // The last column and row are the only ones past the end that used to be written
+    memset(buf, 0xAA, sizeof(buf));
+    new_image(10, 10, ROTATE_0, 8);
+    Paint_SetPixel(10, 0, BLACK);
+    Paint_SetPixel(0, 10, BLACK);
+    assert(buf[10] == 0xAA);
+    assert(buf[100] == 0xAA);
+    assert(Paint_GetDamage(NULL, 0, 1) == 0);
+}
+
+int main(void) {
+    test_string_damage();
+    test_far_areas_stay_apart();
+    test_overlap_merges();
+    test_list_folds_when_full();
+    test_rotated_damage();
+    test_alignment();
+    test_set_pixel_bounds();
+    printf("All GUI_Paint damage tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/GUI_Paint.h"
+
+#define IMG_W 200
+#define IMG_H 120
+
+static unsigned char buf[IMG_W * IMG_H];
+static unsigned char ref[IMG_W * IMG_H];
+
+static const char *text = "The quick brown fox, 0123456789!";
+
+static void draw_page(UBYTE *image, UWORD rotate, UBYTE mirror, UBYTE bpp, UWORD background) {
+    Paint_NewImage(image, IMG_W, IMG_H, rotate, WHITE);
+    Paint_SetBitsPerPixel(bpp);
+    Paint_SetMirroring(mirror);
+    memset(image, 0x5A, sizeof(buf));
+    // Odd positions put glyphs at every offset within a byte
+    Paint_DrawString_EN(1, 3, text, &Font12, BLACK, background);
+    Paint_DrawString_EN(6, 40, text, &Font16, 0x80, background);
+    Paint_DrawString_EN(3, 61, "fox fox fox", &Font24, BLACK, background);
+}
+
+void test_matches_pixels(void) {
+    static const UWORD rotates[] = {ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270};
+    PAINT_RECT cached[PAINT_DAMAGE_MAX], plain[PAINT_DAMAGE_MAX];
+
+    for (int r = 0; r < 4; r++)
+    for (UBYTE mirror = MIRROR_NONE; mirror <= MIRROR_ORIGIN; mirror++)
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2)
+    for (int opaque = 0; opaque < 2; opaque++) {
+        UWORD background = opaque ? 0x33 : WHITE;
+
+        Paint_SetGlyphCache(0);
+        draw_page(ref, rotates[r], mirror, bpp, background);
+        UWORD n = Paint_GetDamage(plain, PAINT_DAMAGE_MAX, 1);
+
+        Paint_SetGlyphCache(PAINT_GLYPH_CACHE_BYTES);
+        draw_page(buf, rotates[r], mirror, bpp, background);
+        assert(Paint_GetDamage(cached, PAINT_DAMAGE_MAX, 1) == n);
+        assert(memcmp(cached, plain, n * sizeof(PAINT_RECT)) == 0);
+        assert(memcmp(buf, ref, sizeof(buf)) == 0);
+    }
+}
+
+void test_stats(void) {
+    PAINT_GLYPH_STATS stats;
+
+    Paint_SetGlyphCache(0);
+    Paint_GetGlyphStats(&stats);
+    assert(stats.Glyphs == 0 && stats.Bytes == 0 && stats.Max_Bytes == 0);
+
+    Paint_SetGlyphCache(PAINT_GLYPH_CACHE_BYTES);
+    Paint_NewImage(buf, IMG_W, IMG_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(8);
+    Paint_GetGlyphStats(&stats);
+    uint64_t hits = stats.Hits, misses = stats.Misses;
+
+    // Three glyphs, the second "a" is a hit
+    Paint_DrawString_EN(0, 0, "aba", &Font16, BLACK, WHITE);
+    Paint_GetGlyphStats(&stats);
+    assert(stats.Misses == misses + 2 && stats.Hits == hits + 1);
+    assert(stats.Glyphs == 2 && stats.Bytes > 0 && stats.Bytes <= stats.Max_Bytes);
+
+    // Another color is another glyph
+    Paint_DrawString_EN(0, 20, "a", &Font16, 0x80, WHITE);
+    Paint_GetGlyphStats(&stats);
+    assert(stats.Glyphs == 3 && stats.Misses == misses + 3);
+
+    Paint_FlushGlyphCache();
+    Paint_GetGlyphStats(&stats);
+    assert(stats.Glyphs == 0 && stats.Bytes == 0 && stats.Misses == misses + 3);
+}
+
+void test_bounded(void) {
+    PAINT_GLYPH_STATS stats;
+    UDOUBLE limit = 4096;
+
+    Paint_SetGlyphCache(limit);
+    Paint_NewImage(buf, IMG_W, IMG_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(8);
+    for (int i = 0; i < 3; i++)
+        Paint_DrawString_EN(0, 0, text, &Font24, BLACK, WHITE);
+    Paint_GetGlyphStats(&stats);
+    assert(stats.Bytes <= limit && stats.Glyphs > 0 && stats.Evictions > 0);
+
+    // Shrinking the limit drops the oldest glyphs at once
+    Paint_SetGlyphCache(limit / 4);
+    Paint_GetGlyphStats(&stats);
+    assert(stats.Bytes <= limit / 4 && stats.Max_Bytes == limit / 4);
+    Paint_SetGlyphCache(PAINT_GLYPH_CACHE_BYTES);
+}
+
+void test_clipped_char(void) {
+    // A character hanging off the image is drawn a pixel at a time
+    Paint_SetGlyphCache(0);
+    Paint_NewImage(ref, IMG_W, IMG_H, ROTATE_90, WHITE);
+    memset(ref, 0x5A, sizeof(ref));
+    Paint_DrawChar(Paint.Width - 5, Paint.Height - 7, 'W', &Font20, BLACK, 0x80);
+
+    Paint_SetGlyphCache(PAINT_GLYPH_CACHE_BYTES);
+    Paint_NewImage(buf, IMG_W, IMG_H, ROTATE_90, WHITE);
+    memset(buf, 0x5A, sizeof(buf));
+    Paint_DrawChar(Paint.Width - 5, Paint.Height - 7, 'W', &Font20, BLACK, 0x80);
+    assert(memcmp(buf, ref, sizeof(buf)) == 0);
+}
+
+int main(void) {
+    test_matches_pixels();
+    test_stats();
+    test_bounded();
+    test_clipped_char();
+    printf("All GUI_Paint glyph cache tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/GUI_Paint.h"
+
+#define IMG_W 120
+#define IMG_H 80
+#define GRAY 0x80
+
+static unsigned char buf[IMG_W * IMG_H];
+
+static void new_image(void) {
+    Paint_NewImage(buf, IMG_W, IMG_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(8);
+    Paint_Clear(WHITE);
+    Paint_ClearDamage();
+}
+
+static int is_black(int x, int y) {
+    return buf[y * IMG_W + x] == BLACK;
+}
+
+// Black exactly on the rectangle X0..X1, Y0..Y1, inclusive
+static void assert_box(int x0, int y0, int x1, int y1) {
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            assert(is_black(x, y) == (x >= x0 && x <= x1 && y >= y0 && y <= y1));
+}
+
+void test_axis_lines(void) {
+    PAINT_RECT rect;
+
+    new_image();
+    Paint_DrawThickLine(10, 20, 30, 20, BLACK, 4, LINE_CAP_BUTT, LINE_STYLE_SOLID);
+    assert_box(10, 18, 29, 21);
+    assert(Paint_GetDamage(&rect, 1, 1) == 1);
+    assert(rect.X == 10 && rect.Y == 18 && rect.W == 20 && rect.H == 4);
+
+    new_image();
+    Paint_DrawThickLine(10, 20, 30, 20, BLACK, 4, LINE_CAP_SQUARE, LINE_STYLE_SOLID);
+    assert_box(8, 18, 31, 21);
+
+    // One pixel with square ends covers both end pixels, in either direction
+    new_image();
+    Paint_DrawThickLine(40, 50, 40, 10, BLACK, 1, LINE_CAP_SQUARE, LINE_STYLE_SOLID);
+    assert_box(40, 10, 40, 50);
+
+    // A point is a square with square ends and nothing with butt ends
+    new_image();
+    Paint_DrawThickLine(5, 5, 5, 5, BLACK, 3, LINE_CAP_BUTT, LINE_STYLE_SOLID);
+    assert(Paint_GetDamage(NULL, 0, 1) == 0);
+    Paint_DrawThickLine(5, 5, 5, 5, BLACK, 3, LINE_CAP_SQUARE, LINE_STYLE_SOLID);
+    assert_box(4, 4, 6, 6);
+}
+
+void test_diagonal_lines(void) {
+    static const int ends[][4] = {{5, 5, 100, 70}, {100, 3, 7, 60}, {60, 75, 62, 2}, {2, 40, 115, 44}};
+
+    for (int i = 0; i < 4; i++)
+    for (UWORD width = 1; width <= 9; width += 4) {
+        int x0 = ends[i][0], y0 = ends[i][1], x1 = ends[i][2], y1 = ends[i][3];
+        double len = hypot(x1 - x0, y1 - y0), ux = (x1 - x0) / len, uy = (y1 - y0) / len;
+        double half = width / 2.0, eps = 1e-9;
+
+        new_image();
+        Paint_DrawThickLine(x0, y0, x1, y1, BLACK, width, LINE_CAP_BUTT, LINE_STYLE_SOLID);
+        for (int y = 0; y < IMG_H; y++) {
+            int row = 0;
+            for (int x = 0; x < IMG_W; x++) {
+                // Position along and across the line
+                double t = (x - x0) * ux + (y - y0) * uy;
+                double n = (y - y0) * ux - (x - x0) * uy;
+                int inside = t > eps && t < len - eps && fabs(n) < half - eps;
+                int near = t > -eps && t < len + eps && fabs(n) < half + eps;
+                assert(!inside || is_black(x, y));
+                assert(!is_black(x, y) || near);
+                row += is_black(x, y);
+            }
+            // No row between the ends is skipped
+            if (y > (y0 < y1 ? y0 : y1) && y < (y0 < y1 ? y1 : y0))
+                assert(row > 0);
+        }
+    }
+}
+
+void test_dashes(void) {
+    // Dashes of 3 and gaps of 2 line widths; gaps keep what was there
+    new_image();
+    Paint_ClearWindows(0, 0, IMG_W, 1, GRAY);
+    Paint_DrawThickLine(0, 0, 50, 0, BLACK, 2, LINE_CAP_BUTT, LINE_STYLE_DASHED);
+    for (int x = 0; x < 50; x++)
+        assert(buf[x] == (x % 10 < 6 ? BLACK : GRAY));
+    assert(buf[50] == GRAY);
+
+    // Dots and gaps of one line width
+    new_image();
+    Paint_DrawThickLine(10, 10, 10, 30, BLACK, 1, LINE_CAP_BUTT, LINE_STYLE_DOTTED);
+    for (int y = 10; y < 30; y++)
+        assert(is_black(10, y) == (y % 2 == 0));
+    assert(!is_black(10, 30) && !is_black(9, 10) && !is_black(11, 10));
+}
+
+void test_draw_line_dashed(void) {
+    // Paint_DrawLine keeps its dot geometry: 2 * width - 1 across, one up and left
+    new_image();
+    Paint_DrawLine(11, 11, 51, 11, BLACK, DOT_PIXEL_2X2, LINE_STYLE_DASHED);
+    for (int x = 9; x <= 51; x++)
+        assert(is_black(x, 9) == is_black(x, 11) && is_black(x, 10) == is_black(x, 11));
+    assert(is_black(9, 10) && !is_black(8, 10) && !is_black(9, 12) && !is_black(9, 8));
+    // Dashes of 9 and gaps of 6 pixels, each reaching 1.5 pixels further
+    assert(is_black(20, 10) && !is_black(21, 10) && !is_black(23, 10) && is_black(24, 10));
+}
+
+void test_solid_line_spans(void) {
+    // Grid lines are the same rectangle of dots as before
+    new_image();
+    Paint_DrawLine(10, 10, 40, 10, BLACK, DOT_PIXEL_3X3, LINE_STYLE_SOLID);
+    assert_box(7, 7, 41, 11);
+    new_image();
+    Paint_DrawLine(1, 1, 1, 60, BLACK, DOT_PIXEL_2X2, LINE_STYLE_SOLID);
+    assert_box(0, 0, 1, 60);
+}
+
+int main(void) {
+    test_axis_lines();
+    test_diagonal_lines();
+    test_dashes();
+    test_draw_line_dashed();
+    test_solid_line_spans();
+    printf("All GUI_Paint line tests passed!\n");
+    return 0;
+}
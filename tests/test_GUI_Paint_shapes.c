@@ -0,0 +1,123 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/GUI_Paint.h"
+
+#define IMG_W 120
+#define IMG_H 80
+
+static unsigned char buf[IMG_W * IMG_H];
+
+static void new_image(UBYTE bpp) {
+    Paint_NewImage(buf, IMG_W, IMG_H, ROTATE_0, WHITE);
+    Paint_SetBitsPerPixel(bpp);
+    Paint_Clear(WHITE);
+    Paint_ClearDamage();
+}
+
+static int is_black(int x, int y) {
+    return buf[y * IMG_W + x] == BLACK;
+}
+
+// Pixel centers within Rx + 1/2, Ry + 1/2 of the center
+static int in_ellipse(int dx, int dy, int rx, int ry) {
+    long long a = (2LL * rx + 1) * (2 * rx + 1), b = (2LL * ry + 1) * (2 * ry + 1);
+    return rx >= 0 && ry >= 0 && 4LL * dx * dx * b + 4LL * dy * dy * a <= a * b;
+}
+
+static int in_rounded(int x, int y, int x0, int y0, int w, int h, int r) {
+    if (w <= 0 || h <= 0 || x < x0 || y < y0 || x >= x0 + w || y >= y0 + h)
+        return 0;
+    int cx = x < x0 + r ? x0 + r : (x > x0 + w - 1 - r ? x0 + w - 1 - r : x);
+    int cy = y < y0 + r ? y0 + r : (y > y0 + h - 1 - r ? y0 + h - 1 - r : y);
+    return in_ellipse(x - cx, y - cy, r, r);
+}
+
+void test_filled_ellipse(void) {
+    PAINT_RECT rect;
+    new_image(8);
+    Paint_DrawEllipse(60, 40, 25, 12, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            assert(is_black(x, y) == in_ellipse(x - 60, y - 40, 25, 12));
+
+    // The extremes are single pixels at the radius
+    assert(is_black(35, 40) && is_black(85, 40) && !is_black(34, 40) && !is_black(86, 40));
+    assert(is_black(60, 28) && is_black(60, 52) && !is_black(60, 27));
+    assert(Paint_GetDamage(&rect, 1, 1) == 1);
+    assert(rect.X == 35 && rect.Y == 28 && rect.W == 51 && rect.H == 25);
+}
+
+void test_ellipse_outline(void) {
+    new_image(8);
+    Paint_DrawEllipse(60, 40, 30, 20, BLACK, DOT_PIXEL_3X3, DRAW_FILL_EMPTY);
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            assert(is_black(x, y) == (in_ellipse(x - 60, y - 40, 30, 20) && !in_ellipse(x - 60, y - 40, 27, 17)));
+
+    // A circle is an ellipse with equal radii; zero radii leave one pixel
+    new_image(8);
+    Paint_DrawEllipse(10, 10, 0, 0, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    assert(is_black(10, 10) && !is_black(9, 10) && !is_black(10, 9));
+}
+
+void test_rounded_rectangle(void) {
+    new_image(8);
+    Paint_DrawRoundedRectangle(10, 5, 70, 45, 8, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            assert(is_black(x, y) == in_rounded(x, y, 10, 5, 60, 40, 8));
+    assert(!is_black(10, 5) && is_black(18, 5) && is_black(10, 13) && is_black(40, 44));
+
+    new_image(8);
+    Paint_DrawRoundedRectangle(10, 5, 70, 45, 8, BLACK, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            assert(is_black(x, y) == (in_rounded(x, y, 10, 5, 60, 40, 8) && !in_rounded(x, y, 12, 7, 56, 36, 6)));
+}
+
+void test_rounded_square_corners(void) {
+    static unsigned char ref[IMG_W * IMG_H];
+
+    // No radius is a plain window, at any depth
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        new_image(bpp);
+        Paint_ClearWindows(3, 4, 50, 30, 0x80);
+        memcpy(ref, buf, sizeof(buf));
+        new_image(bpp);
+        Paint_DrawRoundedRectangle(3, 4, 50, 30, 0, 0x80, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        assert(memcmp(buf, ref, sizeof(buf)) == 0);
+    }
+
+    // A radius past half the height makes round ends
+    new_image(8);
+    Paint_DrawRoundedRectangle(0, 0, 40, 11, 100, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < IMG_W; x++)
+            assert(is_black(x, y) == in_rounded(x, y, 0, 0, 40, 11, 5));
+
+    // Empty and out of range rectangles draw nothing
+    new_image(8);
+    Paint_DrawRoundedRectangle(20, 20, 20, 30, 2, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    Paint_DrawRoundedRectangle(20, 20, IMG_W + 1, 30, 2, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    assert(Paint_GetDamage(NULL, 0, 1) == 0);
+}
+
+void test_clipped_shapes(void) {
+    // Shapes hanging off the image keep the part that is on it
+    new_image(4);
+    Paint_DrawEllipse(2, 3, 40, 30, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    assert(buf[0] == 0x00 && buf[IMG_W / 2 - 1] == 0xFF);
+    Paint_DrawCircle(IMG_W, IMG_H - 1, 50, BLACK, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    assert(buf[(IMG_H - 1) * IMG_W / 2 + IMG_W / 2 - 1] == 0x00);
+}
+
+int main(void) {
+    test_filled_ellipse();
+    test_ellipse_outline();
+    test_rounded_rectangle();
+    test_rounded_square_corners();
+    test_clipped_shapes();
+    printf("All GUI_Paint shape tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/GUI_Paint.h"
+
+#define IMG_W 61
+#define IMG_H 37
+
+static unsigned char buf[IMG_W * IMG_H];
+static unsigned char ref[IMG_W * IMG_H];
+
+static const UWORD rotates[] = {ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270};
+static const UBYTE depths[] = {1, 2, 4, 8};
+
+static void new_image(UBYTE *image, UWORD rotate, UBYTE mirror, UBYTE bpp) {
+    memset(image, 0x5A, sizeof(buf));
+    Paint_NewImage(image, IMG_W, IMG_H, rotate, WHITE);
+    Paint_SetBitsPerPixel(bpp);
+    Paint_SetMirroring(mirror);
+}
+
+static PAINT_RECT damage(void) {
+    PAINT_RECT rect = {0, 0, 0, 0};
+    assert(Paint_GetDamage(&rect, 1, 1) <= 1);
+    return rect;
+}
+
+// Gray level of pixel i of a row packed like the image
+static UBYTE row_pixel(const UBYTE *src, UWORD i, UBYTE bpp) {
+    UBYTE bits = (src[i * bpp / 8] >> (i * bpp % 8)) & ((1 << bpp) - 1);
+    return bits * (255 / ((1 << bpp) - 1));
+}
+
+void test_fill_matches_set_pixel(void) {
+    srand(16);
+    for (int r = 0; r < 4; r++)
+    for (UBYTE mirror = MIRROR_NONE; mirror <= MIRROR_ORIGIN; mirror++)
+    for (int d = 0; d < 4; d++)
+    for (int n = 0; n < 40; n++) {
+        new_image(ref, rotates[r], mirror, depths[d]);
+        UWORD x = rand() % (Paint.Width + 4), y = rand() % (Paint.Height + 2);
+        UWORD len = rand() % (Paint.Width + 8), color = rand() % 256;
+        for (UWORD i = 0; i < len; i++)
+            Paint_SetPixel(x + i, y, color);
+        PAINT_RECT expected = damage();
+
+        new_image(buf, rotates[r], mirror, depths[d]);
+        Paint_FillSpan(x, y, len, color);
+        PAINT_RECT got = damage();
+
+        assert(memcmp(buf, ref, sizeof(buf)) == 0);
+        assert(memcmp(&got, &expected, sizeof(got)) == 0);
+    }
+}
+
+void test_blit_matches_set_pixel(void) {
+    UBYTE src[IMG_W + 8];
+    srand(61);
+    for (int r = 0; r < 4; r++)
+    for (UBYTE mirror = MIRROR_NONE; mirror <= MIRROR_ORIGIN; mirror++)
+    for (int d = 0; d < 4; d++)
+    for (int s = 0; s < 4; s++)
+    for (int n = 0; n < 20; n++) {
+        for (size_t i = 0; i < sizeof(src); i++)
+            src[i] = rand();
+        new_image(ref, rotates[r], mirror, depths[d]);
+        UWORD x = rand() % Paint.Width, y = rand() % Paint.Height;
+        UWORD len = rand() % (Paint.Width + 4);
+        // Byte aligned rows of the image depth take the copy path
+        if (n % 2 == 0 && depths[s] == depths[d])
+            x -= x % (8 / depths[d]);
+        for (UWORD i = 0; i < len; i++)
+            Paint_SetPixel(x + i, y, row_pixel(src, i, depths[s]));
+        PAINT_RECT expected = damage();
+
+        new_image(buf, rotates[r], mirror, depths[d]);
+        Paint_BlitRow(x, y, src, len, depths[s]);
+        PAINT_RECT got = damage();
+
+        assert(memcmp(buf, ref, sizeof(buf)) == 0);
+        assert(memcmp(&got, &expected, sizeof(got)) == 0);
+    }
+}
+
+void test_clear_gray(void) {
+    // Every pixel of a byte takes the gray, not the raw color byte
+    new_image(buf, ROTATE_0, MIRROR_NONE, 4);
+    Paint_Clear(0x80);
+    assert(buf[0] == 0x88 && buf[Paint.WidthByte * IMG_H - 1] == 0x88);
+    new_image(buf, ROTATE_0, MIRROR_NONE, 2);
+    Paint_Clear(0x80);
+    assert(buf[0] == 0xAA);
+
+    // A window shares its edge bytes with the pixels around it
+    new_image(buf, ROTATE_0, MIRROR_NONE, 4);
+    Paint_Clear(WHITE);
+    Paint_ClearWindows(1, 0, 6, 1, BLACK);
+    assert(buf[0] == 0x0F && buf[1] == 0x00 && buf[2] == 0x00 && buf[3] == 0xFF);
+}
+
+void test_bad_depth(void) {
+    UBYTE src[4] = {0, 0, 0, 0};
+    new_image(buf, ROTATE_0, MIRROR_NONE, 8);
+    memcpy(ref, buf, sizeof(buf));
+    Paint_BlitRow(0, 0, src, 4, 3);
+    assert(memcmp(buf, ref, sizeof(buf)) == 0);
+    assert(Paint_GetDamage(NULL, 0, 1) == 0);
+}
+
+int main(void) {
+    test_fill_matches_set_pixel();
+    test_blit_matches_set_pixel();
+    test_clear_gray();
+    test_bad_depth();
+    printf("All GUI_Paint span tests passed!\n");
+    return 0;
+}
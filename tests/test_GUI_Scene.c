@@ -0,0 +1,257 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/GUI_Paint.h"
+#include "../include/GUI_Scene.h"
+#include "../include/GUI_BMPfile.h"
+
+#define IMG_W 200
+#define IMG_H 120
+#define NODES 24
+
+static unsigned char buf[IMG_W * IMG_H];
+static unsigned char ref[IMG_W * IMG_H];
+static unsigned char before[IMG_W * IMG_H];
+static UBYTE bitmap[16 * 12];
+
+static const UWORD rotates[] = {ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270};
+
+// What each node draws, so the scene can be drawn afresh for comparison
+typedef struct {
+    bool present;
+    int kind;
+    UWORD x, y, a, b, color;
+    char text[12];
+} model_node;
+
+static model_node model[NODES];
+static UDOUBLE order[NODES];
+static int order_len;
+
+static void draw_node(Paint_Ctx *ctx, const model_node *n) {
+    switch (n->kind) {
+    case 0:
+        Paint_Ctx_DrawString_EN(ctx, n->x, n->y, n->text, &Font12, n->color, WHITE);
+        break;
+    case 1:
+        Paint_Ctx_DrawRoundedRectangle(ctx, n->x, n->y, n->x + n->a, n->y + n->b, 4, n->color, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+        break;
+    case 2:
+        Paint_Ctx_DrawCircle(ctx, n->x, n->y, n->a, n->color, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
+        break;
+    case 3:
+        for (UWORD y = 0; y < 12; y++)
+            Paint_Ctx_BlitRow(ctx, n->x, n->y + y, bitmap + y * 16, 16, 8);
+        break;
+    }
+}
+
+static int set_node(SCENE *scene, UDOUBLE id, const model_node *n) {
+    switch (n->kind) {
+    case 0:
+        return Scene_SetText(scene, id, n->x, n->y, n->text, &Font12, n->color, WHITE);
+    case 1:
+        return Scene_SetRect(scene, id, n->x, n->y, n->x + n->a, n->y + n->b, 4, n->color, DOT_PIXEL_1X1, DRAW_FILL_FULL);
+    case 2:
+        return Scene_SetCircle(scene, id, n->x, n->y, n->a, n->color, DOT_PIXEL_2X2, DRAW_FILL_EMPTY);
+    default:
+        return Scene_SetBitmap(scene, id, n->x, n->y, 16, 12, bitmap, 8);
+    }
+}
+
+static void random_node(model_node *n) {
+    n->present = true;
+    n->kind = rand() % 4;
+    n->x = rand() % (IMG_W + 20);
+    n->y = rand() % (IMG_H + 10);
+    n->a = 1 + rand() % 60;
+    n->b = 1 + rand() % 40;
+    n->color = (rand() % 16) * 0x11;
+    snprintf(n->text, sizeof(n->text), "v%d", rand() % 100000);
+}
+
+// The whole scene drawn into ref in the order the nodes were first added
+static void draw_reference(UWORD rotate, UBYTE mirror, UBYTE bpp) {
+    Paint_Ctx ctx;
+    Paint_Ctx_Init(&ctx);
+    Paint_Ctx_NewImage(&ctx, ref, IMG_W, IMG_H, rotate, WHITE);
+    Paint_Ctx_SetBitsPerPixel(&ctx, bpp);
+    Paint_Ctx_SetMirroring(&ctx, mirror);
+    Paint_Ctx_Clear(&ctx, 0xE0);
+    for (int i = 0; i < order_len; i++)
+        if (model[order[i]].present)
+            draw_node(&ctx, &model[order[i]]);
+    Paint_Ctx_Release(&ctx);
+}
+
+// Bytes outside the redrawn areas must not change; works in memory bytes, so
+// the areas are widened to whole bytes
+static void check_outside_unchanged(const PAINT_RECT *rects, int count, UBYTE bpp) {
+    UWORD width_byte = (IMG_W * bpp + 7) / 8;
+    for (int y = 0; y < IMG_H; y++)
+        for (int x = 0; x < width_byte; x++) {
+            bool inside = false;
+            for (int i = 0; i < count; i++)
+                if (y >= rects[i].Y && y < rects[i].Y + rects[i].H &&
+                    x >= rects[i].X * bpp / 8 && x <= (rects[i].X + rects[i].W - 1) * bpp / 8)
+                    inside = true;
+            if (!inside)
+                assert(buf[y * width_byte + x] == before[y * width_byte + x]);
+        }
+}
+
+void test_matches_full_redraw(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    Paint_Ctx ctx;
+    SCENE scene;
+
+    for (int i = 0; i < 12 * 16; i++)
+        bitmap[i] = (UBYTE)(i * 7);
+    srand(3);
+    Paint_Ctx_Init(&ctx);
+    for (int r = 0; r < 4; r++)
+    for (UBYTE bpp = 1; bpp <= 8; bpp *= 2) {
+        UBYTE mirror = (r + bpp) % 4;
+        Paint_Ctx_NewImage(&ctx, buf, IMG_W, IMG_H, rotates[r], WHITE);
+        Paint_Ctx_SetBitsPerPixel(&ctx, bpp);
+        Paint_Ctx_SetMirroring(&ctx, mirror);
+        memset(buf, 0x5A, sizeof(buf));
+        Scene_Init(&scene, &ctx, 0xE0);
+        memset(model, 0, sizeof(model));
+        order_len = 0;
+
+        for (int step = 0; step < 60; step++) {
+            // A few nodes added, changed, moved or removed at each step
+            // An ID removed and set again before a commit keeps its place, so
+            // each ID is touched once per step
+            UDOUBLE touched[3];
+            for (int k = 0; k < 3; k++) {
+                UDOUBLE id = rand() % NODES;
+                touched[k] = id;
+                if ((k > 0 && touched[0] == id) || (k > 1 && touched[1] == id))
+                    continue;
+                if (model[id].present && rand() % 4 == 0) {
+                    assert(Scene_Remove(&scene, id) == 0);
+                    model[id].present = false;
+                    for (int i = 0; i < order_len; i++)
+                        if (order[i] == id)
+                            memmove(&order[i], &order[i + 1], (--order_len - i) * sizeof(order[0]));
+                } else {
+                    if (!model[id].present)
+                        order[order_len++] = id;
+                    random_node(&model[id]);
+                    assert(set_node(&scene, id, &model[id]) == 0);
+                }
+            }
+            memcpy(before, buf, sizeof(buf));
+            Paint_Ctx_ClearDamage(&ctx);
+            int count = Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX);
+            assert(count >= 0 && count <= PAINT_DAMAGE_MAX);
+            if (step == 0)
+                assert(count == 1 && rects[0].W == IMG_W && rects[0].H == IMG_H);
+            check_outside_unchanged(rects, count, bpp);
+            draw_reference(rotates[r], mirror, bpp);
+            assert(memcmp(buf, ref, (IMG_W * bpp + 7) / 8 * IMG_H) == 0);
+
+            // The redrawn areas are in the context's damage
+            PAINT_RECT damage[PAINT_DAMAGE_MAX];
+            UWORD n = Paint_Ctx_GetDamage(&ctx, damage, PAINT_DAMAGE_MAX, 1);
+            for (int i = 0; i < count; i++) {
+                bool covered = false;
+                for (UWORD j = 0; j < n; j++)
+                    covered |= rects[i].X >= damage[j].X && rects[i].Y >= damage[j].Y &&
+                               rects[i].X + rects[i].W <= damage[j].X + damage[j].W &&
+                               rects[i].Y + rects[i].H <= damage[j].Y + damage[j].H;
+                assert(covered);
+            }
+        }
+        Scene_Release(&scene);
+    }
+    Paint_Ctx_Release(&ctx);
+}
+
+void test_small_changes(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    SCENE scene;
+
+    Paint_NewImage(buf, IMG_W, IMG_H, ROTATE_0, WHITE);
+    Scene_Init(&scene, &Paint, WHITE);
+    assert(Scene_SetText(&scene, 1, 10, 10, "12:00", &Font12, BLACK, WHITE) == 0);
+    assert(Scene_SetText(&scene, 2, 10, 40, "21.5 C", &Font12, BLACK, WHITE) == 0);
+    assert(Scene_SetRect(&scene, 3, 100, 0, 200, 120, 0, 0x80, DOT_PIXEL_1X1, DRAW_FILL_FULL) == 0);
+    assert(Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX) == 1);
+
+    // Setting nodes to what they already are redraws nothing
+    memcpy(before, buf, sizeof(buf));
+    assert(Scene_SetText(&scene, 1, 10, 10, "12:00", &Font12, BLACK, WHITE) == 0);
+    assert(Scene_SetRect(&scene, 3, 100, 0, 200, 120, 0, 0x80, DOT_PIXEL_1X1, DRAW_FILL_FULL) == 0);
+    assert(Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX) == 0);
+    assert(memcmp(buf, before, sizeof(buf)) == 0);
+
+    // A new value redraws just its text
+    assert(Scene_SetText(&scene, 1, 10, 10, "12:01", &Font12, BLACK, WHITE) == 0);
+    assert(Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX) == 1);
+    assert(rects[0].X == 10 && rects[0].Y == 10);
+    assert(rects[0].W == 5 * Font12.Width && rects[0].H == Font12.Height);
+
+    // A removed node uncovers the background
+    assert(Scene_Remove(&scene, 2) == 0);
+    assert(Scene_Remove(&scene, 2) == SCENE_ERR_MISSING);
+    assert(Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX) == 1);
+    for (int y = 40; y < 40 + Font12.Height; y++)
+        for (int x = 10; x < 10 + 6 * Font12.Width; x++)
+            assert(buf[y * IMG_W + x] == WHITE);
+
+    // A node set from drawing calls, and Scene_Invalidate() redrawing it all
+    assert(Scene_BeginNode(&scene, 4) == 0);
+    assert(Scene_BeginNode(&scene, 5) == SCENE_ERR_BUSY);
+    assert(Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX) == SCENE_ERR_BUSY);
+    Paint_DrawLine(0, 100, 99, 100, BLACK, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+    Paint_DrawLine(0, 110, 99, 110, BLACK, DOT_PIXEL_1X1, LINE_STYLE_SOLID);
+    assert(buf[99 * IMG_W + 50] == WHITE);
+    assert(Scene_EndNode(&scene) == 0);
+    assert(Scene_EndNode(&scene) == SCENE_ERR_MISSING);
+    assert(Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX) == 1);
+    // Paint_DrawPoint() puts a 1x1 dot up and left of its point
+    assert(buf[99 * IMG_W + 50] == BLACK && buf[109 * IMG_W + 50] == BLACK);
+    Scene_Invalidate(&scene);
+    assert(Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX) == 1);
+    assert(rects[0].W == IMG_W && rects[0].H == IMG_H);
+    Scene_Release(&scene);
+}
+
+void test_bmp_node(void) {
+    PAINT_RECT rects[PAINT_DAMAGE_MAX];
+    SCENE scene;
+    Paint_Ctx ctx;
+
+    // The BMP is drawn as GUI_ReadBmp() draws it, into any context
+    Paint_NewImage(ref, IMG_W, IMG_H, ROTATE_90, WHITE);
+    Paint_SetBitsPerPixel(4);
+    Paint_Clear(WHITE);
+    assert(GUI_ReadBmp("assets/test.bmp", 20, 10) == 0);
+
+    Paint_Ctx_Init(&ctx);
+    Paint_Ctx_NewImage(&ctx, buf, IMG_W, IMG_H, ROTATE_90, WHITE);
+    Paint_Ctx_SetBitsPerPixel(&ctx, 4);
+    Scene_Init(&scene, &ctx, WHITE);
+    assert(Scene_SetBMP(&scene, 1, 20, 10, "assets/test.bmp") == 0);
+    assert(Scene_SetBMP(&scene, 2, 0, 0, "assets/missing.bmp") == SCENE_ERR_FILE);
+    assert(Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX) == 1);
+    assert(memcmp(buf, ref, IMG_W * IMG_H / 2) == 0);
+
+    // Reading the same file again changes nothing
+    assert(Scene_SetBMP(&scene, 1, 20, 10, "assets/test.bmp") == 0);
+    assert(Scene_Commit(&scene, rects, PAINT_DAMAGE_MAX) == 0);
+    Scene_Release(&scene);
+    Paint_Ctx_Release(&ctx);
+}
+
+int main(void) {
+    test_matches_full_redraw();
+    test_small_changes();
+    test_bmp_node();
+    printf("All GUI_Scene tests passed!\n");
+    return 0;
+}